@@ -0,0 +1,491 @@
+// Throughput benchmarks for the hot paths of a repository run.
+//
+//   repomix_bench [--filter <substring>] [--json <file>] [--min-time <seconds>]
+//                 [--baseline <file> [--max-regression <fraction>]] [--quick]
+//
+// Results go to stdout (or --json) in the JSON layout of Google Benchmark, so
+// its compare.py and dashboards that read that format work unchanged. With
+// --baseline, every benchmark also present in the baseline file is checked
+// and the exit status is 1 if any got slower by more than --max-regression.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "code_ner.hpp"
+#include "file_processor.hpp"
+#include "file_scorer.hpp"
+#include "output_sink.hpp"
+#include "pattern_matcher.hpp"
+#include "regex_engine.hpp"
+#include "repomix.hpp"
+#include "synthetic_repo.hpp"
+#include "tokenizer.hpp"
+
+namespace {
+
+struct BenchOptions {
+    std::string filter;
+    fs::path jsonPath;
+    fs::path baselinePath;
+    double maxRegression = 0.15;
+    double minSeconds = 0.5;
+    bool quick = false;
+};
+
+// What one iteration got through, for the throughput columns
+struct Work {
+    size_t items = 0;
+    size_t bytes = 0;
+};
+
+// Keeps a computed value alive so the work producing it is not optimized away
+volatile size_t keptValue = 0;
+void keep(size_t value) {
+    keptValue = value;
+}
+
+// Swallows the progress lines the library prints to stdout, which would
+// otherwise mix with the JSON report and time the terminal
+class NullBuffer : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+struct Result {
+    std::string name;
+    size_t iterations = 0;
+    double medianSeconds = 0;
+    double minSeconds = 0;
+    double meanSeconds = 0;
+    double stddevSeconds = 0;
+    double cpuSeconds = 0;          // Mean process CPU time, all threads
+    Work work;
+};
+
+class Runner {
+public:
+    explicit Runner(const BenchOptions& options) : options_(options) {}
+
+    bool selected(const std::string& name) const {
+        return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+    }
+
+    // Time fn after one warm-up call, until both the minimum number of
+    // iterations and the minimum time are reached
+    void run(const std::string& name, const std::function<Work()>& fn) {
+        if (!selected(name)) {
+            return;
+        }
+        constexpr size_t MIN_ITERATIONS = 3;
+        constexpr size_t MAX_ITERATIONS = 1000;
+
+        Result result;
+        result.name = name;
+        result.work = fn();
+
+        std::vector<double> samples;
+        double total = 0;
+        const std::clock_t cpuStart = std::clock();
+        while (samples.size() < MIN_ITERATIONS ||
+               (total < options_.minSeconds && samples.size() < MAX_ITERATIONS)) {
+            const auto start = std::chrono::steady_clock::now();
+            result.work = fn();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            samples.push_back(seconds);
+            total += seconds;
+        }
+
+        result.cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC /
+                            static_cast<double>(samples.size());
+
+        std::sort(samples.begin(), samples.end());
+        result.iterations = samples.size();
+        result.minSeconds = samples.front();
+        result.medianSeconds = samples[samples.size() / 2];
+        result.meanSeconds = total / static_cast<double>(samples.size());
+        double variance = 0;
+        for (double sample : samples) {
+            variance += (sample - result.meanSeconds) * (sample - result.meanSeconds);
+        }
+        result.stddevSeconds = std::sqrt(variance / static_cast<double>(samples.size()));
+
+        std::cerr << std::left << std::setw(48) << name << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(12) << result.medianSeconds * 1e3 << " ms"
+                  << std::setprecision(0) << std::setw(14)
+                  << static_cast<double>(result.work.items) / result.medianSeconds << " items/s"
+                  << std::setprecision(1) << std::setw(10)
+                  << static_cast<double>(result.work.bytes) / result.medianSeconds / 1e6 << " MB/s" << std::endl;
+        results_.push_back(std::move(result));
+    }
+
+    const std::vector<Result>& results() const { return results_; }
+
+private:
+    const BenchOptions& options_;
+    std::vector<Result> results_;
+};
+
+nlohmann::json toJson(const std::vector<Result>& results) {
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    nlohmann::json context = {
+        {"date", date},
+        {"num_cpus", std::thread::hardware_concurrency()},
+        {"library_build_type",
+#ifdef NDEBUG
+         "release"
+#else
+         "debug"
+#endif
+        },
+        {"regex_engine", Regex::engineName()},
+#ifdef USE_TIKTOKEN
+        {"tokenizer", "tiktoken"},
+#else
+        {"tokenizer", "approximate"},
+#endif
+#ifdef USE_ONNX_RUNTIME
+        {"onnx_runtime", true},
+#else
+        {"onnx_runtime", false},
+#endif
+    };
+
+    nlohmann::json benchmarks = nlohmann::json::array();
+    for (const auto& result : results) {
+        benchmarks.push_back({
+            {"name", result.name},
+            {"run_type", "iteration"},
+            {"iterations", result.iterations},
+            {"real_time", result.medianSeconds * 1e9},
+            {"cpu_time", result.cpuSeconds * 1e9},
+            {"time_unit", "ns"},
+            {"min_time", result.minSeconds * 1e9},
+            {"mean_time", result.meanSeconds * 1e9},
+            {"stddev_time", result.stddevSeconds * 1e9},
+            {"items_per_second", static_cast<double>(result.work.items) / result.medianSeconds},
+            {"bytes_per_second", static_cast<double>(result.work.bytes) / result.medianSeconds},
+        });
+    }
+    return {{"context", std::move(context)}, {"benchmarks", std::move(benchmarks)}};
+}
+
+// Benchmarks slower than the baseline by more than the allowed fraction
+int checkBaseline(const std::vector<Result>& results, const BenchOptions& options) {
+    std::ifstream file(options.baselinePath);
+    if (!file) {
+        std::cerr << "Error: cannot read baseline " << options.baselinePath << std::endl;
+        return 2;
+    }
+    std::map<std::string, double> baseline;
+    try {
+        const nlohmann::json report = nlohmann::json::parse(file);
+        for (const auto& entry : report.at("benchmarks")) {
+            baseline[entry.at("name").get<std::string>()] = entry.at("real_time").get<double>();
+        }
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "Error: malformed baseline " << options.baselinePath << ": " << e.what() << std::endl;
+        return 2;
+    }
+
+    int regressions = 0;
+    for (const auto& result : results) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second <= 0) {
+            continue;
+        }
+        const double ratio = result.medianSeconds * 1e9 / it->second;
+        if (ratio > 1.0 + options.maxRegression) {
+            std::cerr << "Regression: " << result.name << " is " << std::fixed << std::setprecision(1)
+                      << (ratio - 1.0) * 100.0 << "% slower than the baseline" << std::endl;
+            ++regressions;
+        }
+    }
+    return regressions > 0 ? 1 : 0;
+}
+
+// Repositories are generated on first use, so a filtered run only pays for its own
+class Fixtures {
+public:
+    explicit Fixtures(bool quick) : quick_(quick) {}
+
+    const synthetic::Repo& tiny() {
+        return get(tiny_, "tiny", [this](synthetic::Repo& repo) {
+            synthetic::addTinyFiles(repo, quick_ ? 1000 : 5000, 1);
+        });
+    }
+
+    const synthetic::Repo& huge() {
+        return get(huge_, "huge", [this](synthetic::Repo& repo) {
+            synthetic::addHugeFiles(repo, 3, (quick_ ? 2 : 8) * 1024 * 1024, 2);
+        });
+    }
+
+    const synthetic::Repo& deep() {
+        return get(deep_, "deep", [this](synthetic::Repo& repo) {
+            synthetic::addDeepTree(repo, quick_ ? 32 : 96, 3, 3);
+        });
+    }
+
+    const synthetic::Repo& ignore() {
+        return get(ignore_, "ignore", [this](synthetic::Repo& repo) {
+            synthetic::addLargeIgnoreList(repo, quick_ ? 600 : 3000, quick_ ? 600 : 3000, 4);
+        });
+    }
+
+private:
+    bool quick_;
+    std::unique_ptr<synthetic::Repo> tiny_, huge_, deep_, ignore_;
+
+    const synthetic::Repo& get(std::unique_ptr<synthetic::Repo>& slot, const std::string& name,
+                               const std::function<void(synthetic::Repo&)>& fill) {
+        if (!slot) {
+            slot = std::make_unique<synthetic::Repo>(name);
+            fill(*slot);
+        }
+        return *slot;
+    }
+};
+
+void benchPatternMatcher(Runner& runner, Fixtures& fixtures) {
+    for (const char* name : {"tiny", "ignore"}) {
+        const std::string benchName = std::string("pattern_matcher/should_process/") + name;
+        if (!runner.selected(benchName)) {
+            continue;
+        }
+        const synthetic::Repo& repo = std::string(name) == "tiny" ? fixtures.tiny() : fixtures.ignore();
+        PatternMatcher matcher;
+        matcher.loadGitignore(repo.root() / ".gitignore");
+        runner.run(benchName, [&]() {
+            size_t kept = 0;
+            for (const auto& path : repo.files()) {
+                kept += matcher.shouldProcess(path) ? 1 : 0;
+            }
+            keep(kept);
+            return Work{repo.files().size(), 0};
+        });
+    }
+}
+
+void benchFileProcessor(Runner& runner, Fixtures& fixtures) {
+    using FixtureFn = const synthetic::Repo& (Fixtures::*)();
+    const std::pair<const char*, FixtureFn> shapes[] = {
+        {"tiny", &Fixtures::tiny}, {"huge", &Fixtures::huge},
+        {"deep", &Fixtures::deep}, {"ignore", &Fixtures::ignore},
+    };
+    for (const auto& shape : shapes) {
+        const std::string benchName = std::string("file_processor/process_directory/") + shape.first;
+        if (!runner.selected(benchName)) {
+            continue;
+        }
+        const synthetic::Repo& repo = (fixtures.*shape.second)();
+        runner.run(benchName, [&]() {
+            // A fresh matcher per run, as Repomix does, so nested .gitignore
+            // files are loaded again each time
+            PatternMatcher matcher;
+            matcher.loadGitignore(repo.root() / ".gitignore");
+            FileProcessor processor(matcher);
+            processor.setKeepContent(false);
+            auto files = processor.processDirectory(repo.root());
+            return Work{files.size(), repo.totalBytes()};
+        });
+    }
+}
+
+void benchFileScorer(Runner& runner, Fixtures& fixtures) {
+    for (const char* name : {"tiny", "ignore"}) {
+        const std::string benchName = std::string("file_scorer/score_repository/") + name;
+        if (!runner.selected(benchName)) {
+            continue;
+        }
+        const synthetic::Repo& repo = std::string(name) == "tiny" ? fixtures.tiny() : fixtures.ignore();
+        FileScorer scorer;
+        runner.run(benchName, [&]() {
+            auto scored = scorer.scoreRepository(repo.root());
+            return Work{scored.size(), 0};
+        });
+    }
+}
+
+void benchCodeNER(Runner& runner) {
+    using Method = SummarizationOptions::NERMethod;
+    const std::pair<const char*, Method> backends[] = {
+        {"regex", Method::Regex}, {"tree_sitter", Method::TreeSitter},
+        {"ml", Method::ML}, {"hybrid", Method::Hybrid},
+    };
+    const std::pair<const char*, const char*> languages[] = {
+        {"cpp", ".cpp"}, {"python", ".py"}, {"javascript", ".js"},
+    };
+    constexpr size_t FILES_PER_ITERATION = 16;
+    constexpr size_t FILE_BYTES = 32 * 1024;
+
+    for (const auto& backend : backends) {
+        std::unique_ptr<CodeNER> ner;
+        for (const auto& language : languages) {
+            const std::string benchName = std::string("code_ner/") + backend.first + "/" + language.first;
+            if (!runner.selected(benchName)) {
+                continue;
+            }
+            if (!ner) {
+                SummarizationOptions options;
+                options.nerMethod = backend.second;
+                options.cacheMLResults = false;     // Measure the backend, not the entity cache
+                ner = CodeNER::create(options);
+            }
+
+            std::vector<std::string> contents;
+            size_t bytes = 0;
+            for (size_t i = 0; i < FILES_PER_ITERATION; ++i) {
+                contents.push_back(synthetic::sourceFile(language.second, FILE_BYTES, static_cast<uint32_t>(i)));
+                bytes += contents.back().size();
+            }
+            const fs::path path = std::string("bench") + language.second;
+            runner.run(benchName, [&]() {
+                size_t entities = 0;
+                for (const auto& content : contents) {
+                    entities += ner->extractEntities(content, path).size();
+                }
+                keep(entities);
+                return Work{contents.size(), bytes};
+            });
+        }
+    }
+}
+
+void benchTokenizer(Runner& runner) {
+    const std::pair<const char*, std::string> inputs[] = {
+        {"cpp", ".cpp"}, {"prose", ".md"},
+    };
+    for (const auto& input : inputs) {
+        const std::string benchName = std::string("tokenizer/count_tokens/") + input.first;
+        if (!runner.selected(benchName)) {
+            continue;
+        }
+        Tokenizer tokenizer;
+        const std::string text = synthetic::sourceFile(input.second, 4 * 1024 * 1024, 5);
+        runner.run(benchName, [&]() {
+            const size_t tokens = tokenizer.countTokens(text);
+            return Work{tokens, text.size()};
+        });
+    }
+}
+
+// Repomix::formatOutput is private; a whole run into a NullSink measures it
+// together with processing, which file_processor/* measures on its own
+void benchRepomix(Runner& runner, Fixtures& fixtures) {
+    const std::pair<const char*, OutputFormat> formats[] = {
+        {"plain", OutputFormat::Plain}, {"markdown", OutputFormat::Markdown},
+        {"xml", OutputFormat::XML}, {"claude_xml", OutputFormat::ClaudeXML},
+    };
+    for (const auto& format : formats) {
+        const std::string benchName = std::string("repomix/run/") + format.first + "/tiny";
+        if (!runner.selected(benchName)) {
+            continue;
+        }
+        const synthetic::Repo& repo = fixtures.tiny();
+        runner.run(benchName, [&]() {
+            RepomixOptions options;
+            options.inputDir = repo.root();
+            options.format = format.second;
+            Repomix repomix(options);
+            auto sink = std::make_shared<NullSink>();
+            repomix.setOutputSink(sink);
+            if (!repomix.run()) {
+                throw std::runtime_error("Repomix run failed");
+            }
+            return Work{repo.files().size(), sink->bytesWritten()};
+        });
+    }
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error(arg + " needs a value");
+            }
+            return argv[++i];
+        };
+        if (arg == "--filter") {
+            options.filter = value();
+        } else if (arg == "--json") {
+            options.jsonPath = value();
+        } else if (arg == "--baseline") {
+            options.baselinePath = value();
+        } else if (arg == "--max-regression") {
+            options.maxRegression = std::stod(value());
+        } else if (arg == "--min-time") {
+            options.minSeconds = std::stod(value());
+        } else if (arg == "--quick") {
+            options.quick = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter <substring>] [--json <file>] [--min-time <seconds>]"
+                      << " [--baseline <file> [--max-regression <fraction>]] [--quick]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            return 2;
+        }
+
+        Runner runner(options);
+        {
+            NullBuffer discard;
+            std::streambuf* stdoutBuffer = std::cout.rdbuf(&discard);
+            try {
+                Fixtures fixtures(options.quick);
+                benchPatternMatcher(runner, fixtures);
+                benchFileProcessor(runner, fixtures);
+                benchFileScorer(runner, fixtures);
+                benchCodeNER(runner);
+                benchTokenizer(runner);
+                benchRepomix(runner, fixtures);
+            } catch (...) {
+                std::cout.rdbuf(stdoutBuffer);
+                throw;
+            }
+            std::cout.rdbuf(stdoutBuffer);
+        }
+
+        const nlohmann::json report = toJson(runner.results());
+        if (options.jsonPath.empty()) {
+            std::cout << report.dump(2) << std::endl;
+        } else {
+            std::ofstream file(options.jsonPath);
+            file << report.dump(2) << std::endl;
+            if (!file) {
+                std::cerr << "Error: cannot write " << options.jsonPath << std::endl;
+                return 2;
+            }
+        }
+
+        return options.baselinePath.empty() ? 0 : checkBaseline(runner.results(), options);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -0,0 +1,220 @@
+#include "synthetic_repo.hpp"
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace synthetic {
+
+namespace {
+
+// Names repeat across files the way base classes and helpers do in real code
+const char* const WORDS[] = {
+    "Widget", "Buffer", "Parser", "Session", "Config", "Handler", "Index", "Stream",
+    "Cache", "Report", "Token", "Schema", "Client", "Router", "Worker", "Record",
+};
+constexpr size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+std::string word(std::mt19937& rng) {
+    return WORDS[rng() % WORD_COUNT];
+}
+
+void cppBlock(std::ostringstream& out, std::mt19937& rng, size_t n) {
+    const std::string name = word(rng) + std::to_string(n);
+    out << "#include <vector>\n"
+        << "#include \"" << word(rng) << "_" << n % 7 << ".hpp\"\n\n"
+        << "// " << name << " keeps a running total of the values it was given\n"
+        << "class " << name << " : public " << word(rng) << "Base {\n"
+        << "public:\n"
+        << "    int compute" << n << "(int value) {\n"
+        << "        if (value > " << n % 97 << ") {\n"
+        << "            return value * 2;\n"
+        << "        }\n"
+        << "        for (int i = 0; i < value; ++i) {\n"
+        << "            total_ += i;\n"
+        << "        }\n"
+        << "        return total_;\n"
+        << "    }\n\n"
+        << "private:\n"
+        << "    int total_ = 0;\n"
+        << "};\n\n"
+        << "enum class Mode" << n << " { First, Second, Third };\n\n"
+        << "int helper" << n << "(int x) {\n"
+        << "    int offset = " << n << ";\n"
+        << "    return x + offset;\n"
+        << "}\n\n";
+}
+
+void pythonBlock(std::ostringstream& out, std::mt19937& rng, size_t n) {
+    const std::string name = word(rng) + std::to_string(n);
+    out << "import os\n"
+        << "from pkg.module" << n % 7 << " import " << word(rng) << "\n\n"
+        << "class " << name << "(" << word(rng) << "Base):\n"
+        << "    \"\"\"Keeps a running total of the values it was given.\"\"\"\n\n"
+        << "    def compute_" << n << "(self, value):\n"
+        << "        if value > " << n % 97 << ":\n"
+        << "            return value * 2\n"
+        << "        for i in range(value):\n"
+        << "            self.total += i\n"
+        << "        return self.total\n\n"
+        << "def helper_" << n << "(x):\n"
+        << "    # Shift by the block number\n"
+        << "    offset = " << n << "\n"
+        << "    return x + offset\n\n";
+}
+
+void javascriptBlock(std::ostringstream& out, std::mt19937& rng, size_t n) {
+    const std::string name = word(rng) + std::to_string(n);
+    out << "import { " << word(rng) << " } from './module" << n % 7 << "';\n"
+        << "const lib" << n << " = require('lib" << n % 5 << "');\n\n"
+        << "// " << name << " keeps a running total of the values it was given\n"
+        << "class " << name << " extends " << word(rng) << "Base {\n"
+        << "  compute" << n << "(value) {\n"
+        << "    if (value > " << n % 97 << ") {\n"
+        << "      return value * 2;\n"
+        << "    }\n"
+        << "    for (let i = 0; i < value; i++) {\n"
+        << "      this.total += i;\n"
+        << "    }\n"
+        << "    return this.total;\n"
+        << "  }\n"
+        << "}\n\n"
+        << "function helper" << n << "(x) {\n"
+        << "  const offset = " << n << ";\n"
+        << "  return x + offset;\n"
+        << "}\n\n";
+}
+
+void proseBlock(std::ostringstream& out, std::mt19937& rng, size_t n) {
+    out << "## Section " << n << "\n\n"
+        << "The " << word(rng) << " talks to the " << word(rng) << " through a small queue, and the "
+        << word(rng) << " drains it on a timer. See the " << word(rng) << " notes for details.\n\n";
+}
+
+fs::path uniqueRoot(const std::string& name) {
+    return fs::temp_directory_path() /
+           ("repomix_bench_" + name + "_" + std::to_string(static_cast<long>(::getpid())));
+}
+
+}  // namespace
+
+/**
+ * @brief Generates source text in the language of an extension
+ *
+ * @param extension Extension selecting the language
+ * @param targetBytes Approximate size; whole blocks are emitted until it is reached
+ * @param seed Seed of the name choices
+ * @return std::string The generated text
+ */
+std::string sourceFile(const std::string& extension, size_t targetBytes, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::ostringstream out;
+    void (*block)(std::ostringstream&, std::mt19937&, size_t) = proseBlock;
+    if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".c") {
+        block = cppBlock;
+    } else if (extension == ".py") {
+        block = pythonBlock;
+    } else if (extension == ".js" || extension == ".ts") {
+        block = javascriptBlock;
+    }
+
+    size_t n = seed % 1000;
+    do {
+        block(out, rng, n++);
+    } while (static_cast<size_t>(out.tellp()) < targetBytes);
+    return out.str();
+}
+
+Repo::Repo(const std::string& name) : root_(uniqueRoot(name)) {
+    fs::remove_all(root_);
+    fs::create_directories(root_);
+}
+
+Repo::~Repo() {
+    std::error_code ec;
+    fs::remove_all(root_, ec);
+}
+
+/**
+ * @brief Writes a file below the repository root
+ *
+ * @param relPath Path relative to the root; parent directories are created
+ * @param content File content
+ * @throws std::runtime_error if the file cannot be written
+ */
+void Repo::addFile(const fs::path& relPath, const std::string& content) {
+    const fs::path path = root_ / relPath;
+    fs::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    if (!file) {
+        throw std::runtime_error("Cannot write benchmark file " + path.string());
+    }
+    files_.push_back(path);
+    totalBytes_ += content.size();
+}
+
+void addTinyFiles(Repo& repo, size_t count, uint32_t seed) {
+    static const char* const extensions[] = {".cpp", ".hpp", ".py", ".js", ".md"};
+    std::mt19937 rng(seed);
+    const size_t dirCount = count / 100 + 1;
+    for (size_t i = 0; i < count; ++i) {
+        const std::string extension = extensions[i % 5];
+        const size_t size = 200 + rng() % 1800;
+        repo.addFile(fs::path("pkg" + std::to_string(i % dirCount)) / ("file" + std::to_string(i) + extension),
+                     sourceFile(extension, size, seed + static_cast<uint32_t>(i)));
+    }
+}
+
+void addHugeFiles(Repo& repo, size_t count, size_t bytesPerFile, uint32_t seed) {
+    static const char* const extensions[] = {".cpp", ".py", ".js"};
+    for (size_t i = 0; i < count; ++i) {
+        const std::string extension = extensions[i % 3];
+        repo.addFile(fs::path("big") / ("huge" + std::to_string(i) + extension),
+                     sourceFile(extension, bytesPerFile, seed + static_cast<uint32_t>(i)));
+    }
+}
+
+void addDeepTree(Repo& repo, size_t depth, size_t filesPerLevel, uint32_t seed) {
+    fs::path dir = "deep";
+    for (size_t level = 0; level < depth; ++level) {
+        dir /= "level" + std::to_string(level);
+        for (size_t i = 0; i < filesPerLevel; ++i) {
+            repo.addFile(dir / ("node" + std::to_string(i) + ".cpp"),
+                         sourceFile(".cpp", 1024, seed + static_cast<uint32_t>(level * filesPerLevel + i)));
+        }
+    }
+}
+
+void addLargeIgnoreList(Repo& repo, size_t patternCount, size_t fileCount, uint32_t seed) {
+    std::ostringstream gitignore;
+    gitignore << "# Generated ignore list\n";
+    for (size_t i = 0; i < patternCount; ++i) {
+        switch (i % 6) {
+            case 0: gitignore << "*.tmp" << i << "\n"; break;
+            case 1: gitignore << "/build_" << i << "/\n"; break;
+            case 2: gitignore << "cache_" << i << "/\n"; break;
+            case 3: gitignore << "src/**/gen_" << i << ".cpp\n"; break;
+            case 4: gitignore << "!keep_" << i - 4 << ".tmp" << i - 4 << "\n"; break;
+            case 5: gitignore << "logs/" << i << "/*.log\n"; break;
+        }
+    }
+    repo.addFile(".gitignore", gitignore.str());
+
+    std::mt19937 rng(seed);
+    for (size_t i = 0; i < fileCount; ++i) {
+        const size_t rule = (rng() % patternCount) / 6 * 6;
+        const fs::path dir = fs::path("src") / ("mod" + std::to_string(i % 40));
+        fs::path relPath;
+        switch (i % 5) {
+            case 0: relPath = dir / ("file" + std::to_string(i) + ".tmp" + std::to_string(rule)); break;
+            case 1: relPath = dir / ("sub" + std::to_string(i)) / ("gen_" + std::to_string(rule + 3) + ".cpp"); break;
+            case 2: relPath = fs::path("cache_" + std::to_string(rule + 2)) / ("entry" + std::to_string(i) + ".cpp"); break;
+            default: relPath = dir / ("file" + std::to_string(i) + ".cpp"); break;
+        }
+        repo.addFile(relPath, sourceFile(relPath.extension().string(), 300, seed + static_cast<uint32_t>(i)));
+    }
+}
+
+}  // namespace synthetic
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Generators for the repository shapes the benchmarks run against. Output is
+// deterministic for a given seed, so two benchmark runs see identical trees.
+namespace synthetic {
+
+// Source text of roughly targetBytes in the language of extension (".cpp",
+// ".py", ".js", anything else gives prose), with classes, functions,
+// imports, comments and branches for the NER backends and the summarizer.
+std::string sourceFile(const std::string& extension, size_t targetBytes, uint32_t seed);
+
+// A generated repository on disk; removed again on destruction
+class Repo {
+public:
+    explicit Repo(const std::string& name);
+    ~Repo();
+
+    Repo(const Repo&) = delete;
+    Repo& operator=(const Repo&) = delete;
+
+    const fs::path& root() const { return root_; }
+    const std::vector<fs::path>& files() const { return files_; }
+    size_t totalBytes() const { return totalBytes_; }
+
+    void addFile(const fs::path& relPath, const std::string& content);
+
+private:
+    fs::path root_;
+    std::vector<fs::path> files_;
+    size_t totalBytes_ = 0;
+};
+
+// Thousands of small files spread over a flat set of directories
+void addTinyFiles(Repo& repo, size_t count, uint32_t seed);
+
+// A handful of multi-megabyte source files
+void addHugeFiles(Repo& repo, size_t count, size_t bytesPerFile, uint32_t seed);
+
+// One chain of nested directories depth levels deep, with a few files per level
+void addDeepTree(Repo& repo, size_t depth, size_t filesPerLevel, uint32_t seed);
+
+// A .gitignore with patternCount rules of every kind (globs, anchored paths,
+// directory rules, negations) plus files that match some of them
+void addLargeIgnoreList(Repo& repo, size_t patternCount, size_t fileCount, uint32_t seed);
+
+}  // namespace synthetic
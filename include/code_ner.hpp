@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <memory>
@@ -10,9 +11,9 @@
 #include <optional>
 #include <unordered_set>
 #include <unordered_map>
-#include <regex>
 #include "repomix.hpp"  // For SummarizationOptions
 #include "tree_sitter_types.hpp"  // For TreeSitter types
+#include "parsed_unit.hpp"
 
 // For ONNX Runtime
 #ifdef USE_ONNX_RUNTIME
@@ -43,10 +44,21 @@ public:
     
     // Extract entities from content
     virtual std::vector<NamedEntity> extractEntities(
-        const std::string& content, 
+        std::string_view content, 
         const fs::path& filePath
     ) const = 0;
     
+    // Same, reusing a parse of the content the caller already has; methods
+    // that do not work on syntax trees ignore it
+    virtual std::vector<NamedEntity> extractEntitiesFrom(
+        const ParsedUnit& unit,
+        std::string_view content, 
+        const fs::path& filePath
+    ) const {
+        (void)unit;
+        return extractEntities(content, filePath);
+    }
+    
     // Factory method to create the appropriate NER instance based on options
     static std::unique_ptr<CodeNER> create(const SummarizationOptions& options);
 };
@@ -57,7 +69,7 @@ public:
     explicit RegexNER(const SummarizationOptions& options);
     
     std::vector<NamedEntity> extractEntities(
-        const std::string& content, 
+        std::string_view content, 
         const fs::path& filePath
     ) const override;
     
@@ -65,34 +77,33 @@ private:
     const SummarizationOptions& options_;
     
     // Specialized extraction methods
-    std::vector<NamedEntity> extractClassNames(const std::string& content, const fs::path& filePath) const;
-    std::vector<NamedEntity> extractFunctionNames(const std::string& content, const fs::path& filePath) const;
-    std::vector<NamedEntity> extractVariableNames(const std::string& content, const fs::path& filePath) const;
-    std::vector<NamedEntity> extractEnumValues(const std::string& content, const fs::path& filePath) const;
-    std::vector<NamedEntity> extractImports(const std::string& content, const fs::path& filePath) const;
+    std::vector<NamedEntity> extractClassNames(std::string_view content, const fs::path& filePath) const;
+    std::vector<NamedEntity> extractFunctionNames(std::string_view content, const fs::path& filePath) const;
+    std::vector<NamedEntity> extractVariableNames(std::string_view content, const fs::path& filePath) const;
+    std::vector<NamedEntity> extractEnumValues(std::string_view content, const fs::path& filePath) const;
+    std::vector<NamedEntity> extractImports(std::string_view content, const fs::path& filePath) const;
 };
 
-// Tree-sitter based NER for more accurate parsing
+// Tree-sitter based NER for more accurate parsing; entities are the named
+// function, class and import spans of the file's ParsedUnit
 class TreeSitterNER : public CodeNER {
 public:
     explicit TreeSitterNER(const SummarizationOptions& options);
     ~TreeSitterNER() override;
     
     std::vector<NamedEntity> extractEntities(
-        const std::string& content, 
+        std::string_view content, 
+        const fs::path& filePath
+    ) const override;
+    
+    std::vector<NamedEntity> extractEntitiesFrom(
+        const ParsedUnit& unit,
+        std::string_view content, 
         const fs::path& filePath
     ) const override;
     
 private:
     const SummarizationOptions& options_;
-    
-    // Tree-sitter specific implementation
-    struct TreeSitterImpl;
-    std::unique_ptr<TreeSitterImpl> impl_;
-    
-    // Helper methods for tree-sitter parsing
-    bool initializeParser(const fs::path& filePath) const;
-    std::string getLanguage(const fs::path& filePath) const;
 };
 
 // Machine Learning based NER using CodeBERT with ONNX Runtime
@@ -102,7 +113,7 @@ public:
     ~MLNER() override;
     
     std::vector<NamedEntity> extractEntities(
-        const std::string& content, 
+        std::string_view content, 
         const fs::path& filePath
     ) const override;
     
@@ -125,15 +136,16 @@ private:
     struct MLImpl;
     std::unique_ptr<MLImpl> impl_;
     
-    // Static cache for entity extraction results
-    static std::unordered_map<std::string, std::vector<NamedEntity>> entityCache_;
-    static std::mutex cacheMutex_;
-    
     // Helper methods for ML-based NER
     bool initializeModel() const;
     bool loadVocabulary(const std::string& vocabPath) const;
-    std::vector<int32_t> tokenize(const std::string& text) const;
-    std::vector<NamedEntity> runInference(const std::string& content, const fs::path& filePath) const;
+    std::vector<int32_t> tokenize(std::string_view text) const;
+    // Lines packed into [CLS] ... [SEP] windows of at most maxSeqLength tokens
+    std::vector<std::vector<int32_t>> packWindows(std::string_view content) const;
+    std::vector<NamedEntity> runInference(std::string_view content, const fs::path& filePath) const;
+    // One padded [B, L] run over windows[begin, end)
+    void runBatch(const std::vector<std::vector<int32_t>>& windows, size_t begin, size_t end,
+                  std::vector<NamedEntity>& entities) const;
     std::vector<std::pair<std::string, EntityType>> extractEntitiesFromLabels(
         const std::vector<std::string>& tokens,
         const std::vector<std::string>& labels
@@ -143,13 +155,44 @@ private:
     std::string getModelPath() const;
 };
 
+// Serves another backend's results from the shared EntityCache; created by
+// CodeNER::create around whichever backend the options select
+class CachedNER : public CodeNER {
+public:
+    CachedNER(std::unique_ptr<CodeNER> backend, const SummarizationOptions& options);
+    
+    std::vector<NamedEntity> extractEntities(
+        std::string_view content, 
+        const fs::path& filePath
+    ) const override;
+    
+    std::vector<NamedEntity> extractEntitiesFrom(
+        const ParsedUnit& unit,
+        std::string_view content, 
+        const fs::path& filePath
+    ) const override;
+    
+private:
+    std::unique_ptr<CodeNER> backend_;
+    uint64_t fingerprint_;      // Backend and the options its results depend on
+    
+    template <typename Extract>
+    std::vector<NamedEntity> cached(std::string_view content, const fs::path& filePath, Extract extract) const;
+};
+
 // Hybrid NER combining multiple approaches
 class HybridNER : public CodeNER {
 public:
     explicit HybridNER(const SummarizationOptions& options);
     
     std::vector<NamedEntity> extractEntities(
-        const std::string& content, 
+        std::string_view content, 
+        const fs::path& filePath
+    ) const override;
+    
+    std::vector<NamedEntity> extractEntitiesFrom(
+        const ParsedUnit& unit,
+        std::string_view content, 
         const fs::path& filePath
     ) const override;
     
@@ -160,5 +203,5 @@ private:
     std::unique_ptr<MLNER> mlNER_;
     
     // Method to determine which NER approach to use
-    CodeNER* chooseNERMethod(const std::string& content, const fs::path& filePath) const;
+    CodeNER* chooseNERMethod(std::string_view content, const fs::path& filePath) const;
 }; 
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Line-aligned pieces of a large buffer, for analyzing one file on several
+// workers. A chunk owns [begin, end) and is read through a window that starts
+// at least `overlap` bytes earlier and ends at least `overlap` bytes later,
+// rounded out to whole lines. Consumers keep what starts in the owned part and
+// drop the rest: the lead-in lets a scan resynchronize, so a match that began
+// in the previous chunk is not found again from the middle, and the tail lets
+// a comment or declaration starting near the end be seen in full. Chunks
+// cover the buffer without gaps or overlaps.
+struct ContentChunk {
+    size_t windowBegin = 0;
+    size_t begin = 0;
+    size_t end = 0;
+    size_t windowEnd = 0;
+
+    // The window as a view of the buffer it was planned for
+    std::string_view window(std::string_view content) const {
+        return content.substr(windowBegin, windowEnd - windowBegin);
+    }
+
+    // The owned part as offsets into the window
+    size_t ownedBegin() const { return begin - windowBegin; }
+    size_t ownedEnd() const { return end - windowBegin; }
+};
+
+// Split content into chunks of about chunkSize bytes, each ending after a
+// newline (or at the end of the buffer). A line longer than chunkSize stays
+// in one chunk. Empty content gives no chunks.
+std::vector<ContentChunk> splitIntoChunks(std::string_view content, size_t chunkSize, size_t overlap);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Directory tree of a set of files, built from their relative paths rather
+// than by walking the filesystem again, so it shows exactly the files that
+// were collected. It is a trie over path components: each distinct name is
+// stored once and nodes refer to it by index. Rendering is one depth-first
+// pass straight into a stream.
+class DirectoryTree {
+public:
+    // Add a file by its path relative to the root; its directories are added too
+    void add(const fs::path& relativePath);
+
+    // Write the tree, one entry per line, indented two spaces per level.
+    // Entries of a directory are sorted by name.
+    void render(std::ostream& out) const;
+    std::string render() const;
+
+    size_t fileCount() const { return fileCount_; }
+    bool empty() const { return nodes_.size() <= 1; }
+
+private:
+    static constexpr uint32_t ROOT = 0;
+
+    struct Node {
+        uint32_t name = 0;          // Index into names_
+        bool isDirectory = false;
+        std::vector<uint32_t> children;
+    };
+
+    uint32_t intern(std::string_view name);
+    uint32_t child(uint32_t parent, std::string_view name, bool isDirectory);
+
+    std::vector<Node> nodes_{Node{0, true, {}}};
+    std::deque<std::string> names_;                         // Stable storage behind nameIds_
+    std::unordered_map<std::string_view, uint32_t> nameIds_;
+    std::unordered_map<uint64_t, uint32_t> childIndex_;     // (parent, name) -> node
+    size_t fileCount_ = 0;
+};
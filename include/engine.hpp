@@ -0,0 +1,68 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include "file_processor.hpp"
+#include "file_scorer.hpp"
+#include "pattern_matcher.hpp"
+#include "tokenizer.hpp"
+
+class CodeNER;
+struct RepomixOptions;
+
+// The expensive, immutable parts of a run, built once and shared by every
+// Repomix given the engine: tokenizers (tiktoken tables), entity recognizers
+// (tree-sitter queries, ONNX sessions), the scorer's compiled patterns and the
+// default ignore patterns. Runs keep their own options; the engine hands out
+// the resources those options select, building each on first use. All
+// methods may be called from several threads at once.
+class Engine {
+public:
+    // Recognizers and scoring pattern sets kept for distinct options; the
+    // least recently used are dropped once no run holds them
+    static constexpr size_t MAX_RECOGNIZERS = 8;
+    static constexpr size_t MAX_SCORING_PATTERNS = 8;
+
+    Engine();
+
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // The default ignore patterns; copy it and add a run's own patterns
+    const PatternMatcher& defaultPatterns() const { return defaultPatterns_; }
+
+    std::shared_ptr<const Tokenizer> tokenizer(TokenizerEncoding encoding);
+
+    // Recognizer for the entity recognition fields of options, or nullptr if
+    // they do not enable entity recognition
+    std::shared_ptr<const CodeNER> codeNER(const SummarizationOptions& options);
+
+    std::shared_ptr<const FileScorer::CompiledPatterns> scoringPatterns(const FileScoringConfig& config);
+
+    // Build what runs with these options need, e.g. before the first request
+    void warmUp(const RepomixOptions& options);
+
+    struct Stats {
+        size_t hits = 0;        // Requests answered with a resource built earlier
+        size_t misses = 0;      // Resources built
+    };
+    Stats stats() const;
+
+private:
+    template <typename T>
+    using Entries = std::list<std::pair<std::string, std::shared_ptr<const T>>>;
+
+    PatternMatcher defaultPatterns_;
+
+    mutable std::mutex mutex_;
+    Entries<Tokenizer> tokenizers_;
+    Entries<CodeNER> recognizers_;
+    Entries<FileScorer::CompiledPatterns> scoringPatterns_;
+    Stats stats_;
+
+    template <typename T, typename Build>
+    std::shared_ptr<const T> lookup(Entries<T>& entries, size_t capacity, const std::string& key, Build build);
+};
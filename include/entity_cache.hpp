@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "file_processor.hpp"
+
+// In-memory cache of entity recognition results, shared by every NER backend
+// and every job of the process.
+//
+// Entries are addressed by the hash and size of the content plus a fingerprint
+// of the backend and the options it ran with, so unchanged files hit across
+// jobs and edited ones simply miss. The hash is seeded with a random value per
+// process, so no client can craft content that collides with another's. The cache is split into shards by key, each
+// with its own lock and LRU list, so workers rarely contend; each shard holds
+// at most its share of the capacity and evicts its least recently used entry.
+class EntityCache {
+public:
+    using Entities = std::vector<FileProcessor::NamedEntity>;
+
+    struct Key {
+        uint64_t contentHash = 0;
+        uint64_t contentSize = 0;
+        uint64_t fingerprint = 0;
+        bool operator==(const Key& other) const {
+            return contentHash == other.contentHash && contentSize == other.contentSize &&
+                   fingerprint == other.fingerprint;
+        }
+    };
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t entries = 0;
+        size_t capacity = 0;
+    };
+
+    static constexpr size_t DEFAULT_CAPACITY = 4096;     // Entries
+    static constexpr size_t DEFAULT_SHARDS = 16;
+
+    explicit EntityCache(size_t capacity = DEFAULT_CAPACITY, size_t shardCount = DEFAULT_SHARDS);
+
+    // The process-wide cache used by the NER backends
+    static EntityCache& instance();
+
+    static Key makeKey(std::string_view content, uint64_t fingerprint);
+
+    // Copy a cached result into entities; returns false on a miss
+    bool lookup(const Key& key, Entities& entities);
+
+    // Store a result, replacing any previous one for the key
+    void store(const Key& key, Entities entities);
+
+    Stats stats() const;
+    void clear();
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(key.contentHash ^ (key.fingerprint * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<std::pair<Key, Entities>> entries;     // Most recently used first
+        std::unordered_map<Key, std::list<std::pair<Key, Entities>>::iterator, KeyHash> index;
+    };
+
+    Shard& shardFor(const Key& key);
+
+    size_t capacity_;
+    size_t shardCapacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+    std::atomic<size_t> evictions_{0};
+};
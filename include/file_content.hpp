@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+// Read-only view of a file's bytes. The bytes live in an mmap region, a
+// pooled read buffer or an owned string; copies of a FileContent share that
+// storage, which is released together with the last copy. NER, summarization,
+// tokenization and the output writer all read through view(), so a file is
+// never copied after it has been read.
+class FileContent {
+public:
+    enum class Backing {
+        Empty,
+        Owned,      // std::string moved into the handle
+        Mapped,     // mmap of the file
+        Pooled,     // Buffer borrowed from a process-wide pool
+        Shared      // Bytes kept alive by another object, e.g. a request body
+    };
+
+    // Files above this size are mapped instead of read
+    static constexpr size_t DEFAULT_MMAP_THRESHOLD = 1 * 1024 * 1024; // 1 MB
+
+    FileContent() = default;
+    explicit FileContent(std::string data);
+
+    // Load a whole file. Throws std::runtime_error if it cannot be read.
+    static FileContent load(const fs::path& path, size_t mmapThreshold = DEFAULT_MMAP_THRESHOLD);
+
+    // Map size bytes of an open descriptor; the descriptor is not closed.
+    // Throws std::runtime_error if the mapping fails.
+    static FileContent map(int fd, size_t size, const fs::path& path);
+
+    // Read size bytes of an open descriptor into a pooled buffer; the
+    // descriptor is not closed. Throws std::runtime_error on read errors.
+    static FileContent read(int fd, size_t size, const fs::path& path);
+
+    // View bytes that owner keeps alive; the handle holds a reference to owner
+    static FileContent share(std::shared_ptr<const void> owner, std::string_view view);
+
+    // Bytes [offset, offset + length) of this content, sharing its storage.
+    // Throws std::out_of_range if the range is not inside the content.
+    FileContent slice(size_t offset, size_t length) const;
+
+    std::string_view view() const { return view_; }
+    operator std::string_view() const { return view_; }
+
+    const char* data() const { return view_.data(); }
+    size_t size() const { return view_.size(); }
+    bool empty() const { return view_.empty(); }
+    size_t find(std::string_view needle, size_t pos = 0) const { return view_.find(needle, pos); }
+
+    // Copy of the bytes, for APIs that need a std::string
+    std::string str() const { return std::string(view_); }
+
+    Backing backing() const { return backing_; }
+
+    // Drop this handle's reference to the storage
+    void reset();
+
+    friend bool operator==(const FileContent& a, const FileContent& b) { return a.view_ == b.view_; }
+    friend bool operator==(const FileContent& a, std::string_view b) { return a.view_ == b; }
+    friend bool operator!=(const FileContent& a, std::string_view b) { return a.view_ != b; }
+
+    // Backing storage; defined in file_content.cpp
+    struct Storage;
+
+private:
+    friend class FileIngest;
+
+    std::shared_ptr<const Storage> storage_;
+    std::string_view view_;
+    Backing backing_ = Backing::Empty;
+
+    FileContent(std::shared_ptr<const Storage> storage, std::string_view view, Backing backing);
+};
+
+// Reads one file with a single open: openat + fstat, then the first block,
+// so the caller can reject the file (size, binary content) before the rest
+// is read. readAll() keeps the first block and the descriptor: small files
+// are read into one pooled buffer that starts with the probed block, large
+// ones are mapped and probed through the mapping.
+class FileIngest {
+public:
+    // Bytes examined by probe(); binary detection looks at no more than this
+    static constexpr size_t PROBE_SIZE = 8 * 1024;
+
+    explicit FileIngest(size_t mmapThreshold = FileContent::DEFAULT_MMAP_THRESHOLD)
+        : mmapThreshold_(mmapThreshold) {}
+    ~FileIngest();
+
+    FileIngest(const FileIngest&) = delete;
+    FileIngest& operator=(const FileIngest&) = delete;
+
+    // Open path (relative to dirFd unless absolute). False, with errno set,
+    // if it cannot be opened or is not a regular file.
+    bool open(const fs::path& path, int dirFd = AT_FDCWD);
+
+    const struct stat& stat() const { return stat_; }
+    size_t size() const { return static_cast<size_t>(stat_.st_size); }
+
+    // First min(size, PROBE_SIZE) bytes. Throws std::runtime_error on read errors.
+    std::string_view probe();
+
+    // The whole file, continuing after the probed block. The handle is done
+    // afterwards. Throws std::runtime_error on read or mmap errors.
+    FileContent readAll();
+
+private:
+    size_t mmapThreshold_;
+    fs::path path_;
+    int fd_ = -1;
+    struct stat stat_{};
+
+    std::shared_ptr<FileContent::Storage> buffer_;   // Pooled buffer for small files
+    char* bufferData_ = nullptr;
+    size_t filled_ = 0;
+    FileContent mapped_;                             // Mapping for large files
+    bool probed_ = false;
+
+    void fill(size_t upTo);
+};
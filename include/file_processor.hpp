@@ -15,7 +15,15 @@
 #include <sstream>
 #include <unordered_set>
 #include <functional>
+#include <atomic>
+#include <chrono>
 #include "pattern_matcher.hpp"
+#include "work_stealing_pool.hpp"
+#include "file_content.hpp"
+#include "parsed_unit.hpp"
+#include "string_pool.hpp"
+#include "virtual_file_system.hpp"
+#include <nlohmann/json.hpp>
 
 namespace fs = std::filesystem;
 
@@ -33,6 +41,12 @@ struct SummarizationOptions {
     size_t fileSizeThreshold = 10240;    // Files larger than this (in bytes) will be summarized
     int maxSummaryLines = 200;           // Maximum lines to include in the summary
     
+    // Files larger than chunkThreshold bytes are analyzed in line-aligned chunks
+    // spread over the workers instead of in one piece (0 = never)
+    size_t chunkThreshold = 4 * 1024 * 1024;
+    size_t chunkSize = 512 * 1024;       // Bytes per chunk
+    size_t chunkOverlap = 4096;          // Bytes each chunk reads past its end
+    
     // Named Entity Recognition options
     bool includeEntityRecognition = false;  // Enable Named Entity Recognition
     
@@ -49,9 +63,11 @@ struct SummarizationOptions {
     bool useMLForLargeFiles = false;       // Use ML for large files (hybrid mode)
     size_t mlNerSizeThreshold = 102400;    // 100KB threshold for ML-NER
     std::string mlModelPath = "";          // Path to ONNX model (empty = use bundled)
-    bool cacheMLResults = true;            // Cache ML results to avoid repeat processing
+    bool cacheMLResults = true;            // Cache entity recognition results in memory (all NER methods)
     float mlConfidenceThreshold = 0.7;     // Confidence threshold for ML predictions
     int maxMLProcessingTimeMs = 5000;      // Maximum time to spend on ML processing before fallback
+    int mlBatchSize = 16;                  // Token windows per inference run
+    int mlIntraOpThreads = 2;              // Threads ONNX Runtime uses within one run
     
     // Entity types to include
     bool includeClassNames = true;       // Include class names in entity list
@@ -67,37 +83,13 @@ struct SummarizationOptions {
     bool generateEntityGraph = false;         // Generate a visual graph of entities and relationships
 };
 
-// Forward declaration for CodeNER
+// Forward declarations
 class CodeNER;
+class ResultCache;
+class Tokenizer;
 
 class FileProcessor {
 public:
-    // Forward declare NamedEntity to use in ProcessedFile
-    struct NamedEntity;
-    
-    struct ProcessedFile {
-        fs::path path;
-        std::string content;
-        size_t lineCount = 0;
-        size_t byteSize = 0;
-        bool isSummarized = false;      // Flag to indicate if the file has been summarized
-        
-        // Additional fields for optimized processing
-        std::string filename;           // Filename without path
-        std::string extension;          // File extension
-        std::string error;              // Error message if processing failed
-        bool processed = false;         // Flag to indicate successful processing
-        bool skipped = false;           // Flag to indicate file was skipped
-        
-        // Content summary fields
-        std::string firstLines;         // First N lines of the file
-        std::string snippets;           // Representative snippets
-        
-        // Entity recognition fields
-        std::vector<NamedEntity> entities;  // Named entities found in the file
-        std::string formattedEntities;      // Formatted entity text
-    };
-
     // Named Entity for code elements
     struct NamedEntity {
         std::string name;
@@ -116,6 +108,43 @@ public:
         // Constructor for easy creation
         NamedEntity(const std::string& n, EntityType t) : name(n), type(t) {}
     };
+    
+    // Entity kept with a processed file; the name is interned in the run's StringPool
+    struct EntityRef {
+        std::string_view name;
+        NamedEntity::EntityType type = NamedEntity::EntityType::Other;
+    };
+    
+    struct ProcessedFile {
+        fs::path path;
+        FileContent content;            // Shared view of the file; copies do not copy the bytes
+        size_t lineCount = 0;
+        size_t byteSize = 0;
+        bool isSummarized = false;      // Flag to indicate if the file has been summarized
+        std::string summary;            // Summary emitted instead of the content when isSummarized
+        size_t tokenCount = 0;          // Tokens in the emitted body (summary or content), if a tokenizer is set
+        uint64_t contentHash = 0;       // ResultCache::contentHash of the content
+        
+        // File with identical content that is analyzed and emitted instead; a
+        // copy is only referred to in the output. Empty for unique files.
+        fs::path duplicateOf;
+        
+        // Additional fields for optimized processing
+        std::string error;              // Error message if processing failed
+        bool processed = false;         // Flag to indicate successful processing
+        bool skipped = false;           // Flag to indicate file was skipped
+        
+        // Arena of the run that produced the file; keeps the views below valid
+        std::shared_ptr<StringPool> strings;
+        
+        // Content summary fields
+        std::string_view firstLines;    // First N lines of the file
+        std::string_view snippets;      // Representative snippets
+        
+        // Entity recognition fields
+        std::vector<EntityRef> entities;    // Named entities found in the file
+        std::string_view formattedEntities; // Formatted entity text
+    };
 
     // Progress reporting structure
     struct ProgressInfo {
@@ -138,6 +167,14 @@ public:
     
     // Define progress callback type
     using ProgressCallback = std::function<void(const ProgressInfo&)>;
+    
+    // How often workers publish progress. Counters are always current (see
+    // getCurrentProgress); only the callback and the console line are throttled.
+    struct ProgressOptions {
+        std::chrono::milliseconds interval{100};  // At most one report per interval...
+        size_t everyFiles = 0;                    // ...or after this many files (0 = time only)
+        bool logToConsole = true;                 // Print [Progress] lines with each report
+    };
 
     explicit FileProcessor(const PatternMatcher& patternMatcher, 
                         unsigned int numThreads = std::thread::hardware_concurrency());
@@ -155,12 +192,60 @@ public:
     // Process a single file
     ProcessedFile processFile(const fs::path& filePath) const;
     
+    /**
+     * @brief Process an explicit list of files on the worker pool
+     * 
+     * @param files Files to process
+     * @return std::vector<ProcessedFile> One result per file, in the order given
+     */
+    std::vector<ProcessedFile> processFiles(const std::vector<fs::path>& files);
+    
     // Set summarization options
     void setSummarizationOptions(const SummarizationOptions& options);
+    
+    // Analyze each distinct content once per run (off by default). Of identical
+    // files the one with the smallest path is analyzed; the others only get
+    // their line count and duplicateOf.
+    void setDeduplicate(bool deduplicate);
 
+    // Reuse results of earlier runs; pass nullptr to disable
+    void setResultCache(std::shared_ptr<ResultCache> cache);
+    
+    // Read directories and files below fileSystem->root() from fileSystem
+    // instead of the disk; pass nullptr to read from the disk again
+    void setFileSystem(std::shared_ptr<const VirtualFileSystem> fileSystem);
+    
+    // Count the tokens of each file's emitted body on the worker that
+    // processes it (ProcessedFile::tokenCount); pass nullptr to disable
+    void setTokenizer(std::shared_ptr<const Tokenizer> tokenizer);
+    
+    // Recognize entities with ner, built for the current summarization options
+    // and possibly shared with other processors (see Engine), instead of
+    // creating a recognizer; setSummarizationOptions drops it
+    void setCodeNER(std::shared_ptr<const CodeNER> ner);
+    
+    // Time workers spent counting tokens during the last run, summed over workers
+    std::chrono::nanoseconds getTokenizationTime() const;
+    
+    // Keep file content in the results (default). When off, content is dropped
+    // once a file is processed and readContent() loads it again for output.
+    void setKeepContent(bool keep);
+    
+    // Content of a processed file: the retained view, or a fresh read from disk
+    FileContent readContent(const ProcessedFile& file) const;
+    
+    // Whether two processed files hold the same bytes; equal content hashes
+    // are only a hint, since XXH64 collisions can be crafted
+    bool hasSameContent(const ProcessedFile& a, const ProcessedFile& b) const;
+    
     // Summarize a file based on the current summarization options
     std::string summarizeFile(const ProcessedFile& file) const;
     
+    // Summarize a file whatever its size, because its full content does not fit
+    // a token budget. Sets summary, isSummarized and tokenCount; returns false
+    // (leaving the file as it was) if the summary would not be shorter.
+    bool summarizeToFit(ProcessedFile& file) const;
+    
     // Check if a file is a README file
     bool isReadmeFile(const fs::path& filePath) const;
 
@@ -176,31 +261,83 @@ public:
     // Set a callback for progress updates
     void setProgressCallback(ProgressCallback callback);
     
+    // Set how often progress is reported; call between runs
+    void setProgressOptions(const ProgressOptions& options);
+    
     // Get current progress information
     ProgressInfo getCurrentProgress() const;
 
 private:
     const PatternMatcher& patternMatcher_;
     unsigned int numThreads_;
-    std::vector<std::thread> workers_;
-    std::queue<fs::path> fileQueue_;
-    std::vector<ProcessedFile> results_;
-    std::mutex queueMutex_;
-    std::mutex resultsMutex_;
-    bool done_;
     SummarizationOptions summarizationOptions_;
     
+    // Tree read instead of the disk (optional)
+    std::shared_ptr<const VirtualFileSystem> fileSystem_;
+    
+    // Persistent per-file result cache (optional)
+    std::shared_ptr<ResultCache> resultCache_;
+    uint64_t cacheFingerprint_ = 0;
+    uint64_t computeCacheFingerprint() const;
+    nlohmann::json cachedResultToJson(const ProcessedFile& file) const;
+    bool restoreCachedResult(const nlohmann::json& cached, ProcessedFile& file) const;
+    
+    // Per-file token counting (optional)
+    std::shared_ptr<const Tokenizer> tokenizer_;
+    mutable std::atomic<int64_t> tokenizationNanos_{0};
+    
     // CodeNER instance for entity recognition
-    mutable std::unique_ptr<CodeNER> codeNER_;
+    mutable std::shared_ptr<const CodeNER> codeNER_;
+    
+    // Worker pool shared by collection and processing (created on first use)
+    std::unique_ptr<WorkStealingPool> pool_;
+    WorkStealingPool& getPool();
+    
+    // Per-worker result buffers, merged once all tasks have finished
+    std::vector<std::vector<ProcessedFile>> workerResults_;
+    
+    // Arena for the text of the current run's results; each run starts a new
+    // one, which is freed with the last result that refers to it
+    std::shared_ptr<StringPool> strings_;
+    
+    // Files handed to the pool per task during collection
+    static constexpr size_t DEFAULT_BATCH_SIZE = 100;
+    
+    // Run lifecycle: reset state, then wait for the pool and merge results
+    void beginRun();
+    std::vector<ProcessedFile> finishRun();
+    
+    // Collect files to process on the calling thread
+    void collectFiles(const fs::path& dir, size_t batchSize);
+    void collectVirtualFiles(const fs::path& dir, size_t batchSize);
+    
+    // Submit collected files to the pool as one task
+    void submitFileBatch(std::vector<fs::path> files);
+    
+    // Process one file on a worker and store the result in that worker's buffer
+    void processQueuedFile(const fs::path& filePath, unsigned int workerIndex);
+    
+    // Process a file on a worker, updating progress counters
+    ProcessedFile processAndCountFile(const fs::path& filePath);
     
-    // Thread worker function
-    void workerThread();
+    // processFile, optionally skipping the analysis of content already claimed in this run
+    ProcessedFile ingestFile(const fs::path& filePath, bool deduplicate) const;
     
-    // Collect files to process
-    void collectFiles(const fs::path& dir);
+    // Owners of the contents seen in the current run, by content hash
+    struct ContentOwner {
+        fs::path path;
+        size_t size = 0;
+    };
+    bool deduplicate_ = false;
+    mutable std::mutex contentOwnersMutex_;
+    mutable std::unordered_map<uint64_t, ContentOwner> contentOwners_;
+    
+    // Claim the file's content; returns the path of a smaller-path file that
+    // already owns identical content, or an empty path if this file owns it now
+    fs::path claimContent(const ProcessedFile& file) const;
     
     // Helper methods
-    size_t countLines(const std::string& content) const;
+    size_t countLines(std::string_view content) const;
     bool shouldProcessFile(const fs::path& filePath) const;
     
     // Memory mapped file processing
@@ -210,82 +347,89 @@ private:
     bool shouldUseMemoryMapping(const fs::path& filePath) const;
 
     // Summarization helper methods
-    std::string extractFirstNLines(const std::string& content, int n) const;
-    std::string extractSignatures(const std::string& content, const fs::path& filePath) const;
-    std::string extractDocstrings(const std::string& content) const;
-    std::string extractRepresentativeSnippets(const std::string& content, int count) const;
+    std::string extractFirstNLines(std::string_view content, int n) const;
+    // Regex fallbacks only report matches starting in [from, limit) (see ContentChunk)
+    std::string extractSignatures(std::string_view content, const fs::path& filePath, const ParsedUnit& unit,
+                                  size_t from = 0, size_t limit = std::string_view::npos) const;
+    std::string extractDocstrings(std::string_view content, const ParsedUnit& unit,
+                                  size_t from = 0, size_t limit = std::string_view::npos) const;
+    std::string extractRepresentativeSnippets(std::string_view content, int count) const;
     bool shouldSummarizeFile(const ProcessedFile& file) const;
+    ParsedUnit parseUnit(const ProcessedFile& file, bool forSummary) const;
+    
+    // Entities, signatures and docstrings of a file too large to analyze in one
+    // piece, gathered chunk by chunk on the worker pool
+    struct ChunkAnalysis {
+        std::vector<NamedEntity> entities;  // Unfiltered, first occurrence of each
+        std::string signatures;
+        std::string docstrings;
+    };
+    bool shouldAnalyzeInChunks(const ProcessedFile& file) const;
+    ChunkAnalysis analyzeInChunks(const ProcessedFile& file, bool forSummary) const;
+    
+    // Summary from a parse of the file, or from its chunks if given
+    std::string buildSummary(const ProcessedFile& file, const ParsedUnit& unit,
+                             const ChunkAnalysis* chunks = nullptr) const;
+    
+    // Summary of a loaded file, chunked or parsed as its size calls for
+    std::string summarizeContent(const ProcessedFile& file) const;
     
     // Get or create the CodeNER instance
-    CodeNER* getCodeNER() const;
+    const CodeNER* getCodeNER() const;
     
-    // Format entities as a string
-    std::string formatEntities(const std::vector<NamedEntity>& entities, bool groupByType) const;
+    // Format entities (NamedEntity or EntityRef) as a string
+    template <typename Entity>
+    std::string formatEntities(const std::vector<Entity>& entities, bool groupByType) const;
     
     // Extract named entities from content
-    std::vector<NamedEntity> extractNamedEntities(const std::string& content, const fs::path& filePath) const;
+    std::vector<NamedEntity> extractNamedEntities(std::string_view content, const fs::path& filePath,
+                                                  const ParsedUnit& unit) const;
+    
+    // Drop the entity types the options exclude and cap the count at maxEntities
+    std::vector<NamedEntity> selectEntities(std::vector<NamedEntity> entities) const;
 
     // Maximum file size to process (100 MB)
     static constexpr size_t MAX_FILE_SIZE = 100 * 1024 * 1024;
     
     // File type detection
-    bool isBinaryFile(const fs::path& filePath) const;
+    static bool hasBinaryExtension(const fs::path& filePath);
+    static bool isBinaryContent(std::string_view block);
     
     // Optimized file reading methods
-    std::string readFile(const fs::path& filePath) const;
-    std::string readLargeFile(const fs::path& filePath, uintmax_t fileSize) const;
-    
-    // Pre-allocated buffer for file reading to reduce memory allocations
-    std::vector<char> fileReadBuffer_;
+    FileContent readFile(const fs::path& filePath) const;
 
     // Content flags
     bool keepContent_ = true;
     bool performNER_ = true;
 
     /**
-     * @brief Collects files in parallel from directories
-     * 
-     * @param dir Root directory to start collection from
-     * @param batchSize Size of batches when adding files to the queue
-     */
-    void collectFilesParallel(const fs::path& dir, size_t batchSize);
-    
-    /**
-     * @brief Worker function for parallel file collection
+     * @brief Pool task that scans one directory and submits its files and subdirectories
      * 
+     * @param dir Directory to scan
      * @param batchSize Size of batches when adding files to the queue
      */
-    void fileCollectorWorker(size_t batchSize);
-    
-    /**
-     * @brief Add a directory to the directory queue for parallel processing
-     * 
-     * @param dir Directory to add
-     */
-    void addDirectoryToQueue(const fs::path& dir);
-    
-    // Queue of directories to be processed in parallel
-    std::queue<fs::path> directoryQueue_;
-    
-    // Mutex for directory queue access
-    std::mutex dirQueueMutex_;
+    void scanDirectory(const fs::path& dir, size_t batchSize);
+
+    // Progress counters, updated lock-free by the workers
+    std::atomic<size_t> totalFiles_{0};
+    std::atomic<size_t> processedFiles_{0};
+    std::atomic<size_t> skippedFiles_{0};
+    std::atomic<size_t> errorFiles_{0};
+    std::atomic<bool> progressComplete_{false};
     
-    // Condition variable for directory queue
-    std::condition_variable dirQueueCondition_;
+    // Report throttling: the next report is due at this steady-clock time (ns),
+    // or once filesSinceReport_ reaches progressOptions_.everyFiles
+    ProgressOptions progressOptions_;
+    std::atomic<int64_t> nextReportNanos_{0};
+    std::atomic<size_t> filesSinceReport_{0};
     
-    // Signal for directory collectors to finish
-    std::atomic<bool> dirCollectionDone_{false};
-
-    // Progress tracking members
-    ProgressInfo progress_;
-    std::mutex progressMutex_;
+    // Serializes progress reports and guards currentFile_/progressCallback_
+    mutable std::mutex progressMutex_;
+    std::string currentFile_;
     ProgressCallback progressCallback_ = nullptr;
     
     // Helper methods for progress tracking
-    void updateProgress(size_t totalFiles);
-    void incrementProcessedFiles(const fs::path& currentFile = {});
-    void incrementSkippedFiles();
-    void incrementErrorFiles();
     void setProgressComplete(bool complete = true);
-    void reportProgress();
+    void reportProgress(const fs::path& currentFile);
+    void emitProgressLocked();
 };
\ No newline at end of file
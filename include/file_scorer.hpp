@@ -6,14 +6,24 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <mutex>
+#include <memory>
+#include <regex>
+#include <thread>
+#include <ctime>
+#include <cstdint>
 #include <nlohmann/json.hpp>
 #include <functional>
 #include "pattern_matcher.hpp"
+#include "parsed_unit.hpp"
+#include "virtual_file_system.hpp"
+#include <optional>
 
 namespace fs = std::filesystem;
 
 // Forward declarations
 class FileProcessor;
+class WorkStealingPool;
+class ResultCache;
 struct SummarizationOptions;
 
 // Configuration for the file scoring system
@@ -88,8 +98,25 @@ public:
         bool included;  // Whether the file is included based on score threshold
     };
 
-    // Constructor
-    explicit FileScorer(const FileScoringConfig& config = FileScoringConfig());
+    // Constructor; scoreRepository spreads per-file work over numThreads workers
+    // The regexes compiled from a config's file and directory patterns;
+    // immutable, so scorers with the same patterns can share them (see Engine)
+    struct CompiledPatterns {
+        std::vector<std::regex> importantFiles;
+        std::vector<std::regex> importantDirs;
+        std::vector<std::regex> testFiles;
+        std::vector<std::regex> entryPoints;
+    };
+    static std::shared_ptr<const CompiledPatterns> compilePatterns(const FileScoringConfig& config);
+    
+    // Identifies the patterns compilePatterns builds from config
+    static std::string patternsKey(const FileScoringConfig& config);
+
+    // patterns must have been compiled from config; nullptr compiles them here
+    explicit FileScorer(const FileScoringConfig& config = FileScoringConfig(),
+                        unsigned int numThreads = std::thread::hardware_concurrency(),
+                        std::shared_ptr<const CompiledPatterns> patterns = nullptr);
+    ~FileScorer();
     
     // Set the configuration
     void setConfig(const FileScoringConfig& config);
@@ -108,17 +135,66 @@ public:
 
     // Get the current configuration
     const FileScoringConfig& getConfig() const;
+    
+    // Reuse content-derived scores of earlier runs; pass nullptr to disable
+    void setResultCache(std::shared_ptr<ResultCache> cache);
+    
+    // Score the files of fileSystem instead of the disk; pass nullptr to disable
+    void setFileSystem(std::shared_ptr<const VirtualFileSystem> fileSystem);
 
 private:
+    // Everything scoring needs to know about one file, gathered with a single
+    // stat and at most one read
+    struct FileInfo {
+        fs::path path;
+        fs::path relPath;           // Relative to the repository root
+        uintmax_t size = 0;
+        std::time_t modifiedTime = 0;
+        std::string content;        // Only loaded for source files
+        bool contentLoaded = false;
+        
+        // Syntax of content, parsed by whichever analysis needs it first and
+        // then shared by density and imports; dropped together with content
+        mutable std::optional<ParsedUnit> unit;
+        const ParsedUnit& parsed() const {
+            if (!unit) {
+                unit = ParsedUnit::parse(content, path);
+            }
+            return *unit;
+        }
+    };
+    
+    // Files found by the repository walk, used to resolve imports without touching the disk
+    struct FileIndex {
+        std::unordered_map<std::string, std::vector<std::string>> filesByName;  // Name -> relative paths
+        std::unordered_set<std::string> relPaths;
+        
+        void add(const fs::path& relPath);
+    };
+    
     FileScoringConfig config_;
     std::unique_ptr<PatternMatcher> patternMatcher_;
+    unsigned int numThreads_;
+    std::unique_ptr<WorkStealingPool> pool_;
+    std::shared_ptr<ResultCache> resultCache_;
+    std::shared_ptr<const VirtualFileSystem> fileSystem_;
+    
+    // Configured patterns, compiled once so worker threads only read them
+    std::shared_ptr<const CompiledPatterns> patterns_;
+    std::vector<FileInfo> listFiles(const fs::path& repoPath, FileIndex& index) const;
+    static std::regex globToRegex(const std::string& pattern);
+    
+    // Single stat plus (for source files) a single read
+    bool loadFileInfo(FileInfo& info, bool needImports) const;
+    ScoredFile scoreFileInfo(const FileInfo& info);
     
     // Scoring components
-    float scoreProjectStructure(const fs::path& filePath, const fs::path& repoRoot);
+    float scoreProjectStructure(const FileInfo& info);
     float scoreFileType(const fs::path& filePath);
-    float scoreRecency(const fs::path& filePath);
-    float scoreFileSize(const fs::path& filePath);
-    float scoreCodeDensity(const fs::path& filePath);
+    float scoreRecency(std::time_t modifiedTime);
+    float scoreFileSize(uintmax_t fileSize);
+    float scoreCodeDensity(const FileInfo& info);
+    float cachedCodeDensity(const FileInfo& info);
     
     // Helper methods
     bool isSourceCodeFile(const fs::path& filePath) const;
@@ -126,24 +202,21 @@ private:
     bool isDocumentationFile(const fs::path& filePath) const;
     bool isTestFile(const fs::path& filePath) const;
     bool isEntryPoint(const fs::path& filePath) const;
-    bool matchesAnyPattern(const std::string& pathStr, const std::vector<std::string>& patterns) const;
+    bool matchesAnyPattern(const std::string& pathStr, const std::vector<std::regex>& patterns) const;
     float calculateImportanceByLocation(const fs::path& filePath, const fs::path& repoRoot) const;
     
     // Dependency graph analysis
-    std::unordered_map<std::string, std::vector<std::string>> buildDependencyGraph(const fs::path& repoRoot);
-    float calculateConnectivityScore(const fs::path& filePath, 
-                                    const std::unordered_map<std::string, std::vector<std::string>>& depGraph);
+    std::vector<std::string> extractImports(const FileInfo& info, const FileIndex& index) const;
+    float calculateConnectivityScore(size_t connections) const;
     
     // Import path resolution
     std::string resolveImportPath(const std::string& importPath, 
-                               const fs::path& sourceFile, 
-                               const fs::path& repoRoot,
-                               const std::unordered_map<std::string, std::vector<fs::path>>& filesByName);
+                                  const FileInfo& sourceFile,
+                                  const FileIndex& index) const;
     
     // TreeSitter integration helper
-    float analyzeWithTreeSitter(const fs::path& filePath);
+    float analyzeWithTreeSitter(const FileInfo& info);
     
-    // Fallback methods for file analysis without tree-sitter
+    // Fallback method for file analysis without tree-sitter
     float analyzeFileContent(const fs::path& filePath, const std::string& content);
-    float analyzeFileContent(const fs::path& filePath);
-}; 
\ No newline at end of file
+}; 
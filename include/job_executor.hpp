@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Runs long jobs (clone + Repomix::run) on a fixed number of job slots.
+//
+// At most maxConcurrentJobs run at once and at most maxQueuedJobs wait behind
+// them; submit() refuses anything beyond that so the caller can answer "busy"
+// right away. The CPU budget is split evenly between the slots and each job is
+// told how many threads it may use, so the total never exceeds the budget no
+// matter how many requests arrive.
+class JobExecutor {
+public:
+    struct Config {
+        unsigned int maxConcurrentJobs = 2;
+        size_t maxQueuedJobs = 32;
+        unsigned int cpuBudget = std::thread::hardware_concurrency();
+        size_t maxRetainedJobs = 256;   // Finished jobs remembered for getState
+    };
+
+    enum class JobState {
+        Queued,
+        Running,
+        Finished
+    };
+
+    // Receives the number of threads the job may use
+    using Task = std::function<void(unsigned int numThreads)>;
+
+    explicit JobExecutor(const Config& config);
+    ~JobExecutor();
+
+    JobExecutor(const JobExecutor&) = delete;
+    JobExecutor& operator=(const JobExecutor&) = delete;
+
+    // Queue a task under jobId. Returns false (and drops the task) if the queue is full.
+    bool submit(const std::string& jobId, Task task);
+
+    // State of a job; false if the id is unknown (or finished long ago)
+    bool getState(const std::string& jobId, JobState& state) const;
+
+    size_t queuedJobs() const;
+    size_t runningJobs() const;
+
+    // Threads granted to each job: the CPU budget divided by the number of slots
+    unsigned int threadsPerJob() const { return threadsPerJob_; }
+
+    const Config& config() const { return config_; }
+
+    static const char* stateName(JobState state);
+
+private:
+    struct QueuedJob {
+        std::string id;
+        Task task;
+    };
+
+    Config config_;
+    unsigned int threadsPerJob_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable jobAvailable_;
+    std::deque<QueuedJob> queue_;
+    std::unordered_map<std::string, JobState> states_;
+    std::deque<std::string> finishedOrder_;
+    size_t running_ = 0;
+    bool stopping_ = false;
+
+    std::vector<std::thread> workers_;
+
+    void workerLoop();
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+#include "regex_engine.hpp"
+
+namespace fs = std::filesystem;
+
+// Languages the pattern-based analyses know about
+enum class Language {
+    Unknown,
+    C,
+    Cpp,
+    Python,
+    JavaScript,     // Also TypeScript
+    Java,
+    Ruby,
+    Php,
+    Go,
+    Rust
+};
+
+// Language of a file from its extension; one table lookup
+Language languageOf(const fs::path& filePath);
+
+inline bool isCFamily(Language language) {
+    return language == Language::C || language == Language::Cpp;
+}
+
+// A signature pattern of the regex fallback in FileProcessor::extractSignatures
+struct SignaturePattern {
+    Regex regex;
+    const char* suffix = "";    // Appended to each match
+    bool cutAtBrace = false;    // Keep the match up to its first '{'; the suffix is only added if there is one
+};
+
+// The regex tables of one language, compiled once per process and shared by
+// every thread. A pattern a language does not have matches nothing.
+struct LanguageRules {
+    // RegexNER; the name is capture group 1
+    Regex classNames;
+    std::vector<Regex> functionNames;
+    std::vector<std::string_view> functionStopWords;    // Keywords the function patterns also catch
+    Regex variableNames;
+    std::vector<std::string_view> variableStopWords;
+    Regex enumNames;
+    Regex importNames;
+
+    // FileProcessor::extractSignatures without a parsed unit, in output order
+    std::vector<SignaturePattern> signatures;
+
+    // FileScorer::analyzeFileContent, matched against each trimmed line
+    Regex functionLine;
+    Regex classLine;
+    Regex importLine;
+    Regex commentStart;
+    Regex commentEnd;
+
+    // FileScorer::extractImports; the path or module is capture group 1
+    std::vector<Regex> imports;
+    bool hasMultiLineImports = false;
+    Regex multiLineImportStart;         // Group 1 is the source if it is on the first line
+    Regex multiLineImportEnd;           // Group 1 is the source if it is on the last line
+};
+
+const LanguageRules& rulesFor(Language language);
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Process-wide counters and latency histograms for the stages of a run.
+//
+// Every thread records into its own cache-line aligned slot with relaxed
+// atomic adds, so instrumenting a hot path costs two clock reads and a few
+// uncontended increments. Readers sum the slots into a Snapshot; the
+// difference of two snapshots is what one run did (exactly so when only one
+// run is active, as in the CLI), and the server renders the running totals
+// in the Prometheus text format.
+class Metrics {
+public:
+    enum class Stage {
+        Traversal,      // Scanning one directory, .gitignore loading included
+        Open,           // open + fstat of a file
+        Read,           // Reading file content
+        BinaryCheck,    // Extension and first-block binary detection
+        NerRegex,       // Entity recognition, per configured backend
+        NerTreeSitter,
+        NerMl,
+        NerHybrid,
+        Summarize,      // Building one file's summary
+        Tokenize,       // Counting one body's tokens
+        Format,         // Formatting a whole output
+        Scoring,        // Scoring a whole repository
+        COUNT
+    };
+
+    enum class Counter {
+        DirectoriesScanned,
+        FilesOpened,
+        BytesRead,
+        BinaryFilesSkipped,
+        PoolTasksRun,
+        WorkerIdleNanos,    // Time pool workers slept waiting for tasks
+        ChunksAnalyzed,     // Chunks of files too large to analyze in one piece
+        DuplicateFiles,     // Files whose content another file of the run already had
+        COUNT
+    };
+
+    enum class Gauge {
+        PoolQueuedTasks,    // Tasks sitting in a pool deque, over all pools
+        PoolBusyWorkers,    // Workers running a task, over all pools
+        COUNT
+    };
+
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::COUNT);
+    static constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+    static constexpr size_t GAUGE_COUNT = static_cast<size_t>(Gauge::COUNT);
+
+    // Upper bounds of the latency buckets, in seconds; a last bucket takes the rest
+    static constexpr std::array<double, 8> BUCKET_BOUNDS = {1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1.0, 10.0};
+    static constexpr size_t BUCKET_COUNT = BUCKET_BOUNDS.size() + 1;
+
+    struct StageTotals {
+        uint64_t count = 0;
+        uint64_t nanos = 0;
+        std::array<uint64_t, BUCKET_COUNT> buckets{};   // Not cumulative
+    };
+
+    struct Snapshot {
+        std::array<StageTotals, STAGE_COUNT> stages{};
+        std::array<uint64_t, COUNTER_COUNT> counters{};
+        std::array<int64_t, GAUGE_COUNT> gauges{};
+
+        // Totals accumulated since earlier; gauges keep their current value
+        Snapshot since(const Snapshot& earlier) const;
+
+        const StageTotals& stage(Stage s) const { return stages[static_cast<size_t>(s)]; }
+        uint64_t counter(Counter c) const { return counters[static_cast<size_t>(c)]; }
+        int64_t gauge(Gauge g) const { return gauges[static_cast<size_t>(g)]; }
+    };
+
+    // Records the time from construction to destruction against a stage, and as a
+    // span of the run's trace when one is recorded (see TraceRecorder). The path,
+    // if given, labels the span and must outlive the timer.
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Stage stage, const std::filesystem::path* detail = nullptr)
+            : stage_(stage), detail_(detail), start_(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Stage stage_;
+        const std::filesystem::path* detail_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    static Metrics& instance();
+
+    void record(Stage stage, std::chrono::nanoseconds elapsed);
+    void add(Counter counter, uint64_t amount = 1);
+    void adjust(Gauge gauge, int64_t delta);
+
+    Snapshot snapshot() const;
+
+    // Prometheus text exposition of the running totals, metric names prefixed "repomix_"
+    std::string prometheus() const;
+
+    // Human-readable per-stage table of a snapshot difference, for --timing
+    static std::string breakdown(const Snapshot& run);
+
+    static const char* stageName(Stage stage);
+    static const char* counterName(Counter counter);
+    static const char* gaugeName(Gauge gauge);
+
+private:
+    static constexpr size_t SLOT_COUNT = 64;
+
+    struct alignas(64) Slot {
+        struct Stage {
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> nanos{0};
+            std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+        };
+        std::array<Stage, STAGE_COUNT> stages;
+        std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+        std::array<std::atomic<int64_t>, GAUGE_COUNT> gauges{};
+    };
+
+    Metrics();
+    Slot& slot();
+
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<unsigned int> nextSlot_{0};
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <streambuf>
+
+namespace fs = std::filesystem;
+
+// Destination of the formatted output. Pieces arrive in output order; a sink
+// may buffer them but must not reorder them.
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+
+    // Append data. Throws std::runtime_error if the target fails.
+    virtual void write(std::string_view data) = 0;
+
+    // Push buffered data to the target
+    virtual void flush() {}
+
+    // Total bytes accepted so far
+    size_t bytesWritten() const { return bytesWritten_; }
+
+protected:
+    size_t bytesWritten_ = 0;
+};
+
+// Collects the output in a string
+class MemorySink : public OutputSink {
+public:
+    void write(std::string_view data) override;
+
+    const std::string& str() const { return buffer_; }
+
+    // Move the collected output out, leaving the sink empty
+    std::string release();
+
+private:
+    std::string buffer_;
+};
+
+// Counts the output and throws it away (token counting without output)
+class NullSink : public OutputSink {
+public:
+    void write(std::string_view data) override { bytesWritten_ += data.size(); }
+};
+
+// Writes the output to a file
+class FileSink : public OutputSink {
+public:
+    // Throws std::runtime_error if the file cannot be opened
+    explicit FileSink(const fs::path& path);
+
+    void write(std::string_view data) override;
+    void flush() override;
+
+private:
+    fs::path path_;
+    std::vector<char> buffer_;  // Stream buffer; must outlive file_
+    std::ofstream file_;
+};
+
+// Writes the output to a file descriptor such as a socket or a pipe
+class FdSink : public OutputSink {
+public:
+    // The descriptor is closed on destruction only if closeOnDestroy is set
+    explicit FdSink(int fd, bool closeOnDestroy = false);
+    ~FdSink() override;
+
+    FdSink(const FdSink&) = delete;
+    FdSink& operator=(const FdSink&) = delete;
+
+    void write(std::string_view data) override;
+    void flush() override;
+
+private:
+    int fd_;
+    bool closeOnDestroy_;
+    bool isSocket_ = false;
+    std::string buffer_;
+
+    // Small pieces are coalesced up to this size before hitting the descriptor
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    // Write everything, retrying on EINTR and short writes
+    void writeAll(const char* data, size_t size);
+};
+
+// std::streambuf over an OutputSink, so formatting code can use operator<<.
+// Small writes are buffered; large ones (file bodies) go straight to the sink.
+class SinkStreamBuf : public std::streambuf {
+public:
+    explicit SinkStreamBuf(OutputSink& sink, size_t bufferSize = 16 * 1024);
+    ~SinkStreamBuf() override;
+
+    // Hand buffered bytes to the sink without flushing the sink itself
+    void drain() { flushBuffer(); }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    OutputSink& sink_;
+    std::vector<char> buffer_;
+
+    void flushBuffer();
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// One tree-sitter parse of a file, reduced by a single combined query to the
+// spans that entity recognition, signatures, docstrings, code density and
+// import resolution all read. Producing it once per file replaces a parse
+// per consumer plus the regex sweeps over the same content.
+// Spans point into the parsed content, which must outlive the unit.
+class ParsedUnit {
+public:
+    enum class Kind {
+        Function,
+        Class,
+        Import,
+        Comment,
+        Docstring,
+        Branch          // if/while/for/switch
+    };
+
+    struct Span {
+        Kind kind;
+        uint32_t start = 0;         // Whole node
+        uint32_t end = 0;
+        uint32_t nameStart = 0;     // Name, or path/module of an import; empty if none
+        uint32_t nameEnd = 0;
+        uint32_t bodyStart = 0;     // Start of the body; end if there is none
+    };
+
+    // Parse content as the language of filePath. The result is not parsed()
+    // if no grammar covers the file or parsing fails; callers then fall back
+    // to their regex paths.
+    static ParsedUnit parse(std::string_view content, const fs::path& filePath);
+
+    // Whether a grammar covers the file's extension
+    static bool supports(const fs::path& filePath);
+
+    bool parsed() const { return parsed_; }
+
+    // Spans in source order
+    const std::vector<Span>& spans() const { return spans_; }
+    size_t count(Kind kind) const;
+
+    std::string_view text(const Span& span) const;
+    std::string_view name(const Span& span) const;
+    std::string_view header(const Span& span) const;   // From the start to the body, trimmed
+
+private:
+    std::string_view content_;
+    std::vector<Span> spans_;
+    bool parsed_ = false;
+};
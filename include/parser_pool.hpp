@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include "tree_sitter_types.hpp"
+
+// Tree-sitter state shared by the workers that parse files. A TSParser and a
+// TSQueryCursor may only be used by one thread at a time, while a compiled
+// TSQuery is immutable and can be shared. So each thread gets its own parser
+// and cursor, created on first use and kept until the thread exits (the
+// worker pools are long-lived), and queries are compiled once per process.
+class ParserPool {
+public:
+    struct TreeDeleter {
+        void operator()(TSTree* tree) const;
+    };
+    using Tree = std::unique_ptr<TSTree, TreeDeleter>;
+
+    // Parse content with the calling thread's parser; nullptr on failure
+    static Tree parse(const TSLanguage* language, std::string_view content);
+
+    // The calling thread's query cursor, to be used for one query at a time
+    static TSQueryCursor* cursor();
+
+    // Query compiled for language, shared by all threads; nullptr if the
+    // source does not compile (the failure is remembered too)
+    static const TSQuery* query(const TSLanguage* language, std::string_view source);
+};
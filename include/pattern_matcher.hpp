@@ -1,9 +1,16 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 #include <regex>
+#include <unordered_set>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <cstdint>
 
 namespace fs = std::filesystem;
 
@@ -15,6 +22,11 @@ public:
     // Constructor with custom ignore patterns
     PatternMatcher(const std::vector<std::string>& ignorePatterns);
     
+    // Copy the compiled patterns, root and .gitignore scopes (which are shared,
+    // not copied), e.g. to start a run from a prepared set of defaults
+    PatternMatcher(const PatternMatcher& other);
+    PatternMatcher& operator=(const PatternMatcher&) = delete;
+    
     // Add a new ignore pattern
     void addIgnorePattern(const std::string& pattern);
     
@@ -27,9 +39,23 @@ public:
     // Set exclude patterns from a comma-separated string (e.g., "*.txt,*.md")
     void setExcludePatterns(const std::string& patternsStr);
     
-    // Load patterns from a .gitignore file
+    // Match ignore/include patterns relative to this directory instead of the raw path
+    void setRootDirectory(const fs::path& rootDir);
+    
+    // Load patterns from a .gitignore file, scoped to the directory containing it
     void loadGitignore(const fs::path& gitignorePath);
     
+    // Load dir/.gitignore as a nested scope if present. Safe to call from several
+    // traversal threads while other threads are matching.
+    void loadNestedGitignore(const fs::path& dir) const;
+    
+    // Add the content of dir/.gitignore as a nested scope, for trees that are
+    // not on disk (see VirtualFileSystem)
+    void addNestedGitignore(const fs::path& dir, std::string_view content) const;
+    
+    // Check if a whole directory is excluded, so traversal can skip its subtree
+    bool isDirectoryIgnored(const fs::path& dirPath) const;
+    
     // Check if a file should be processed (matches include patterns and doesn't match ignore patterns)
     bool shouldProcess(const fs::path& filePath) const;
     
@@ -42,13 +68,74 @@ public:
     // Check if any include patterns have been specified
     bool hasIncludePatterns() const { return !includePatterns_.empty(); }
     
+    // Translate a glob pattern into ECMAScript regex source
+    static std::string patternToRegex(const std::string& pattern);
+    
 private:
+    // All non-trivial globs of a set merged into a single NFA, built from the
+    // patternToRegex translation and simulated in one pass over the path
+    class GlobAutomaton {
+    public:
+        void add(const std::string& regexSource);
+        void clear() { tokens_.clear(); starts_.clear(); }
+        bool empty() const { return starts_.empty(); }
+        bool matches(const std::string& text) const;
+        
+    private:
+        enum class TokenKind { Literal, AnyChar, Star, GlobStar, DirPrefix, Accept };
+        struct Token {
+            TokenKind kind;
+            char ch;
+        };
+        std::vector<Token> tokens_;
+        std::vector<uint32_t> starts_;
+    };
+    
+    // A set of glob patterns compiled for single-pass matching. Extension and
+    // literal patterns are answered by hash lookups, everything else by one
+    // automaton over the full path (plus one over the filename for "*.x*").
+    class CompiledPatternSet {
+    public:
+        void add(const std::string& pattern);
+        void clear();
+        bool matches(const std::string& pathStr) const;
+        
+    private:
+        std::unordered_set<std::string> extensions_;        // "*.o"       -> ".o"
+        std::unordered_set<std::string> basenames_;         // ".DS_Store" -> any depth
+        std::unordered_set<std::string> literalPaths_;      // "src/secret.key"
+        std::unordered_set<std::string> directoryPrefixes_; // "build/**"  -> "build/"
+        GlobAutomaton pathAutomaton_;
+        GlobAutomaton filenameAutomaton_;
+    };
+    
+    // Consecutive .gitignore lines of the same kind; the last matching rule wins
+    struct GitignoreRun {
+        bool negated = false;
+        bool directoryOnly = false;
+        CompiledPatternSet patterns;
+    };
+    
+    struct GitignoreScope {
+        std::vector<GitignoreRun> runs;
+    };
+    
     std::vector<std::string> ignorePatterns_;
-    std::vector<std::regex> ignoreRegexes_;
     std::vector<std::string> includePatterns_;
-    std::vector<std::regex> includeRegexes_;
+    CompiledPatternSet ignoreSet_;
+    CompiledPatternSet includeSet_;
+    std::string rootPrefix_;
+    
+    // .gitignore scopes keyed by their directory ("dir/"), resolved by path prefix;
+    // immutable once added, so copies of the matcher share them
+    mutable std::unordered_map<std::string, std::shared_ptr<const GitignoreScope>> gitignoreScopes_;
+    mutable std::shared_mutex scopesMutex_;
     
     // Helper methods
-    std::regex patternToRegex(const std::string& pattern) const;
+    std::string relativeToRoot(const std::string& pathStr) const;
+    bool isIgnoredByGitignore(const std::string& pathStr, bool isDirectory) const;
+    void addGitignoreScope(const fs::path& gitignorePath) const;
+    static std::unique_ptr<GitignoreScope> parseGitignore(std::istream& input);
+    static std::string scopeKey(const fs::path& dir);
     std::vector<std::string> splitPatternString(const std::string& patternsStr) const;
-};
\ No newline at end of file
+};
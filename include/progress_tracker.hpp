@@ -5,15 +5,24 @@
 #include <mutex>
 #include <memory>
 #include <chrono>
+#include <array>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <sstream>
 #include "file_processor.hpp"
 
 /**
  * @brief Class for tracking progress of file processing jobs
- * 
+ *
  * This class provides a centralized way to track the progress of multiple
  * file processing jobs. It maintains a map of job IDs to progress information
  * and provides methods to register, update, and query job progress.
+ *
+ * Jobs are spread over shards by ID and every job has its own lock, so
+ * concurrent jobs publishing progress never wait for each other; the shard
+ * lock is only held to find or insert an entry. Console logging is off
+ * unless enabled with setLogging().
  */
 class ProgressTracker {
 public:
@@ -24,113 +33,162 @@ public:
         FileProcessor::ProgressInfo lastProgress;
         bool isComplete = false;
     };
-    
+
     // Singleton instance
     static ProgressTracker& getInstance() {
         static ProgressTracker instance;
         return instance;
     }
-    
+
     // Register a new job
     std::string registerJob() {
-        std::lock_guard<std::mutex> lock(mutex_);
         std::string jobId = generateJobId();
-        
-        Job job;
-        job.id = jobId;
-        job.startTime = std::chrono::steady_clock::now();
-        
-        jobs_[jobId] = job;
+
+        auto entry = std::make_shared<Entry>();
+        entry->job.id = jobId;
+        entry->job.startTime = std::chrono::steady_clock::now();
+
+        Shard& shard = shardFor(jobId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.jobs[jobId] = std::move(entry);
         return jobId;
     }
-    
+
     // Update job progress
     void updateProgress(const std::string& jobId, const FileProcessor::ProgressInfo& progress) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto it = jobs_.find(jobId);
-        if (it != jobs_.end()) {
-            it->second.lastProgress = progress;
-            it->second.isComplete = progress.isComplete;
-            
-            // Log progress to console
-            std::cout << "[Job " << jobId << "] Progress: " 
-                      << progress.getPercentage() << "% ("
-                      << progress.processedFiles << "/" << progress.totalFiles 
-                      << " files)" << std::endl;
-            
-            // If job is complete, log completion
-            if (progress.isComplete) {
-                auto now = std::chrono::steady_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now - it->second.startTime).count();
-                
-                std::cout << "[Job " << jobId << "] Completed in " 
-                          << duration << "ms" << std::endl;
-            }
+        std::shared_ptr<Entry> entry = find(jobId);
+        if (!entry) {
+            return;
         }
+
+        std::chrono::steady_clock::time_point startTime;
+        {
+            std::lock_guard<std::mutex> lock(entry->mutex);
+            entry->job.lastProgress = progress;
+            entry->job.isComplete = progress.isComplete;
+            startTime = entry->job.startTime;
+        }
+
+        if (!logging_.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // One write per update, so lines of concurrent jobs do not interleave
+        std::ostringstream line;
+        line << "[Job " << jobId << "] Progress: "
+             << progress.getPercentage() << "% ("
+             << progress.processedFiles << "/" << progress.totalFiles
+             << " files)\n";
+
+        // If job is complete, log completion
+        if (progress.isComplete) {
+            auto now = std::chrono::steady_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - startTime).count();
+
+            line << "[Job " << jobId << "] Completed in "
+                 << duration << "ms\n";
+        }
+        std::cout << line.str() << std::flush;
     }
-    
+
     // Get job progress
     bool getJobProgress(const std::string& jobId, Job& job) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto it = jobs_.find(jobId);
-        if (it != jobs_.end()) {
-            job = it->second;
-            return true;
+        std::shared_ptr<Entry> entry = find(jobId);
+        if (!entry) {
+            return false;
         }
-        
-        return false;
+
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        job = entry->job;
+        return true;
     }
-    
+
     // Get all jobs
     std::unordered_map<std::string, Job> getAllJobs() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return jobs_;
+        std::unordered_map<std::string, Job> jobs;
+        forEachEntry([&jobs](const std::string& id, Entry& entry) {
+            std::lock_guard<std::mutex> lock(entry.mutex);
+            jobs[id] = entry.job;
+            return false;
+        });
+        return jobs;
     }
-    
+
     // Remove a job
     void removeJob(const std::string& jobId) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        jobs_.erase(jobId);
+        Shard& shard = shardFor(jobId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.jobs.erase(jobId);
     }
-    
+
     // Clean up completed jobs older than specified duration
     void cleanupCompletedJobs(std::chrono::milliseconds olderThan) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
         auto now = std::chrono::steady_clock::now();
-        
-        for (auto it = jobs_.begin(); it != jobs_.end(); ) {
-            if (it->second.isComplete) {
-                auto jobAge = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now - it->second.startTime);
-                
-                if (jobAge > olderThan) {
-                    it = jobs_.erase(it);
-                } else {
-                    ++it;
-                }
-            } else {
-                ++it;
-            }
-        }
+
+        forEachEntry([now, olderThan](const std::string&, Entry& entry) {
+            std::lock_guard<std::mutex> lock(entry.mutex);
+            auto jobAge = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - entry.job.startTime);
+            return entry.job.isComplete && jobAge > olderThan;
+        });
+    }
+
+    // Log every update to the console (off by default)
+    void setLogging(bool enabled) {
+        logging_.store(enabled, std::memory_order_relaxed);
     }
-    
+
 private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Entry {
+        std::mutex mutex;
+        Job job;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<Entry>> jobs;
+    };
+
     // Private constructor for singleton
     ProgressTracker() = default;
-    
+
     // Generate a unique job ID
     std::string generateJobId() {
         auto timestamp = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
         return "job_" + timestamp;
     }
-    
-    // Map of job IDs to job information
-    std::unordered_map<std::string, Job> jobs_;
-    
-    // Mutex for thread safety
-    std::mutex mutex_;
-}; 
\ No newline at end of file
+
+    Shard& shardFor(const std::string& jobId) {
+        return shards_[std::hash<std::string>{}(jobId) % SHARD_COUNT];
+    }
+
+    std::shared_ptr<Entry> find(const std::string& jobId) {
+        Shard& shard = shardFor(jobId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.jobs.find(jobId);
+        return it != shard.jobs.end() ? it->second : nullptr;
+    }
+
+    // Visits every job one shard at a time; entries the visitor returns true for are removed
+    template <typename Visitor>
+    void forEachEntry(Visitor visit) {
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (auto it = shard.jobs.begin(); it != shard.jobs.end(); ) {
+                if (visit(it->first, *it->second)) {
+                    it = shard.jobs.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    // Jobs by shard; an entry outlives its removal while an update still holds it
+    std::array<Shard, SHARD_COUNT> shards_;
+
+    std::atomic<bool> logging_{false};
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// A compiled regular expression behind one interface, so the engine can be
+// chosen at build time: PCRE2 with its JIT when USE_PCRE2 is defined (the
+// library tiktoken already links), std::regex otherwise. Patterns stick to
+// the syntax both engines read the same way. A compiled Regex is immutable
+// and can be shared by any number of threads.
+class Regex {
+public:
+    struct Match {
+        size_t start = 0;                       // Whole match, as offsets into the searched text
+        size_t end = 0;
+        std::vector<std::string_view> groups;   // groups[0] is the whole match; unset groups are empty
+
+        std::string_view group(size_t index) const {
+            return index < groups.size() ? groups[index] : std::string_view();
+        }
+    };
+
+    Regex();                                    // Matches nothing
+    explicit Regex(const char* pattern);        // A pattern that does not compile is reported and matches nothing
+    ~Regex();
+    Regex(Regex&& other) noexcept;
+    Regex& operator=(Regex&& other) noexcept;
+
+    // Whether the pattern matches anywhere in text
+    bool search(std::string_view text) const;
+
+    // First match starting at or after offset; text before offset is still
+    // visible to anchors and word boundaries
+    bool search(std::string_view text, size_t offset, Match& match) const;
+
+    // Call onMatch(const Match&) for each non-overlapping match, left to right
+    template <typename OnMatch>
+    void forEach(std::string_view text, OnMatch&& onMatch) const {
+        Match match;
+        size_t offset = 0;
+        while (offset <= text.size() && search(text, offset, match)) {
+            onMatch(match);
+            offset = match.end > match.start ? match.end : match.end + 1;
+        }
+    }
+
+    // "pcre2-jit" or "std::regex"
+    static const char* engineName();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
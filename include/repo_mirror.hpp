@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+// A bare mirror of a remote git repository plus a persistent checkout of its HEAD.
+//
+// The first sync clones the mirror; later syncs only fetch. After fetching, the
+// checkout is moved to the new HEAD (git rewrites only the files that changed, so
+// unchanged files keep their mtime and hit the result cache), and
+// `git diff --name-status` against a caller-supplied base commit tells the caller
+// which files to reprocess.
+class RepoMirror {
+public:
+    struct SyncResult {
+        std::string commit;              // HEAD after the sync
+        bool diffAvailable = false;      // False if there was no usable base commit
+        std::vector<fs::path> changed;   // Added or modified files, inside worktree()
+        std::vector<fs::path> removed;   // Deleted files, inside worktree()
+    };
+
+    // Mirror and checkout live in baseDir/<hash of repoUrl>.git and .../<hash>.worktree.
+    // Throws std::runtime_error if repoUrl starts with '-'.
+    RepoMirror(const std::string& repoUrl, const fs::path& baseDir);
+
+    // Clone or fetch, check out the new HEAD and diff it against baseCommit.
+    // Throws std::runtime_error if a git command fails.
+    SyncResult sync(const std::string& baseCommit);
+
+    // Delete the mirror and the checkout; the next sync clones again
+    void remove();
+
+    const fs::path& worktree() const { return worktreeDir_; }
+    const std::string& url() const { return url_; }
+
+    // Split `git diff --name-status -z --no-renames` output into changed and removed paths
+    static void parseNameStatus(const std::string& output, const fs::path& root, SyncResult& result);
+
+    // Quote an argument for /bin/sh
+    static std::string shellQuote(const std::string& arg);
+
+private:
+    std::string url_;
+    fs::path mirrorDir_;
+    fs::path worktreeDir_;
+
+    // Run git with the given (already quoted) arguments; returns false on a non-zero exit
+    static bool runGit(const std::string& args, std::string* output = nullptr);
+    std::string mirrorArgs() const;
+};
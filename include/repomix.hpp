@@ -10,6 +10,13 @@
 #include "tokenizer.hpp"
 #include "file_scorer.hpp"
 #include "progress_tracker.hpp"
+#include "result_cache.hpp"
+#include "output_sink.hpp"
+#include "directory_tree.hpp"
+#include "metrics.hpp"
+#include "trace_recorder.hpp"
+
+class Engine;
 
 namespace fs = std::filesystem;
 
@@ -25,6 +32,10 @@ enum class OutputFormat {
 
 struct RepomixOptions {
     fs::path inputDir;
+    
+    // Read the files from this tree instead of the disk (archive, upload, git
+    // objects); inputDir defaults to its root()
+    std::shared_ptr<const VirtualFileSystem> fileSystem;
     fs::path outputFile = "repomix-output.txt";
     OutputFormat format = OutputFormat::Plain;
     bool verbose = false;
@@ -46,6 +57,21 @@ struct RepomixOptions {
     bool countTokens = false;                        // Flag to count tokens in the output
     TokenizerEncoding tokenEncoding = TokenizerEncoding::CL100K_BASE; // Tokenizer to use
     bool onlyShowTokenCount = false;                 // Only display token count without generating the full output
+    size_t tokenBudget = 0;                          // Fit the output into this many tokens, best-scoring files
+                                                     // first and summarized if needed (0 = no budget)
+    
+    // Emit identical files once; later copies (by path) only refer to the first
+    bool deduplicate = true;
+    
+    // Persistent per-file result cache
+    fs::path cacheDir;                               // Cache directory (empty = caching disabled)
+    
+    // Chrome trace-event timeline of each run (empty = no trace)
+    fs::path traceFile;
+    
+    // How often progress is published to callbacks, the job's ProgressTracker
+    // entry and the console
+    FileProcessor::ProgressOptions progress;
 };
 
 class Repomix {
@@ -53,14 +79,31 @@ public:
     // Define progress callback type that passes through FileProcessor::ProgressInfo
     using ProgressCallback = FileProcessor::ProgressCallback;
     
-    Repomix(const RepomixOptions& options);
+    // With an engine, tokenizers, entity recognizers and compiled patterns are
+    // taken from it instead of being built for this instance
+    Repomix(const RepomixOptions& options, std::shared_ptr<Engine> engine = nullptr);
+    
+    // Add the ignore patterns every run starts with (build output, dependencies,
+    // editor files, binaries, archives, logs)
+    static void addDefaultIgnorePatterns(PatternMatcher& matcher);
     
     // Run the repomix process
     bool run();
     
+    // Re-run after the given files changed on disk, reprocessing only those files.
+    // Paths are below inputDir; falls back to run() if there is no previous run.
+    bool runIncremental(const std::vector<fs::path>& changedFiles, 
+                        const std::vector<fs::path>& removedFiles);
+    
+    // Stream the output into sink instead of outputFile or memory; pass nullptr to reset
+    void setOutputSink(std::shared_ptr<OutputSink> sink);
+    
     // Set a callback for progress updates
     void setProgressCallback(ProgressCallback callback);
     
+    // Write the timeline of the next runs to path; pass an empty path to stop tracing
+    void setTraceFile(const fs::path& path);
+    
     // Get the current progress information
     FileProcessor::ProgressInfo getCurrentProgress() const;
     
@@ -76,8 +119,9 @@ public:
     // Get timing information
     std::string getTimingInfo() const;
     
-    // Get the output content directly (useful for WASM)
-    std::string getOutput() const;
+    // Get the output content directly (useful for WASM); empty if the output
+    // went to outputFile or an output sink
+    const std::string& getOutput() const;
     
     // Get token count of the output
     size_t getTokenCount() const;
@@ -90,10 +134,12 @@ public:
 
 private:
     RepomixOptions options_;
+    std::shared_ptr<Engine> engine_;
     std::unique_ptr<FileProcessor> fileProcessor_;
     std::unique_ptr<PatternMatcher> patternMatcher_;
-    std::unique_ptr<Tokenizer> tokenizer_;
+    std::shared_ptr<const Tokenizer> tokenizer_;
     std::unique_ptr<FileScorer> fileScorer_;
+    std::shared_ptr<ResultCache> resultCache_;
     
     // Job ID for progress tracking
     std::string jobId_;
@@ -101,16 +147,33 @@ private:
     // Scored files (if scoring was used)
     std::vector<FileScorer::ScoredFile> scoredFiles_;
     
-    // Output content storage
+    // Output content storage (only when no file or sink receives the output)
     std::string outputContent_;
+    std::shared_ptr<OutputSink> outputSink_;
+    
+    // Results of the last run, reused by runIncremental
+    std::vector<FileProcessor::ProcessedFile> processedFiles_;
+    bool hasPreviousRun_ = false;
     
     // Token count
     size_t tokenCount_ = 0;
     
+    // Framing charged against a token budget: the summary table and headings,
+    // and each file's header and fences besides its path
+    static constexpr size_t BUDGET_PREAMBLE_TOKENS = 64;
+    static constexpr size_t BUDGET_TOKENS_PER_FILE = 32;
+    
+    // Outcome of packing to options_.tokenBudget
+    size_t budgetUsedTokens_ = 0;
+    size_t budgetFullFiles_ = 0;
+    size_t budgetSummarizedFiles_ = 0;
+    size_t budgetOmittedFiles_ = 0;
+    
     // Statistics
     size_t totalFiles_ = 0;
     size_t totalLines_ = 0;
     size_t totalBytes_ = 0;
+    size_t duplicateFiles_ = 0;
     
     // Timing info
     std::chrono::steady_clock::time_point startTime_;
@@ -121,13 +184,25 @@ private:
     std::chrono::milliseconds tokenizationDuration_{0};
     std::chrono::milliseconds scoringDuration_{0};
     
+    // Stage metrics: totals when the run started, and what the run added
+    Metrics::Snapshot metricsAtStart_;
+    Metrics::Snapshot runMetrics_;
+    
+    // Timeline of the current run, when options_.traceFile is set
+    std::unique_ptr<TraceRecorder> trace_;
+    
     // Helper methods
-    void writeOutput();
-    void countOutputTokens();
-    std::string generateDirectoryTree(const fs::path& dir, int level = 0) const;
-    std::string formatOutput(const std::vector<FileProcessor::ProcessedFile>& files) const;
+    DirectoryTree buildDirectoryTree(const std::vector<FileProcessor::ProcessedFile>& files) const;
+    class TokenCountingSink;
+    void formatOutput(const std::vector<FileProcessor::ProcessedFile>& files, OutputSink& sink,
+                      TokenCountingSink* counter = nullptr, bool writeBodies = true) const;
+    void emitOutput(const std::vector<FileProcessor::ProcessedFile>& files);
+    TraceRecorder* beginTrace();
+    void writeTrace();
     
     // File selection methods
     std::vector<fs::path> selectFilesUsingScoring(const fs::path& repoPath);
     std::vector<FileProcessor::ProcessedFile> processSelectedFiles(const std::vector<fs::path>& selectedFiles);
+    std::vector<FileProcessor::ProcessedFile> packToTokenBudget(std::vector<FileProcessor::ProcessedFile> files);
+    void resolveDuplicates(std::vector<FileProcessor::ProcessedFile>& files);
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+// Persistent on-disk cache for per-file results.
+//
+// Entries are addressed by a key derived from the file's path, size, mtime, content
+// hash and a fingerprint of the options that produced the result, so a changed file
+// or a changed option simply misses; nothing ever has to be invalidated. Each entry is
+// a CBOR-encoded JSON value in its own file under a 256-way fan-out directory. Writes
+// go to a temporary file that is renamed into place, so several threads (or several
+// processes sharing a CI cache) can use the same directory concurrently.
+class ResultCache {
+public:
+    explicit ResultCache(const fs::path& directory);
+
+    // $XDG_CACHE_HOME/repomix, falling back to ~/.cache/repomix
+    static fs::path defaultDirectory();
+
+    // 64-bit FNV-1a; pass a previous result as seed to hash incrementally
+    static constexpr uint64_t HASH_SEED = 14695981039346656037ULL;
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = HASH_SEED);
+    static uint64_t hash(std::string_view data, uint64_t seed = HASH_SEED) {
+        return hash(data.data(), data.size(), seed);
+    }
+
+    // 64-bit XXH64 of file content, eight bytes per step where FNV-1a takes one.
+    // Identifies content in entry keys and for deduplication within a run.
+    // Keys that must not be collided on purpose pass a secret seed.
+    static uint64_t contentHash(std::string_view data, uint64_t seed = 0);
+
+    // Build the entry key; fingerprint identifies the producer and its options
+    static std::string makeKey(const fs::path& path, uintmax_t size, std::time_t modifiedTime,
+                               uint64_t contentHash, uint64_t fingerprint);
+
+    // Look up an entry; returns false on a miss or an unreadable entry
+    bool load(const std::string& key, nlohmann::json& value) const;
+
+    // Store an entry, replacing any previous one. Failures are reported and ignored.
+    void store(const std::string& key, const nlohmann::json& value) const;
+
+    const fs::path& directory() const { return directory_; }
+    size_t hits() const { return hits_.load(); }
+    size_t misses() const { return misses_.load(); }
+
+private:
+    fs::path directory_;
+    mutable std::atomic<size_t> hits_{0};
+    mutable std::atomic<size_t> misses_{0};
+    mutable std::atomic<bool> storeErrorReported_{false};
+
+    fs::path entryPath(const std::string& key) const;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Arena for the text a processing run attaches to its results: entity names,
+// leading lines, snippets and formatted entity lists.
+//
+// Strings are copied into monotonic buffers and handed out as views that stay
+// valid for the pool's lifetime; nothing is freed individually, the whole
+// arena goes at once when the last result of the run lets go of the pool.
+// intern() additionally deduplicates, so a name recognized in hundreds of
+// files (a common base class, an include) is stored once. Workers share the
+// pool; it is split into independently locked shards so they rarely contend.
+class StringPool {
+public:
+    static constexpr size_t DEFAULT_SHARDS = 16;
+
+    explicit StringPool(size_t shardCount = DEFAULT_SHARDS);
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Copy of text shared with every equal string interned before
+    std::string_view intern(std::string_view text);
+
+    // Copy of text without deduplication, for strings unlikely to repeat
+    std::string_view store(std::string_view text);
+
+    size_t internedCount() const;       // Distinct interned strings
+    size_t bytesUsed() const;           // Bytes of string data held
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::unordered_set<std::string_view> interned{&arena};
+        size_t bytes = 0;
+    };
+
+    static std::string_view copyInto(Shard& shard, std::string_view text);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// Byte statistics gathered in one pass over a buffer
+struct TextStats {
+    size_t newlines = 0;
+    size_t nulBytes = 0;
+    size_t textBytes = 0;           // Printable ASCII plus \t, \n and \r
+    size_t estimatedTokens = 0;     // Word/punctuation estimate of the fallback tokenizer
+};
+
+// Vectorized byte scanning for line counting, binary detection and the
+// fallback token estimate. Each kernel classifies 64 bytes at a time into
+// bit masks (newline, NUL, text, whitespace, punctuation); counts come from
+// popcounts and words are measured run by run rather than byte by byte.
+// The kernel is picked once at startup from what the CPU supports.
+class TextScanner {
+public:
+    enum class Kernel {
+        Scalar,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    // All of TextStats in one pass
+    static TextStats scan(std::string_view data);
+
+    // Same, with a specific kernel (which must be supported)
+    static TextStats scan(std::string_view data, Kernel kernel);
+
+    // Only the newline count; skips the word measurement
+    static size_t countNewlines(std::string_view data);
+
+    static Kernel activeKernel();
+    static bool isSupported(Kernel kernel);
+    static const char* kernelName(Kernel kernel);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+
+// Chooses what to emit for each file so that the output fits a token budget.
+// This is a knapsack over (score, tokens) solved greedily: files are taken in
+// order of score per token, and a file whose full content no longer fits is
+// offered as a summary instead. Summaries are only computed at that point,
+// so files that fit (or are dropped outright) are never summarized.
+class TokenBudgetPacker {
+public:
+    enum class Choice {
+        Full,
+        Summary,
+        Omitted
+    };
+
+    struct Item {
+        float score = 0.0f;
+        size_t tokens = 0;          // Tokens of the full content
+        size_t overhead = 0;        // Tokens of the output framing around the body
+    };
+
+    // Token count of the summary of item index, or nullopt if it has none shorter
+    using Summarizer = std::function<std::optional<size_t>(size_t index)>;
+
+    struct Result {
+        std::vector<Choice> choices;    // One per item, in input order
+        size_t usedTokens = 0;          // Bodies plus framing of the chosen items
+        size_t fullCount = 0;
+        size_t summaryCount = 0;
+        size_t omittedCount = 0;
+    };
+
+    explicit TokenBudgetPacker(size_t budget);
+
+    // Pack items; without a summarizer, files either fit in full or are omitted
+    Result pack(const std::vector<Item>& items, const Summarizer& summarize = nullptr) const;
+
+    size_t getBudget() const { return budget_; }
+
+private:
+    size_t budget_;
+};
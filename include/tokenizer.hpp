@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <vector>
 #include <unordered_map>
@@ -27,7 +28,7 @@ public:
     ~Tokenizer();
 
     // Count tokens in a string
-    size_t countTokens(const std::string& text) const;
+    size_t countTokens(std::string_view text) const;
     
     // Get the encoding name as a string
     std::string getEncodingName() const;
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Timeline of one run in the Chrome trace-event format (chrome://tracing, Perfetto).
+//
+// A recorder is bound to a thread with a ThreadScope, and the work-stealing pool
+// carries the submitting thread's binding over to the tasks it runs, so every
+// span and metrics timer entered during a run lands in that run's recorder even
+// when several jobs share the process. Each thread appends to its own buffer;
+// the buffers are merged only when the trace is written. With no recorder bound
+// a span costs one thread-local load.
+class TraceRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // Binds a recorder (or none) to the calling thread until destroyed
+    class ThreadScope {
+    public:
+        explicit ThreadScope(TraceRecorder* recorder);
+        ~ThreadScope();
+
+        ThreadScope(const ThreadScope&) = delete;
+        ThreadScope& operator=(const ThreadScope&) = delete;
+
+    private:
+        TraceRecorder* previous_;
+    };
+
+    // Records the time from construction to destruction into the bound recorder.
+    // The detail path is only read at the end and must outlive the span.
+    class Span {
+    public:
+        Span(const char* name, const char* category, const fs::path* detail = nullptr);
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        TraceRecorder* recorder_;
+        const char* name_;
+        const char* category_;
+        const fs::path* detail_;
+        Clock::time_point start_;
+    };
+
+    // Recorder bound to the calling thread, nullptr when nothing is traced
+    static TraceRecorder* current();
+
+    // Label of the calling thread in every trace it records into
+    static void setThreadName(std::string name);
+
+    // Adds a complete ("X") event; name and category must outlive the recorder
+    void complete(const char* name, const char* category, Clock::time_point start, Clock::time_point end,
+                  std::string detail = {});
+
+    size_t eventCount() const;
+
+    // Writes {"traceEvents": [...]} with one track per thread
+    void write(std::ostream& out) const;
+    void writeFile(const fs::path& path) const;
+
+private:
+    struct Event {
+        const char* name;
+        const char* category;
+        int64_t startNanos;     // Since the recorder was created
+        int64_t durationNanos;
+        std::string detail;
+    };
+
+    struct ThreadBuffer {
+        mutable std::mutex mutex;   // Only contended while the trace is written
+        uint32_t tid = 0;
+        std::string name;
+        std::vector<Event> events;
+    };
+
+    ThreadBuffer& buffer();
+
+    const uint64_t id_;
+    const Clock::time_point origin_;
+    const std::thread::id owner_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::thread::id, std::unique_ptr<ThreadBuffer>> buffers_;
+};
@@ -80,10 +80,10 @@ TSQuery* ts_query_new(
     TSQueryError* error_type
 );
 void ts_query_delete(TSQuery* query);
-void ts_query_capture_name_for_id(
+uint32_t ts_query_capture_count(const TSQuery* query);
+const char* ts_query_capture_name_for_id(
     const TSQuery* query,
     uint32_t index,
-    const char** name,
     uint32_t* length
 );
 
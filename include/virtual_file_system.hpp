@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "file_content.hpp"
+
+namespace fs = std::filesystem;
+
+// A read-only tree of files that does not live on disk: an upload held in
+// memory, a zip or tar archive, or a commit in a git object database.
+// FileProcessor and FileScorer read through it instead of the filesystem when
+// one is set, so nothing is extracted to a temporary directory and nothing has
+// to be deleted afterwards. Every file appears below root(); reads may come
+// from several threads at once.
+class VirtualFileSystem {
+public:
+    struct Entry {
+        fs::path path;                  // root() / path inside the tree
+        size_t size = 0;
+        std::time_t modifiedTime = 0;   // 0 if the source does not record one
+        size_t slot = 0;                // Where the implementation finds the bytes
+    };
+
+    virtual ~VirtualFileSystem() = default;
+
+    const fs::path& root() const { return root_; }
+
+    // Every regular file, sorted by path
+    const std::vector<Entry>& entries() const;
+
+    // Entry of a file below root(), or nullptr
+    const Entry* find(const fs::path& path) const;
+
+    // Whole content of a file below root(). Throws std::runtime_error if there
+    // is no such file or its bytes cannot be produced.
+    FileContent read(const fs::path& path) const;
+
+protected:
+    explicit VirtualFileSystem(fs::path root) : root_(std::move(root)) {}
+
+    // Add a file at a path relative to root(); false if the path is absolute
+    // or leaves the tree. The index is sorted by sortEntries(), or on the
+    // first entries() or find() after files were added out of order.
+    bool addEntry(const std::string& relPath, size_t size, std::time_t modifiedTime, size_t slot);
+    void sortEntries() const;
+
+    virtual FileContent readEntry(const Entry& entry) const = 0;
+
+private:
+    fs::path root_;
+    mutable std::vector<Entry> entries_;
+    mutable std::atomic<bool> sorted_{true};
+    mutable std::mutex sortMutex_;
+};
+
+// Files handed over in memory, e.g. the parts of a multipart upload
+class MemoryFileSystem : public VirtualFileSystem {
+public:
+    explicit MemoryFileSystem(fs::path root = "upload") : VirtualFileSystem(std::move(root)) {}
+
+    // Add or replace a file; relPath is relative to root(). Returns false if
+    // the path is absolute or leaves the tree. Files may come in any order;
+    // they are sorted once, when the tree is first read.
+    bool add(const std::string& relPath, FileContent content, std::time_t modifiedTime = 0);
+
+private:
+    std::vector<FileContent> contents_;
+
+    FileContent readEntry(const Entry& entry) const override;
+};
+
+// The members of a zip, tar or gzip-compressed tar archive held in memory.
+// Stored zip members and tar members are slices of the archive; deflated zip
+// members are inflated when read. Compressed formats need zlib (USE_ZLIB).
+class ArchiveFileSystem : public VirtualFileSystem {
+public:
+    // Default bound on how many times its compressed size a gzip-compressed
+    // tar may inflate to; deflate itself allows about 1000
+    static constexpr size_t MAX_EXPANSION = 256;
+
+    // Index an archive; the format is taken from its first bytes. Throws
+    // std::runtime_error if the archive is malformed, inflates past
+    // maxExpansion times its size (1 MB at least) or its format unsupported.
+    ArchiveFileSystem(FileContent archive, fs::path root = "archive", size_t maxExpansion = MAX_EXPANSION);
+
+    // Whether data starts like a zip, tar or gzip file
+    static bool isArchive(std::string_view data);
+
+    // Whether compressed archives and deflated zip members can be read
+    static bool supportsCompression();
+
+private:
+    struct Member {
+        size_t offset = 0;              // Start of the (compressed) bytes
+        size_t storedSize = 0;
+        bool deflated = false;
+    };
+
+    FileContent archive_;
+    std::vector<Member> members_;
+
+    void indexZip();
+    void indexTar();
+    FileContent readEntry(const Entry& entry) const override;
+};
+
+// The files of one commit, read from a git object database without a
+// checkout: `git ls-tree` lists them and a few long-running
+// `git cat-file --batch` processes serve the blobs.
+class GitObjectFileSystem : public VirtualFileSystem {
+public:
+    // Default number of cat-file processes reading at once
+    static constexpr size_t MAX_PROCESSES = 8;
+
+    // List the tree of revision in repoDir, a bare or non-bare repository.
+    // Up to maxProcesses reads run in parallel. Throws std::runtime_error if
+    // git fails.
+    GitObjectFileSystem(const fs::path& repoDir, const std::string& revision = "HEAD",
+                        fs::path root = "repo", size_t maxProcesses = MAX_PROCESSES);
+    ~GitObjectFileSystem() override;
+
+    GitObjectFileSystem(const GitObjectFileSystem&) = delete;
+    GitObjectFileSystem& operator=(const GitObjectFileSystem&) = delete;
+
+    // Parse `git ls-tree -r -l -z` output into (path, object id, size) of each blob
+    struct Blob {
+        std::string path;
+        std::string objectId;
+        size_t size = 0;
+    };
+    static std::vector<Blob> parseTree(std::string_view output);
+
+private:
+    fs::path repoDir_;
+    std::vector<std::string> objectIds_;
+
+    // A cat-file process, talked to over a socket pair (no SIGPIPE if it
+    // dies); it serves one read at a time
+    struct BatchProcess {
+        int pid = -1;
+        int fd = -1;
+        std::string buffer;             // Output received past the last read
+    };
+
+    // Processes are started as reads need them, up to maxProcesses_, and
+    // kept idle between reads
+    size_t maxProcesses_;
+    mutable std::mutex batchMutex_;
+    mutable std::condition_variable batchAvailable_;
+    mutable std::vector<std::unique_ptr<BatchProcess>> idleBatches_;
+    mutable size_t runningBatches_ = 0;
+
+    std::unique_ptr<BatchProcess> acquireBatch() const;
+    void releaseBatch(std::unique_ptr<BatchProcess> batch) const;
+    std::unique_ptr<BatchProcess> startBatch() const;
+    static void stopBatch(BatchProcess& batch);
+    static std::string readBlob(BatchProcess& batch, const std::string& objectId);
+    FileContent readEntry(const Entry& entry) const override;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small fixed-size thread pool with one task deque per worker.
+//
+// Tasks submitted from a worker go to the back of that worker's own deque and are
+// popped LIFO (good locality for recursive work such as directory scanning); idle
+// workers steal from the front of other deques. Each deque has its own mutex, so
+// workers only contend when stealing. Tasks receive the index of the worker that
+// runs them, which lets callers keep per-worker state without locking.
+class WorkStealingPool {
+public:
+    using Task = std::function<void(unsigned int workerIndex)>;
+
+    explicit WorkStealingPool(unsigned int numThreads = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Queue a task; may be called from inside a running task
+    void submit(Task task);
+
+    // Block until every submitted task (including tasks they spawned) has finished.
+    // Must not be called from a worker of this pool.
+    void wait();
+
+    // Run body(0) .. body(count - 1) on the calling thread and on idle workers,
+    // returning once all have finished. The caller claims indices itself, so it
+    // never waits for a task that has not started and may be a worker of this
+    // pool. The first exception a body throws is rethrown here.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // Number of worker slots; worker indices are in [0, size())
+    unsigned int size() const { return static_cast<unsigned int>(queues_.size()); }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<size_t> pendingTasks_{0};  // Submitted but not finished
+    std::atomic<size_t> queuedTasks_{0};   // Sitting in a deque
+    std::atomic<size_t> sleepingWorkers_{0};
+    std::atomic<unsigned int> nextQueue_{0};
+    std::atomic<bool> stopping_{false};
+
+    std::mutex sleepMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+
+    void workerLoop(unsigned int index);
+    bool tryPop(unsigned int index, Task& task);
+    bool trySteal(unsigned int thief, Task& task);
+    void runTask(Task& task, unsigned int index);
+};
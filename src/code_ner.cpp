@@ -1,7 +1,9 @@
 #include "../include/code_ner.hpp"
 #include "../include/file_processor.hpp"
+#include "../include/entity_cache.hpp"
+#include "../include/result_cache.hpp"
+#include "../include/language_registry.hpp"
 #include <iostream>
-#include <regex>
 #include <unordered_map>
 #include <algorithm>
 #include <fstream>
@@ -24,10 +26,6 @@ extern "C" {
     // TSLanguage* tree_sitter_javascript();
 }
 
-// Static cache initialization for MLNER
-std::unordered_map<std::string, std::vector<CodeNER::NamedEntity>> MLNER::entityCache_;
-std::mutex MLNER::cacheMutex_;
-
 // MLNER::MLImpl structure definition
 struct MLNER::MLImpl {
 #ifdef USE_ONNX_RUNTIME
@@ -55,8 +53,9 @@ struct MLNER::MLImpl {
     };
 };
 
-// Factory method implementation
-std::unique_ptr<CodeNER> CodeNER::create(const SummarizationOptions& options) {
+namespace {
+
+std::unique_ptr<CodeNER> createBackend(const SummarizationOptions& options) {
     switch (options.nerMethod) {
         case SummarizationOptions::NERMethod::TreeSitter:
             try {
@@ -88,11 +87,81 @@ std::unique_ptr<CodeNER> CodeNER::create(const SummarizationOptions& options) {
     }
 }
 
+}  // namespace
+
+// Factory method implementation
+std::unique_ptr<CodeNER> CodeNER::create(const SummarizationOptions& options) {
+    std::unique_ptr<CodeNER> backend = createBackend(options);
+    if (!options.cacheMLResults) {
+        return backend;
+    }
+    return std::make_unique<CachedNER>(std::move(backend), options);
+}
+
+// CachedNER implementation
+CachedNER::CachedNER(std::unique_ptr<CodeNER> backend, const SummarizationOptions& options)
+    : backend_(std::move(backend)) {
+    // Everything the backends read from the options
+    const SummarizationOptions& o = options;
+    std::ostringstream fields;
+    fields << "entities/v1|" << static_cast<int>(o.nerMethod) << '|' << o.useTreeSitter
+           << '|' << o.useMLForLargeFiles << o.mlNerSizeThreshold << '|' << o.mlModelPath
+           << '|' << o.mlConfidenceThreshold << '|' << o.maxMLProcessingTimeMs
+           << '|' << o.includeClassNames << o.includeFunctionNames << o.includeVariableNames
+           << o.includeEnumValues << o.includeImports << '|' << o.maxEntities;
+    fingerprint_ = ResultCache::hash(fields.str());
+}
+
+std::vector<CodeNER::NamedEntity> CachedNER::extractEntities(
+    std::string_view content, 
+    const fs::path& filePath
+) const {
+    return cached(content, filePath, [&]() { return backend_->extractEntities(content, filePath); });
+}
+
+std::vector<CodeNER::NamedEntity> CachedNER::extractEntitiesFrom(
+    const ParsedUnit& unit,
+    std::string_view content, 
+    const fs::path& filePath
+) const {
+    return cached(content, filePath, [&]() { return backend_->extractEntitiesFrom(unit, content, filePath); });
+}
+
+/**
+ * @brief Returns the cached result for content or computes and stores it
+ *
+ * The extension is part of the key because the backends recognize entities
+ * per language; the rest of the path is not, so identical files share a result.
+ *
+ * @param content Content to recognize entities in
+ * @param filePath Path of the file
+ * @param extract Runs the backend on a miss
+ * @return std::vector<NamedEntity> Entities of the content
+ */
+template <typename Extract>
+std::vector<CodeNER::NamedEntity> CachedNER::cached(
+    std::string_view content, 
+    const fs::path& filePath, 
+    Extract extract
+) const {
+    EntityCache& cache = EntityCache::instance();
+    const EntityCache::Key key = EntityCache::makeKey(
+        content, ResultCache::hash(filePath.extension().string(), fingerprint_));
+    
+    std::vector<NamedEntity> entities;
+    if (cache.lookup(key, entities)) {
+        return entities;
+    }
+    entities = extract();
+    cache.store(key, entities);
+    return entities;
+}
+
 // RegexNER implementation
 RegexNER::RegexNER(const SummarizationOptions& options) : options_(options) {}
 
 std::vector<CodeNER::NamedEntity> RegexNER::extractEntities(
-    const std::string& content, 
+    std::string_view content, 
     const fs::path& filePath
 ) const {
     std::vector<NamedEntity> entities;
@@ -131,408 +200,107 @@ std::vector<CodeNER::NamedEntity> RegexNER::extractEntities(
     return entities;
 }
 
-// Implementation of the regex-based extraction methods
-std::vector<CodeNER::NamedEntity> RegexNER::extractClassNames(const std::string& content, const fs::path& filePath) const {
-    std::vector<NamedEntity> entities;
-    std::string extension = filePath.extension().string();
-    
-    if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".c") {
-        // C/C++ class names
-        std::regex classRegex(R"((class|struct)\s+(\w+))");
-        
-        std::sregex_iterator it(content.begin(), content.end(), classRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 2) {
-                entities.push_back(NamedEntity(it->str(2), EntityType::Class));
-            }
-        }
-    } 
-    else if (extension == ".py") {
-        // Python class names
-        std::regex classRegex(R"(class\s+(\w+))");
-        
-        std::sregex_iterator it(content.begin(), content.end(), classRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 1) {
-                entities.push_back(NamedEntity(it->str(1), EntityType::Class));
-            }
-        }
-    }
-    else if (extension == ".js" || extension == ".ts" || extension == ".jsx" || extension == ".tsx") {
-        // JavaScript/TypeScript class names
-        std::regex classRegex(R"(class\s+(\w+))");
-        
-        std::sregex_iterator it(content.begin(), content.end(), classRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 1) {
-                entities.push_back(NamedEntity(it->str(1), EntityType::Class));
-            }
+// Implementation of the regex-based extraction methods; the patterns come
+// from the language registry, compiled once per process
+namespace {
+
+// Appends group 1 of every match unless it is one of the stop words
+void collectNames(const Regex& regex, std::string_view content, CodeNER::EntityType type,
+                  const std::vector<std::string_view>& stopWords,
+                  std::vector<CodeNER::NamedEntity>& entities) {
+    regex.forEach(content, [&](const Regex::Match& match) {
+        std::string_view name = match.group(1);
+        if (!name.empty() && std::find(stopWords.begin(), stopWords.end(), name) == stopWords.end()) {
+            entities.push_back(CodeNER::NamedEntity(std::string(name), type));
         }
-    }
-    
+    });
+}
+
+}  // namespace
+
+std::vector<CodeNER::NamedEntity> RegexNER::extractClassNames(std::string_view content, const fs::path& filePath) const {
+    std::vector<NamedEntity> entities;
+    collectNames(rulesFor(languageOf(filePath)).classNames, content, EntityType::Class, {}, entities);
     return entities;
 }
 
-std::vector<CodeNER::NamedEntity> RegexNER::extractFunctionNames(const std::string& content, const fs::path& filePath) const {
+std::vector<CodeNER::NamedEntity> RegexNER::extractFunctionNames(std::string_view content, const fs::path& filePath) const {
     std::vector<NamedEntity> entities;
-    std::string extension = filePath.extension().string();
-    
-    if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".c") {
-        // C/C++ function names
-        std::regex functionRegex(R"((\w+)\s*\([^{;]*\)\s*(?:const)?\s*(?:noexcept)?\s*(?:override)?\s*(?:final)?\s*(?:=\s*0)?\s*(?:=\s*delete)?\s*(?:=\s*default)?\s*(?:;|{))");
-        
-        std::sregex_iterator it(content.begin(), content.end(), functionRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 1) {
-                // Skip common keywords that might be mistaken for function names
-                std::string name = it->str(1);
-                if (name != "if" && name != "for" && name != "while" && name != "switch" &&
-                    name != "catch" && name != "return" && name != "sizeof") {
-                    entities.push_back(NamedEntity(name, EntityType::Function));
-                }
-            }
-        }
-    } 
-    else if (extension == ".py") {
-        // Python function names
-        std::regex functionRegex(R"(def\s+(\w+)\s*\()");
-        
-        std::sregex_iterator it(content.begin(), content.end(), functionRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 1) {
-                entities.push_back(NamedEntity(it->str(1), EntityType::Function));
-            }
-        }
-    }
-    else if (extension == ".js" || extension == ".ts" || extension == ".jsx" || extension == ".tsx") {
-        // JavaScript/TypeScript function names
-        // Function declarations
-        std::regex functionRegex(R"(function\s+(\w+)\s*\()");
-        // Arrow functions with assignment
-        std::regex arrowFunctionRegex(R"(const\s+(\w+)\s*=\s*(?:async\s+)?\([^{]*\)\s*=>)");
-        // Class methods
-        std::regex methodRegex(R"((\w+)\s*\([^{]*\)\s*\{)");
-        
-        std::sregex_iterator funcIt(content.begin(), content.end(), functionRegex);
-        std::sregex_iterator arrowIt(content.begin(), content.end(), arrowFunctionRegex);
-        std::sregex_iterator methodIt(content.begin(), content.end(), methodRegex);
-        std::sregex_iterator end;
-        
-        for (; funcIt != end; ++funcIt) {
-            if (funcIt->size() > 1) {
-                entities.push_back(NamedEntity(funcIt->str(1), EntityType::Function));
-            }
-        }
-        
-        for (; arrowIt != end; ++arrowIt) {
-            if (arrowIt->size() > 1) {
-                entities.push_back(NamedEntity(arrowIt->str(1), EntityType::Function));
-            }
-        }
-        
-        for (; methodIt != end; ++methodIt) {
-            if (methodIt->size() > 1) {
-                std::string name = methodIt->str(1);
-                // Skip common keywords and constructor
-                if (name != "if" && name != "for" && name != "while" && name != "switch" &&
-                    name != "catch" && name != "constructor") {
-                    entities.push_back(NamedEntity(name, EntityType::Function));
-                }
-            }
-        }
+    const LanguageRules& rules = rulesFor(languageOf(filePath));
+    for (const auto& regex : rules.functionNames) {
+        collectNames(regex, content, EntityType::Function, rules.functionStopWords, entities);
     }
-    
     return entities;
 }
 
-// Placeholder implementations for other entity extraction methods
-std::vector<CodeNER::NamedEntity> RegexNER::extractVariableNames(const std::string& content, const fs::path& filePath) const {
+std::vector<CodeNER::NamedEntity> RegexNER::extractVariableNames(std::string_view content, const fs::path& filePath) const {
     std::vector<NamedEntity> entities;
-    std::string extension = filePath.extension().string();
-    
-    if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".c") {
-        // C/C++ variable declarations
-        std::regex varRegex(R"((?:int|float|double|char|bool|unsigned|long|short|size_t|uint\d+_t|int\d+_t|std::string|string|auto|constexpr|const|static)\s+(\w+)\s*(?:=|;|\[))");
-        
-        std::sregex_iterator it(content.begin(), content.end(), varRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 1) {
-                entities.push_back(NamedEntity(it->str(1), EntityType::Variable));
-            }
-        }
-    }
-    else if (extension == ".py") {
-        // Simple Python variable assignments
-        std::regex varRegex(R"((\w+)\s*=\s*[^=])");
-        
-        std::sregex_iterator it(content.begin(), content.end(), varRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 1) {
-                std::string name = it->str(1);
-                if (name != "if" && name != "for" && name != "while" && name != "def") {
-                    entities.push_back(NamedEntity(name, EntityType::Variable));
-                }
-            }
-        }
-    }
-    
+    const LanguageRules& rules = rulesFor(languageOf(filePath));
+    collectNames(rules.variableNames, content, EntityType::Variable, rules.variableStopWords, entities);
     return entities;
 }
 
-std::vector<CodeNER::NamedEntity> RegexNER::extractEnumValues(const std::string& content, const fs::path& filePath) const {
+std::vector<CodeNER::NamedEntity> RegexNER::extractEnumValues(std::string_view content, const fs::path& filePath) const {
     std::vector<NamedEntity> entities;
-    // Basic implementation for C/C++ enums
-    if (filePath.extension() == ".cpp" || filePath.extension() == ".hpp" || filePath.extension() == ".h") {
-        std::regex enumRegex(R"(enum\s+(?:class\s+)?(\w+))");
-        std::sregex_iterator it(content.begin(), content.end(), enumRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 1) {
-                entities.push_back(NamedEntity(it->str(1), EntityType::Enum));
-            }
-        }
-    }
+    collectNames(rulesFor(languageOf(filePath)).enumNames, content, EntityType::Enum, {}, entities);
     return entities;
 }
 
-std::vector<CodeNER::NamedEntity> RegexNER::extractImports(const std::string& content, const fs::path& filePath) const {
+std::vector<CodeNER::NamedEntity> RegexNER::extractImports(std::string_view content, const fs::path& filePath) const {
     std::vector<NamedEntity> entities;
-    std::string extension = filePath.extension().string();
-    
-    if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".c") {
-        // C/C++ includes
-        std::regex includeRegex(R"(#include\s*[<"]([^>"]+)[>"])");
-        
-        std::sregex_iterator it(content.begin(), content.end(), includeRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 1) {
-                entities.push_back(NamedEntity(it->str(1), EntityType::Import));
-            }
-        }
-    }
-    else if (extension == ".py") {
-        // Python imports
-        std::regex importRegex(R"(import\s+(\w+))");
-        
-        std::sregex_iterator it(content.begin(), content.end(), importRegex);
-        std::sregex_iterator end;
-        
-        for (; it != end; ++it) {
-            if (it->size() > 1) {
-                entities.push_back(NamedEntity(it->str(1), EntityType::Import));
-            }
-        }
-    }
-    
+    collectNames(rulesFor(languageOf(filePath)).importNames, content, EntityType::Import, {}, entities);
     return entities;
 }
 
 // TreeSitterNER implementation
-struct TreeSitterNER::TreeSitterImpl {
-    TSParser* parser = nullptr;
-    std::unordered_map<std::string, TSLanguage*> languages;
-    std::unordered_map<std::string, TSQuery*> queries;
-    
-    TreeSitterImpl() {
-        // Initialize parser
-        parser = ts_parser_new();
-        
-        // Initialize supported languages
-        languages["cpp"] = tree_sitter_cpp();
-        languages["c"] = tree_sitter_c();
-        languages["python"] = tree_sitter_python();
-        languages["javascript"] = tree_sitter_javascript();
-        languages["typescript"] = tree_sitter_javascript(); // TypeScript uses JavaScript grammar for basic parsing
-        
-        // Create queries for entity extraction
-        // Function declarations
-        const char* cpp_function_query = "(function_definition declarator: (function_declarator declarator: (identifier) @function.name)) @function.def";
-        const char* python_function_query = "(function_definition name: (identifier) @function.name) @function.def";
-        const char* js_function_query = "(function_declaration name: (identifier) @function.name) @function.def";
-        
-        // Class declarations
-        const char* cpp_class_query = "(class_specifier name: (type_identifier) @class.name) @class.def";
-        const char* python_class_query = "(class_definition name: (identifier) @class.name) @class.def";
-        const char* js_class_query = "(class_declaration name: (identifier) @class.name) @class.def";
-        
-        // Import statements
-        const char* cpp_include_query = "(preproc_include path: (string_literal) @import.path) @import.statement";
-        const char* python_import_query = "(import_statement module_name: (dotted_name (identifier) @import.name)) @import.statement";
-        const char* js_import_query = "(import_statement source: (string) @import.path) @import.statement";
-        
-        // Initialize queries
-        uint32_t error_offset;
-        TSQueryError error_type;
-        
-        // C++ queries
-        queries["cpp_function"] = ts_query_new(languages["cpp"], cpp_function_query, strlen(cpp_function_query), &error_offset, &error_type);
-        queries["cpp_class"] = ts_query_new(languages["cpp"], cpp_class_query, strlen(cpp_class_query), &error_offset, &error_type);
-        queries["cpp_import"] = ts_query_new(languages["cpp"], cpp_include_query, strlen(cpp_include_query), &error_offset, &error_type);
-        
-        // Python queries
-        queries["python_function"] = ts_query_new(languages["python"], python_function_query, strlen(python_function_query), &error_offset, &error_type);
-        queries["python_class"] = ts_query_new(languages["python"], python_class_query, strlen(python_class_query), &error_offset, &error_type);
-        queries["python_import"] = ts_query_new(languages["python"], python_import_query, strlen(python_import_query), &error_offset, &error_type);
-        
-        // JavaScript queries
-        queries["javascript_function"] = ts_query_new(languages["javascript"], js_function_query, strlen(js_function_query), &error_offset, &error_type);
-        queries["javascript_class"] = ts_query_new(languages["javascript"], js_class_query, strlen(js_class_query), &error_offset, &error_type);
-        queries["javascript_import"] = ts_query_new(languages["javascript"], js_import_query, strlen(js_import_query), &error_offset, &error_type);
-    }
-    
-    ~TreeSitterImpl() {
-        // Free parser
-        if (parser) {
-            ts_parser_delete(parser);
-        }
-        
-        // Free queries
-        for (auto& query : queries) {
-            if (query.second) {
-                ts_query_delete(query.second);
-            }
-        }
-        
-        // Note: Languages are not owned by us, so we don't delete them
-    }
-};
-
 TreeSitterNER::TreeSitterNER(const SummarizationOptions& options) 
-    : options_(options), impl_(std::make_unique<TreeSitterImpl>()) {
-    // TreeSitter implementation is now properly initialized
+    : options_(options) {
 }
 
 TreeSitterNER::~TreeSitterNER() = default;
 
 std::vector<CodeNER::NamedEntity> TreeSitterNER::extractEntities(
-    const std::string& content, 
+    std::string_view content, 
     const fs::path& filePath
 ) const {
-    std::vector<NamedEntity> entities;
-    
-    // Check if we can initialize the parser for this file type
-    std::string language = getLanguage(filePath);
-    if (language.empty() || !impl_->languages.count(language)) {
-        // Fallback to regex NER if tree-sitter doesn't support this language
-        RegexNER fallback(options_);
-        return fallback.extractEntities(content, filePath);
-    }
-    
-    // Set language in parser
-    ts_parser_set_language(impl_->parser, impl_->languages[language]);
-    
-    // Parse the file with tree-sitter
-    TSTree* tree = ts_parser_parse_string(
-        impl_->parser,
-        nullptr,  // Previous tree for incremental parsing
-        content.c_str(),
-        static_cast<uint32_t>(content.length())
-    );
-    
-    if (!tree) {
-        // Parsing failed, fallback to regex
+    return extractEntitiesFrom(ParsedUnit::parse(content, filePath), content, filePath);
+}
+
+/**
+ * @brief Reads entities off a parsed unit
+ * 
+ * Safe to call from several threads at once. Falls back to regex NER if no
+ * grammar covers the file or it could not be parsed.
+ */
+std::vector<CodeNER::NamedEntity> TreeSitterNER::extractEntitiesFrom(
+    const ParsedUnit& unit,
+    std::string_view content, 
+    const fs::path& filePath
+) const {
+    if (!unit.parsed()) {
         RegexNER fallback(options_);
         return fallback.extractEntities(content, filePath);
     }
     
-    // Get the root node
-    TSNode root_node = ts_tree_root_node(tree);
-    
-    // Extract entities using queries
-    std::vector<std::string> queryTypes = {"function", "class", "import"};
-    
-    for (const auto& queryType : queryTypes) {
-        std::string queryName = language + "_" + queryType;
-        if (impl_->queries.count(queryName) && impl_->queries[queryName]) {
-            TSQuery* query = impl_->queries[queryName];
-            TSQueryCursor* cursor = ts_query_cursor_new();
-            
-            ts_query_cursor_exec(cursor, query, root_node);
-            
-            TSQueryMatch match;
-            while (ts_query_cursor_next_match(cursor, &match)) {
-                for (uint32_t i = 0; i < match.capture_count; i++) {
-                    TSQueryCapture capture = match.captures[i];
-                    
-                    // Skip captures that aren't entity names
-                    const char* capture_name;
-                    uint32_t capture_name_len;
-                    ts_query_capture_name_for_id(query, capture.index, &capture_name, &capture_name_len);
-                    std::string captureName(capture_name, capture_name_len);
-                    
-                    if (captureName.find(".name") != std::string::npos) {
-                        TSNode node = capture.node;
-                        uint32_t start_byte = ts_node_start_byte(node);
-                        uint32_t end_byte = ts_node_end_byte(node);
-                        
-                        std::string entityName = content.substr(start_byte, end_byte - start_byte);
-                        
-                        EntityType type;
-                        if (captureName.find("function") != std::string::npos) {
-                            type = EntityType::Function;
-                        } else if (captureName.find("class") != std::string::npos) {
-                            type = EntityType::Class;
-                        } else if (captureName.find("import") != std::string::npos) {
-                            type = EntityType::Import;
-                        } else {
-                            continue;  // Skip unknown entity types
-                        }
-                        
-                        entities.push_back(NamedEntity(entityName, type));
-                    }
-                }
-            }
-            
-            ts_query_cursor_delete(cursor);
+    std::vector<NamedEntity> entities;
+    for (const auto& span : unit.spans()) {
+        EntityType type;
+        switch (span.kind) {
+            case ParsedUnit::Kind::Function: type = EntityType::Function; break;
+            case ParsedUnit::Kind::Class:    type = EntityType::Class; break;
+            case ParsedUnit::Kind::Import:   type = EntityType::Import; break;
+            default: continue;  // Skip spans that are not entities
+        }
+        
+        std::string_view name = unit.name(span);
+        if (!name.empty()) {
+            entities.push_back(NamedEntity(std::string(name), type));
         }
     }
     
-    // Free the tree
-    ts_tree_delete(tree);
-    
     return entities;
 }
 
-bool TreeSitterNER::initializeParser(const fs::path& filePath) const {
-    // Get language for the file
-    std::string language = getLanguage(filePath);
-    
-    // Check if we support this language
-    return !language.empty() && impl_->languages.count(language) > 0;
-}
-
-std::string TreeSitterNER::getLanguage(const fs::path& filePath) const {
-    // Map file extension to tree-sitter language
-    std::string extension = filePath.extension().string();
-    
-    if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".cc") return "cpp";
-    if (extension == ".c") return "c";
-    if (extension == ".py") return "python";
-    if (extension == ".js") return "javascript";
-    if (extension == ".ts") return "typescript";
-    if (extension == ".jsx") return "javascript";
-    if (extension == ".tsx") return "typescript";
-    
-    return "";
-}
-
 // MLNER implementation
 MLNER::MLNER(const SummarizationOptions& options) 
     : options_(options), impl_(std::make_unique<MLImpl>()) {
@@ -550,7 +318,7 @@ bool MLNER::initializeModel() const {
         
         // Set up session options
         Ort::SessionOptions sessionOptions;
-        sessionOptions.SetIntraOpNumThreads(2);
+        sessionOptions.SetIntraOpNumThreads(std::max(1, options_.mlIntraOpThreads));
         sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_BASIC);
         
         // Load the model
@@ -605,56 +373,96 @@ bool MLNER::loadVocabulary(const std::string& vocabPath) const {
     return false;
 }
 
-std::vector<int32_t> MLNER::tokenize(const std::string& text) const {
+/**
+ * @brief Maps the words of a text to vocabulary ids
+ *
+ * @param text Text to tokenize
+ * @return std::vector<int32_t> Ids of the words, without [CLS] and [SEP],
+ *         at most maxSeqLength - 2 of them
+ */
+std::vector<int32_t> MLNER::tokenize(std::string_view text) const {
     std::vector<int32_t> tokens;
 #ifdef USE_ONNX_RUNTIME
-    // Very basic tokenization - split on whitespace and punctuation
-    std::istringstream iss(text);
-    std::string token;
-    
-    // Add CLS token
-    tokens.push_back(impl_->tokenizerConfig.clsTokenId);
-    
-    // Add content tokens
-    while (iss >> token) {
+    const TokenizerConfig& config = impl_->tokenizerConfig;
+    const size_t maxTokens = static_cast<size_t>(std::max(config.maxSeqLength - 2, 1));
+    
+    // Very basic tokenization - split on whitespace
+    size_t pos = 0;
+    while (pos < text.size() && tokens.size() < maxTokens) {
+        pos = text.find_first_not_of(" \t\r\n", pos);
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        size_t end = text.find_first_of(" \t\r\n", pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        
         // Check if token exists in vocab
-        auto it = impl_->tokenizerConfig.vocabMap.find(token);
-        if (it != impl_->tokenizerConfig.vocabMap.end()) {
-            tokens.push_back(it->second);
-        } else {
-            // Unknown token
-            tokens.push_back(impl_->tokenizerConfig.unkTokenId);
+        auto it = config.vocabMap.find(std::string(text.substr(pos, end - pos)));
+        tokens.push_back(it != config.vocabMap.end() ? it->second : config.unkTokenId);
+        pos = end;
+    }
+#else
+    (void)text;
+#endif
+    return tokens;
+}
+
+/**
+ * @brief Packs consecutive lines into model-sized windows
+ *
+ * Lines are appended to the current window until the next one would push it
+ * past maxSeqLength, so each inference row carries a few lines of context
+ * instead of one. A line too long for a window on its own is truncated.
+ *
+ * @param content Source text
+ * @return std::vector<std::vector<int32_t>> Windows, each [CLS] ids... [SEP]
+ */
+std::vector<std::vector<int32_t>> MLNER::packWindows(std::string_view content) const {
+    std::vector<std::vector<int32_t>> windows;
+#ifdef USE_ONNX_RUNTIME
+    const TokenizerConfig& config = impl_->tokenizerConfig;
+    const size_t maxLength = static_cast<size_t>(std::max(config.maxSeqLength, 3));
+    
+    std::vector<int32_t> window{config.clsTokenId};
+    auto flush = [&]() {
+        if (window.size() > 1) {
+            window.push_back(config.sepTokenId);
+            windows.push_back(std::move(window));
         }
+        window.assign(1, config.clsTokenId);
+    };
+    
+    size_t lineStart = 0;
+    while (lineStart < content.size()) {
+        size_t lineEnd = content.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = content.size();
+        }
+        std::vector<int32_t> ids = tokenize(content.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
         
-        // Limit token length to prevent buffer overflow
-        if (tokens.size() >= static_cast<size_t>(impl_->tokenizerConfig.maxSeqLength - 1)) {
-            break;
+        if (ids.empty()) {
+            continue;
         }
+        // Room is left for [SEP]
+        if (window.size() + ids.size() + 1 > maxLength) {
+            flush();
+        }
+        window.insert(window.end(), ids.begin(), ids.end());
     }
-    
-    // Add SEP token
-    tokens.push_back(impl_->tokenizerConfig.sepTokenId);
+    flush();
+#else
+    (void)content;
 #endif
-    return tokens;
+    return windows;
 }
 
 std::vector<CodeNER::NamedEntity> MLNER::extractEntities(
-    const std::string& content, 
+    std::string_view content, 
     const fs::path& filePath
 ) const {
-    // Check if caching is enabled and if we have cached results
-    if (options_.cacheMLResults) {
-        std::string cacheKey = filePath.string();
-        
-        {
-            std::lock_guard<std::mutex> lock(cacheMutex_);
-            auto it = entityCache_.find(cacheKey);
-            if (it != entityCache_.end()) {
-                return it->second;
-            }
-        }
-    }
-    
     // Start timing
     auto startTime = std::chrono::steady_clock::now();
     
@@ -687,104 +495,45 @@ std::vector<CodeNER::NamedEntity> MLNER::extractEntities(
         mlEntities = fallback.extractEntities(content, filePath);
     }
     
-    // Cache results if enabled
-    if (options_.cacheMLResults) {
-        std::string cacheKey = filePath.string();
-        
-        {
-            std::lock_guard<std::mutex> lock(cacheMutex_);
-            entityCache_[cacheKey] = mlEntities;
-        }
-    }
-    
     return mlEntities;
 }
 
+/**
+ * @brief Runs the model over a file in padded batches
+ *
+ * The file is packed into windows and mlBatchSize windows at a time go
+ * through one session run. Batches stop early once maxMLProcessingTimeMs is
+ * used up; the caller then falls back to regex NER anyway.
+ *
+ * @param content Source text
+ * @param filePath Path of the file (unused by the model)
+ * @return std::vector<NamedEntity> Entities in source order
+ */
 std::vector<CodeNER::NamedEntity> MLNER::runInference(
-    const std::string& content, 
+    std::string_view content, 
     const fs::path& filePath
 ) const {
+    (void)filePath;
     std::vector<NamedEntity> entities;
 
 #ifdef USE_ONNX_RUNTIME
     try {
-        // Simplified implementation for inference
-        // Break the content into lines for processing
-        std::vector<std::string> lines;
-        std::istringstream iss(content);
-        std::string line;
-        while (std::getline(iss, line)) {
-            if (!line.empty()) {
-                lines.push_back(line);
-            }
-        }
-        
-        // Process each line individually to avoid excessive token length
-        for (const auto& line : lines) {
-            // Tokenize the line
-            std::vector<int32_t> inputIds = tokenize(line);
-            if (inputIds.size() <= 2) continue; // Skip empty lines (just CLS and SEP tokens)
-            
-            // Create tensors
-            std::vector<int64_t> inputShape = {1, static_cast<int64_t>(inputIds.size())};
-            auto inputTensor = Ort::Value::CreateTensor<int32_t>(
-                *impl_->memoryInfo, inputIds.data(), inputIds.size(), 
-                inputShape.data(), inputShape.size());
-            
-            // Set up names
-            std::vector<const char*> inputNames = {"input_ids"};
-            std::vector<const char*> outputNames = {"logits"};
-            
-            // Run inference
-            auto outputTensors = impl_->session->Run(
-                Ort::RunOptions{nullptr}, 
-                inputNames.data(), &inputTensor, 1, 
-                outputNames.data(), 1);
-            
-            // Process the output tensor
-            auto* outputData = outputTensors[0].GetTensorData<float>();
-            auto outputShape = outputTensors[0].GetTensorTypeAndShapeInfo().GetShape();
-            
-            // The output shape is [1, sequence_length, num_labels]
-            int64_t seqLen = outputShape[1];
-            int64_t numLabels = outputShape[2];
-            
-            // Convert logits to labels
-            std::vector<int> predictedLabels;
-            for (int i = 1; i < seqLen - 1; i++) { // Skip CLS and SEP tokens
-                int maxLabelIdx = 0;
-                float maxProb = outputData[i * numLabels];
-                
-                for (int j = 1; j < numLabels; j++) {
-                    if (outputData[i * numLabels + j] > maxProb) {
-                        maxProb = outputData[i * numLabels + j];
-                        maxLabelIdx = j;
-                    }
-                }
-                
-                predictedLabels.push_back(maxLabelIdx);
-            }
-            
-            // Extract tokens (excluding CLS and SEP)
-            std::vector<std::string> tokens;
-            for (size_t i = 1; i < inputIds.size() - 1; i++) {
-                int32_t id = inputIds[i];
-                if (id < impl_->tokenizerConfig.idToToken.size()) {
-                    tokens.push_back(impl_->tokenizerConfig.idToToken[id]);
-                } else {
-                    tokens.push_back("<unk>");
-                }
-            }
-            
-            // Extract entities based on predicted labels
-            auto lineEntities = extractEntitiesFromLabels(tokens, predictedLabels);
-            for (const auto& [name, type] : lineEntities) {
-                entities.push_back(NamedEntity(name, type));
+        const std::vector<std::vector<int32_t>> windows = packWindows(content);
+        const size_t batchSize = static_cast<size_t>(std::max(1, options_.mlBatchSize));
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::milliseconds(options_.maxMLProcessingTimeMs);
+        
+        for (size_t begin = 0; begin < windows.size(); begin += batchSize) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                break;
             }
+            runBatch(windows, begin, std::min(windows.size(), begin + batchSize), entities);
         }
     } catch (const std::exception& e) {
         std::cerr << "Error during ONNX inference: " << e.what() << std::endl;
     }
+#else
+    (void)content;
 #endif
 
     // Add some dummy values for demonstration if we didn't find any real entities
@@ -797,6 +546,107 @@ std::vector<CodeNER::NamedEntity> MLNER::runInference(
     return entities;
 }
 
+/**
+ * @brief Runs one batch of windows through the model
+ *
+ * Rows are right-padded to the longest window of the batch; the attention
+ * mask marks the real tokens and is passed when the model takes one.
+ *
+ * @param windows Packed windows of the file
+ * @param begin First window of the batch
+ * @param end One past the last window of the batch
+ * @param entities Receives the entities found, in window order
+ */
+void MLNER::runBatch(
+    const std::vector<std::vector<int32_t>>& windows,
+    size_t begin,
+    size_t end,
+    std::vector<NamedEntity>& entities
+) const {
+#ifdef USE_ONNX_RUNTIME
+    const TokenizerConfig& config = impl_->tokenizerConfig;
+    const size_t rows = end - begin;
+    size_t length = 0;
+    for (size_t row = begin; row < end; ++row) {
+        length = std::max(length, windows[row].size());
+    }
+    if (rows == 0 || length == 0) {
+        return;
+    }
+    
+    std::vector<int32_t> inputIds(rows * length, config.padTokenId);
+    std::vector<int32_t> attentionMask(rows * length, 0);
+    for (size_t row = 0; row < rows; ++row) {
+        const auto& window = windows[begin + row];
+        std::copy(window.begin(), window.end(), inputIds.begin() + row * length);
+        std::fill_n(attentionMask.begin() + row * length, window.size(), 1);
+    }
+    
+    // Create tensors
+    std::vector<int64_t> inputShape = {static_cast<int64_t>(rows), static_cast<int64_t>(length)};
+    std::vector<Ort::Value> inputTensors;
+    inputTensors.push_back(Ort::Value::CreateTensor<int32_t>(
+        *impl_->memoryInfo, inputIds.data(), inputIds.size(), 
+        inputShape.data(), inputShape.size()));
+    std::vector<const char*> inputNames = {"input_ids"};
+    if (impl_->session->GetInputCount() > 1) {
+        inputTensors.push_back(Ort::Value::CreateTensor<int32_t>(
+            *impl_->memoryInfo, attentionMask.data(), attentionMask.size(), 
+            inputShape.data(), inputShape.size()));
+        inputNames.push_back("attention_mask");
+    }
+    std::vector<const char*> outputNames = {"logits"};
+    
+    // Run inference
+    auto outputTensors = impl_->session->Run(
+        Ort::RunOptions{nullptr}, 
+        inputNames.data(), inputTensors.data(), inputTensors.size(), 
+        outputNames.data(), 1);
+    
+    // The output shape is [rows, length, num_labels]
+    const float* outputData = outputTensors[0].GetTensorData<float>();
+    auto outputShape = outputTensors[0].GetTensorTypeAndShapeInfo().GetShape();
+    if (outputShape.size() != 3) {
+        return;
+    }
+    const size_t outputLength = static_cast<size_t>(outputShape[1]);
+    const size_t numLabels = static_cast<size_t>(outputShape[2]);
+    
+    for (size_t row = 0; row < rows; ++row) {
+        const auto& window = windows[begin + row];
+        const float* rowData = outputData + row * outputLength * numLabels;
+        
+        // Convert logits to labels, skipping CLS and SEP
+        std::vector<std::string> tokens;
+        std::vector<std::string> labels;
+        for (size_t i = 1; i + 1 < window.size() && i < outputLength; ++i) {
+            const float* logits = rowData + i * numLabels;
+            const size_t best = static_cast<size_t>(std::max_element(logits, logits + numLabels) - logits);
+            
+            auto label = impl_->labelMap.find(static_cast<int>(best));
+            labels.push_back(label != impl_->labelMap.end() ? label->second : "O");
+            
+            const int32_t id = window[i];
+            if (id >= 0 && static_cast<size_t>(id) < config.idToToken.size()) {
+                tokens.push_back(config.idToToken[id]);
+            } else {
+                tokens.push_back("<unk>");
+            }
+        }
+        
+        // Extract entities based on predicted labels
+        for (const auto& [name, type] : extractEntitiesFromLabels(tokens, labels)) {
+            entities.push_back(NamedEntity(name, type));
+        }
+    }
+#else
+    (void)windows;
+    (void)begin;
+    (void)end;
+    (void)entities;
+#endif
+}
+
 std::vector<std::pair<std::string, CodeNER::EntityType>> MLNER::extractEntitiesFromLabels(
     const std::vector<std::string>& tokens,
     const std::vector<std::string>& labels
@@ -905,7 +755,7 @@ HybridNER::HybridNER(const SummarizationOptions& options)
 }
 
 std::vector<CodeNER::NamedEntity> HybridNER::extractEntities(
-    const std::string& content, 
+    std::string_view content, 
     const fs::path& filePath
 ) const {
     // Choose the appropriate NER method
@@ -915,8 +765,16 @@ std::vector<CodeNER::NamedEntity> HybridNER::extractEntities(
     return nerMethod->extractEntities(content, filePath);
 }
 
+std::vector<CodeNER::NamedEntity> HybridNER::extractEntitiesFrom(
+    const ParsedUnit& unit,
+    std::string_view content, 
+    const fs::path& filePath
+) const {
+    return chooseNERMethod(content, filePath)->extractEntitiesFrom(unit, content, filePath);
+}
+
 CodeNER* HybridNER::chooseNERMethod(
-    const std::string& content, 
+    std::string_view content, 
     const fs::path& filePath
 ) const {
     // Use ML for large files if available
@@ -0,0 +1,53 @@
+#include "content_chunks.hpp"
+#include <algorithm>
+
+namespace {
+
+// Position just past the newline at or after pos, or the end of content
+size_t lineEndFrom(std::string_view content, size_t pos) {
+    if (pos >= content.size()) {
+        return content.size();
+    }
+    const size_t newline = content.find('\n', pos);
+    return newline == std::string_view::npos ? content.size() : newline + 1;
+}
+
+// Start of the line containing pos
+size_t lineStartAt(std::string_view content, size_t pos) {
+    if (pos == 0) {
+        return 0;
+    }
+    const size_t newline = content.rfind('\n', pos - 1);
+    return newline == std::string_view::npos ? 0 : newline + 1;
+}
+
+}  // namespace
+
+/**
+ * @brief Plans line-aligned chunks over a buffer
+ *
+ * @param content Buffer to split
+ * @param chunkSize Target bytes per chunk; 0 is treated as 1
+ * @param overlap Bytes each window reads before and after its chunk
+ * @return std::vector<ContentChunk> Chunks in order, covering content exactly
+ *
+ * Chunk and window bounds are each found with one search for the nearest
+ * newline, so planning touches a few bytes per chunk rather than the whole file.
+ */
+std::vector<ContentChunk> splitIntoChunks(std::string_view content, size_t chunkSize, size_t overlap) {
+    std::vector<ContentChunk> chunks;
+    const size_t step = std::max<size_t>(1, chunkSize);
+    chunks.reserve(content.size() / step + 1);
+
+    size_t begin = 0;
+    while (begin < content.size()) {
+        ContentChunk chunk;
+        chunk.windowBegin = begin <= overlap ? 0 : lineStartAt(content, begin - overlap);
+        chunk.begin = begin;
+        chunk.end = lineEndFrom(content, begin + step - 1);
+        chunk.windowEnd = overlap == 0 ? chunk.end : lineEndFrom(content, chunk.end + overlap - 1);
+        chunks.push_back(chunk);
+        begin = chunk.end;
+    }
+    return chunks;
+}
@@ -0,0 +1,110 @@
+#include "directory_tree.hpp"
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+uint32_t DirectoryTree::intern(std::string_view name) {
+    auto it = nameIds_.find(name);
+    if (it != nameIds_.end()) {
+        return it->second;
+    }
+    const uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.emplace_back(name);
+    nameIds_.emplace(names_.back(), id);
+    return id;
+}
+
+uint32_t DirectoryTree::child(uint32_t parent, std::string_view name, bool isDirectory) {
+    const uint32_t nameId = intern(name);
+    const uint64_t key = (static_cast<uint64_t>(parent) << 32) | nameId;
+    auto it = childIndex_.find(key);
+    if (it != childIndex_.end()) {
+        // A path seen as a file and later as a prefix is a directory
+        nodes_[it->second].isDirectory |= isDirectory;
+        return it->second;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(nodes_.size());
+    Node node;
+    node.name = nameId;
+    node.isDirectory = isDirectory;
+    nodes_.push_back(std::move(node));
+    nodes_[parent].children.push_back(index);
+    childIndex_.emplace(key, index);
+    return index;
+}
+
+/**
+ * @brief Adds a file and the directories leading to it
+ *
+ * @param relativePath Path of the file relative to the tree's root; "." and
+ *        empty components are skipped
+ */
+void DirectoryTree::add(const fs::path& relativePath) {
+    std::vector<std::string> components;
+    for (const auto& component : relativePath) {
+        std::string name = component.string();
+        if (!name.empty() && name != "." && name != "/") {
+            components.push_back(std::move(name));
+        }
+    }
+    if (components.empty()) {
+        return;
+    }
+
+    uint32_t node = ROOT;
+    for (size_t i = 0; i + 1 < components.size(); ++i) {
+        node = child(node, components[i], true);
+    }
+    const size_t before = nodes_.size();
+    child(node, components.back(), false);
+    if (nodes_.size() > before) {
+        ++fileCount_;
+    }
+}
+
+/**
+ * @brief Writes the tree in one depth-first pass
+ *
+ * @param out Stream receiving the tree
+ *
+ * Uses an explicit stack, so deep trees cannot overflow the call stack.
+ */
+void DirectoryTree::render(std::ostream& out) const {
+    auto sortedChildren = [this](uint32_t node) {
+        std::vector<uint32_t> children = nodes_[node].children;
+        std::sort(children.begin(), children.end(), [this](uint32_t a, uint32_t b) {
+            return names_[nodes_[a].name] < names_[nodes_[b].name];
+        });
+        return children;
+    };
+
+    // Each frame holds a directory's sorted entries and the next one to write
+    std::vector<std::pair<std::vector<uint32_t>, size_t>> stack;
+    stack.emplace_back(sortedChildren(ROOT), 0);
+    std::string indent;
+    while (!stack.empty()) {
+        auto& [children, next] = stack.back();
+        if (next == children.size()) {
+            stack.pop_back();
+            if (!indent.empty()) {
+                indent.resize(indent.size() - 2);
+            }
+            continue;
+        }
+
+        const Node& node = nodes_[children[next++]];
+        out << indent << (node.isDirectory ? "📁 " : "📄 ") << names_[node.name] << '\n';
+        if (node.isDirectory && !node.children.empty()) {
+            const uint32_t index = static_cast<uint32_t>(&node - nodes_.data());
+            stack.emplace_back(sortedChildren(index), 0);
+            indent += "  ";
+        }
+    }
+}
+
+std::string DirectoryTree::render() const {
+    std::ostringstream out;
+    render(out);
+    return out.str();
+}
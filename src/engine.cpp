@@ -0,0 +1,149 @@
+#include "engine.hpp"
+#include "code_ner.hpp"
+#include "repomix.hpp"
+#include <sstream>
+
+namespace {
+
+// Everything CodeNER::create and the recognizers read from the options
+std::string recognizerKey(const SummarizationOptions& o) {
+    std::ostringstream key;
+    key << static_cast<int>(o.nerMethod) << '|' << o.useTreeSitter << o.cacheMLResults
+        << '|' << o.useMLForLargeFiles << '|' << o.mlNerSizeThreshold << '|' << o.mlModelPath
+        << '|' << o.mlConfidenceThreshold << '|' << o.maxMLProcessingTimeMs
+        << '|' << o.mlBatchSize << '|' << o.mlIntraOpThreads
+        << '|' << o.includeClassNames << o.includeFunctionNames << o.includeVariableNames
+        << o.includeEnumValues << o.includeImports << '|' << o.maxEntities;
+    return key.str();
+}
+
+// A recognizer and the options it keeps a reference to
+struct Recognizer {
+    SummarizationOptions options;
+    std::unique_ptr<CodeNER> ner;
+};
+
+}  // namespace
+
+/**
+ * @brief Prepares the default ignore patterns
+ *
+ * Tokenizers, recognizers and scoring patterns are built on first use, or
+ * ahead of time with warmUp.
+ */
+Engine::Engine() {
+    Repomix::addDefaultIgnorePatterns(defaultPatterns_);
+}
+
+/**
+ * @brief Returns the tokenizer of an encoding
+ *
+ * @param encoding Encoding to count tokens in
+ * @return std::shared_ptr<const Tokenizer> The engine's tokenizer for encoding
+ */
+std::shared_ptr<const Tokenizer> Engine::tokenizer(TokenizerEncoding encoding) {
+    return lookup(tokenizers_, Tokenizer::getSupportedEncodings().size(), Tokenizer::encodingToString(encoding),
+                  [encoding]() { return std::make_shared<const Tokenizer>(encoding); });
+}
+
+/**
+ * @brief Returns a recognizer for the entity recognition options of a run
+ *
+ * @param options Summarization options of the run
+ * @return std::shared_ptr<const CodeNER> Recognizer, or nullptr if entity
+ *         recognition is off
+ *
+ * Runs whose options differ only in fields the recognizers do not read share
+ * a recognizer. It keeps its own copy of the options, so it stays valid after
+ * the run that asked for it has ended.
+ */
+std::shared_ptr<const CodeNER> Engine::codeNER(const SummarizationOptions& options) {
+    if (!options.includeEntityRecognition) {
+        return nullptr;
+    }
+    return lookup(recognizers_, MAX_RECOGNIZERS, recognizerKey(options), [&options]() {
+        auto recognizer = std::make_shared<Recognizer>();
+        recognizer->options = options;
+        recognizer->ner = CodeNER::create(recognizer->options);
+        return std::shared_ptr<const CodeNER>(recognizer, recognizer->ner.get());
+    });
+}
+
+/**
+ * @brief Returns the compiled patterns of a scoring configuration
+ *
+ * @param config Scoring configuration of a run
+ * @return std::shared_ptr<const FileScorer::CompiledPatterns> Patterns for FileScorer
+ */
+std::shared_ptr<const FileScorer::CompiledPatterns> Engine::scoringPatterns(const FileScoringConfig& config) {
+    return lookup(scoringPatterns_, MAX_SCORING_PATTERNS, FileScorer::patternsKey(config),
+                  [&config]() { return FileScorer::compilePatterns(config); });
+}
+
+/**
+ * @brief Builds the resources runs with these options will ask for
+ *
+ * @param options Options of the expected runs
+ *
+ * The tokenizer is built even if the options do not count tokens, since it
+ * is the most expensive resource to build on a request.
+ */
+void Engine::warmUp(const RepomixOptions& options) {
+    tokenizer(options.tokenEncoding);
+    scoringPatterns(options.scoringConfig);
+    codeNER(options.summarization);
+}
+
+Engine::Stats Engine::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+/**
+ * @brief Returns the entry for a key, building it if there is none
+ *
+ * @param entries Entries of one kind, most recently used first
+ * @param capacity Number of entries kept
+ * @param key Identifies the entry
+ * @param build Creates the resource on a miss
+ * @return std::shared_ptr<const T> The shared resource
+ *
+ * Resources are built outside the lock, so a slow build (an ONNX session)
+ * does not hold up runs that need something else. If two runs build the same
+ * resource at once, the first one stored is kept.
+ */
+template <typename T, typename Build>
+std::shared_ptr<const T> Engine::lookup(Entries<T>& entries, size_t capacity, const std::string& key, Build build) {
+    auto find = [&entries, &key]() {
+        auto it = entries.begin();
+        while (it != entries.end() && it->first != key) {
+            ++it;
+        }
+        return it;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = find();
+        if (it != entries.end()) {
+            entries.splice(entries.begin(), entries, it);
+            ++stats_.hits;
+            return it->second;
+        }
+    }
+
+    std::shared_ptr<const T> built = build();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = find();
+    if (it != entries.end()) {
+        entries.splice(entries.begin(), entries, it);
+        return it->second;
+    }
+    ++stats_.misses;
+    entries.emplace_front(key, built);
+    while (entries.size() > capacity) {
+        entries.pop_back();
+    }
+    return built;
+}
@@ -0,0 +1,149 @@
+#include "entity_cache.hpp"
+#include "result_cache.hpp"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+// Seeds the content hash of every key. The cache is shared by the jobs of all
+// clients, and XXH64 collisions can be built when the seed is known, so a
+// client could otherwise plant entities under the hash of another's file.
+uint64_t keySeed() {
+    static const uint64_t seed = [] {
+        std::random_device device;
+        return (static_cast<uint64_t>(device()) << 32) ^ device();
+    }();
+    return seed;
+}
+
+}  // namespace
+
+/**
+ * @brief Creates an empty cache
+ *
+ * @param capacity Maximum number of entries over all shards
+ * @param shardCount Number of independently locked shards
+ */
+EntityCache::EntityCache(size_t capacity, size_t shardCount)
+    : capacity_(std::max<size_t>(capacity, 1)) {
+    shardCount = std::max<size_t>(1, std::min(shardCount, capacity_));
+    shardCapacity_ = (capacity_ + shardCount - 1) / shardCount;
+    shards_.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+/**
+ * @brief Returns the process-wide cache
+ *
+ * @return EntityCache& Cache shared by all NER backends and jobs
+ */
+EntityCache& EntityCache::instance() {
+    static EntityCache cache;
+    return cache;
+}
+
+/**
+ * @brief Derives the key of a result
+ *
+ * @param content Content the entities were recognized in
+ * @param fingerprint Identifies the backend, its options and the file's language
+ * @return Key Key of the result
+ */
+EntityCache::Key EntityCache::makeKey(std::string_view content, uint64_t fingerprint) {
+    Key key;
+    key.contentHash = ResultCache::contentHash(content, keySeed());
+    key.contentSize = content.size();
+    key.fingerprint = fingerprint;
+    return key;
+}
+
+EntityCache::Shard& EntityCache::shardFor(const Key& key) {
+    // The low bits of the key hash pick the bucket inside the shard, so the
+    // shard is chosen from the high bits
+    return *shards_[(KeyHash()(key) >> 32) % shards_.size()];
+}
+
+/**
+ * @brief Looks up a result and marks it as recently used
+ *
+ * @param key Key of the result
+ * @param entities Receives a copy of the cached entities on a hit
+ * @return bool True on a hit
+ */
+bool EntityCache::lookup(const Key& key, Entities& entities) {
+    Shard& shard = shardFor(key);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            entities = it->second->second;
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief Stores a result, evicting the shard's least recently used entries if full
+ *
+ * @param key Key of the result
+ * @param entities Entities to cache
+ */
+void EntityCache::store(const Key& key, Entities entities) {
+    Shard& shard = shardFor(key);
+    size_t evicted = 0;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->second = std::move(entities);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+
+        while (shard.entries.size() >= shardCapacity_) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+            ++evicted;
+        }
+        shard.entries.emplace_front(key, std::move(entities));
+        shard.index.emplace(key, shard.entries.begin());
+    }
+    if (evicted > 0) {
+        evictions_.fetch_add(evicted, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Returns the counters and current size
+ *
+ * @return Stats Hits, misses and evictions since creation, entries held now
+ */
+EntityCache::Stats EntityCache::stats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    stats.capacity = capacity_;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->entries.size();
+    }
+    return stats;
+}
+
+/**
+ * @brief Drops all entries; the counters are kept
+ */
+void EntityCache::clear() {
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->index.clear();
+        shard->entries.clear();
+    }
+}
@@ -0,0 +1,334 @@
+#include "file_content.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct FileContent::Storage {
+    virtual ~Storage() = default;
+};
+
+namespace {
+
+struct OwnedStorage : FileContent::Storage {
+    explicit OwnedStorage(std::string s) : data(std::move(s)) {}
+    std::string data;
+};
+
+struct SharedStorage : FileContent::Storage {
+    explicit SharedStorage(std::shared_ptr<const void> o) : owner(std::move(o)) {}
+    std::shared_ptr<const void> owner;
+};
+
+struct MappedStorage : FileContent::Storage {
+    MappedStorage(void* a, size_t s) : addr(a), size(s) {}
+    ~MappedStorage() override { ::munmap(addr, size); }
+    void* addr;
+    size_t size;
+};
+
+// Read buffers are recycled so that reading thousands of small files does not
+// allocate (and page-fault in) a fresh buffer for each one
+class BufferPool {
+public:
+    struct Buffer {
+        std::unique_ptr<char[]> data;
+        size_t capacity = 0;
+    };
+
+    static BufferPool& instance() {
+        static BufferPool pool;
+        return pool;
+    }
+
+    Buffer acquire(size_t size) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < free_.size(); ++i) {
+                if (free_[i].capacity >= size) {
+                    Buffer buffer = std::move(free_[i]);
+                    free_[i] = std::move(free_.back());
+                    free_.pop_back();
+                    return buffer;
+                }
+            }
+        }
+        // Round up so a buffer fits the next, slightly larger file too
+        size_t capacity = MIN_BUFFER_SIZE;
+        while (capacity < size) {
+            capacity *= 2;
+        }
+        return Buffer{std::unique_ptr<char[]>(new char[capacity]), capacity};
+    }
+
+    void release(Buffer buffer) {
+        if (buffer.capacity > MAX_POOLED_CAPACITY) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < MAX_POOLED_BUFFERS) {
+            free_.push_back(std::move(buffer));
+        }
+    }
+
+private:
+    static constexpr size_t MIN_BUFFER_SIZE = 4 * 1024;
+    static constexpr size_t MAX_POOLED_CAPACITY = 2 * FileContent::DEFAULT_MMAP_THRESHOLD;
+    static constexpr size_t MAX_POOLED_BUFFERS = 64;
+
+    std::mutex mutex_;
+    std::vector<Buffer> free_;
+};
+
+struct PooledStorage : FileContent::Storage {
+    explicit PooledStorage(BufferPool::Buffer b) : buffer(std::move(b)) {}
+    ~PooledStorage() override { BufferPool::instance().release(std::move(buffer)); }
+    BufferPool::Buffer buffer;
+};
+
+// Reads buffer[filled, size) from fd, stopping early at end of file.
+// Returns the new fill level.
+size_t readFully(int fd, char* buffer, size_t filled, size_t size, const fs::path& path) {
+    while (filled < size) {
+        ssize_t n = ::read(fd, buffer + filled, size - filled);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to read file: " + path.string() + ": " + std::strerror(errno));
+        }
+        if (n == 0) {
+            break;
+        }
+        filled += static_cast<size_t>(n);
+    }
+    return filled;
+}
+
+// Closes a descriptor when the scope ends
+struct FdGuard {
+    int fd;
+    ~FdGuard() { ::close(fd); }
+};
+
+}  // namespace
+
+/**
+ * @brief Takes ownership of a string
+ *
+ * @param data Bytes to hold
+ */
+FileContent::FileContent(std::string data) {
+    if (data.empty()) {
+        return;
+    }
+    auto storage = std::make_shared<OwnedStorage>(std::move(data));
+    view_ = storage->data;
+    storage_ = std::move(storage);
+    backing_ = Backing::Owned;
+}
+
+FileContent::FileContent(std::shared_ptr<const Storage> storage, std::string_view view, Backing backing)
+    : storage_(std::move(storage)), view_(view), backing_(backing) {}
+
+/**
+ * @brief Views bytes owned by another object
+ *
+ * @param owner Keeps the bytes alive, e.g. the request whose body holds them
+ * @param view The bytes
+ * @return FileContent Handle that holds a reference to owner
+ */
+FileContent FileContent::share(std::shared_ptr<const void> owner, std::string_view view) {
+    if (view.empty()) {
+        return FileContent();
+    }
+    return FileContent(std::make_shared<SharedStorage>(std::move(owner)), view, Backing::Shared);
+}
+
+/**
+ * @brief Part of this content, without copying
+ *
+ * @param offset First byte of the part
+ * @param length Number of bytes
+ * @return FileContent Handle on the same storage, e.g. one member of an archive
+ * @throws std::out_of_range if the part does not lie inside the content
+ */
+FileContent FileContent::slice(size_t offset, size_t length) const {
+    if (offset > view_.size() || length > view_.size() - offset) {
+        throw std::out_of_range("Slice outside of the content");
+    }
+    if (length == 0) {
+        return FileContent();
+    }
+    return FileContent(storage_, view_.substr(offset, length), backing_);
+}
+
+/**
+ * @brief Loads a whole file
+ *
+ * @param path File to load
+ * @param mmapThreshold Files larger than this are mapped, smaller ones read
+ * @return FileContent The file's bytes
+ * @throws std::runtime_error if the file cannot be opened or read
+ */
+FileContent FileContent::load(const fs::path& path, size_t mmapThreshold) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open file: " + path.string() + ": " + std::strerror(errno));
+    }
+    FdGuard guard{fd};
+
+    struct stat sb;
+    if (::fstat(fd, &sb) == -1) {
+        throw std::runtime_error("Error getting file size for " + path.string() + ": " + std::strerror(errno));
+    }
+
+    const size_t size = static_cast<size_t>(sb.st_size);
+    if (size == 0) {
+        return FileContent();
+    }
+    if (size > mmapThreshold) {
+        return map(fd, size, path);
+    }
+    return read(fd, size, path);
+}
+
+/**
+ * @brief Maps an open file
+ *
+ * @param fd Descriptor of the file; stays open
+ * @param size Number of bytes to map
+ * @param path Path used in error messages
+ * @return FileContent View of the mapping, unmapped with the last copy
+ * @throws std::runtime_error if mmap fails
+ */
+FileContent FileContent::map(int fd, size_t size, const fs::path& path) {
+    if (size == 0) {
+        return FileContent();
+    }
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Memory mapping failed for file: " + path.string());
+    }
+    // Content is scanned front to back by every consumer
+    ::madvise(mapped, size, MADV_SEQUENTIAL);
+
+    auto storage = std::make_shared<MappedStorage>(mapped, size);
+    return FileContent(std::move(storage), std::string_view(static_cast<const char*>(mapped), size),
+                       Backing::Mapped);
+}
+
+/**
+ * @brief Reads an open file into a pooled buffer
+ *
+ * @param fd Descriptor positioned at the start of the file; stays open
+ * @param size Expected size of the file
+ * @param path Path used in error messages
+ * @return FileContent The bytes read (fewer than size if the file shrank)
+ * @throws std::runtime_error if read fails
+ */
+FileContent FileContent::read(int fd, size_t size, const fs::path& path) {
+    if (size == 0) {
+        return FileContent();
+    }
+    // Owned by the storage right away, so a failed read returns it to the pool
+    auto storage = std::make_shared<PooledStorage>(BufferPool::instance().acquire(size));
+    size_t total = readFully(fd, storage->buffer.data.get(), 0, size, path);
+    std::string_view view(storage->buffer.data.get(), total);
+    return FileContent(std::move(storage), view, Backing::Pooled);
+}
+
+/**
+ * @brief Drops this handle's reference to the storage
+ */
+void FileContent::reset() {
+    storage_.reset();
+    view_ = std::string_view();
+    backing_ = Backing::Empty;
+}
+
+FileIngest::~FileIngest() {
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+}
+
+/**
+ * @brief Opens a file and reads its metadata
+ *
+ * @param path File to open
+ * @param dirFd Directory that relative paths are resolved against
+ * @return bool False if the file cannot be opened or is not a regular file
+ *
+ * O_NONBLOCK keeps a FIFO in the tree from blocking the open; it has no
+ * effect on reads from regular files.
+ */
+bool FileIngest::open(const fs::path& path, int dirFd) {
+    path_ = path;
+    fd_ = ::openat(dirFd, path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd_ == -1) {
+        return false;
+    }
+    if (::fstat(fd_, &stat_) == -1 || !S_ISREG(stat_.st_mode)) {
+        int savedErrno = S_ISREG(stat_.st_mode) ? errno : EINVAL;
+        ::close(fd_);
+        fd_ = -1;
+        errno = savedErrno;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the first block of the file
+ *
+ * @return std::string_view Up to PROBE_SIZE bytes from the start of the file
+ * @throws std::runtime_error if the read or the mapping fails
+ */
+std::string_view FileIngest::probe() {
+    if (!probed_) {
+        probed_ = true;
+        if (size() > mmapThreshold_) {
+            mapped_ = FileContent::map(fd_, size(), path_);
+        } else if (size() > 0) {
+            auto storage = std::make_shared<PooledStorage>(BufferPool::instance().acquire(size()));
+            bufferData_ = storage->buffer.data.get();
+            buffer_ = std::move(storage);
+            fill(std::min(size(), PROBE_SIZE));
+        }
+    }
+    if (!mapped_.empty()) {
+        return mapped_.view().substr(0, PROBE_SIZE);
+    }
+    return std::string_view(bufferData_, std::min(filled_, PROBE_SIZE));
+}
+
+/**
+ * @brief Reads the rest of the file after the probed block
+ *
+ * @return FileContent The whole file (fewer bytes than size() if it shrank)
+ * @throws std::runtime_error if the read or the mapping fails
+ */
+FileContent FileIngest::readAll() {
+    probe();
+    FileContent content;
+    if (!mapped_.empty()) {
+        content = std::move(mapped_);
+    } else if (buffer_) {
+        fill(size());
+        content = FileContent(std::move(buffer_), std::string_view(bufferData_, filled_), FileContent::Backing::Pooled);
+    }
+    ::close(fd_);
+    fd_ = -1;
+    return content;
+}
+
+void FileIngest::fill(size_t upTo) {
+    filled_ = readFully(fd_, bufferData_, filled_, upTo, path_);
+}
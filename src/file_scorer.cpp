@@ -22,7 +22,15 @@
 #include <cmath>
 #include <nlohmann/json.hpp>
 #include "tree_sitter_types.hpp"
+#include "work_stealing_pool.hpp"
+#include "result_cache.hpp"
+#include "language_registry.hpp"
+#include "metrics.hpp"
 #include <set>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sys/stat.h>
 
 /**
  * @brief Include language headers for TreeSitter
@@ -47,13 +55,21 @@ using json = nlohmann::json;
  * @brief Constructor for FileScorer with configuration
  *
  * @param config Configuration parameters that control file scoring behavior
+ * @param numThreads Number of worker threads used by scoreRepository
+ * @param patterns The patterns of config, compiled beforehand, or nullptr
  */
-FileScorer::FileScorer(const FileScoringConfig& config)
-    : config_(config) {
+FileScorer::FileScorer(const FileScoringConfig& config, unsigned int numThreads,
+                       std::shared_ptr<const CompiledPatterns> patterns)
+    : config_(config), numThreads_(numThreads), patterns_(std::move(patterns)) {
     // Initialize pattern matcher
     patternMatcher_ = std::make_unique<PatternMatcher>();
+    if (!patterns_) {
+        patterns_ = compilePatterns(config_);
+    }
 }
 
+FileScorer::~FileScorer() = default;
+
 /**
  * @brief Updates the scoring configuration
  * 
@@ -61,6 +77,7 @@ FileScorer::FileScorer(const FileScoringConfig& config)
  */
 void FileScorer::setConfig(const FileScoringConfig& config) {
     config_ = config;
+    patterns_ = compilePatterns(config_);
 }
 
 /**
@@ -75,53 +92,101 @@ const FileScoringConfig& FileScorer::getConfig() const {
 /**
  * @brief Score all files in a repository
  * 
- * This method traverses the entire repository, scores each file according to the
- * configured criteria, and returns a collection of scored files.
+ * The repository is walked once to collect candidate files, skipping the
+ * default ignored directories. Each file is then stat'ed and read exactly once
+ * on the worker pool; the same buffer feeds density analysis, tree-sitter and
+ * import extraction. Connectivity scores are computed from the resolved imports
+ * after all workers have finished.
  * 
  * @param repoPath Path to the root of the repository
  * @return std::vector<FileScorer::ScoredFile> Collection of files with their scores
  */
 std::vector<FileScorer::ScoredFile> FileScorer::scoreRepository(const fs::path& repoPath) {
-    if (!fs::exists(repoPath) || !fs::is_directory(repoPath)) {
+    if (!fileSystem_ && (!fs::exists(repoPath) || !fs::is_directory(repoPath))) {
         throw std::runtime_error("Invalid repository path: " + repoPath.string());
     }
+    Metrics::ScopedTimer timer(Metrics::Stage::Scoring);
 
-    std::vector<ScoredFile> scoredFiles;
+    FileIndex index;
+    patternMatcher_->setRootDirectory(repoPath);
+    std::vector<FileInfo> files = listFiles(repoPath, index);
+    
+    const bool useConnectivity = config_.dependencyGraphWeight > 0.0f;
+    std::vector<ScoredFile> results(files.size());
+    std::vector<std::vector<std::string>> imports(files.size());
+    std::vector<char> scored(files.size(), 0);
     
-    // Build dependency graph if needed for connectivity scoring
-    std::unordered_map<std::string, std::vector<std::string>> dependencyGraph;
-    if (config_.dependencyGraphWeight > 0.0f) {
-        dependencyGraph = buildDependencyGraph(repoPath);
+    if (!pool_) {
+        pool_ = std::make_unique<WorkStealingPool>(numThreads_);
+    }
+    
+    // Small batches keep every worker busy; each slot is written by one task only
+    const size_t batchSize = std::max<size_t>(
+        1, std::min<size_t>(64, files.size() / (static_cast<size_t>(pool_->size()) * 4)));
+    for (size_t begin = 0; begin < files.size(); begin += batchSize) {
+        const size_t end = std::min(files.size(), begin + batchSize);
+        pool_->submit([&, begin, end](unsigned int) {
+            for (size_t i = begin; i < end; ++i) {
+                FileInfo& info = files[i];
+                try {
+                    if (!loadFileInfo(info, useConnectivity)) {
+                        continue;
+                    }
+                    results[i] = scoreFileInfo(info);
+                    if (useConnectivity) {
+                        imports[i] = extractImports(info, index);
+                    }
+                    scored[i] = 1;
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Error scoring file " << info.path << ": " << e.what() << std::endl;
+                }
+                
+                // The buffer is not needed once the file has been analyzed
+                info.unit.reset();
+                std::string().swap(info.content);
+            }
+        });
     }
+    pool_->wait();
     
-    // Iterate through the repository and score each file
-    for (const auto& entry : fs::recursive_directory_iterator(repoPath)) {
-        if (!entry.is_regular_file()) {
+    // Count incoming edges once instead of scanning the whole graph per file
+    std::unordered_map<std::string, size_t> incomingConnections;
+    if (useConnectivity) {
+        for (const auto& fileImports : imports) {
+            for (const auto& target : fileImports) {
+                incomingConnections[target]++;
+            }
+        }
+    }
+    
+    std::vector<ScoredFile> scoredFiles;
+    scoredFiles.reserve(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!scored[i]) {
             continue;
         }
-        
-        try {
-            // Score the file
-            auto scoredFile = scoreFile(entry.path(), repoPath);
-            
-            // Add dependency graph score if applicable
-            if (config_.dependencyGraphWeight > 0.0f) {
-                float connectivityScore = calculateConnectivityScore(entry.path(), dependencyGraph);
-                scoredFile.componentScores["connectivity"] = connectivityScore * config_.dependencyGraphWeight;
-                scoredFile.score += scoredFile.componentScores["connectivity"];
+        ScoredFile& scoredFile = results[i];
+        
+        // Add dependency graph score if applicable
+        if (useConnectivity) {
+            size_t connections = imports[i].size();
+            auto incoming = incomingConnections.find(files[i].relPath.generic_string());
+            if (incoming != incomingConnections.end()) {
+                connections += incoming->second;
             }
-            
-            // Normalize score to 0-1 range
-            scoredFile.score = std::min(1.0f, std::max(0.0f, scoredFile.score));
-            
-            // Determine inclusion based on score threshold
-            scoredFile.included = scoredFile.score >= config_.inclusionThreshold;
-            
-            scoredFiles.push_back(scoredFile);
-        }
-        catch (const std::exception& e) {
-            std::cerr << "Error scoring file " << entry.path() << ": " << e.what() << std::endl;
+            float connectivityScore = calculateConnectivityScore(connections);
+            scoredFile.componentScores["connectivity"] = connectivityScore * config_.dependencyGraphWeight;
+            scoredFile.score += scoredFile.componentScores["connectivity"];
         }
+        
+        // Normalize score to 0-1 range
+        scoredFile.score = std::min(1.0f, std::max(0.0f, scoredFile.score));
+        
+        // Determine inclusion based on score threshold
+        scoredFile.included = scoredFile.score >= config_.inclusionThreshold;
+        
+        scoredFiles.push_back(std::move(scoredFile));
     }
     
     // Sort the files by score (highest first)
@@ -133,6 +198,69 @@ std::vector<FileScorer::ScoredFile> FileScorer::scoreRepository(const fs::path&
     return scoredFiles;
 }
 
+/**
+ * @brief Lists the files to score with a single walk over the repository
+ * 
+ * @param repoPath Root of the repository, on disk or in fileSystem_
+ * @param index Receives the relative path of every file
+ * @return std::vector<FileInfo> Files with path and relPath set
+ * 
+ * Ignored directories are not descended into; in a virtual file system,
+ * whose index is flat, their files are skipped instead.
+ */
+std::vector<FileScorer::FileInfo> FileScorer::listFiles(const fs::path& repoPath, FileIndex& index) const {
+    std::vector<FileInfo> files;
+    auto addFile = [&](const fs::path& path) {
+        FileInfo info;
+        info.path = path;
+        info.relPath = path.lexically_relative(repoPath);
+        index.add(info.relPath);
+        files.push_back(std::move(info));
+    };
+    
+    if (fileSystem_) {
+        std::unordered_map<std::string, bool> ignoredDirs;
+        std::function<bool(const fs::path&)> inIgnoredDirectory = [&](const fs::path& dir) {
+            const fs::path rel = dir.lexically_relative(repoPath);
+            if (rel.empty() || rel == "." || *rel.begin() == "..") {
+                return false;
+            }
+            auto it = ignoredDirs.find(dir.native());
+            if (it != ignoredDirs.end()) {
+                return it->second;
+            }
+            const bool ignored = inIgnoredDirectory(dir.parent_path()) || patternMatcher_->isDirectoryIgnored(dir);
+            ignoredDirs.emplace(dir.native(), ignored);
+            return ignored;
+        };
+        
+        for (const auto& entry : fileSystem_->entries()) {
+            const fs::path rel = entry.path.lexically_relative(repoPath);
+            if (rel.empty() || *rel.begin() == ".." || inIgnoredDirectory(entry.path.parent_path()) ||
+                patternMatcher_->isIgnored(entry.path)) {
+                continue;
+            }
+            addFile(entry.path);
+        }
+        return files;
+    }
+    
+    for (auto it = fs::recursive_directory_iterator(repoPath); it != fs::recursive_directory_iterator(); ++it) {
+        const auto& entry = *it;
+        if (entry.is_directory()) {
+            if (patternMatcher_->isDirectoryIgnored(entry.path())) {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!entry.is_regular_file() || patternMatcher_->isIgnored(entry.path())) {
+            continue;
+        }
+        addFile(entry.path());
+    }
+    return files;
+}
+
 /**
  * @brief Score a single file
  * 
@@ -145,19 +273,89 @@ std::vector<FileScorer::ScoredFile> FileScorer::scoreRepository(const fs::path&
  * @return FileScorer::ScoredFile Structure containing file path, score, and component scores
  */
 FileScorer::ScoredFile FileScorer::scoreFile(const fs::path& filePath, const fs::path& repoRoot) {
+    FileInfo info;
+    info.path = filePath;
+    info.relPath = filePath.lexically_relative(repoRoot);
+    if (info.relPath.empty()) {
+        // Mixed relative/absolute inputs need the filesystem to line up
+        info.relPath = fs::relative(filePath, repoRoot);
+    }
+    
+    if (!loadFileInfo(info, false)) {
+        throw std::runtime_error("Cannot read file: " + filePath.string());
+    }
+    return scoreFileInfo(info);
+}
+
+/**
+ * @brief Stat a file and read its content when a content-based score needs it
+ * 
+ * @param info File to load; path and relPath must be set
+ * @param needImports Whether import extraction will run on the content
+ * @return bool False if the file could not be stat'ed or read
+ */
+bool FileScorer::loadFileInfo(FileInfo& info, bool needImports) const {
+    const VirtualFileSystem::Entry* entry = nullptr;
+    if (fileSystem_) {
+        entry = fileSystem_->find(info.path);
+        if (!entry) {
+            std::cerr << "Error getting file status for " << info.path << ": no such file" << std::endl;
+            return false;
+        }
+        info.size = entry->size;
+        info.modifiedTime = entry->modifiedTime;
+    } else {
+        struct stat st;
+        if (::stat(info.path.c_str(), &st) != 0) {
+            std::cerr << "Error getting file status for " << info.path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        info.size = static_cast<uintmax_t>(st.st_size);
+        info.modifiedTime = st.st_mtime;
+    }
+    
+    const bool needContent = isSourceCodeFile(info.path) && 
+                             (config_.codeDensityWeight > 0.0f || needImports);
+    if (!needContent) {
+        return true;
+    }
+    
+    if (entry) {
+        info.content = fileSystem_->read(info.path).str();
+        info.contentLoaded = true;
+        return true;
+    }
+    
+    std::ifstream file(info.path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open file: " << info.path << std::endl;
+        return false;
+    }
+    info.content.resize(info.size);
+    file.read(&info.content[0], static_cast<std::streamsize>(info.size));
+    info.content.resize(static_cast<size_t>(file.gcount()));
+    info.contentLoaded = true;
+    return true;
+}
+
+/**
+ * @brief Compute the per-file score components from already loaded file data
+ * 
+ * @param info File metadata and content gathered by loadFileInfo
+ * @return FileScorer::ScoredFile Scored file without connectivity component
+ */
+FileScorer::ScoredFile FileScorer::scoreFileInfo(const FileInfo& info) {
     ScoredFile result;
-    result.path = filePath;
+    result.path = info.path;
     result.score = 0.0f;
-    
-    // Get relative path from repo root
-    fs::path relPath = fs::relative(filePath, repoRoot);
+    result.included = false;
     
     // Calculate individual score components
-    float structureScore = scoreProjectStructure(filePath, repoRoot);
-    float typeScore = scoreFileType(filePath);
-    float recencyScore = scoreRecency(filePath);
-    float sizeScore = scoreFileSize(filePath);
-    float densityScore = scoreCodeDensity(filePath);
+    float structureScore = scoreProjectStructure(info);
+    float typeScore = scoreFileType(info.path);
+    float recencyScore = scoreRecency(info.modifiedTime);
+    float sizeScore = scoreFileSize(info.size);
+    float densityScore = cachedCodeDensity(info);
     
     // Store component scores for reporting
     result.componentScores["structure"] = structureScore;
@@ -262,18 +460,65 @@ std::string FileScorer::getScoringReport(const std::vector<ScoredFile>& scoredFi
     return report.dump(2); // Pretty-print with 2-space indentation
 }
 
+/**
+ * @brief Uses a persistent cache for content-derived scores
+ * 
+ * @param cache Cache to consult in scoreFile and scoreRepository, or nullptr to disable caching
+ * 
+ * Only the density component is cached: recency depends on the current time
+ * and connectivity on the other files of the repository.
+ */
+void FileScorer::setResultCache(std::shared_ptr<ResultCache> cache) {
+    resultCache_ = std::move(cache);
+}
+
+/**
+ * @brief Scores the files of a virtual file system instead of the disk
+ * 
+ * @param fileSystem Tree that scoreRepository and scoreFile read, or nullptr
+ */
+void FileScorer::setFileSystem(std::shared_ptr<const VirtualFileSystem> fileSystem) {
+    fileSystem_ = std::move(fileSystem);
+}
+
+/**
+ * @brief Score code density, reusing a cached value when the file is unchanged
+ * 
+ * @param info File to score, with its content already loaded
+ * @return float Density score component
+ */
+float FileScorer::cachedCodeDensity(const FileInfo& info) {
+    if (!resultCache_ || !info.contentLoaded || config_.codeDensityWeight <= 0.0f) {
+        return scoreCodeDensity(info);
+    }
+    
+    std::ostringstream fields;
+    fields << "file-score/v2|" << config_.useTreeSitter << '|' << config_.codeDensityWeight;
+    const std::string key = ResultCache::makeKey(info.path, info.size, info.modifiedTime,
+                                                 ResultCache::contentHash(info.content),
+                                                 ResultCache::hash(fields.str()));
+    
+    nlohmann::json cached;
+    if (resultCache_->load(key, cached) && cached.contains("density") && cached["density"].is_number()) {
+        return cached["density"].get<float>();
+    }
+    
+    float density = scoreCodeDensity(info);
+    resultCache_->store(key, {{"density", density}});
+    return density;
+}
+
 /**
  * @brief Score a file based on its position in the project structure
  * 
  * Files in important locations (root level, top-level directories, entry points)
  * and files with many connections in the dependency graph receive higher scores.
  * 
- * @param filePath Path to the file to score
- * @param repoRoot Path to the repository root
+ * @param info File to score, with its path relative to the repository root
  * @return float Score component based on the project structure (0.0 to 1.0)
  */
-float FileScorer::scoreProjectStructure(const fs::path& filePath, const fs::path& repoRoot) {
-    fs::path relPath = fs::relative(filePath, repoRoot);
+float FileScorer::scoreProjectStructure(const FileInfo& info) {
+    const fs::path& relPath = info.relPath;
     std::string pathStr = relPath.string();
     float score = 0.0f;
     
@@ -282,14 +527,13 @@ float FileScorer::scoreProjectStructure(const fs::path& filePath, const fs::path
         score += config_.rootFilesWeight;
         
         // Extra boost for important root files (README, package.json, etc.)
-        if (matchesAnyPattern(relPath.filename().string(), config_.importantFilePatterns)) {
+        if (matchesAnyPattern(relPath.filename().string(), patterns_->importantFiles)) {
             score += config_.rootFilesWeight * 0.5f;
         }
     }
     
     // Boost score for files in important top-level directories
-    for (const auto& dirPattern : config_.importantDirPatterns) {
-        std::regex dirRegex(dirPattern);
+    for (const auto& dirRegex : patterns_->importantDirs) {
         if (std::regex_search(pathStr, dirRegex)) {
             score += config_.topLevelDirsWeight;
             break;
@@ -297,7 +541,7 @@ float FileScorer::scoreProjectStructure(const fs::path& filePath, const fs::path
     }
     
     // Boost score for entry points
-    if (isEntryPoint(filePath)) {
+    if (isEntryPoint(info.path)) {
         score += config_.entryPointsWeight;
     }
     
@@ -341,31 +585,21 @@ float FileScorer::scoreFileType(const fs::path& filePath) {
  * Recently modified files receive higher scores. The time window for considering
  * a file as "recent" is configurable.
  * 
- * @param filePath Path to the file to score
+ * @param modifiedTime Last modification time of the file
  * @return float Score component based on the file's recency (0.0 to 1.0)
  */
-float FileScorer::scoreRecency(const fs::path& filePath) {
+float FileScorer::scoreRecency(std::time_t modifiedTime) {
     if (config_.recentlyModifiedWeight <= 0.0f) {
         return 0.0f;
     }
     
-    try {
-        // Get last write time
-        auto lastWriteTime = fs::last_write_time(filePath);
-        auto now = fs::file_time_type::clock::now();
-        
-        // Calculate days since last modification
-        auto duration = now - lastWriteTime;
-        auto days = std::chrono::duration_cast<std::chrono::hours>(duration).count() / 24;
-        
-        // Score based on recency (linear falloff)
-        if (days <= config_.recentTimeWindowDays) {
-            float recencyFactor = 1.0f - (static_cast<float>(days) / static_cast<float>(config_.recentTimeWindowDays));
-            return recencyFactor * config_.recentlyModifiedWeight;
-        }
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Error getting file modification time for " << filePath << ": " << e.what() << std::endl;
+    // Calculate days since last modification
+    auto days = static_cast<long long>(std::difftime(std::time(nullptr), modifiedTime)) / (24 * 60 * 60);
+    
+    // Score based on recency (linear falloff)
+    if (days <= config_.recentTimeWindowDays) {
+        float recencyFactor = 1.0f - (static_cast<float>(days) / static_cast<float>(config_.recentTimeWindowDays));
+        return recencyFactor * config_.recentlyModifiedWeight;
     }
     
     return 0.0f;
@@ -377,26 +611,18 @@ float FileScorer::scoreRecency(const fs::path& filePath) {
  * Smaller files generally receive higher scores than larger files, 
  * as they tend to be more focused and easier to comprehend.
  * 
- * @param filePath Path to the file to score
+ * @param fileSize Size of the file in bytes
  * @return float Score component based on the file size (0.0 to 1.0)
  */
-float FileScorer::scoreFileSize(const fs::path& filePath) {
+float FileScorer::scoreFileSize(uintmax_t fileSize) {
     if (config_.fileSizeWeight <= 0.0f) {
         return 0.0f;
     }
     
-    try {
-        // Get file size
-        size_t fileSize = fs::file_size(filePath);
-        
-        // Smaller files get higher scores (inverse relationship)
-        if (fileSize <= config_.largeFileThreshold) {
-            float sizeFactor = 1.0f - (static_cast<float>(fileSize) / static_cast<float>(config_.largeFileThreshold));
-            return sizeFactor * config_.fileSizeWeight;
-        }
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Error getting file size for " << filePath << ": " << e.what() << std::endl;
+    // Smaller files get higher scores (inverse relationship)
+    if (fileSize <= config_.largeFileThreshold) {
+        float sizeFactor = 1.0f - (static_cast<float>(fileSize) / static_cast<float>(config_.largeFileThreshold));
+        return sizeFactor * config_.fileSizeWeight;
     }
     
     return 0.0f;
@@ -409,188 +635,30 @@ float FileScorer::scoreFileSize(const fs::path& filePath) {
  * Higher density (more functionality in less space) generally scores higher,
  * but excessive complexity may reduce the score.
  * 
- * @param filePath Path to the file to score
+ * @param info File to score, with its content already loaded
  * @return float Score component based on code density and complexity (0.0 to 1.0)
  */
-float FileScorer::scoreCodeDensity(const fs::path& filePath) {
+float FileScorer::scoreCodeDensity(const FileInfo& info) {
     if (config_.codeDensityWeight <= 0.0f) {
         return 0.0f;
     }
     
     // Only analyze source code files for density
-    if (!isSourceCodeFile(filePath)) {
+    if (!isSourceCodeFile(info.path) || !info.contentLoaded) {
         return 0.0f;
     }
     
     try {
         // Use TreeSitter for better analysis if enabled
         if (config_.useTreeSitter) {
-            return analyzeWithTreeSitter(filePath);
-        }
-        
-        // Fallback to simple analysis
-        std::ifstream file(filePath);
-        if (!file) {
-            return 0.0f;
-        }
-        
-        std::string line;
-        int totalLines = 0;
-        int codeLines = 0;
-        int commentLines = 0;
-        int emptyLines = 0;
-        int importLines = 0;
-        int functionDefs = 0;
-        int classDefs = 0;
-        
-        // Basic stack for tracking code blocks/scope depth
-        int scopeDepth = 0;
-        std::string extension = filePath.extension().string();
-        bool inMultiLineComment = false;
-        
-        // Regex patterns for detecting code structures based on language
-        std::regex functionPattern;
-        std::regex classPattern;
-        std::regex importPattern;
-        std::regex commentStartPattern;
-        std::regex commentEndPattern;
-        
-        // Configure language-specific patterns
-        if (extension == ".py") {
-            functionPattern = std::regex("^\\s*def\\s+\\w+\\s*\\(.*\\)\\s*:");
-            classPattern = std::regex("^\\s*class\\s+\\w+.*:");
-            importPattern = std::regex("^\\s*(import|from)\\s+\\w+");
-            commentStartPattern = std::regex("^\\s*\"\"\"");
-            commentEndPattern = std::regex("\"\"\"\\s*$");
-        } 
-        else if (extension == ".js" || extension == ".ts" || extension == ".jsx" || extension == ".tsx") {
-            functionPattern = std::regex("(function\\s+\\w+\\s*\\(|const\\s+\\w+\\s*=\\s*\\(|\\w+\\s*=\\s*\\(|\\w+\\s*\\(.*\\)\\s*\\{)");
-            classPattern = std::regex("class\\s+\\w+");
-            importPattern = std::regex("(import|require)");
-            commentStartPattern = std::regex("/\\*");
-            commentEndPattern = std::regex("\\*/");
-        }
-        else if (extension == ".cpp" || extension == ".cc" || extension == ".cxx" || extension == ".h" || extension == ".hpp") {
-            functionPattern = std::regex("\\w+\\s+\\w+\\s*\\(.*\\)\\s*(const)?\\s*\\{?");
-            classPattern = std::regex("(class|struct)\\s+\\w+");
-            importPattern = std::regex("#include");
-            commentStartPattern = std::regex("/\\*");
-            commentEndPattern = std::regex("\\*/");
-        }
-        else if (extension == ".java") {
-            functionPattern = std::regex("(public|private|protected)?\\s*(static)?\\s*\\w+\\s+\\w+\\s*\\(.*\\)\\s*\\{?");
-            classPattern = std::regex("(public|private|protected)?\\s*(static)?\\s*class\\s+\\w+");
-            importPattern = std::regex("import\\s+\\w+");
-            commentStartPattern = std::regex("/\\*");
-            commentEndPattern = std::regex("\\*/");
-        }
-        else if (extension == ".rb") {
-            functionPattern = std::regex("def\\s+\\w+");
-            classPattern = std::regex("class\\s+\\w+");
-            importPattern = std::regex("(require|include)");
-            commentStartPattern = std::regex("=begin");
-            commentEndPattern = std::regex("=end");
-        }
-        
-        while (std::getline(file, line)) {
-            totalLines++;
-            
-            // Trim whitespace
-            line.erase(0, line.find_first_not_of(" \t\r\n"));
-            line.erase(line.find_last_not_of(" \t\r\n") + 1);
-            
-            // Track multiline comments
-            if (!inMultiLineComment && std::regex_search(line, commentStartPattern)) {
-                inMultiLineComment = true;
-                commentLines++;
-                continue;
-            }
-            
-            if (inMultiLineComment) {
-                commentLines++;
-                if (std::regex_search(line, commentEndPattern)) {
-                    inMultiLineComment = false;
-                }
-                continue;
-            }
-            
-            // Handle empty lines
-            if (line.empty()) {
-                emptyLines++;
-                continue;
-            }
-            
-            // Handle single-line comments
-            if (line.substr(0, 2) == "//" || line.substr(0, 1) == "#" || 
-                line.substr(0, 2) == "--" || line.substr(0, 1) == ";") {
-                commentLines++;
-                continue;
-            }
-            
-            // Count code structures
-            if (std::regex_search(line, functionPattern)) {
-                functionDefs++;
-            }
-            
-            if (std::regex_search(line, classPattern)) {
-                classDefs++;
-            }
-            
-            if (std::regex_search(line, importPattern)) {
-                importLines++;
-            }
-            
-            // Basic scope tracking
-            for (char c : line) {
-                if (c == '{') scopeDepth++;
-                if (c == '}') scopeDepth = std::max(0, scopeDepth - 1);
-            }
-            
-            // It's a code line
-            codeLines++;
-        }
-        
-        // Calculate code density score (0.0 - 1.0)
-        float density = static_cast<float>(codeLines) / static_cast<float>(totalLines > 0 ? totalLines : 1);
-        
-        // Apply additional analysis factors
-        float structureBonus = 0.0f;
-        
-        // Bonus for files with function/class definitions (indicates important structural code)
-        if (functionDefs > 0 || classDefs > 0) {
-            structureBonus += std::min(0.2f, (functionDefs + classDefs * 2) * 0.02f);
-        }
-        
-        // Penalty for files with no comments at all but lots of code
-        float commentPenalty = 0.0f;
-        if (commentLines == 0 && codeLines > 20) {
-            commentPenalty = 0.1f;
-        }
-        
-        // Bonus for balanced comment-to-code ratio
-        float commentBonus = 0.0f;
-        if (commentLines > 0) {
-            float commentRatio = static_cast<float>(commentLines) / static_cast<float>(codeLines > 0 ? codeLines : 1);
-            // Ideal range is 0.1-0.3 (10-30% comments)
-            if (commentRatio >= 0.1f && commentRatio <= 0.3f) {
-                commentBonus = 0.1f;
-            }
-        }
-        
-        // Import density can indicate a file that's more "glue" than substance
-        float importPenalty = 0.0f;
-        if (importLines > 5 && codeLines < importLines * 3) {
-            importPenalty = 0.1f;
+            return analyzeWithTreeSitter(info);
         }
         
-        // Calculate final score
-        float finalScore = (density * 0.6f) + structureBonus + commentBonus - commentPenalty - importPenalty;
-        
-        // Scale by the configured weight
-        return std::min(1.0f, std::max(0.0f, finalScore)) * config_.codeDensityWeight;
+        // Fallback to simple analysis, scaled by the configured weight
+        return analyzeFileContent(info.path, info.content) * config_.codeDensityWeight;
     }
     catch (const std::exception& e) {
-        std::cerr << "Error analyzing code density for " << filePath << ": " << e.what() << std::endl;
+        std::cerr << "Error analyzing code density for " << info.path << ": " << e.what() << std::endl;
     }
     
     return 0.0f;
@@ -655,7 +723,7 @@ bool FileScorer::isDocumentationFile(const fs::path& filePath) const {
  */
 bool FileScorer::isTestFile(const fs::path& filePath) const {
     std::string pathStr = filePath.string();
-    return matchesAnyPattern(pathStr, config_.testFilePatterns);
+    return matchesAnyPattern(pathStr, patterns_->testFiles);
 }
 
 /**
@@ -669,45 +737,18 @@ bool FileScorer::isTestFile(const fs::path& filePath) const {
  */
 bool FileScorer::isEntryPoint(const fs::path& filePath) const {
     std::string filename = filePath.filename().string();
-    
-    // Common entry point file names
-    std::vector<std::string> entryPointPatterns = {
-        "main.*", "index.*", "app.*", "server.*", "start.*", "init.*", "bootstrap.*"
-    };
-    
-    return matchesAnyPattern(filename, entryPointPatterns);
+    return matchesAnyPattern(filename, patterns_->entryPoints);
 }
 
 /**
  * @brief Check if a path matches any of the given patterns
  * 
- * Uses regex matching to test if a path string matches any of the 
- * patterns in the provided collection.
- * 
  * @param pathStr The path as a string to check against patterns
- * @param patterns Collection of regex patterns to match against
+ * @param patterns Precompiled patterns to search for
  * @return bool True if the path matches any pattern, false otherwise
  */
-bool FileScorer::matchesAnyPattern(const std::string& pathStr, const std::vector<std::string>& patterns) const {
-    for (const auto& pattern : patterns) {
-        // Convert glob pattern to regex
-        std::string regexPattern = pattern;
-        
-        // Replace "." with literal "."
-        size_t pos = 0;
-        while ((pos = regexPattern.find(".", pos)) != std::string::npos) {
-            regexPattern.replace(pos, 1, "\\.");
-            pos += 2;
-        }
-        
-        // Replace "*" with ".*"
-        pos = 0;
-        while ((pos = regexPattern.find("*", pos)) != std::string::npos) {
-            regexPattern.replace(pos, 1, ".*");
-            pos += 2;
-        }
-        
-        std::regex re(regexPattern);
+bool FileScorer::matchesAnyPattern(const std::string& pathStr, const std::vector<std::regex>& patterns) const {
+    for (const auto& re : patterns) {
         if (std::regex_search(pathStr, re)) {
             return true;
         }
@@ -716,6 +757,84 @@ bool FileScorer::matchesAnyPattern(const std::string& pathStr, const std::vector
     return false;
 }
 
+/**
+ * @brief Convert a simple glob pattern to a regex
+ * 
+ * Only "." and "*" are translated; the result is meant for regex_search.
+ * 
+ * @param pattern Glob pattern such as "*_test.*"
+ * @return std::regex Compiled regex
+ */
+std::regex FileScorer::globToRegex(const std::string& pattern) {
+    std::string regexPattern = pattern;
+    
+    // Replace "." with literal "."
+    size_t pos = 0;
+    while ((pos = regexPattern.find(".", pos)) != std::string::npos) {
+        regexPattern.replace(pos, 1, "\\.");
+        pos += 2;
+    }
+    
+    // Replace "*" with ".*"
+    pos = 0;
+    while ((pos = regexPattern.find("*", pos)) != std::string::npos) {
+        regexPattern.replace(pos, 1, ".*");
+        pos += 2;
+    }
+    
+    return std::regex(regexPattern);
+}
+
+/**
+ * @brief Compile the configured patterns once so scoring threads only read them
+ * 
+ * @param config Configuration whose file and directory patterns are compiled
+ * @return std::shared_ptr<const CompiledPatterns> Regexes to share between scorers
+ */
+std::shared_ptr<const FileScorer::CompiledPatterns> FileScorer::compilePatterns(const FileScoringConfig& config) {
+    // Common entry point file names
+    static const std::vector<std::string> entryPointPatterns = {
+        "main.*", "index.*", "app.*", "server.*", "start.*", "init.*", "bootstrap.*"
+    };
+    
+    auto patterns = std::make_shared<CompiledPatterns>();
+    for (const auto& pattern : config.importantFilePatterns) {
+        patterns->importantFiles.push_back(globToRegex(pattern));
+    }
+    
+    for (const auto& pattern : config.importantDirPatterns) {
+        patterns->importantDirs.emplace_back(pattern);
+    }
+    
+    for (const auto& pattern : config.testFilePatterns) {
+        patterns->testFiles.push_back(globToRegex(pattern));
+    }
+    
+    for (const auto& pattern : entryPointPatterns) {
+        patterns->entryPoints.push_back(globToRegex(pattern));
+    }
+    return patterns;
+}
+
+/**
+ * @brief Identifies the patterns compilePatterns builds from a configuration
+ * 
+ * @param config Configuration to describe
+ * @return std::string Equal for configs whose compiled patterns are equal
+ */
+std::string FileScorer::patternsKey(const FileScoringConfig& config) {
+    std::string key;
+    for (const auto* patterns : {&config.importantFilePatterns, &config.importantDirPatterns,
+                                 &config.testFilePatterns}) {
+        for (const auto& pattern : *patterns) {
+            key += pattern;
+            key += '\0';
+        }
+        key += '\1';
+    }
+    return key;
+}
+
 /**
  * @brief Calculate file importance based on its location in the repository
  * 
@@ -734,324 +853,243 @@ float FileScorer::calculateImportanceByLocation(const fs::path& filePath, const
 }
 
 /**
- * @brief Build a dependency graph for the repository
- * 
- * Scans the repository to identify dependencies between files
- * by analyzing import statements, include directives, etc.
+ * @brief Register a file found by the repository walk
  * 
- * @param repoRoot Path to the repository root
- * @return std::unordered_map<std::string, std::vector<std::string>> Map of file paths to their dependencies
+ * @param relPath Path of the file relative to the repository root
  */
-std::unordered_map<std::string, std::vector<std::string>> FileScorer::buildDependencyGraph(const fs::path& repoRoot) {
-    std::unordered_map<std::string, std::vector<std::string>> graph;
+void FileScorer::FileIndex::add(const fs::path& relPath) {
+    std::string relPathStr = relPath.generic_string();
+    std::string filename = relPath.filename().string();
+    std::string extension = relPath.extension().string();
+    filesByName[filename].push_back(relPathStr);
     
-    // Map of file extensions to possible absolute paths (for dependency resolution)
-    std::unordered_map<std::string, std::vector<fs::path>> filesByName;
+    // Also store without extension for languages that import without extensions
+    if (!extension.empty()) {
+        std::string nameWithoutExt = filename.substr(0, filename.length() - extension.length());
+        filesByName[nameWithoutExt].push_back(relPathStr);
+    }
     
-    // First, index all files in the repository for faster lookups
-    for (const auto& entry : fs::recursive_directory_iterator(repoRoot)) {
-        if (!entry.is_regular_file()) {
-            continue;
-        }
-        
-        std::string filename = entry.path().filename().string();
-        std::string extension = entry.path().extension().string();
-        filesByName[filename].push_back(entry.path());
-        
-        // Also store without extension for languages that import without extensions
-        if (!extension.empty()) {
-            std::string nameWithoutExt = filename.substr(0, filename.length() - extension.length());
-            filesByName[nameWithoutExt].push_back(entry.path());
-        }
+    relPaths.insert(std::move(relPathStr));
+}
+
+/**
+ * @brief Extract the dependencies of a file from its loaded content
+ * 
+ * Analyzes import statements, include directives, etc. and resolves them
+ * against the files found by the repository walk.
+ * 
+ * @param info File to analyze, with its content already loaded
+ * @param index Files of the repository
+ * @return std::vector<std::string> Distinct repository-relative paths this file depends on
+ */
+std::vector<std::string> FileScorer::extractImports(const FileInfo& info, const FileIndex& index) const {
+    std::vector<std::string> imports;
+    if (!info.contentLoaded) {
+        return imports;
     }
     
-    // Now scan files for imports
-    for (const auto& entry : fs::recursive_directory_iterator(repoRoot)) {
-        if (!entry.is_regular_file() || !isSourceCodeFile(entry.path())) {
-            continue;
+    const std::string relPathStr = info.relPath.generic_string();
+    const Language language = languageOf(info.path);
+    const LanguageRules& rules = rulesFor(language);
+    std::unordered_set<std::string> seen;
+    auto addImport = [&](const std::string& resolvedImport) {
+        if (!resolvedImport.empty() && resolvedImport != relPathStr && seen.insert(resolvedImport).second) {
+            imports.push_back(resolvedImport);
         }
-        
-        try {
-            std::string relPathStr = fs::relative(entry.path(), repoRoot).string();
-            std::string extension = entry.path().extension().string();
-            std::ifstream file(entry.path());
-            std::string line;
-            
-            // Skip binary files
-            if (!file.is_open() || !file) {
-                continue;
-            }
-            
-            // Initialize an empty vector for this file's imports
-            if (graph.find(relPathStr) == graph.end()) {
-                graph[relPathStr] = std::vector<std::string>();
-            }
-            
-            // Track imports in multi-line scopes (e.g., import { a, b, c } from '...')
-            bool inMultiLineImport = false;
-            std::string multiLineImportSource;
-            
-            // Language-specific import regexes
-            std::vector<std::regex> importRegexes;
-            std::regex multiLineStartRegex;
-            std::regex multiLineEndRegex;
-            bool hasMultiLineImports = false;
-            
-            // Python-specific import handling
-            bool isPython = (extension == ".py");
-            std::set<std::string> pythonImports;
+    };
+    
+    // Track imports in multi-line scopes (e.g., import { a, b, c } from '...')
+    bool inMultiLineImport = false;
+    std::string multiLineImportSource;
+    
+    // Python-specific import handling
+    bool isPython = language == Language::Python;
+    std::set<std::string> pythonImports;
+    
+    // Resolve collected Python modules to files
+    auto addPythonImports = [&]() {
+        for (const auto& importPath : pythonImports) {
+            // Convert dot notation to path
+            std::string pathWithSlashes = importPath;
+            std::replace(pathWithSlashes.begin(), pathWithSlashes.end(), '.', '/');
             
-            // Set up language-specific regex patterns
-            if (extension == ".js" || extension == ".ts" || extension == ".jsx" || extension == ".tsx") {
-                // JavaScript/TypeScript imports
-                importRegexes.push_back(std::regex("import\\s+.*?from\\s+['\"](.+?)['\"]"));
-                importRegexes.push_back(std::regex("import\\s+['\"](.+?)['\"]"));
-                importRegexes.push_back(std::regex("require\\s*\\(['\"](.+?)['\"]\\)"));
-                
-                // Handle multi-line imports like: import {
-                //   Component1,
-                //   Component2
-                // } from 'source';
-                multiLineStartRegex = std::regex("import\\s+\\{.*(?:from\\s+['\"](.+?)['\"])?$");
-                multiLineEndRegex = std::regex(".*\\}\\s+from\\s+['\"](.+?)['\"]");
-                hasMultiLineImports = true;
-            }
-            else if (extension == ".py") {
-                // Python imports
-                importRegexes.push_back(std::regex("from\\s+([\\w\\.]+)\\s+import"));
-                importRegexes.push_back(std::regex("import\\s+([\\w\\.]+)"));
-                
-                // Handle multi-line imports with parentheses
-                multiLineStartRegex = std::regex("from\\s+([\\w\\.]+)\\s+import\\s+\\(");
-                multiLineEndRegex = std::regex("\\)");
-                hasMultiLineImports = true;
+            // Try with .py extension
+            std::string resolvedImport = resolveImportPath(pathWithSlashes + ".py", info, index);
+            if (resolvedImport.empty()) {
+                // Try as a directory with __init__.py
+                resolvedImport = resolveImportPath(pathWithSlashes + "/__init__.py", info, index);
             }
-            else if (extension == ".java") {
-                // Java imports
-                importRegexes.push_back(std::regex("import\\s+([\\w\\.\\*]+);"));
-            }
-            else if (extension == ".cpp" || extension == ".cc" || extension == ".cxx" || extension == ".h" || extension == ".hpp") {
-                // C/C++ includes
-                importRegexes.push_back(std::regex("#include\\s+[<\"](.+?)[>\"]"));
-            }
-            else if (extension == ".rb") {
-                // Ruby requires
-                importRegexes.push_back(std::regex("require\\s+['\"](.+?)['\"]"));
-                importRegexes.push_back(std::regex("require_relative\\s+['\"](.+?)['\"]"));
-                importRegexes.push_back(std::regex("load\\s+['\"](.+?)['\"]"));
-            }
-            else if (extension == ".php") {
-                // PHP includes
-                importRegexes.push_back(std::regex("(require|include)(_once)?\\s+['\"](.+?)['\"]"));
-                importRegexes.push_back(std::regex("use\\s+([\\w\\\\]+)"));
+            addImport(resolvedImport);
+        }
+    };
+    
+    // With a grammar for the file, its parsed unit (shared with code density)
+    // already holds the include paths and module names
+    if (config_.useTreeSitter && ParsedUnit::supports(info.path) && info.parsed().parsed()) {
+        const ParsedUnit& unit = info.parsed();
+        for (const auto& span : unit.spans()) {
+            if (span.kind != ParsedUnit::Kind::Import) {
+                continue;
             }
-            else if (extension == ".go") {
-                // Go imports
-                importRegexes.push_back(std::regex("import\\s+['\"](.+?)['\"]"));
-                
-                // Multi-line imports
-                multiLineStartRegex = std::regex("import\\s+\\(");
-                multiLineEndRegex = std::regex("\\)");
-                hasMultiLineImports = true;
+            std::string importPath(unit.name(span));
+            if (isPython) {
+                pythonImports.insert(importPath);
+                continue;
             }
-            else if (extension == ".rs") {
-                // Rust imports
-                importRegexes.push_back(std::regex("use\\s+([\\w:]+)"));
-                
-                // Multi-line imports
-                multiLineStartRegex = std::regex("use\\s+\\{");
-                multiLineEndRegex = std::regex("\\};");
-                hasMultiLineImports = true;
+            // Strip the quotes or angle brackets around include paths and module specifiers
+            if (importPath.size() >= 2 && std::strchr("\"'`<", importPath.front())) {
+                importPath = importPath.substr(1, importPath.size() - 2);
             }
-            
-            while (std::getline(file, line)) {
-                // Handle multi-line imports if supported for this language
-                if (hasMultiLineImports) {
-                    if (!inMultiLineImport) {
-                        std::smatch startMatch;
-                        if (std::regex_search(line, startMatch, multiLineStartRegex)) {
-                            inMultiLineImport = true;
-                            if (startMatch.size() > 1 && !startMatch[1].str().empty()) {
-                                multiLineImportSource = startMatch[1].str();
-                            }
-                            continue;
-                        }
-                    }
-                    else {
-                        // Check if multi-line import ends
-                        std::smatch endMatch;
-                        if (std::regex_search(line, endMatch, multiLineEndRegex)) {
-                            inMultiLineImport = false;
-                            
-                            // Get import source from end match if available
-                            if (endMatch.size() > 1 && !endMatch[1].str().empty()) {
-                                multiLineImportSource = endMatch[1].str();
-                            }
-                            
-                            // Add the import if we have a source
-                            if (!multiLineImportSource.empty()) {
-                                // Process the import based on language
-                                std::string resolvedImport = resolveImportPath(multiLineImportSource, entry.path(), repoRoot, filesByName);
-                                if (!resolvedImport.empty() && resolvedImport != relPathStr) {
-                                    graph[relPathStr].push_back(resolvedImport);
-                                }
-                                multiLineImportSource.clear();
-                            }
-                            continue;
-                        }
-                        
-                        // For some languages, extract imports from the multi-line block
-                        if (isPython && !line.empty()) {
-                            // Extract Python's inline imports within parentheses
-                            std::string importName = line;
-                            // Trim whitespace and commas
-                            importName.erase(0, importName.find_first_not_of(" \t\r\n,"));
-                            importName.erase(importName.find_last_not_of(" \t\r\n,") + 1);
-                            
-                            if (!importName.empty() && importName.find("#") != 0) { // Skip comments
-                                pythonImports.insert(multiLineImportSource + "." + importName);
-                            }
-                        }
-                        
-                        continue;
+            addImport(resolveImportPath(importPath, info, index));
+        }
+        addPythonImports();
+        return imports;
+    }
+    
+    std::istringstream stream(info.content);
+    std::string line;
+    Regex::Match match;
+    while (std::getline(stream, line)) {
+        // Handle multi-line imports if supported for this language
+        if (rules.hasMultiLineImports) {
+            if (!inMultiLineImport) {
+                if (rules.multiLineImportStart.search(line, 0, match)) {
+                    inMultiLineImport = true;
+                    if (!match.group(1).empty()) {
+                        multiLineImportSource = std::string(match.group(1));
                     }
-                }
-                
-                // Skip comments
-                if (line.find("//") == 0 || line.find("#") == 0) {
                     continue;
                 }
-                
-                // Process regular imports using regex patterns
-                for (const auto& regex : importRegexes) {
-                    std::smatch matches;
-                    std::string::const_iterator searchStart(line.cbegin());
+            }
+            else {
+                // Check if multi-line import ends
+                if (rules.multiLineImportEnd.search(line, 0, match)) {
+                    inMultiLineImport = false;
                     
-                    while (std::regex_search(searchStart, line.cend(), matches, regex)) {
-                        if (matches.size() > 1) {
-                            std::string importPath = matches[1].str();
-                            
-                            // Handle PHP's require/include which has the path in group 3
-                            if (extension == ".php" && (matches[0].str().find("require") == 0 || 
-                                                       matches[0].str().find("include") == 0)) {
-                                importPath = matches[3].str();
-                            }
-                            
-                            // For Python, collect imports for later resolution
-                            if (isPython) {
-                                pythonImports.insert(importPath);
-                            } else {
-                                // For other languages, resolve immediately
-                                std::string resolvedImport = resolveImportPath(importPath, entry.path(), repoRoot, filesByName);
-                                if (!resolvedImport.empty() && resolvedImport != relPathStr) {
-                                    graph[relPathStr].push_back(resolvedImport);
-                                }
-                            }
-                        }
-                        
-                        // Move to the next match
-                        searchStart = matches.suffix().first;
+                    // Get import source from end match if available
+                    if (!match.group(1).empty()) {
+                        multiLineImportSource = std::string(match.group(1));
                     }
-                }
-            }
-            
-            // Process collected Python imports
-            if (isPython && !pythonImports.empty()) {
-                for (const auto& importPath : pythonImports) {
-                    // Convert dot notation to path
-                    std::string pathWithSlashes = importPath;
-                    std::replace(pathWithSlashes.begin(), pathWithSlashes.end(), '.', '/');
                     
-                    // Try with .py extension
-                    std::string resolvedImport = resolveImportPath(pathWithSlashes + ".py", entry.path(), repoRoot, filesByName);
-                    if (resolvedImport.empty()) {
-                        // Try as a directory with __init__.py
-                        resolvedImport = resolveImportPath(pathWithSlashes + "/__init__.py", entry.path(), repoRoot, filesByName);
+                    // Add the import if we have a source
+                    if (!multiLineImportSource.empty()) {
+                        addImport(resolveImportPath(multiLineImportSource, info, index));
+                        multiLineImportSource.clear();
                     }
+                    continue;
+                }
+                
+                // For some languages, extract imports from the multi-line block
+                if (isPython && !line.empty()) {
+                    // Extract Python's inline imports within parentheses
+                    std::string importName = line;
+                    // Trim whitespace and commas
+                    importName.erase(0, importName.find_first_not_of(" \t\r\n,"));
+                    importName.erase(importName.find_last_not_of(" \t\r\n,") + 1);
                     
-                    if (!resolvedImport.empty() && resolvedImport != relPathStr) {
-                        graph[relPathStr].push_back(resolvedImport);
+                    if (!importName.empty() && importName.find("#") != 0) { // Skip comments
+                        pythonImports.insert(multiLineImportSource + "." + importName);
                     }
                 }
+                
+                continue;
             }
         }
-        catch (const std::exception& e) {
-            std::cerr << "Error analyzing dependencies in " << entry.path() << ": " << e.what() << std::endl;
+        
+        // Skip comments ('#' starts a directive, not a comment, in C/C++)
+        if (line.find("//") == 0 || (line.find("#") == 0 && !isCFamily(language))) {
+            continue;
+        }
+        
+        // Process regular imports using regex patterns
+        for (const auto& regex : rules.imports) {
+            regex.forEach(line, [&](const Regex::Match& importMatch) {
+                std::string importPath(importMatch.group(1));
+                if (importPath.empty()) {
+                    return;
+                }
+                
+                // For Python, collect imports for later resolution
+                if (isPython) {
+                    pythonImports.insert(importPath);
+                } else {
+                    // For other languages, resolve immediately
+                    addImport(resolveImportPath(importPath, info, index));
+                }
+            });
         }
     }
     
-    return graph;
+    addPythonImports();
+    
+    return imports;
 }
 
 /**
- * @brief Resolve the absolute path of an imported file
+ * @brief Resolve an import to a file of the repository
  * 
- * Converts a relative import path to an absolute path based on
- * the importing file's location and repository structure.
+ * Resolution only consults the index built by the repository walk, so it
+ * never touches the filesystem.
  * 
  * @param importPath The import path from the source file
- * @param sourceFilePath Path to the file containing the import
- * @param repoRoot Path to the repository root
- * @param filesByName Map of file extensions to possible absolute paths
- * @return std::string Resolved absolute path or empty string if not resolved
+ * @param sourceFile The file containing the import
+ * @param index Files of the repository
+ * @return std::string Repository-relative path of the imported file, or empty string if not resolved
  */
 std::string FileScorer::resolveImportPath(const std::string& importPath, 
-                                         const fs::path& sourceFilePath,
-                                         const fs::path& repoRoot,
-                                         const std::unordered_map<std::string, std::vector<fs::path>>& filesByName) {
+                                         const FileInfo& sourceFile,
+                                         const FileIndex& index) const {
+    if (importPath.empty()) {
+        return "";
+    }
+    
+    auto lookup = [&index](const fs::path& candidate) -> std::string {
+        std::string key = candidate.lexically_normal().generic_string();
+        return index.relPaths.count(key) ? key : std::string();
+    };
+    
     // Handle absolute path (relative to repo root)
     if (importPath.front() == '/') {
-        fs::path absolutePath = repoRoot / importPath.substr(1);
-        if (fs::exists(absolutePath) && fs::is_regular_file(absolutePath)) {
-            return fs::relative(absolutePath, sourceFilePath.parent_path()).string();
+        std::string resolved = lookup(importPath.substr(1));
+        if (!resolved.empty()) {
+            return resolved;
         }
     }
     
     // Handle relative path
     if (importPath.substr(0, 2) == "./" || importPath.substr(0, 3) == "../") {
-        fs::path relativePath = sourceFilePath.parent_path() / importPath;
+        fs::path relativePath = sourceFile.relPath.parent_path() / importPath;
         
-        // Normalize path
-        try {
-            relativePath = fs::canonical(relativePath);
-            
-            // Check if file exists
-            if (fs::exists(relativePath) && fs::is_regular_file(relativePath)) {
-                return fs::relative(relativePath, sourceFilePath.parent_path()).string();
-            }
-            
-            // If path doesn't exist as-is, try adding common extensions
-            for (const auto& ext : {".js", ".ts", ".jsx", ".tsx", ".py", ".java", ".rb", ".php", ".go", ".rs"}) {
-                fs::path withExt = fs::path(relativePath.string() + ext);
-                if (fs::exists(withExt) && fs::is_regular_file(withExt)) {
-                    return fs::relative(withExt, sourceFilePath.parent_path()).string();
-                }
-            }
-            
-            // Handle index files in directories (common in JS/TS)
-            for (const auto& indexFile : {"index.js", "index.ts", "index.jsx", "index.tsx", "__init__.py"}) {
-                fs::path indexPath = relativePath / indexFile;
-                if (fs::exists(indexPath) && fs::is_regular_file(indexPath)) {
-                    return fs::relative(indexPath, sourceFilePath.parent_path()).string();
-                }
+        std::string resolved = lookup(relativePath);
+        if (!resolved.empty()) {
+            return resolved;
+        }
+        
+        // If path doesn't exist as-is, try adding common extensions
+        for (const auto& ext : {".js", ".ts", ".jsx", ".tsx", ".py", ".java", ".rb", ".php", ".go", ".rs"}) {
+            resolved = lookup(relativePath.string() + ext);
+            if (!resolved.empty()) {
+                return resolved;
             }
         }
-        catch (const std::exception& e) {
-            // Ignore errors in path resolution (e.g., invalid paths)
+        
+        // Handle index files in directories (common in JS/TS)
+        for (const auto& indexFile : {"index.js", "index.ts", "index.jsx", "index.tsx", "__init__.py"}) {
+            resolved = lookup(relativePath / indexFile);
+            if (!resolved.empty()) {
+                return resolved;
+            }
         }
     }
     
     // Try to match by filename for non-relative imports (e.g., modules)
     // Extract just the filename from the import path
-    fs::path importPathObj(importPath);
-    std::string filename = importPathObj.filename().string();
-    
-    if (filesByName.find(filename) != filesByName.end()) {
-        const auto& possibleFiles = filesByName.at(filename);
-        if (!possibleFiles.empty()) {
-            // Return the first match (could be improved to find the most likely match)
-            return fs::relative(possibleFiles.front(), sourceFilePath.parent_path()).string();
-        }
+    std::string filename = fs::path(importPath).filename().string();
+    
+    auto byName = index.filesByName.find(filename);
+    if (byName != index.filesByName.end() && !byName->second.empty()) {
+        // Return the first match (could be improved to find the most likely match)
+        return byName->second.front();
     }
     
     // Could not resolve the import
@@ -1061,220 +1099,48 @@ std::string FileScorer::resolveImportPath(const std::string& importPath,
 /**
  * @brief Calculate how connected a file is in the dependency graph
  * 
- * Evaluates a file's importance based on how many other files
- * depend on it and how many files it depends on.
- * 
- * @param filePath Path to the file to evaluate
- * @param dependencyGraph The dependency graph of the repository
+ * @param connections Number of files importing this file plus the number it imports
  * @return float Connectivity score (0.0 to 1.0)
  */
-float FileScorer::calculateConnectivityScore(const fs::path& filePath,
-                                           const std::unordered_map<std::string, std::vector<std::string>>& dependencyGraph) {
-    std::string relPath = fs::relative(filePath, fs::current_path()).string();
-    
-    // Count incoming and outgoing connections
-    int incomingConnections = 0;
-    int outgoingConnections = 0;
-    
-    // Count outgoing connections (files this file imports)
-    if (dependencyGraph.find(relPath) != dependencyGraph.end()) {
-        outgoingConnections = dependencyGraph.at(relPath).size();
-    }
-    
-    // Count incoming connections (files that import this file)
-    for (const auto& [file, imports] : dependencyGraph) {
-        if (file == relPath) {
-            continue;
-        }
-        
-        for (const auto& import : imports) {
-            // Check if this import refers to the current file
-            if (import == relPath || import.find(filePath.filename().string()) != std::string::npos) {
-                incomingConnections++;
-                break;
-            }
-        }
-    }
-    
-    // Files with more connections are likely more important
-    int totalConnections = incomingConnections + outgoingConnections;
-    
+float FileScorer::calculateConnectivityScore(size_t connections) const {
     // Scale connectivity score based on total connections (diminishing returns)
-    if (totalConnections == 0) {
+    if (connections == 0) {
         return 0.0f;
     }
     
     // Log scale to handle files with many connections
-    return std::min(1.0f, std::log2f(totalConnections + 1) / 5.0f);
+    return std::min(1.0f, std::log2f(static_cast<float>(connections) + 1.0f) / 5.0f);
 }
 
 /**
- * @brief Analyze a file using Tree-Sitter for detailed code metrics
+ * @brief Analyze code using TreeSitter for more accurate complexity assessment
  * 
- * Uses the Tree-Sitter parsing library to analyze source code structure,
- * count functions, classes, and statements to calculate code complexity.
+ * Reads the function, class and branch counts of the file's parsed unit
+ * (shared with import extraction) to calculate code complexity.
  * 
- * @param filePath Path to the file to analyze
+ * @param info File to analyze, with its content loaded
  * @return float Code complexity score based on AST analysis
  */
-float FileScorer::analyzeWithTreeSitter(const fs::path& filePath) {
-    try {
-        // Read file content
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open file: " << filePath << std::endl;
-            return 0.0f;
-        }
-        
-        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-        file.close();
-        
-        // Initialize TreeSitter parser
-        TSParser* parser = ts_parser_new();
-        if (!parser) {
-            std::cerr << "Failed to create TreeSitter parser for " << filePath << std::endl;
-            return 0.0f;
-        }
-        
-        // Determine language based on file extension
-        std::string extension = filePath.extension().string();
-        TSLanguage* language = nullptr;
-        
-        if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".cc") {
-            language = tree_sitter_cpp();
-        } else if (extension == ".c") {
-            language = tree_sitter_c();
-        } else if (extension == ".py") {
-            language = tree_sitter_python();
-        } else if (extension == ".js" || extension == ".jsx") {
-            language = tree_sitter_javascript();
-        } else if (extension == ".ts" || extension == ".tsx") {
-            language = tree_sitter_javascript(); // Use JavaScript parser as fallback for TypeScript
-        } else {
-            // Unsupported language, use simple analysis
-            ts_parser_delete(parser);
-            return analyzeFileContent(filePath, content);
-        }
-        
-        // Set language in parser
-        ts_parser_set_language(parser, language);
-        
-        // Parse file
-        TSTree* tree = ts_parser_parse_string(parser, nullptr, content.c_str(), static_cast<uint32_t>(content.length()));
-        if (!tree) {
-            std::cerr << "Failed to parse file: " << filePath << std::endl;
-            ts_parser_delete(parser);
-            return analyzeFileContent(filePath, content);
-        }
-        
-        // Get root node
-        TSNode root = ts_tree_root_node(tree);
-        
-        // Analyze code complexity based on AST
-        float complexity = 0.0f;
-        
-        // Count functions
-        const char* function_query_str = "";
-        if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".cc" || extension == ".c") {
-            function_query_str = "(function_definition) @function";
-        } else if (extension == ".py") {
-            function_query_str = "(function_definition) @function";
-        } else if (extension == ".js" || extension == ".jsx" || extension == ".ts" || extension == ".tsx") {
-            function_query_str = "(function_declaration) @function";
-        }
-        
-        uint32_t error_offset;
-        TSQueryError error_type;
-        TSQuery* function_query = ts_query_new(language, function_query_str, strlen(function_query_str), &error_offset, &error_type);
-        
-        if (function_query) {
-            TSQueryCursor* function_cursor = ts_query_cursor_new();
-            ts_query_cursor_exec(function_cursor, function_query, root);
-            
-            // Count functions
-            int function_count = 0;
-            TSQueryMatch match;
-            while (ts_query_cursor_next_match(function_cursor, &match)) {
-                function_count++;
-            }
-            
-            // More functions generally means more complex code
-            complexity += function_count * 0.1f;
-            
-            ts_query_cursor_delete(function_cursor);
-            ts_query_delete(function_query);
-        }
-        
-        // Count classes
-        const char* class_query_str = "";
-        if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".cc") {
-            class_query_str = "(class_specifier) @class";
-        } else if (extension == ".py") {
-            class_query_str = "(class_definition) @class";
-        } else if (extension == ".js" || extension == ".jsx" || extension == ".ts" || extension == ".tsx") {
-            class_query_str = "(class_declaration) @class";
-        }
-        
-        TSQuery* class_query = ts_query_new(language, class_query_str, strlen(class_query_str), &error_offset, &error_type);
-        
-        if (class_query) {
-            TSQueryCursor* class_cursor = ts_query_cursor_new();
-            ts_query_cursor_exec(class_cursor, class_query, root);
-            
-            // Count classes
-            int class_count = 0;
-            TSQueryMatch match;
-            while (ts_query_cursor_next_match(class_cursor, &match)) {
-                class_count++;
-            }
-            
-            // Classes add to complexity
-            complexity += class_count * 0.2f;
-            
-            ts_query_cursor_delete(class_cursor);
-            ts_query_delete(class_query);
-        }
-        
-        // Count conditional statements (if, else, switch, etc.)
-        const char* conditional_query_str = "";
-        if (extension == ".cpp" || extension == ".hpp" || extension == ".h" || extension == ".cc" || extension == ".c") {
-            conditional_query_str = "((if_statement) @if (while_statement) @while (for_statement) @for (switch_statement) @switch)";
-        } else if (extension == ".py") {
-            conditional_query_str = "((if_statement) @if (while_statement) @while (for_statement) @for)";
-        } else if (extension == ".js" || extension == ".jsx" || extension == ".ts" || extension == ".tsx") {
-            conditional_query_str = "((if_statement) @if (while_statement) @while (for_statement) @for (switch_statement) @switch)";
-        }
-        
-        TSQuery* conditional_query = ts_query_new(language, conditional_query_str, strlen(conditional_query_str), &error_offset, &error_type);
-        
-        if (conditional_query) {
-            TSQueryCursor* conditional_cursor = ts_query_cursor_new();
-            ts_query_cursor_exec(conditional_cursor, conditional_query, root);
-            
-            // Count conditional statements
-            int conditional_count = 0;
-            TSQueryMatch match;
-            while (ts_query_cursor_next_match(conditional_cursor, &match)) {
-                conditional_count++;
-            }
-            
-            // Conditionals add to complexity
-            complexity += conditional_count * 0.05f;
-            
-            ts_query_cursor_delete(conditional_cursor);
-            ts_query_delete(conditional_query);
-        }
-        
-        // Clean up
-        ts_tree_delete(tree);
-        ts_parser_delete(parser);
-        
-        // Normalize complexity score (0.0 - 1.0)
-        return std::min(1.0f, complexity);
-    } catch (const std::exception& e) {
-        std::cerr << "Error analyzing file with tree-sitter: " << filePath << ": " << e.what() << std::endl;
-        return analyzeFileContent(filePath);
+float FileScorer::analyzeWithTreeSitter(const FileInfo& info) {
+    if (!ParsedUnit::supports(info.path)) {
+        // Unsupported language, use simple analysis
+        return analyzeFileContent(info.path, info.content);
     }
+    
+    const ParsedUnit& unit = info.parsed();
+    if (!unit.parsed()) {
+        std::cerr << "Failed to parse file: " << info.path << std::endl;
+        return analyzeFileContent(info.path, info.content);
+    }
+    
+    // More functions generally means more complex code; classes and
+    // conditionals add to complexity as well
+    float complexity = unit.count(ParsedUnit::Kind::Function) * 0.1f +
+                       unit.count(ParsedUnit::Kind::Class) * 0.2f +
+                       unit.count(ParsedUnit::Kind::Branch) * 0.05f;
+    
+    // Normalize complexity score (0.0 - 1.0)
+    return std::min(1.0f, complexity);
 }
 
 /**
@@ -1299,52 +1165,10 @@ float FileScorer::analyzeFileContent(const fs::path& filePath, const std::string
         
         // Basic stack for tracking code blocks/scope depth
         int scopeDepth = 0;
-        std::string extension = filePath.extension().string();
         bool inMultiLineComment = false;
         
-        // Regex patterns for detecting code structures based on language
-        std::regex functionPattern;
-        std::regex classPattern;
-        std::regex importPattern;
-        std::regex commentStartPattern;
-        std::regex commentEndPattern;
-        
-        // Configure language-specific patterns
-        if (extension == ".py") {
-            functionPattern = std::regex("^\\s*def\\s+\\w+\\s*\\(.*\\)\\s*:");
-            classPattern = std::regex("^\\s*class\\s+\\w+.*:");
-            importPattern = std::regex("^\\s*(import|from)\\s+\\w+");
-            commentStartPattern = std::regex("^\\s*\"\"\"");
-            commentEndPattern = std::regex("\"\"\"\\s*$");
-        } 
-        else if (extension == ".js" || extension == ".ts" || extension == ".jsx" || extension == ".tsx") {
-            functionPattern = std::regex("(function\\s+\\w+\\s*\\(|const\\s+\\w+\\s*=\\s*\\(|\\w+\\s*=\\s*\\(|\\w+\\s*\\(.*\\)\\s*\\{)");
-            classPattern = std::regex("class\\s+\\w+");
-            importPattern = std::regex("(import|require)");
-            commentStartPattern = std::regex("/\\*");
-            commentEndPattern = std::regex("\\*/");
-        }
-        else if (extension == ".cpp" || extension == ".cc" || extension == ".cxx" || extension == ".h" || extension == ".hpp") {
-            functionPattern = std::regex("\\w+\\s+\\w+\\s*\\(.*\\)\\s*(const)?\\s*\\{?");
-            classPattern = std::regex("(class|struct)\\s+\\w+");
-            importPattern = std::regex("#include");
-            commentStartPattern = std::regex("/\\*");
-            commentEndPattern = std::regex("\\*/");
-        }
-        else if (extension == ".java") {
-            functionPattern = std::regex("(public|private|protected)?\\s*(static)?\\s*\\w+\\s+\\w+\\s*\\(.*\\)\\s*\\{?");
-            classPattern = std::regex("(public|private|protected)?\\s*(static)?\\s*class\\s+\\w+");
-            importPattern = std::regex("import\\s+\\w+");
-            commentStartPattern = std::regex("/\\*");
-            commentEndPattern = std::regex("\\*/");
-        }
-        else if (extension == ".rb") {
-            functionPattern = std::regex("def\\s+\\w+");
-            classPattern = std::regex("class\\s+\\w+");
-            importPattern = std::regex("(require|include)");
-            commentStartPattern = std::regex("=begin");
-            commentEndPattern = std::regex("=end");
-        }
+        // Patterns for detecting code structures based on language
+        const LanguageRules& rules = rulesFor(languageOf(filePath));
         
         // Process file line by line
         std::istringstream stream(content);
@@ -1358,7 +1182,7 @@ float FileScorer::analyzeFileContent(const fs::path& filePath, const std::string
             line.erase(line.find_last_not_of(" \t\r\n") + 1);
             
             // Track multiline comments
-            if (!inMultiLineComment && std::regex_search(line, commentStartPattern)) {
+            if (!inMultiLineComment && rules.commentStart.search(line)) {
                 inMultiLineComment = true;
                 commentLines++;
                 continue;
@@ -1366,7 +1190,7 @@ float FileScorer::analyzeFileContent(const fs::path& filePath, const std::string
             
             if (inMultiLineComment) {
                 commentLines++;
-                if (std::regex_search(line, commentEndPattern)) {
+                if (rules.commentEnd.search(line)) {
                     inMultiLineComment = false;
                 }
                 continue;
@@ -1386,15 +1210,15 @@ float FileScorer::analyzeFileContent(const fs::path& filePath, const std::string
             }
             
             // Count code structures
-            if (std::regex_search(line, functionPattern)) {
+            if (rules.functionLine.search(line)) {
                 functionDefs++;
             }
             
-            if (std::regex_search(line, classPattern)) {
+            if (rules.classLine.search(line)) {
                 classDefs++;
             }
             
-            if (std::regex_search(line, importPattern)) {
+            if (rules.importLine.search(line)) {
                 importLines++;
             }
             
@@ -1457,31 +1281,3 @@ float FileScorer::analyzeFileContent(const fs::path& filePath, const std::string
         return 0.2f;
     }
 }
-
-/**
- * @brief Analyze file content by reading the file first
- * 
- * Opens and reads a file, then calls the content analysis function.
- * 
- * @param filePath Path to the file to analyze
- * @return float Complexity score based on content analysis
- */
-float FileScorer::analyzeFileContent(const fs::path& filePath) {
-    try {
-        // Read file content
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open file: " << filePath << std::endl;
-            return 0.0f;
-        }
-        
-        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-        file.close();
-        
-        return analyzeFileContent(filePath, content);
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Error reading file: " << filePath << ": " << e.what() << std::endl;
-        return 0.0f;
-    }
-} 
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "job_executor.hpp"
+#include <algorithm>
+#include <iostream>
+
+/**
+ * @brief Starts one worker thread per job slot
+ *
+ * @param config Slot count, queue limit and CPU budget
+ */
+JobExecutor::JobExecutor(const Config& config)
+    : config_(config) {
+    config_.maxConcurrentJobs = std::max(1u, config_.maxConcurrentJobs);
+    config_.cpuBudget = std::max(config_.maxConcurrentJobs, config_.cpuBudget);
+    threadsPerJob_ = config_.cpuBudget / config_.maxConcurrentJobs;
+
+    workers_.reserve(config_.maxConcurrentJobs);
+    for (unsigned int i = 0; i < config_.maxConcurrentJobs; ++i) {
+        workers_.emplace_back(&JobExecutor::workerLoop, this);
+    }
+}
+
+/**
+ * @brief Lets running jobs finish and drops the ones still queued
+ */
+JobExecutor::~JobExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    jobAvailable_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Queues a job
+ *
+ * @param jobId Identifier reported by getState
+ * @param task Work to run; receives its share of the CPU budget
+ * @return bool False if the queue is full or the executor is shutting down
+ */
+bool JobExecutor::submit(const std::string& jobId, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= config_.maxQueuedJobs) {
+            return false;
+        }
+        queue_.push_back({jobId, std::move(task)});
+        states_[jobId] = JobState::Queued;
+    }
+    jobAvailable_.notify_one();
+    return true;
+}
+
+/**
+ * @brief Looks up the state of a job
+ *
+ * @param jobId Identifier passed to submit
+ * @param state Receives the state
+ * @return bool False if the job is unknown
+ */
+bool JobExecutor::getState(const std::string& jobId, JobState& state) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = states_.find(jobId);
+    if (it == states_.end()) {
+        return false;
+    }
+    state = it->second;
+    return true;
+}
+
+size_t JobExecutor::queuedJobs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+size_t JobExecutor::runningJobs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+const char* JobExecutor::stateName(JobState state) {
+    switch (state) {
+        case JobState::Queued:
+            return "queued";
+        case JobState::Running:
+            return "running";
+        case JobState::Finished:
+        default:
+            return "finished";
+    }
+}
+
+void JobExecutor::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        jobAvailable_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            return;
+        }
+
+        QueuedJob job = std::move(queue_.front());
+        queue_.pop_front();
+        states_[job.id] = JobState::Running;
+        ++running_;
+        lock.unlock();
+
+        try {
+            job.task(threadsPerJob_);
+        } catch (const std::exception& e) {
+            std::cerr << "Job " << job.id << " failed: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Job " << job.id << " failed" << std::endl;
+        }
+        // Release whatever the task captured before taking the lock again
+        job.task = nullptr;
+
+        lock.lock();
+        --running_;
+        states_[job.id] = JobState::Finished;
+        finishedOrder_.push_back(job.id);
+        while (finishedOrder_.size() > config_.maxRetainedJobs) {
+            states_.erase(finishedOrder_.front());
+            finishedOrder_.pop_front();
+        }
+    }
+}
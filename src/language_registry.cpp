@@ -0,0 +1,214 @@
+#include "language_registry.hpp"
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+LanguageRules cFamilyRules() {
+    LanguageRules rules;
+    rules.classNames = Regex(R"((?:class|struct)\s+(\w+))");
+    rules.functionNames.emplace_back(R"((\w+)\s*\([^{;]*\)\s*(?:const)?\s*(?:noexcept)?\s*(?:override)?\s*(?:final)?\s*(?:=\s*0)?\s*(?:=\s*delete)?\s*(?:=\s*default)?\s*(?:;|\{))");
+    rules.functionStopWords = {"if", "for", "while", "switch", "catch", "return", "sizeof"};
+    rules.variableNames = Regex(R"((?:int|float|double|char|bool|unsigned|long|short|size_t|uint\d+_t|int\d+_t|std::string|string|auto|constexpr|const|static)\s+(\w+)\s*(?:=|;|\[))");
+    rules.enumNames = Regex(R"(enum\s+(?:class\s+)?(\w+))");
+    rules.importNames = Regex(R"(#include\s*[<"]([^>"]+)[>"])");
+
+    SignaturePattern function;
+    function.regex = Regex(R"((\w+\s+)*\w+\s+\w+\s*\([^{;]*\)\s*(?:const)?\s*(?:noexcept)?\s*(?:override)?\s*(?:final)?\s*(?:=\s*0)?\s*(?:=\s*delete)?\s*(?:=\s*default)?\s*(?:;|\{))");
+    function.suffix = "...}";
+    function.cutAtBrace = true;
+    rules.signatures.push_back(std::move(function));
+    SignaturePattern classSignature;
+    classSignature.regex = Regex(R"((class|struct)\s+\w+\s*(?::\s*(?:public|protected|private)\s+\w+(?:::\w+)?(?:\s*,\s*(?:public|protected|private)\s+\w+(?:::\w+)?)*\s*)?\s*\{)");
+    classSignature.suffix = "...};";
+    rules.signatures.push_back(std::move(classSignature));
+
+    rules.functionLine = Regex(R"(\w+\s+\w+\s*\(.*\)\s*(const)?\s*\{?)");
+    rules.classLine = Regex(R"((class|struct)\s+\w+)");
+    rules.importLine = Regex("#include");
+    rules.commentStart = Regex(R"(/\*)");
+    rules.commentEnd = Regex(R"(\*/)");
+
+    rules.imports.emplace_back(R"(#include\s+[<"](.+?)[>"])");
+    return rules;
+}
+
+LanguageRules pythonRules() {
+    LanguageRules rules;
+    rules.classNames = Regex(R"(class\s+(\w+))");
+    rules.functionNames.emplace_back(R"(def\s+(\w+)\s*\()");
+    rules.variableNames = Regex(R"((\w+)\s*=\s*[^=])");
+    rules.variableStopWords = {"if", "for", "while", "def"};
+    rules.importNames = Regex(R"(import\s+(\w+))");
+
+    SignaturePattern function;
+    function.regex = Regex(R"(def\s+\w+\s*\([^:]*\)\s*(?:->.*?)?\s*:)");
+    rules.signatures.push_back(std::move(function));
+    SignaturePattern classSignature;
+    classSignature.regex = Regex(R"(class\s+\w+(?:\([^:]*\))?\s*:)");
+    rules.signatures.push_back(std::move(classSignature));
+
+    rules.functionLine = Regex(R"(^\s*def\s+\w+\s*\(.*\)\s*:)");
+    rules.classLine = Regex(R"(^\s*class\s+\w+.*:)");
+    rules.importLine = Regex(R"(^\s*(import|from)\s+\w+)");
+    rules.commentStart = Regex(R"(^\s*""")");
+    rules.commentEnd = Regex(R"("""\s*$)");
+
+    rules.imports.emplace_back(R"(from\s+([\w\.]+)\s+import)");
+    rules.imports.emplace_back(R"(import\s+([\w\.]+))");
+    // from package import (
+    //     a,
+    //     b
+    // )
+    rules.hasMultiLineImports = true;
+    rules.multiLineImportStart = Regex(R"(from\s+([\w\.]+)\s+import\s+\()");
+    rules.multiLineImportEnd = Regex(R"(\))");
+    return rules;
+}
+
+LanguageRules javaScriptRules() {
+    LanguageRules rules;
+    rules.classNames = Regex(R"(class\s+(\w+))");
+    // Function declarations, arrow functions with assignment, class methods
+    rules.functionNames.emplace_back(R"(function\s+(\w+)\s*\()");
+    rules.functionNames.emplace_back(R"(const\s+(\w+)\s*=\s*(?:async\s+)?\([^{]*\)\s*=>)");
+    rules.functionNames.emplace_back(R"((\w+)\s*\([^{]*\)\s*\{)");
+    rules.functionStopWords = {"if", "for", "while", "switch", "catch", "constructor"};
+
+    SignaturePattern function;
+    function.regex = Regex(R"((async\s+)?function\s+\w+\s*\([^{]*\)|const\s+\w+\s*=\s*(async\s+)?\([^{]*\)\s*=>)");
+    function.suffix = " {...}";
+    rules.signatures.push_back(std::move(function));
+    SignaturePattern classSignature;
+    classSignature.regex = Regex(R"(class\s+\w+(?:\s+extends\s+\w+)?\s*\{)");
+    classSignature.suffix = "...}";
+    rules.signatures.push_back(std::move(classSignature));
+    SignaturePattern method;
+    method.regex = Regex(R"((\w+)\s*\([^{]*\)\s*\{)");
+    method.suffix = "...}";
+    rules.signatures.push_back(std::move(method));
+
+    rules.functionLine = Regex(R"((function\s+\w+\s*\(|const\s+\w+\s*=\s*\(|\w+\s*=\s*\(|\w+\s*\(.*\)\s*\{))");
+    rules.classLine = Regex(R"(class\s+\w+)");
+    rules.importLine = Regex("(import|require)");
+    rules.commentStart = Regex(R"(/\*)");
+    rules.commentEnd = Regex(R"(\*/)");
+
+    rules.imports.emplace_back(R"(import\s+.*?from\s+['"](.+?)['"])");
+    rules.imports.emplace_back(R"(import\s+['"](.+?)['"])");
+    rules.imports.emplace_back(R"(require\s*\(['"](.+?)['"]\))");
+    // import {
+    //   Component1,
+    //   Component2
+    // } from 'source';
+    rules.hasMultiLineImports = true;
+    rules.multiLineImportStart = Regex(R"(import\s+\{.*(?:from\s+['"](.+?)['"])?$)");
+    rules.multiLineImportEnd = Regex(R"(.*\}\s+from\s+['"](.+?)['"])");
+    return rules;
+}
+
+LanguageRules javaRules() {
+    LanguageRules rules;
+    rules.functionLine = Regex(R"((public|private|protected)?\s*(static)?\s*\w+\s+\w+\s*\(.*\)\s*\{?)");
+    rules.classLine = Regex(R"((public|private|protected)?\s*(static)?\s*class\s+\w+)");
+    rules.importLine = Regex(R"(import\s+\w+)");
+    rules.commentStart = Regex(R"(/\*)");
+    rules.commentEnd = Regex(R"(\*/)");
+
+    rules.imports.emplace_back(R"(import\s+([\w\.\*]+);)");
+    return rules;
+}
+
+LanguageRules rubyRules() {
+    LanguageRules rules;
+    rules.functionLine = Regex(R"(def\s+\w+)");
+    rules.classLine = Regex(R"(class\s+\w+)");
+    rules.importLine = Regex("(require|include)");
+    rules.commentStart = Regex("=begin");
+    rules.commentEnd = Regex("=end");
+
+    rules.imports.emplace_back(R"(require\s+['"](.+?)['"])");
+    rules.imports.emplace_back(R"(require_relative\s+['"](.+?)['"])");
+    rules.imports.emplace_back(R"(load\s+['"](.+?)['"])");
+    return rules;
+}
+
+LanguageRules phpRules() {
+    LanguageRules rules;
+    rules.imports.emplace_back(R"((?:require|include)(?:_once)?\s+['"](.+?)['"])");
+    rules.imports.emplace_back(R"(use\s+([\w\\]+))");
+    return rules;
+}
+
+LanguageRules goRules() {
+    LanguageRules rules;
+    rules.imports.emplace_back(R"(import\s+['"](.+?)['"])");
+    rules.hasMultiLineImports = true;
+    rules.multiLineImportStart = Regex(R"(import\s+\()");
+    rules.multiLineImportEnd = Regex(R"(\))");
+    return rules;
+}
+
+LanguageRules rustRules() {
+    LanguageRules rules;
+    rules.imports.emplace_back(R"(use\s+([\w:]+))");
+    rules.hasMultiLineImports = true;
+    rules.multiLineImportStart = Regex(R"(use\s+\{)");
+    rules.multiLineImportEnd = Regex(R"(\};)");
+    return rules;
+}
+
+std::vector<LanguageRules> buildRules() {
+    // Indexed by Language
+    std::vector<LanguageRules> rules;
+    rules.push_back(LanguageRules());       // Unknown
+    rules.push_back(cFamilyRules());        // C
+    rules.push_back(cFamilyRules());        // Cpp
+    rules.push_back(pythonRules());
+    rules.push_back(javaScriptRules());
+    rules.push_back(javaRules());
+    rules.push_back(rubyRules());
+    rules.push_back(phpRules());
+    rules.push_back(goRules());
+    rules.push_back(rustRules());
+    return rules;
+}
+
+}  // namespace
+
+/**
+ * @brief Maps a file to its language by extension
+ *
+ * @param filePath Path of the file
+ * @return Language The language, or Unknown
+ */
+Language languageOf(const fs::path& filePath) {
+    static const std::unordered_map<std::string, Language> byExtension = {
+        {".c", Language::C},
+        {".cpp", Language::Cpp}, {".cc", Language::Cpp}, {".cxx", Language::Cpp},
+        {".h", Language::Cpp}, {".hpp", Language::Cpp},
+        {".py", Language::Python},
+        {".js", Language::JavaScript}, {".jsx", Language::JavaScript},
+        {".ts", Language::JavaScript}, {".tsx", Language::JavaScript},
+        {".java", Language::Java},
+        {".rb", Language::Ruby},
+        {".php", Language::Php},
+        {".go", Language::Go},
+        {".rs", Language::Rust},
+    };
+    auto it = byExtension.find(filePath.extension().string());
+    return it != byExtension.end() ? it->second : Language::Unknown;
+}
+
+/**
+ * @brief Returns the pattern tables of a language
+ *
+ * All tables are compiled together on first use.
+ *
+ * @param language Language to look up
+ * @return const LanguageRules& Tables shared by all callers
+ */
+const LanguageRules& rulesFor(Language language) {
+    static const std::vector<LanguageRules> rules = buildRules();
+    return rules[static_cast<size_t>(language)];
+}
@@ -39,6 +39,14 @@ int main(int argc, char** argv) {
         
         // Optional timing flag
         app.add_flag("-t,--timing", options.showTiming, "Show detailed timing information");
+        app.add_option("--trace", options.traceFile, 
+                      "Write a Chrome trace-event timeline of the run to this file (chrome://tracing, Perfetto)");
+        
+        // Progress reporting
+        unsigned int progressIntervalMs = 100;
+        bool noProgress = false;
+        app.add_option("--progress-interval", progressIntervalMs, "Minimum time between progress reports in milliseconds (default: 100)");
+        app.add_flag("--no-progress", noProgress, "Do not print progress reports");
         
         // Optional thread count
         app.add_option("--threads", options.numThreads, "Number of threads to use for processing (default: number of CPU cores)")
@@ -49,6 +57,18 @@ int main(int argc, char** argv) {
         app.add_option("--token-encoding", tokenEncodingStr, "Token encoding to use: cl100k_base, r50k_base, p50k_base (default: cl100k_base)")
             ->check(CLI::IsMember({"cl100k_base", "r50k_base", "p50k_base"}));
         app.add_flag("--only-show-token-count", options.onlyShowTokenCount, "Only show token count without generating full output");
+        app.add_option("--token-budget", options.tokenBudget, 
+                      "Fit the output into this many tokens: best-scoring files first, summarized where they do not fit in full")
+            ->check(CLI::PositiveNumber);
+        
+        // Identical files are emitted once, copies as references
+        bool noDedup = false;
+        app.add_flag("--no-dedup", noDedup, "Emit every copy of identical files in full");
+        
+        // Persistent result cache
+        bool useCache = false;
+        app.add_flag("--cache", useCache, "Cache per-file results between runs in the default cache directory");
+        app.add_option("--cache-dir", options.cacheDir, "Cache per-file results between runs in this directory");
         
         // File selection strategy options
         auto fileSelectionOpt = app.add_option("--file-selection", fileSelectionStr, 
@@ -139,7 +159,7 @@ int main(int argc, char** argv) {
         options.excludePatterns = excludePatterns;
         
         // Set token encoding
-        if (options.countTokens) {
+        if (options.countTokens || options.tokenBudget > 0) {
             options.tokenEncoding = Tokenizer::encodingFromString(tokenEncodingStr);
         }
         
@@ -150,6 +170,15 @@ int main(int argc, char** argv) {
             options.selectionStrategy = RepomixOptions::FileSelectionStrategy::All;
         }
         
+        options.progress.interval = std::chrono::milliseconds(progressIntervalMs);
+        options.progress.logToConsole = !noProgress;
+        options.deduplicate = !noDedup;
+        
+        // Fall back to the per-user cache location
+        if (useCache && options.cacheDir.empty()) {
+            options.cacheDir = ResultCache::defaultDirectory();
+        }
+        
         // Run repomix
         Repomix repomix(options);
         if (!repomix.run()) {
@@ -157,7 +186,7 @@ int main(int argc, char** argv) {
         }
         
         // Print summary or token count
-        if (options.verbose || options.countTokens) {
+        if (options.verbose || options.showTiming || options.countTokens || options.tokenBudget > 0) {
             std::cout << repomix.getSummary() << std::endl;
         }
         
@@ -166,8 +195,9 @@ int main(int argc, char** argv) {
             std::cout << repomix.getTokenCount() << std::endl;
         }
         
-        // Generate scoring report if requested
-        if (generateScoringReport && options.selectionStrategy == RepomixOptions::FileSelectionStrategy::Scoring) {
+        // Generate scoring report if requested (a token budget implies scoring)
+        if (generateScoringReport && (options.selectionStrategy == RepomixOptions::FileSelectionStrategy::Scoring ||
+                                      options.tokenBudget > 0)) {
             std::string reportPath = scoringReportPath.empty() ? "scoring-report.json" : scoringReportPath;
             std::string report = repomix.getFileScoringReport();
             
@@ -0,0 +1,242 @@
+#include "metrics.hpp"
+#include "trace_recorder.hpp"
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+struct CounterInfo {
+    const char* name;       // Prometheus name without the prefix
+    const char* help;
+    bool nanos;             // Exported in seconds
+};
+
+const CounterInfo COUNTERS[] = {
+    {"directories_scanned_total", "Directories scanned for files", false},
+    {"files_opened_total", "Files opened and stat'ed", false},
+    {"read_bytes_total", "Bytes of file content read", false},
+    {"binary_files_skipped_total", "Files skipped as binary", false},
+    {"pool_tasks_total", "Tasks run by the worker pools", false},
+    {"worker_idle_seconds_total", "Time pool workers slept waiting for tasks", true},
+    {"chunks_analyzed_total", "Chunks of large files analyzed on their own", false},
+    {"duplicate_files_total", "Files skipped as copies of another file's content", false},
+};
+
+const CounterInfo GAUGES[] = {
+    {"pool_queued_tasks", "Tasks waiting in a worker pool deque", false},
+    {"pool_busy_workers", "Pool workers currently running a task", false},
+};
+
+const char* const STAGES[] = {
+    "traversal", "open", "read", "binary_check",
+    "ner_regex", "ner_tree_sitter", "ner_ml", "ner_hybrid",
+    "summarize", "tokenize", "format", "scoring",
+};
+
+static_assert(sizeof(COUNTERS) / sizeof(COUNTERS[0]) == Metrics::COUNTER_COUNT, "one entry per counter");
+static_assert(sizeof(GAUGES) / sizeof(GAUGES[0]) == Metrics::GAUGE_COUNT, "one entry per gauge");
+static_assert(sizeof(STAGES) / sizeof(STAGES[0]) == Metrics::STAGE_COUNT, "one entry per stage");
+
+// Slot of the calling thread, assigned round-robin on first use
+thread_local unsigned int threadSlot = ~0u;
+
+size_t bucketFor(uint64_t nanos) {
+    const double seconds = static_cast<double>(nanos) * 1e-9;
+    size_t bucket = 0;
+    while (bucket < Metrics::BUCKET_BOUNDS.size() && seconds > Metrics::BUCKET_BOUNDS[bucket]) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+}  // namespace
+
+Metrics::Metrics() : slots_(std::make_unique<Slot[]>(SLOT_COUNT)) {}
+
+/**
+ * @brief Returns the process-wide registry
+ *
+ * @return Metrics& Registry shared by every job and thread
+ */
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Slot& Metrics::slot() {
+    if (threadSlot == ~0u) {
+        threadSlot = nextSlot_.fetch_add(1, std::memory_order_relaxed) % SLOT_COUNT;
+    }
+    return slots_[threadSlot];
+}
+
+Metrics::ScopedTimer::~ScopedTimer() {
+    const auto end = std::chrono::steady_clock::now();
+    Metrics::instance().record(stage_, end - start_);
+    if (TraceRecorder* trace = TraceRecorder::current()) {
+        trace->complete(STAGES[static_cast<size_t>(stage_)], "stage", start_, end,
+                        detail_ ? detail_->string() : std::string());
+    }
+}
+
+/**
+ * @brief Adds one timed event to a stage
+ *
+ * @param stage Stage the time was spent in
+ * @param elapsed Duration of the event
+ */
+void Metrics::record(Stage stage, std::chrono::nanoseconds elapsed) {
+    const uint64_t nanos = elapsed.count() > 0 ? static_cast<uint64_t>(elapsed.count()) : 0;
+    Slot::Stage& totals = slot().stages[static_cast<size_t>(stage)];
+    totals.count.fetch_add(1, std::memory_order_relaxed);
+    totals.nanos.fetch_add(nanos, std::memory_order_relaxed);
+    totals.buckets[bucketFor(nanos)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::add(Counter counter, uint64_t amount) {
+    slot().counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Metrics::adjust(Gauge gauge, int64_t delta) {
+    slot().gauges[static_cast<size_t>(gauge)].fetch_add(delta, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sums the per-thread slots
+ *
+ * @return Snapshot Totals since the process started
+ *
+ * Slots are read one after another without stopping the writers, so a
+ * snapshot taken while work is running may be off by the events in flight.
+ */
+Metrics::Snapshot Metrics::snapshot() const {
+    Snapshot result;
+    for (size_t s = 0; s < SLOT_COUNT; ++s) {
+        const Slot& slot = slots_[s];
+        for (size_t i = 0; i < STAGE_COUNT; ++i) {
+            StageTotals& totals = result.stages[i];
+            totals.count += slot.stages[i].count.load(std::memory_order_relaxed);
+            totals.nanos += slot.stages[i].nanos.load(std::memory_order_relaxed);
+            for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+                totals.buckets[b] += slot.stages[i].buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+        for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+            result.counters[i] += slot.counters[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < GAUGE_COUNT; ++i) {
+            result.gauges[i] += slot.gauges[i].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+Metrics::Snapshot Metrics::Snapshot::since(const Snapshot& earlier) const {
+    Snapshot result = *this;
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        result.stages[i].count -= earlier.stages[i].count;
+        result.stages[i].nanos -= earlier.stages[i].nanos;
+        for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+            result.stages[i].buckets[b] -= earlier.stages[i].buckets[b];
+        }
+    }
+    for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+        result.counters[i] -= earlier.counters[i];
+    }
+    return result;
+}
+
+/**
+ * @brief Renders the running totals in the Prometheus text format
+ *
+ * @return std::string Exposition text (version 0.0.4)
+ */
+std::string Metrics::prometheus() const {
+    const Snapshot totals = snapshot();
+    std::ostringstream out;
+    out << std::setprecision(9);
+
+    out << "# HELP repomix_stage_duration_seconds Time spent per pipeline stage, summed over threads\n"
+        << "# TYPE repomix_stage_duration_seconds histogram\n";
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        const StageTotals& stage = totals.stages[i];
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+            cumulative += stage.buckets[b];
+            out << "repomix_stage_duration_seconds_bucket{stage=\"" << STAGES[i] << "\",le=\"";
+            if (b < BUCKET_BOUNDS.size()) {
+                out << BUCKET_BOUNDS[b];
+            } else {
+                out << "+Inf";
+            }
+            out << "\"} " << cumulative << '\n';
+        }
+        out << "repomix_stage_duration_seconds_sum{stage=\"" << STAGES[i] << "\"} "
+            << static_cast<double>(stage.nanos) * 1e-9 << '\n'
+            << "repomix_stage_duration_seconds_count{stage=\"" << STAGES[i] << "\"} " << stage.count << '\n';
+    }
+
+    for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+        const CounterInfo& info = COUNTERS[i];
+        out << "# HELP repomix_" << info.name << ' ' << info.help << '\n'
+            << "# TYPE repomix_" << info.name << " counter\n"
+            << "repomix_" << info.name << ' ';
+        if (info.nanos) {
+            out << static_cast<double>(totals.counters[i]) * 1e-9;
+        } else {
+            out << totals.counters[i];
+        }
+        out << '\n';
+    }
+
+    for (size_t i = 0; i < GAUGE_COUNT; ++i) {
+        const CounterInfo& info = GAUGES[i];
+        out << "# HELP repomix_" << info.name << ' ' << info.help << '\n'
+            << "# TYPE repomix_" << info.name << " gauge\n"
+            << "repomix_" << info.name << ' ' << totals.gauges[i] << '\n';
+    }
+    return out.str();
+}
+
+/**
+ * @brief Formats the stages and counters of one run as a table
+ *
+ * @param run Difference of the snapshots taken around the run
+ * @return std::string One line per stage that was entered, then the counters
+ */
+std::string Metrics::breakdown(const Snapshot& run) {
+    std::ostringstream out;
+    out << "Stage breakdown (summed over threads):" << std::endl;
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        const StageTotals& stage = run.stages[i];
+        if (stage.count == 0) {
+            continue;
+        }
+        const double totalMs = static_cast<double>(stage.nanos) / 1e6;
+        out << "  " << std::left << std::setw(16) << STAGES[i] << std::right << std::fixed
+            << std::setprecision(2) << std::setw(10) << totalMs << " ms" << std::setw(10) << stage.count
+            << " calls" << std::setprecision(3) << std::setw(10) << totalMs / static_cast<double>(stage.count)
+            << " ms avg" << std::endl;
+    }
+    out << "  Directories scanned: " << run.counter(Counter::DirectoriesScanned)
+        << ", files opened: " << run.counter(Counter::FilesOpened)
+        << ", bytes read: " << run.counter(Counter::BytesRead)
+        << ", binary skipped: " << run.counter(Counter::BinaryFilesSkipped)
+        << ", duplicates: " << run.counter(Counter::DuplicateFiles) << std::endl;
+    out << "  Pool tasks: " << run.counter(Counter::PoolTasksRun) << ", worker idle: " << std::fixed
+        << std::setprecision(2) << static_cast<double>(run.counter(Counter::WorkerIdleNanos)) / 1e6 << " ms"
+        << ", large-file chunks: " << run.counter(Counter::ChunksAnalyzed) << std::endl;
+    return out.str();
+}
+
+const char* Metrics::stageName(Stage stage) {
+    return STAGES[static_cast<size_t>(stage)];
+}
+
+const char* Metrics::counterName(Counter counter) {
+    return COUNTERS[static_cast<size_t>(counter)].name;
+}
+
+const char* Metrics::gaugeName(Gauge gauge) {
+    return GAUGES[static_cast<size_t>(gauge)].name;
+}
@@ -0,0 +1,197 @@
+#include "output_sink.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Appends data to the in-memory output
+ *
+ * @param data Piece of output
+ */
+void MemorySink::write(std::string_view data) {
+    buffer_.append(data.data(), data.size());
+    bytesWritten_ += data.size();
+}
+
+/**
+ * @brief Moves the collected output out of the sink
+ *
+ * @return std::string Everything written so far
+ */
+std::string MemorySink::release() {
+    std::string result;
+    result.swap(buffer_);
+    return result;
+}
+
+/**
+ * @brief Opens (and truncates) the output file
+ *
+ * @param path File to write
+ * @throws std::runtime_error if the file cannot be opened
+ */
+FileSink::FileSink(const fs::path& path)
+    : path_(path), buffer_(1 << 20) {
+    // The buffer has to be installed before the file is opened to take effect
+    file_.rdbuf()->pubsetbuf(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        throw std::runtime_error("Could not open output file: " + path.string());
+    }
+}
+
+/**
+ * @brief Appends data to the file
+ *
+ * @param data Piece of output
+ * @throws std::runtime_error if the write fails
+ */
+void FileSink::write(std::string_view data) {
+    file_.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file_) {
+        throw std::runtime_error("Failed to write output file: " + path_.string());
+    }
+    bytesWritten_ += data.size();
+}
+
+/**
+ * @brief Flushes the stream buffer to the file
+ *
+ * @throws std::runtime_error if the flush fails
+ */
+void FileSink::flush() {
+    file_.flush();
+    if (!file_) {
+        throw std::runtime_error("Failed to write output file: " + path_.string());
+    }
+}
+
+/**
+ * @brief Wraps a file descriptor
+ *
+ * @param fd Descriptor to write to
+ * @param closeOnDestroy Whether the sink owns the descriptor
+ *
+ * Sockets are written with send(MSG_NOSIGNAL) so a client that hangs up
+ * produces an error instead of SIGPIPE.
+ */
+FdSink::FdSink(int fd, bool closeOnDestroy)
+    : fd_(fd), closeOnDestroy_(closeOnDestroy) {
+    struct stat sb;
+    isSocket_ = ::fstat(fd_, &sb) == 0 && S_ISSOCK(sb.st_mode);
+    buffer_.reserve(BUFFER_SIZE);
+}
+
+FdSink::~FdSink() {
+    try {
+        flush();
+    } catch (...) {
+        // Nothing sensible to do with a failed write during destruction
+    }
+    if (closeOnDestroy_) {
+        ::close(fd_);
+    }
+}
+
+/**
+ * @brief Appends data, coalescing small pieces
+ *
+ * @param data Piece of output
+ * @throws std::runtime_error if the descriptor reports an error
+ */
+void FdSink::write(std::string_view data) {
+    if (buffer_.size() + data.size() > BUFFER_SIZE) {
+        flush();
+    }
+    if (data.size() >= BUFFER_SIZE) {
+        writeAll(data.data(), data.size());
+    } else {
+        buffer_.append(data.data(), data.size());
+    }
+    bytesWritten_ += data.size();
+}
+
+/**
+ * @brief Writes the coalesced pieces to the descriptor
+ *
+ * @throws std::runtime_error if the descriptor reports an error
+ */
+void FdSink::flush() {
+    if (!buffer_.empty()) {
+        writeAll(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+}
+
+void FdSink::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = isSocket_ ? ::send(fd_, data, size, MSG_NOSIGNAL) : ::write(fd_, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Failed to write output: ") + std::strerror(errno));
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * @brief Creates a stream buffer that forwards to a sink
+ *
+ * @param sink Sink receiving the output
+ * @param bufferSize Writes smaller than this are coalesced
+ */
+SinkStreamBuf::SinkStreamBuf(OutputSink& sink, size_t bufferSize)
+    : sink_(sink), buffer_(bufferSize) {
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+SinkStreamBuf::~SinkStreamBuf() {
+    try {
+        flushBuffer();
+    } catch (...) {
+        // Callers that care about errors flush the stream explicitly
+    }
+}
+
+void SinkStreamBuf::flushBuffer() {
+    if (pptr() > pbase()) {
+        sink_.write(std::string_view(pbase(), static_cast<size_t>(pptr() - pbase())));
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+}
+
+SinkStreamBuf::int_type SinkStreamBuf::overflow(int_type ch) {
+    flushBuffer();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize SinkStreamBuf::xsputn(const char* s, std::streamsize n) {
+    // Large pieces bypass the buffer so file bodies are not copied again
+    if (n >= static_cast<std::streamsize>(buffer_.size())) {
+        flushBuffer();
+        sink_.write(std::string_view(s, static_cast<size_t>(n)));
+        return n;
+    }
+    if (n > epptr() - pptr()) {
+        flushBuffer();
+    }
+    std::memcpy(pptr(), s, static_cast<size_t>(n));
+    pbump(static_cast<int>(n));
+    return n;
+}
+
+int SinkStreamBuf::sync() {
+    flushBuffer();
+    sink_.flush();
+    return 0;
+}
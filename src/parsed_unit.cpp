@@ -0,0 +1,246 @@
+#include "parsed_unit.hpp"
+#include "parser_pool.hpp"
+#include "language_registry.hpp"
+#include <algorithm>
+#include <string>
+
+namespace {
+
+enum class Grammar {
+    None,
+    Cpp,
+    C,
+    Python,
+    JavaScript
+};
+
+Grammar grammarFor(const fs::path& filePath) {
+    switch (languageOf(filePath)) {
+        case Language::Cpp:         return Grammar::Cpp;
+        case Language::C:           return Grammar::C;
+        case Language::Python:      return Grammar::Python;
+        case Language::JavaScript:  return Grammar::JavaScript;   // TypeScript uses the JavaScript grammar for basic parsing
+        default:                    return Grammar::None;
+    }
+}
+
+// One query per grammar, with a pattern per span kind. Capture "<kind>" is
+// the node of the span, "<kind>.name" and "<kind>.body" its parts;
+// "import.callee" must read "require" for a call to count as an import.
+const char* const CPP_QUERY = R"(
+(function_definition declarator: (function_declarator declarator: (_) @function.name) body: (_) @function.body) @function
+(class_specifier name: (type_identifier) @class.name body: (_) @class.body) @class
+(struct_specifier name: (type_identifier) @class.name body: (_) @class.body) @class
+(preproc_include path: (_) @import.name) @import
+(comment) @comment
+[(if_statement) (while_statement) (for_statement) (for_range_loop) (switch_statement)] @branch
+)";
+
+const char* const C_QUERY = R"(
+(function_definition declarator: (function_declarator declarator: (_) @function.name) body: (_) @function.body) @function
+(struct_specifier name: (type_identifier) @class.name body: (_) @class.body) @class
+(preproc_include path: (_) @import.name) @import
+(comment) @comment
+[(if_statement) (while_statement) (for_statement) (switch_statement)] @branch
+)";
+
+const char* const PYTHON_QUERY = R"(
+(function_definition name: (identifier) @function.name body: (_) @function.body) @function
+(class_definition name: (identifier) @class.name body: (_) @class.body) @class
+(import_statement name: (dotted_name) @import.name) @import
+(import_from_statement module_name: (dotted_name) @import.name) @import
+(comment) @comment
+(expression_statement (string) @docstring)
+[(if_statement) (while_statement) (for_statement)] @branch
+)";
+
+const char* const JAVASCRIPT_QUERY = R"(
+(function_declaration name: (identifier) @function.name body: (_) @function.body) @function
+(method_definition name: (_) @function.name body: (_) @function.body) @function
+(class_declaration name: (identifier) @class.name body: (_) @class.body) @class
+(import_statement source: (string) @import.name) @import
+(call_expression function: (identifier) @import.callee arguments: (arguments (string) @import.name)) @import
+(comment) @comment
+[(if_statement) (while_statement) (for_statement) (for_in_statement) (switch_statement)] @branch
+)";
+
+const TSLanguage* languageFor(Grammar grammar) {
+    switch (grammar) {
+        case Grammar::Cpp:        return tree_sitter_cpp();
+        case Grammar::C:          return tree_sitter_c();
+        case Grammar::Python:     return tree_sitter_python();
+        case Grammar::JavaScript: return tree_sitter_javascript();
+        case Grammar::None:       break;
+    }
+    return nullptr;
+}
+
+const char* querySourceFor(Grammar grammar) {
+    switch (grammar) {
+        case Grammar::Cpp:        return CPP_QUERY;
+        case Grammar::C:          return C_QUERY;
+        case Grammar::Python:     return PYTHON_QUERY;
+        case Grammar::JavaScript: return JAVASCRIPT_QUERY;
+        case Grammar::None:       break;
+    }
+    return "";
+}
+
+// What a capture contributes to its span
+struct CaptureRole {
+    enum Part { Node, Name, Body, Callee, Ignored } part = Ignored;
+    ParsedUnit::Kind kind = ParsedUnit::Kind::Function;
+};
+
+CaptureRole roleFor(std::string_view captureName) {
+    static const std::pair<std::string_view, ParsedUnit::Kind> kinds[] = {
+        {"function", ParsedUnit::Kind::Function},
+        {"class", ParsedUnit::Kind::Class},
+        {"import", ParsedUnit::Kind::Import},
+        {"comment", ParsedUnit::Kind::Comment},
+        {"docstring", ParsedUnit::Kind::Docstring},
+        {"branch", ParsedUnit::Kind::Branch},
+    };
+
+    const size_t dot = captureName.find('.');
+    const std::string_view kindName = captureName.substr(0, dot);
+    const std::string_view partName = dot == std::string_view::npos ? std::string_view() : captureName.substr(dot + 1);
+
+    CaptureRole role;
+    for (const auto& kind : kinds) {
+        if (kind.first == kindName) {
+            role.kind = kind.second;
+            if (partName.empty()) {
+                role.part = CaptureRole::Node;
+            } else if (partName == "name") {
+                role.part = CaptureRole::Name;
+            } else if (partName == "body") {
+                role.part = CaptureRole::Body;
+            } else if (partName == "callee") {
+                role.part = CaptureRole::Callee;
+            }
+            break;
+        }
+    }
+    return role;
+}
+
+}  // namespace
+
+/**
+ * @brief Parses a file once and collects its spans with one query
+ *
+ * @param content Source text; must outlive the result
+ * @param filePath Path whose extension selects the grammar
+ * @return ParsedUnit The spans in source order, or an unparsed unit
+ */
+ParsedUnit ParsedUnit::parse(std::string_view content, const fs::path& filePath) {
+    ParsedUnit unit;
+    unit.content_ = content;
+
+    const Grammar grammar = grammarFor(filePath);
+    const TSLanguage* language = languageFor(grammar);
+    if (!language) {
+        return unit;
+    }
+    const TSQuery* query = ParserPool::query(language, querySourceFor(grammar));
+    TSQueryCursor* cursor = ParserPool::cursor();
+    if (!query || !cursor) {
+        return unit;
+    }
+    ParserPool::Tree tree = ParserPool::parse(language, content);
+    if (!tree) {
+        return unit;
+    }
+
+    std::vector<CaptureRole> roles(ts_query_capture_count(query));
+    for (uint32_t i = 0; i < roles.size(); ++i) {
+        uint32_t length = 0;
+        const char* name = ts_query_capture_name_for_id(query, i, &length);
+        if (name) {
+            roles[i] = roleFor(std::string_view(name, length));
+        }
+    }
+
+    ts_query_cursor_exec(cursor, query, ts_tree_root_node(tree.get()));
+    TSQueryMatch match;
+    while (ts_query_cursor_next_match(cursor, &match)) {
+        Span span{};
+        bool hasNode = false;
+        bool keep = true;
+        uint32_t bodyStart = 0;
+        bool hasBody = false;
+
+        for (uint16_t i = 0; i < match.capture_count; ++i) {
+            const TSQueryCapture& capture = match.captures[i];
+            if (capture.index >= roles.size()) {
+                continue;
+            }
+            const CaptureRole& role = roles[capture.index];
+            const uint32_t start = ts_node_start_byte(capture.node);
+            const uint32_t end = ts_node_end_byte(capture.node);
+            switch (role.part) {
+                case CaptureRole::Node:
+                    span.kind = role.kind;
+                    span.start = start;
+                    span.end = end;
+                    hasNode = true;
+                    break;
+                case CaptureRole::Name:
+                    span.nameStart = start;
+                    span.nameEnd = end;
+                    break;
+                case CaptureRole::Body:
+                    bodyStart = start;
+                    hasBody = true;
+                    break;
+                case CaptureRole::Callee:
+                    keep = content.substr(start, end - start) == "require";
+                    break;
+                case CaptureRole::Ignored:
+                    break;
+            }
+        }
+
+        if (!hasNode || !keep || span.end > content.size()) {
+            continue;
+        }
+        span.bodyStart = hasBody ? bodyStart : span.end;
+        unit.spans_.push_back(span);
+    }
+
+    // Matches arrive by pattern as well as position; consumers expect source order
+    std::stable_sort(unit.spans_.begin(), unit.spans_.end(),
+                     [](const Span& a, const Span& b) { return a.start < b.start; });
+    unit.parsed_ = true;
+    return unit;
+}
+
+/**
+ * @brief Tells whether a grammar covers a file
+ *
+ * @param filePath Path whose extension is checked
+ * @return bool True if parse() can produce a parsed unit for it
+ */
+bool ParsedUnit::supports(const fs::path& filePath) {
+    return grammarFor(filePath) != Grammar::None;
+}
+
+size_t ParsedUnit::count(Kind kind) const {
+    return static_cast<size_t>(std::count_if(spans_.begin(), spans_.end(),
+                                             [kind](const Span& span) { return span.kind == kind; }));
+}
+
+std::string_view ParsedUnit::text(const Span& span) const {
+    return content_.substr(span.start, span.end - span.start);
+}
+
+std::string_view ParsedUnit::name(const Span& span) const {
+    return content_.substr(span.nameStart, span.nameEnd - span.nameStart);
+}
+
+std::string_view ParsedUnit::header(const Span& span) const {
+    std::string_view header = content_.substr(span.start, span.bodyStart - span.start);
+    const size_t last = header.find_last_not_of(" \t\r\n");
+    return last == std::string_view::npos ? std::string_view() : header.substr(0, last + 1);
+}
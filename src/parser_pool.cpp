@@ -0,0 +1,124 @@
+#include "parser_pool.hpp"
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace {
+
+// The calling thread's parser and cursor
+struct ThreadState {
+    TSParser* parser = nullptr;
+    const TSLanguage* language = nullptr;
+    TSQueryCursor* cursor = nullptr;
+
+    ~ThreadState() {
+        if (cursor) {
+            ts_query_cursor_delete(cursor);
+        }
+        if (parser) {
+            ts_parser_delete(parser);
+        }
+    }
+};
+
+thread_local ThreadState threadState;
+
+// Compiled queries; never modified once inserted, so lookups hand out plain pointers
+class QueryCache {
+public:
+    static QueryCache& instance() {
+        static QueryCache cache;
+        return cache;
+    }
+
+    ~QueryCache() {
+        for (auto& entry : queries_) {
+            if (entry.second) {
+                ts_query_delete(entry.second);
+            }
+        }
+    }
+
+    const TSQuery* get(const TSLanguage* language, std::string_view source) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto key = std::make_pair(language, std::string(source));
+        auto it = queries_.find(key);
+        if (it == queries_.end()) {
+            uint32_t errorOffset = 0;
+            TSQueryError errorType;
+            TSQuery* query = ts_query_new(language, source.data(), static_cast<uint32_t>(source.size()),
+                                          &errorOffset, &errorType);
+            it = queries_.emplace(std::move(key), query).first;
+        }
+        return it->second;
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::pair<const TSLanguage*, std::string>, TSQuery*> queries_;
+};
+
+}  // namespace
+
+void ParserPool::TreeDeleter::operator()(TSTree* tree) const {
+    ts_tree_delete(tree);
+}
+
+/**
+ * @brief Parses a buffer with the calling thread's parser
+ *
+ * @param language Grammar to parse with
+ * @param content Source text
+ * @return Tree The syntax tree, or nullptr if parsing failed
+ *
+ * The parser is only switched to another grammar when the language changes,
+ * which is rare within a worker's run of files.
+ */
+ParserPool::Tree ParserPool::parse(const TSLanguage* language, std::string_view content) {
+    ThreadState& state = threadState;
+    if (!state.parser) {
+        state.parser = ts_parser_new();
+        if (!state.parser) {
+            return nullptr;
+        }
+    }
+    if (state.language != language) {
+        if (!ts_parser_set_language(state.parser, language)) {
+            state.language = nullptr;
+            return nullptr;
+        }
+        state.language = language;
+    }
+    return Tree(ts_parser_parse_string(state.parser, nullptr, content.data(),
+                                       static_cast<uint32_t>(content.size())));
+}
+
+/**
+ * @brief Returns the calling thread's query cursor
+ *
+ * @return TSQueryCursor* Cursor reused for every query run on this thread
+ *
+ * ts_query_cursor_exec resets the cursor, so it needs no cleanup between uses.
+ */
+TSQueryCursor* ParserPool::cursor() {
+    ThreadState& state = threadState;
+    if (!state.cursor) {
+        state.cursor = ts_query_cursor_new();
+    }
+    return state.cursor;
+}
+
+/**
+ * @brief Returns a compiled query shared by all threads
+ *
+ * @param language Grammar the query is written against
+ * @param source Query source
+ * @return const TSQuery* The query, or nullptr if it does not compile
+ */
+const TSQuery* ParserPool::query(const TSLanguage* language, std::string_view source) {
+    if (!language || source.empty()) {
+        return nullptr;
+    }
+    return QueryCache::instance().get(language, source);
+}
@@ -28,20 +28,30 @@ PatternMatcher::PatternMatcher(const std::vector<std::string>& ignorePatterns)
     }
 }
 
+PatternMatcher::PatternMatcher(const PatternMatcher& other)
+    : ignorePatterns_(other.ignorePatterns_),
+      includePatterns_(other.includePatterns_),
+      ignoreSet_(other.ignoreSet_),
+      includeSet_(other.includeSet_),
+      rootPrefix_(other.rootPrefix_) {
+    std::shared_lock<std::shared_mutex> lock(other.scopesMutex_);
+    gitignoreScopes_ = other.gitignoreScopes_;
+}
+
 void PatternMatcher::addIgnorePattern(const std::string& pattern) {
     ignorePatterns_.push_back(pattern);
-    ignoreRegexes_.push_back(patternToRegex(pattern));
+    ignoreSet_.add(pattern);
 }
 
 void PatternMatcher::addIncludePattern(const std::string& pattern) {
     includePatterns_.push_back(pattern);
-    includeRegexes_.push_back(patternToRegex(pattern));
+    includeSet_.add(pattern);
 }
 
 void PatternMatcher::setIncludePatterns(const std::string& patternsStr) {
     // Clear existing include patterns
     includePatterns_.clear();
-    includeRegexes_.clear();
+    includeSet_.clear();
     
     // Split comma-separated string and add each pattern
     for (const auto& pattern : splitPatternString(patternsStr)) {
@@ -76,21 +86,63 @@ std::vector<std::string> PatternMatcher::splitPatternString(const std::string& p
     return patterns;
 }
 
+void PatternMatcher::setRootDirectory(const fs::path& rootDir) {
+    rootPrefix_ = scopeKey(rootDir);
+}
+
 void PatternMatcher::loadGitignore(const fs::path& gitignorePath) {
+    addGitignoreScope(gitignorePath);
+}
+
+void PatternMatcher::loadNestedGitignore(const fs::path& dir) const {
+    const std::string key = scopeKey(dir);
+    {
+        std::shared_lock<std::shared_mutex> lock(scopesMutex_);
+        if (gitignoreScopes_.count(key) > 0) {
+            return;
+        }
+    }
+    
+    const fs::path gitignorePath = dir / ".gitignore";
+    std::error_code ec;
+    if (fs::is_regular_file(gitignorePath, ec)) {
+        addGitignoreScope(gitignorePath);
+    }
+}
+
+void PatternMatcher::addNestedGitignore(const fs::path& dir, std::string_view content) const {
+    std::istringstream input{std::string(content)};
+    auto scope = parseGitignore(input);
+    if (scope->runs.empty()) {
+        return;
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(scopesMutex_);
+    gitignoreScopes_.emplace(scopeKey(dir), std::move(scope));
+}
+
+void PatternMatcher::addGitignoreScope(const fs::path& gitignorePath) const {
     std::ifstream file(gitignorePath);
     if (!file) {
         std::cerr << "Warning: Failed to open .gitignore file: " << gitignorePath << std::endl;
         return;
     }
     
+    auto scope = parseGitignore(file);
+    if (scope->runs.empty()) {
+        return;
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(scopesMutex_);
+    gitignoreScopes_.emplace(scopeKey(gitignorePath.parent_path()), std::move(scope));
+}
+
+std::unique_ptr<PatternMatcher::GitignoreScope> PatternMatcher::parseGitignore(std::istream& input) {
+    auto scope = std::make_unique<GitignoreScope>();
+    
     std::string line;
-    while (std::getline(file, line)) {
-        // Skip empty lines and comments
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-        
-        // Trim whitespace
+    while (std::getline(input, line)) {
+        // Trim whitespace (also drops the '\r' of CRLF files)
         line.erase(line.begin(), std::find_if(line.begin(), line.end(), [](unsigned char ch) {
             return !std::isspace(ch);
         }));
@@ -98,14 +150,130 @@ void PatternMatcher::loadGitignore(const fs::path& gitignorePath) {
             return !std::isspace(ch);
         }).base(), line.end());
         
-        // Skip empty lines after trimming
+        // Skip empty lines and comments
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        
+        // "!pattern" re-includes; "\!" and "\#" escape a literal first character
+        bool negated = false;
+        if (line[0] == '!') {
+            negated = true;
+            line.erase(0, 1);
+        } else if (line.size() > 1 && line[0] == '\\' && (line[1] == '!' || line[1] == '#')) {
+            line.erase(0, 1);
+        }
+        
+        // "dir/" only matches directories
+        bool directoryOnly = false;
+        while (!line.empty() && line.back() == '/') {
+            directoryOnly = true;
+            line.pop_back();
+        }
         if (line.empty()) {
             continue;
         }
         
-        // Add pattern
-        addIgnorePattern(line);
+        // A separator anywhere anchors the pattern to the .gitignore directory;
+        // otherwise it matches a name at any depth below it. Scoped paths are
+        // matched as "/relative/path", so anchored globs start with '/'.
+        std::string glob;
+        if (line.find('/') != std::string::npos) {
+            glob = (line[0] == '/') ? line : "/" + line;
+        } else {
+            glob = "**/" + line;
+        }
+        
+        if (scope->runs.empty() || scope->runs.back().negated != negated ||
+            scope->runs.back().directoryOnly != directoryOnly) {
+            scope->runs.emplace_back();
+            scope->runs.back().negated = negated;
+            scope->runs.back().directoryOnly = directoryOnly;
+        }
+        scope->runs.back().patterns.add(glob);
+    }
+    
+    return scope;
+}
+
+std::string PatternMatcher::scopeKey(const fs::path& dir) {
+    std::string key = dir.generic_string();
+    if (key.empty()) {
+        return key;
+    }
+    while (key.size() > 1 && key.back() == '/') {
+        key.pop_back();
+    }
+    if (key.back() != '/') {
+        key += '/';
+    }
+    return key;
+}
+
+std::string PatternMatcher::relativeToRoot(const std::string& pathStr) const {
+    if (!rootPrefix_.empty() && pathStr.compare(0, rootPrefix_.size(), rootPrefix_) == 0) {
+        return pathStr.substr(rootPrefix_.size());
+    }
+    return pathStr;
+}
+
+bool PatternMatcher::isIgnoredByGitignore(const std::string& pathStr, bool isDirectory) const {
+    // Scopes along the path, outermost first
+    std::vector<std::pair<size_t, const GitignoreScope*>> scopes;
+    {
+        std::shared_lock<std::shared_mutex> lock(scopesMutex_);
+        if (gitignoreScopes_.empty()) {
+            return false;
+        }
+        // A .gitignore loaded from the working directory has an empty key
+        if (!pathStr.empty() && pathStr[0] != '/') {
+            auto it = gitignoreScopes_.find("");
+            if (it != gitignoreScopes_.end()) {
+                scopes.emplace_back(0, it->second.get());
+            }
+        }
+        for (size_t pos = pathStr.find('/'); pos != std::string::npos;
+             pos = pathStr.find('/', pos + 1)) {
+            auto it = gitignoreScopes_.find(pathStr.substr(0, pos + 1));
+            if (it != gitignoreScopes_.end()) {
+                scopes.emplace_back(pos + 1, it->second.get());
+            }
+        }
+    }
+    if (scopes.empty()) {
+        return false;
     }
+    
+    // Deeper .gitignore files take precedence, and within a file the last matching rule wins
+    auto decide = [&](size_t length, bool asDirectory) {
+        const std::string target = pathStr.substr(0, length);
+        for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+            if (scope->first >= length) {
+                continue;
+            }
+            const std::string relative = "/" + target.substr(scope->first);
+            const auto& runs = scope->second->runs;
+            for (auto run = runs.rbegin(); run != runs.rend(); ++run) {
+                if (run->directoryOnly && !asDirectory) {
+                    continue;
+                }
+                if (run->patterns.matches(relative)) {
+                    return !run->negated;
+                }
+            }
+        }
+        return false;
+    };
+    
+    // Nothing below an excluded directory can be re-included
+    for (size_t pos = pathStr.find('/', scopes.front().first); pos != std::string::npos;
+         pos = pathStr.find('/', pos + 1)) {
+        if (decide(pos, true)) {
+            return true;
+        }
+    }
+    
+    return decide(pathStr.size(), isDirectory);
 }
 
 bool PatternMatcher::shouldProcess(const fs::path& filePath) const {
@@ -124,87 +292,282 @@ bool PatternMatcher::shouldProcess(const fs::path& filePath) const {
 }
 
 bool PatternMatcher::isIgnored(const fs::path& filePath) const {
-    // Convert file path to string
-    const auto pathStr = filePath.string();
+    const std::string pathStr = filePath.generic_string();
+    return ignoreSet_.matches(relativeToRoot(pathStr)) || isIgnoredByGitignore(pathStr, false);
+}
+
+bool PatternMatcher::isDirectoryIgnored(const fs::path& dirPath) const {
+    std::string pathStr = dirPath.generic_string();
+    while (pathStr.size() > 1 && pathStr.back() == '/') {
+        pathStr.pop_back();
+    }
+    
+    // A flat pattern excludes the directory when it matches everything below it ("build/**")
+    return ignoreSet_.matches(relativeToRoot(pathStr) + "/") || isIgnoredByGitignore(pathStr, true);
+}
+
+bool PatternMatcher::isIncluded(const fs::path& filePath) const {
+    // If no include patterns, everything is included
+    if (includePatterns_.empty()) {
+        return true;
+    }
+    
+    return includeSet_.matches(relativeToRoot(filePath.generic_string()));
+}
+
+namespace {
+
+// Characters that give a pattern glob (or regex-escape) meaning
+bool hasGlobChars(const std::string& s) {
+    return s.find_first_of("*?\\") != std::string::npos;
+}
+
+}  // namespace
+
+void PatternMatcher::CompiledPatternSet::add(const std::string& pattern) {
+    if (pattern.empty()) {
+        return;
+    }
+    
+    // "**/name" and "**/*.ext" already match at any depth without the prefix
+    if (pattern.compare(0, 3, "**/") == 0) {
+        const std::string rest = pattern.substr(3);
+        const bool plainExtension = rest.size() >= 2 && rest[0] == '*' && rest[1] == '.' &&
+                                    !hasGlobChars(rest.substr(1));
+        if (rest.find('/') == std::string::npos && (!hasGlobChars(rest) || plainExtension)) {
+            add(rest);
+            return;
+        }
+    }
+    
+    // "*.ext" with a plain extension: suffix lookup on the filename
+    if (pattern.size() >= 2 && pattern[0] == '*' && pattern[1] == '.') {
+        const std::string extension = pattern.substr(1);
+        if (!hasGlobChars(extension) && extension.find('/') == std::string::npos) {
+            extensions_.insert(extension);
+            return;
+        }
+    }
+    
+    // Literal names without a separator match the basename at any depth,
+    // literal paths must match the whole path
+    if (!hasGlobChars(pattern)) {
+        if (pattern.find('/') == std::string::npos) {
+            basenames_.insert(pattern);
+        } else {
+            literalPaths_.insert(pattern);
+        }
+        return;
+    }
+    
+    // "dir/**" with a literal directory: prefix lookup
+    if (pattern.size() > 3 && pattern.compare(pattern.size() - 3, 3, "/**") == 0) {
+        const std::string prefix = pattern.substr(0, pattern.size() - 2);
+        if (!hasGlobChars(prefix)) {
+            directoryPrefixes_.insert(prefix);
+            return;
+        }
+    }
     
-    // Check if file path matches any ignore pattern
-    for (size_t i = 0; i < ignorePatterns_.size(); ++i) {
-        const auto& pattern = ignorePatterns_[i];
-        const auto& regex = ignoreRegexes_[i];
+    // Everything else goes into the combined automaton
+    const std::string regexStr = patternToRegex(pattern);
+    pathAutomaton_.add(regexStr);
+    if (pattern.size() >= 2 && pattern[0] == '*' && pattern[1] == '.' &&
+        pattern.find('/') == std::string::npos) {
+        filenameAutomaton_.add(regexStr);
+    }
+}
+
+void PatternMatcher::CompiledPatternSet::clear() {
+    extensions_.clear();
+    basenames_.clear();
+    literalPaths_.clear();
+    directoryPrefixes_.clear();
+    pathAutomaton_.clear();
+    filenameAutomaton_.clear();
+}
 
-        // Special case for simple extensions like "*.o"
-        if (pattern.size() >= 2 && pattern[0] == '*' && pattern[1] == '.') {
-            const std::string extension = pattern.substr(1);  // Get ".o" for example
-            if (pathStr.size() >= extension.size() && 
-                pathStr.substr(pathStr.size() - extension.size()) == extension) {
+bool PatternMatcher::CompiledPatternSet::matches(const std::string& pathStr) const {
+    const size_t slash = pathStr.find_last_of('/');
+    const size_t nameStart = (slash == std::string::npos) ? 0 : slash + 1;
+    
+    // Extension lookup: try every ".suffix" of the filename
+    if (!extensions_.empty()) {
+        for (size_t pos = pathStr.find('.', nameStart); pos != std::string::npos;
+             pos = pathStr.find('.', pos + 1)) {
+            if (extensions_.count(pathStr.substr(pos)) > 0) {
                 return true;
             }
         }
-        
-        // Try regex match
-        if (std::regex_match(pathStr, regex)) {
-            return true;
-        }
-        
-        // Special case for wildcard patterns
-        if (pattern[0] == '*' && pattern[1] == '.' && pattern.find('/') == std::string::npos) {
-            // Check if this is just a file extension pattern without path components
-            // Only match the filename part of the path
-            fs::path p(pathStr);
-            std::string filename = p.filename().string();
-            if (std::regex_match(filename, regex)) {
+    }
+    
+    if (!basenames_.empty() && basenames_.count(pathStr.substr(nameStart)) > 0) {
+        return true;
+    }
+    
+    if (!literalPaths_.empty() && literalPaths_.count(pathStr) > 0) {
+        return true;
+    }
+    
+    // Directory prefixes end with '/', so only prefixes ending at a separator can match
+    if (!directoryPrefixes_.empty()) {
+        for (size_t pos = pathStr.find('/'); pos != std::string::npos;
+             pos = pathStr.find('/', pos + 1)) {
+            if (directoryPrefixes_.count(pathStr.substr(0, pos + 1)) > 0) {
                 return true;
             }
         }
     }
     
+    if (pathAutomaton_.matches(pathStr)) {
+        return true;
+    }
+    
+    if (nameStart > 0 && !filenameAutomaton_.empty()) {
+        return filenameAutomaton_.matches(pathStr.substr(nameStart));
+    }
+    
     return false;
 }
 
-bool PatternMatcher::isIncluded(const fs::path& filePath) const {
-    // If no include patterns, everything is included
-    if (includePatterns_.empty()) {
-        return true;
+// Compiles one regex produced by patternToRegex (and only the constructs it emits)
+void PatternMatcher::GlobAutomaton::add(const std::string& regexSource) {
+    static const std::string DIR_PREFIX = "(?:.*?/)?";
+    static const std::string SEGMENT_STAR = "[^/]*";
+    static const std::string SEGMENT_CHAR = "[^/]";
+    
+    starts_.push_back(static_cast<uint32_t>(tokens_.size()));
+    
+    size_t i = 0;
+    size_t end = regexSource.size();
+    if (i < end && regexSource[i] == '^') {
+        ++i;
+    }
+    if (end > i && regexSource[end - 1] == '$' && (end < 2 || regexSource[end - 2] != '\\')) {
+        --end;
     }
     
-    // Convert file path to string
-    const auto pathStr = filePath.string();
+    while (i < end) {
+        if (regexSource.compare(i, DIR_PREFIX.size(), DIR_PREFIX) == 0) {
+            tokens_.push_back({TokenKind::DirPrefix, 0});
+            i += DIR_PREFIX.size();
+        } else if (regexSource.compare(i, SEGMENT_STAR.size(), SEGMENT_STAR) == 0) {
+            tokens_.push_back({TokenKind::Star, 0});
+            i += SEGMENT_STAR.size();
+        } else if (regexSource.compare(i, SEGMENT_CHAR.size(), SEGMENT_CHAR) == 0) {
+            tokens_.push_back({TokenKind::AnyChar, 0});
+            i += SEGMENT_CHAR.size();
+        } else if (regexSource.compare(i, 2, ".*") == 0) {
+            tokens_.push_back({TokenKind::GlobStar, 0});
+            i += 2;
+        } else if (regexSource[i] == '\\' && i + 1 < end) {
+            tokens_.push_back({TokenKind::Literal, regexSource[i + 1]});
+            i += 2;
+        } else {
+            tokens_.push_back({TokenKind::Literal, regexSource[i]});
+            ++i;
+        }
+    }
     
-    // Check if file path matches any include pattern
-    for (size_t i = 0; i < includePatterns_.size(); ++i) {
-        const auto& pattern = includePatterns_[i];
-        const auto& regex = includeRegexes_[i];
+    tokens_.push_back({TokenKind::Accept, 0});
+}
 
-        // Special case for simple extensions like "*.cpp"
-        if (pattern.size() >= 2 && pattern[0] == '*' && pattern[1] == '.') {
-            const std::string extension = pattern.substr(1);  // Get ".cpp" for example
-            if (pathStr.size() >= extension.size() && 
-                pathStr.substr(pathStr.size() - extension.size()) == extension) {
-                return true;
-            }
+// Runs every compiled pattern against the whole text in a single pass
+bool PatternMatcher::GlobAutomaton::matches(const std::string& text) const {
+    if (starts_.empty()) {
+        return false;
+    }
+    
+    // Per-thread scratch space; a state is active in a step when its stamp equals the generation
+    thread_local std::vector<uint32_t> stamps;
+    thread_local std::vector<uint32_t> current;
+    thread_local std::vector<uint32_t> next;
+    thread_local uint32_t generation = 0;
+    
+    if (stamps.size() < tokens_.size()) {
+        stamps.resize(tokens_.size(), 0);
+    }
+    
+    auto beginStep = [&]() {
+        if (++generation == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            generation = 1;
         }
-        
-        // Try regex match
-        if (std::regex_match(pathStr, regex)) {
-            return true;
+    };
+    
+    // Adds a state followed by its epsilon closure (wildcards may match nothing)
+    auto addState = [&](uint32_t state, std::vector<uint32_t>& list) {
+        while (stamps[state] != generation) {
+            stamps[state] = generation;
+            list.push_back(state);
+            const TokenKind kind = tokens_[state].kind;
+            if (kind != TokenKind::Star && kind != TokenKind::GlobStar &&
+                kind != TokenKind::DirPrefix) {
+                break;
+            }
+            ++state;
         }
-        
-        // Special case for wildcard patterns
-        if (pattern[0] == '*' && pattern[1] == '.' && pattern.find('/') == std::string::npos) {
-            // Check if this is just a file extension pattern without path components
-            // Only match the filename part of the path
-            fs::path p(pathStr);
-            std::string filename = p.filename().string();
-            if (std::regex_match(filename, regex)) {
-                return true;
+    };
+    
+    beginStep();
+    current.clear();
+    for (uint32_t start : starts_) {
+        addState(start, current);
+    }
+    
+    for (char c : text) {
+        beginStep();
+        next.clear();
+        for (uint32_t state : current) {
+            const Token& token = tokens_[state];
+            switch (token.kind) {
+                case TokenKind::Literal:
+                    if (token.ch == c) {
+                        addState(state + 1, next);
+                    }
+                    break;
+                case TokenKind::AnyChar:
+                    if (c != '/') {
+                        addState(state + 1, next);
+                    }
+                    break;
+                case TokenKind::Star:
+                    if (c != '/') {
+                        addState(state, next);
+                    }
+                    break;
+                case TokenKind::GlobStar:
+                    // A trailing ** accepts whatever remains
+                    if (tokens_[state + 1].kind == TokenKind::Accept) {
+                        return true;
+                    }
+                    addState(state, next);
+                    break;
+                case TokenKind::DirPrefix:
+                    addState(state, next);
+                    if (c == '/') {
+                        addState(state + 1, next);
+                    }
+                    break;
+                case TokenKind::Accept:
+                    break;
             }
         }
+        if (next.empty()) {
+            return false;
+        }
+        current.swap(next);
     }
     
+    for (uint32_t state : current) {
+        if (tokens_[state].kind == TokenKind::Accept) {
+            return true;
+        }
+    }
     return false;
 }
 
-std::regex PatternMatcher::patternToRegex(const std::string& pattern) const {
+std::string PatternMatcher::patternToRegex(const std::string& pattern) {
     // Convert pattern to regex
     std::string regexStr = "";
     
@@ -258,5 +621,5 @@ std::regex PatternMatcher::patternToRegex(const std::string& pattern) const {
         regexStr += "$";
     }
     
-    return std::regex(regexStr);
+    return regexStr;
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "regex_engine.hpp"
+#include <iostream>
+
+#ifdef USE_PCRE2
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#else
+#include <regex>
+#endif
+
+#ifdef USE_PCRE2
+
+namespace {
+
+// Match data is per call state, so each thread keeps one block big enough
+// for every pattern in the tables
+constexpr uint32_t MAX_GROUPS = 32;
+
+struct ThreadMatchData {
+    pcre2_match_data* data = pcre2_match_data_create(MAX_GROUPS, nullptr);
+    ~ThreadMatchData() {
+        pcre2_match_data_free(data);
+    }
+};
+
+pcre2_match_data* threadMatchData() {
+    thread_local ThreadMatchData matchData;
+    return matchData.data;
+}
+
+}  // namespace
+
+struct Regex::Impl {
+    pcre2_code* code = nullptr;
+
+    ~Impl() {
+        pcre2_code_free(code);
+    }
+};
+
+/**
+ * @brief Compiles a pattern, with the JIT where the platform supports it
+ *
+ * @param pattern Pattern in the syntax shared by PCRE2 and ECMAScript
+ */
+Regex::Regex(const char* pattern) {
+    int errorCode = 0;
+    PCRE2_SIZE errorOffset = 0;
+    pcre2_code* code = pcre2_compile(reinterpret_cast<PCRE2_SPTR>(pattern), PCRE2_ZERO_TERMINATED, 0,
+                                     &errorCode, &errorOffset, nullptr);
+    if (!code) {
+        PCRE2_UCHAR message[256];
+        pcre2_get_error_message(errorCode, message, sizeof(message));
+        std::cerr << "Warning: Invalid pattern '" << pattern << "' at offset " << errorOffset
+                  << ": " << reinterpret_cast<const char*>(message) << std::endl;
+        return;
+    }
+    // Without the JIT, pcre2_match falls back to the interpreter
+    pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+    impl_ = std::make_unique<Impl>();
+    impl_->code = code;
+}
+
+bool Regex::search(std::string_view text, size_t offset, Match& match) const {
+    if (!impl_ || offset > text.size()) {
+        return false;
+    }
+    pcre2_match_data* data = threadMatchData();
+    const int rc = pcre2_match(impl_->code, reinterpret_cast<PCRE2_SPTR>(text.data()), text.size(),
+                               offset, 0, data, nullptr);
+    if (rc < 0) {
+        return false;       // No match, or an error such as hitting the match limit
+    }
+    // Zero means the groups did not all fit; the first MAX_GROUPS are set
+    const uint32_t setGroups = rc == 0 ? MAX_GROUPS : static_cast<uint32_t>(rc);
+
+    const PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(data);
+    uint32_t groupCount = 0;
+    pcre2_pattern_info(impl_->code, PCRE2_INFO_CAPTURECOUNT, &groupCount);
+    match.groups.assign(groupCount + 1, std::string_view());
+    for (uint32_t i = 0; i < setGroups && i <= groupCount; ++i) {
+        if (ovector[2 * i] != PCRE2_UNSET) {
+            match.groups[i] = text.substr(ovector[2 * i], ovector[2 * i + 1] - ovector[2 * i]);
+        }
+    }
+    match.start = ovector[0];
+    match.end = ovector[1];
+    return true;
+}
+
+bool Regex::search(std::string_view text) const {
+    return impl_ && pcre2_match(impl_->code, reinterpret_cast<PCRE2_SPTR>(text.data()), text.size(),
+                                0, 0, threadMatchData(), nullptr) >= 0;
+}
+
+const char* Regex::engineName() {
+    return "pcre2-jit";
+}
+
+#else
+
+struct Regex::Impl {
+    std::regex regex;
+};
+
+/**
+ * @brief Compiles a pattern with std::regex
+ *
+ * @param pattern Pattern in the syntax shared by PCRE2 and ECMAScript
+ */
+Regex::Regex(const char* pattern) {
+    try {
+        auto impl = std::make_unique<Impl>();
+        impl->regex = std::regex(pattern);
+        impl_ = std::move(impl);
+    } catch (const std::regex_error& e) {
+        std::cerr << "Warning: Invalid pattern '" << pattern << "': " << e.what() << std::endl;
+    }
+}
+
+bool Regex::search(std::string_view text, size_t offset, Match& match) const {
+    if (!impl_ || offset > text.size()) {
+        return false;
+    }
+    const char* begin = text.data();
+    std::cmatch result;
+    const auto flags = offset > 0 ? std::regex_constants::match_prev_avail : std::regex_constants::match_default;
+    if (!std::regex_search(begin + offset, begin + text.size(), result, impl_->regex, flags)) {
+        return false;
+    }
+
+    match.groups.assign(result.size(), std::string_view());
+    for (size_t i = 0; i < result.size(); ++i) {
+        if (result[i].matched) {
+            match.groups[i] = std::string_view(result[i].first, static_cast<size_t>(result[i].length()));
+        }
+    }
+    match.start = static_cast<size_t>(result[0].first - begin);
+    match.end = static_cast<size_t>(result[0].second - begin);
+    return true;
+}
+
+bool Regex::search(std::string_view text) const {
+    return impl_ && std::regex_search(text.data(), text.data() + text.size(), impl_->regex);
+}
+
+const char* Regex::engineName() {
+    return "std::regex";
+}
+
+#endif
+
+Regex::Regex() = default;
+Regex::~Regex() = default;
+Regex::Regex(Regex&& other) noexcept = default;
+Regex& Regex::operator=(Regex&& other) noexcept = default;
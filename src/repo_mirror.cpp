@@ -0,0 +1,177 @@
+#include "repo_mirror.hpp"
+#include "result_cache.hpp"
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/wait.h>
+
+/**
+ * @brief Creates a mirror handle; nothing is cloned until the first sync
+ *
+ * @param repoUrl URL (or local path) of the remote repository
+ * @param baseDir Directory holding all mirrors
+ * @throws std::runtime_error if repoUrl starts with '-', which git would read as an option
+ */
+RepoMirror::RepoMirror(const std::string& repoUrl, const fs::path& baseDir)
+    : url_(repoUrl) {
+    if (!repoUrl.empty() && repoUrl.front() == '-') {
+        throw std::runtime_error("Invalid repository URL: " + repoUrl);
+    }
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << ResultCache::hash(repoUrl);
+    mirrorDir_ = baseDir / (name.str() + ".git");
+    worktreeDir_ = baseDir / (name.str() + ".worktree");
+}
+
+/**
+ * @brief Quotes an argument for the shell
+ *
+ * @param arg Raw argument
+ * @return std::string Argument wrapped in single quotes
+ */
+std::string RepoMirror::shellQuote(const std::string& arg) {
+    std::string quoted = "'";
+    for (char c : arg) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    quoted += "'";
+    return quoted;
+}
+
+/**
+ * @brief Runs a git command
+ *
+ * @param args Arguments after "git", already quoted
+ * @param output Receives stdout if not null
+ * @return bool True if git exited with status 0
+ */
+bool RepoMirror::runGit(const std::string& args, std::string* output) {
+    const std::string cmd = "git " + args;
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) {
+        return false;
+    }
+
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        if (output) {
+            output->append(buffer, n);
+        }
+    }
+
+    int status = pclose(pipe);
+    return status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+std::string RepoMirror::mirrorArgs() const {
+    return "--git-dir=" + shellQuote(mirrorDir_.string()) + " ";
+}
+
+/**
+ * @brief Brings the mirror and its checkout up to date
+ *
+ * @param baseCommit Commit of the last successful pack, or empty for none
+ * @return SyncResult New HEAD and, when baseCommit is known to the mirror,
+ *         the files that differ between the two commits
+ * @throws std::runtime_error if cloning, fetching or checking out fails
+ *
+ * The first call clones a bare mirror and adds a detached worktree; later
+ * calls fetch into the existing mirror, which costs about as much as the new
+ * objects.
+ */
+RepoMirror::SyncResult RepoMirror::sync(const std::string& baseCommit) {
+    std::error_code ec;
+    fs::create_directories(mirrorDir_.parent_path(), ec);
+
+    if (!fs::exists(mirrorDir_ / "HEAD")) {
+        std::cout << "Creating mirror of " << url_ << " in " << mirrorDir_ << std::endl;
+        if (!runGit("clone --quiet --mirror -- " + shellQuote(url_) + " " + shellQuote(mirrorDir_.string()))) {
+            fs::remove_all(mirrorDir_, ec);
+            throw std::runtime_error("Failed to clone repository: " + url_);
+        }
+    } else if (!runGit(mirrorArgs() + "fetch --quiet --prune origin")) {
+        throw std::runtime_error("Failed to fetch repository: " + url_);
+    }
+
+    SyncResult result;
+    std::string head;
+    if (!runGit(mirrorArgs() + "rev-parse --verify --quiet HEAD^{commit}", &head)) {
+        throw std::runtime_error("Repository has no HEAD commit: " + url_);
+    }
+    result.commit = head.substr(0, head.find_first_of(" \r\n"));
+
+    // The worktree is created once and then moved from commit to commit
+    if (!fs::exists(worktreeDir_ / ".git")) {
+        fs::remove_all(worktreeDir_, ec);
+        runGit(mirrorArgs() + "worktree prune");
+        if (!runGit(mirrorArgs() + "worktree add --quiet --detach " +
+                    shellQuote(worktreeDir_.string()) + " " + result.commit)) {
+            throw std::runtime_error("Failed to check out " + url_);
+        }
+    } else if (!runGit("-C " + shellQuote(worktreeDir_.string()) +
+                       " checkout --quiet --force --detach " + result.commit)) {
+        throw std::runtime_error("Failed to check out " + url_ + " at " + result.commit);
+    }
+
+    // A base the mirror does not know (e.g. after a force push and gc) means a full re-pack
+    if (!baseCommit.empty() &&
+        runGit(mirrorArgs() + "cat-file -e " + shellQuote(baseCommit + "^{commit}"))) {
+        std::string diff;
+        if (runGit(mirrorArgs() + "diff --name-status -z --no-renames " +
+                   shellQuote(baseCommit) + " " + result.commit, &diff)) {
+            parseNameStatus(diff, worktreeDir_, result);
+            result.diffAvailable = true;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Deletes the mirror and its checkout from disk
+ *
+ * Errors are ignored; whatever is left is replaced by the next sync.
+ */
+void RepoMirror::remove() {
+    std::error_code ec;
+    fs::remove_all(worktreeDir_, ec);
+    fs::remove_all(mirrorDir_, ec);
+}
+
+/**
+ * @brief Parses NUL-separated name-status output
+ *
+ * @param output Output of `git diff --name-status -z --no-renames`
+ * @param root Directory the paths are relative to
+ * @param result Receives the changed and removed paths
+ */
+void RepoMirror::parseNameStatus(const std::string& output, const fs::path& root, SyncResult& result) {
+    size_t pos = 0;
+    while (pos < output.size()) {
+        size_t statusEnd = output.find('\0', pos);
+        if (statusEnd == std::string::npos) {
+            break;
+        }
+        size_t pathEnd = output.find('\0', statusEnd + 1);
+        if (pathEnd == std::string::npos) {
+            pathEnd = output.size();
+        }
+
+        const char status = output[pos];
+        fs::path path = root / output.substr(statusEnd + 1, pathEnd - statusEnd - 1);
+        if (status == 'D') {
+            result.removed.push_back(std::move(path));
+        } else {
+            result.changed.push_back(std::move(path));
+        }
+
+        pos = pathEnd + 1;
+    }
+}
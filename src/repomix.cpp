@@ -1,93 +1,132 @@
 #include "repomix.hpp"
+#include "engine.hpp"
+#include "token_budget.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <chrono>
 #include <iomanip>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
-Repomix::Repomix(const RepomixOptions& options) 
-    : options_(options) {
+// Counts the tokens of everything written, then passes it on to another sink.
+// Text is counted up to the last newline seen, so tokens never straddle the
+// boundary between two pieces; memory is bounded by the largest piece.
+// While paused (around file bodies, whose tokens were counted on the workers)
+// data is passed on uncounted.
+class Repomix::TokenCountingSink : public OutputSink {
+public:
+    TokenCountingSink(OutputSink& target, const Tokenizer& tokenizer)
+        : target_(target), tokenizer_(tokenizer) {}
     
-    // Initialize the pattern matcher
-    patternMatcher_ = std::make_unique<PatternMatcher>();
+    void write(std::string_view data) override {
+        target_.write(data);
+        bytesWritten_ += data.size();
+        if (paused_) {
+            return;
+        }
+        
+        // Count whole lines straight from data; only a partial last line is
+        // kept back, so file bodies are not copied
+        size_t firstNewline = data.find('\n');
+        if (firstNewline == std::string_view::npos) {
+            pending_.append(data.data(), data.size());
+            return;
+        }
+        size_t lastNewline = data.rfind('\n');
+        if (pending_.empty()) {
+            count(data.substr(0, lastNewline + 1));
+        } else {
+            pending_.append(data.data(), firstNewline + 1);
+            count(pending_);
+            count(data.substr(firstNewline + 1, lastNewline - firstNewline));
+        }
+        pending_.assign(data.data() + lastNewline + 1, data.size() - lastNewline - 1);
+    }
     
-    // Check for .gitignore file in input directory
-    const auto gitignorePath = options_.inputDir / ".gitignore";
-    if (fs::exists(gitignorePath)) {
-        patternMatcher_->loadGitignore(gitignorePath);
+    void flush() override {
+        target_.flush();
     }
     
-    // Add default ignore patterns
+    // Stop counting (a file body follows) after counting what is pending
+    void pause() {
+        countPending();
+        paused_ = true;
+    }
     
-    // Version control
-    patternMatcher_->addIgnorePattern(".git/**");
-    patternMatcher_->addIgnorePattern(".svn/**");
-    patternMatcher_->addIgnorePattern(".hg/**");
+    void resume() {
+        paused_ = false;
+    }
     
-    // Build directories
-    patternMatcher_->addIgnorePattern("build/**");
-    patternMatcher_->addIgnorePattern("dist/**");
-    patternMatcher_->addIgnorePattern("out/**");
-    patternMatcher_->addIgnorePattern("target/**");
-    patternMatcher_->addIgnorePattern("bin/**");
-    patternMatcher_->addIgnorePattern("obj/**");
+    // Tokens counted elsewhere for text written while paused
+    void addTokens(size_t tokens) {
+        tokens_ += tokens;
+    }
     
-    // Dependencies
-    patternMatcher_->addIgnorePattern("node_modules/**");
-    patternMatcher_->addIgnorePattern("vendor/**");
-    patternMatcher_->addIgnorePattern("bower_components/**");
-    patternMatcher_->addIgnorePattern("jspm_packages/**");
-    patternMatcher_->addIgnorePattern("packages/**");
-    patternMatcher_->addIgnorePattern("_deps/**");
+    // Count whatever is left and return the total
+    size_t finish() {
+        countPending();
+        return tokens_;
+    }
     
-    // Docker
-    patternMatcher_->addIgnorePattern("Dockerfile");
-    patternMatcher_->addIgnorePattern("docker-compose.yml");
-    patternMatcher_->addIgnorePattern(".dockerignore");
+    std::chrono::milliseconds elapsed() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_);
+    }
     
-    // Caches
-    patternMatcher_->addIgnorePattern(".cache/**");
-    patternMatcher_->addIgnorePattern("__pycache__/**");
-    patternMatcher_->addIgnorePattern(".pytest_cache/**");
-    patternMatcher_->addIgnorePattern(".nyc_output/**");
+private:
+    OutputSink& target_;
+    const Tokenizer& tokenizer_;
+    std::string pending_;
+    size_t tokens_ = 0;
+    bool paused_ = false;
+    std::chrono::steady_clock::duration elapsed_{0};
     
-    // IDE and editor files
-    patternMatcher_->addIgnorePattern(".idea/**");
-    patternMatcher_->addIgnorePattern(".vscode/**");
-    patternMatcher_->addIgnorePattern("*.sublime-*");
-    patternMatcher_->addIgnorePattern("*.swp");
-    patternMatcher_->addIgnorePattern(".DS_Store");
+    void countPending() {
+        if (!pending_.empty()) {
+            count(pending_);
+            std::string().swap(pending_);
+        }
+    }
     
-    // Binary and compiled files
-    patternMatcher_->addIgnorePattern("*.exe");
-    patternMatcher_->addIgnorePattern("*.dll");
-    patternMatcher_->addIgnorePattern("*.so");
-    patternMatcher_->addIgnorePattern("*.dylib");
-    patternMatcher_->addIgnorePattern("*.a");
-    patternMatcher_->addIgnorePattern("*.lib");
-    patternMatcher_->addIgnorePattern("*.o");
-    patternMatcher_->addIgnorePattern("*.obj");
-    patternMatcher_->addIgnorePattern("*.class");
-    patternMatcher_->addIgnorePattern("*.jar");
-    patternMatcher_->addIgnorePattern("*.war");
-    patternMatcher_->addIgnorePattern("*.pyc");
-    patternMatcher_->addIgnorePattern("*.pyo");
+    void count(std::string_view text) {
+        if (text.empty()) {
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        tokens_ += tokenizer_.countTokens(text);
+        elapsed_ += std::chrono::steady_clock::now() - start;
+    }
+};
+
+Repomix::Repomix(const RepomixOptions& options, std::shared_ptr<Engine> engine) 
+    : options_(options), engine_(std::move(engine)) {
     
-    // Package files
-    patternMatcher_->addIgnorePattern("*.zip");
-    patternMatcher_->addIgnorePattern("*.tar.gz");
-    patternMatcher_->addIgnorePattern("*.tgz");
-    patternMatcher_->addIgnorePattern("*.rar");
-    patternMatcher_->addIgnorePattern("*.7z");
+    // Packing to a token budget ranks files by their score
+    if (options_.tokenBudget > 0) {
+        options_.selectionStrategy = RepomixOptions::FileSelectionStrategy::Scoring;
+    }
     
-    // Logs
-    patternMatcher_->addIgnorePattern("*.log");
-    patternMatcher_->addIgnorePattern("logs/**");
+    if (options_.fileSystem && options_.inputDir.empty()) {
+        options_.inputDir = options_.fileSystem->root();
+    }
     
-    // Generated files
-    patternMatcher_->addIgnorePattern("CMakeFiles/**");
-    patternMatcher_->addIgnorePattern("CMakeCache.txt");
-    patternMatcher_->addIgnorePattern("cmake_install.cmake");
+    // Initialize the pattern matcher, from the engine's compiled defaults if there is one
+    patternMatcher_ = engine_ ? std::make_unique<PatternMatcher>(engine_->defaultPatterns())
+                              : std::make_unique<PatternMatcher>();
+    patternMatcher_->setRootDirectory(options_.inputDir);
+    
+    // Check for .gitignore file in input directory (nested ones are loaded during
+    // traversal, as are all of a virtual file system's)
+    const auto gitignorePath = options_.inputDir / ".gitignore";
+    if (!options_.fileSystem && fs::exists(gitignorePath)) {
+        patternMatcher_->loadGitignore(gitignorePath);
+    }
+    
+    // Add default ignore patterns (the engine's copy has them already)
+    if (!engine_) {
+        addDefaultIgnorePatterns(*patternMatcher_);
+    }
     
     // Apply include patterns if specified
     if (!options_.includePatterns.empty()) {
@@ -107,27 +146,141 @@ Repomix::Repomix(const RepomixOptions& options)
         }
     }
     
+    // Open the persistent result cache if requested
+    if (!options_.cacheDir.empty()) {
+        resultCache_ = std::make_shared<ResultCache>(options_.cacheDir);
+        
+        if (options_.verbose) {
+            std::cout << "Using result cache: " << options_.cacheDir << std::endl;
+        }
+    }
+    
     // Create file processor with pattern matcher
     fileProcessor_ = std::make_unique<FileProcessor>(*patternMatcher_, options_.numThreads);
     
-    // Set summarization options
-    fileProcessor_->setSummarizationOptions(options_.summarization);
+    // Content is re-read one file at a time while the output is written, so
+    // memory stays bounded by the largest file instead of the repository
+    fileProcessor_->setKeepContent(false);
+    
+    // Set summarization options; with a token budget, files are only
+    // summarized when they do not fit in full
+    SummarizationOptions processing = options_.summarization;
+    if (options_.tokenBudget > 0) {
+        processing.enabled = false;
+    }
+    fileProcessor_->setSummarizationOptions(processing);
+    if (engine_) {
+        fileProcessor_->setCodeNER(engine_->codeNER(processing));
+    }
+    fileProcessor_->setResultCache(resultCache_);
+    fileProcessor_->setProgressOptions(options_.progress);
+    fileProcessor_->setDeduplicate(options_.deduplicate);
+    fileProcessor_->setFileSystem(options_.fileSystem);
+    
+    // Publish to the job's ProgressTracker entry even without a caller callback
+    setProgressCallback(nullptr);
     
     // Initialize file scorer if selection strategy is Scoring
     if (options_.selectionStrategy == RepomixOptions::FileSelectionStrategy::Scoring) {
-        fileScorer_ = std::make_unique<FileScorer>(options_.scoringConfig);
+        fileScorer_ = std::make_unique<FileScorer>(options_.scoringConfig, options_.numThreads,
+            engine_ ? engine_->scoringPatterns(options_.scoringConfig) : nullptr);
+        fileScorer_->setResultCache(resultCache_);
+        fileScorer_->setFileSystem(options_.fileSystem);
     }
     
-    // Initialize the tokenizer if token counting is enabled
-    if (options_.countTokens) {
-        tokenizer_ = std::make_unique<Tokenizer>(options_.tokenEncoding);
+    // Initialize the tokenizer if token counting is enabled or a budget needs
+    // per-file counts; file bodies are counted by the processing workers
+    if (options_.countTokens || options_.tokenBudget > 0) {
+        tokenizer_ = engine_ ? engine_->tokenizer(options_.tokenEncoding)
+                             : std::make_shared<Tokenizer>(options_.tokenEncoding);
+        fileProcessor_->setTokenizer(tokenizer_);
     }
 }
 
+/**
+ * @brief Adds the ignore patterns every run starts with
+ * 
+ * @param matcher Matcher to add them to
+ */
+void Repomix::addDefaultIgnorePatterns(PatternMatcher& matcher) {
+    
+    // Version control
+    matcher.addIgnorePattern(".git/**");
+    matcher.addIgnorePattern(".svn/**");
+    matcher.addIgnorePattern(".hg/**");
+    
+    // Build directories
+    matcher.addIgnorePattern("build/**");
+    matcher.addIgnorePattern("dist/**");
+    matcher.addIgnorePattern("out/**");
+    matcher.addIgnorePattern("target/**");
+    matcher.addIgnorePattern("bin/**");
+    matcher.addIgnorePattern("obj/**");
+    
+    // Dependencies
+    matcher.addIgnorePattern("node_modules/**");
+    matcher.addIgnorePattern("vendor/**");
+    matcher.addIgnorePattern("bower_components/**");
+    matcher.addIgnorePattern("jspm_packages/**");
+    matcher.addIgnorePattern("packages/**");
+    matcher.addIgnorePattern("_deps/**");
+    
+    // Docker
+    matcher.addIgnorePattern("Dockerfile");
+    matcher.addIgnorePattern("docker-compose.yml");
+    matcher.addIgnorePattern(".dockerignore");
+    
+    // Caches
+    matcher.addIgnorePattern(".cache/**");
+    matcher.addIgnorePattern("__pycache__/**");
+    matcher.addIgnorePattern(".pytest_cache/**");
+    matcher.addIgnorePattern(".nyc_output/**");
+    
+    // IDE and editor files
+    matcher.addIgnorePattern(".idea/**");
+    matcher.addIgnorePattern(".vscode/**");
+    matcher.addIgnorePattern("*.sublime-*");
+    matcher.addIgnorePattern("*.swp");
+    matcher.addIgnorePattern(".DS_Store");
+    
+    // Binary and compiled files
+    matcher.addIgnorePattern("*.exe");
+    matcher.addIgnorePattern("*.dll");
+    matcher.addIgnorePattern("*.so");
+    matcher.addIgnorePattern("*.dylib");
+    matcher.addIgnorePattern("*.a");
+    matcher.addIgnorePattern("*.lib");
+    matcher.addIgnorePattern("*.o");
+    matcher.addIgnorePattern("*.obj");
+    matcher.addIgnorePattern("*.class");
+    matcher.addIgnorePattern("*.jar");
+    matcher.addIgnorePattern("*.war");
+    matcher.addIgnorePattern("*.pyc");
+    matcher.addIgnorePattern("*.pyo");
+    
+    // Package files
+    matcher.addIgnorePattern("*.zip");
+    matcher.addIgnorePattern("*.tar.gz");
+    matcher.addIgnorePattern("*.tgz");
+    matcher.addIgnorePattern("*.rar");
+    matcher.addIgnorePattern("*.7z");
+    
+    // Logs
+    matcher.addIgnorePattern("*.log");
+    matcher.addIgnorePattern("logs/**");
+    
+    // Generated files
+    matcher.addIgnorePattern("CMakeFiles/**");
+    matcher.addIgnorePattern("CMakeCache.txt");
+    matcher.addIgnorePattern("cmake_install.cmake");
+}
+
 bool Repomix::run() {
     try {
         // Start overall timer
         startTime_ = std::chrono::steady_clock::now();
+        metricsAtStart_ = Metrics::instance().snapshot();
+        TraceRecorder::ThreadScope traceScope(beginTrace());
         
         // Register a job ID if we don't have one yet
         if (jobId_.empty()) {
@@ -164,9 +317,15 @@ bool Repomix::run() {
             
             // Process the selected files
             files = processSelectedFiles(selectedFiles);
+            resolveDuplicates(files);
+            
+            if (options_.tokenBudget > 0) {
+                files = packToTokenBudget(std::move(files));
+            }
         } else {
             // Process all files using the standard method with parallel collection
             files = fileProcessor_->processDirectory(options_.inputDir, true);
+            resolveDuplicates(files);
         }
 
         std::cout << "Files processed: " << files.size() << std::endl;
@@ -177,48 +336,95 @@ bool Repomix::run() {
 
         std::cout << "Processing duration: " << processingDuration_.count() << " ms" << std::endl;
         
-        // Update statistics
-        totalFiles_ = files.size();
-        for (const auto& file : files) {
-            totalLines_ += file.lineCount;
-            totalBytes_ += file.byteSize;
-        }
+        emitOutput(files);
         
-        // Start output timer
-        auto outputStart = std::chrono::steady_clock::now();
+        // Keep the results so runIncremental can splice changes into them
+        processedFiles_ = std::move(files);
         
-        // Format the output
-        outputContent_ = formatOutput(files);
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+/**
+ * @brief Re-packs after some files changed on disk since the last run
+ * 
+ * @param changedFiles Added or modified files below the input directory
+ * @param removedFiles Deleted files below the input directory
+ * @return bool True on success
+ * 
+ * Only the changed files are processed again; every other file keeps the
+ * result of the previous run. Falls back to a full run() when there is no
+ * previous run, when scoring selects the files (the selection depends on the
+ * whole repository) or when a .gitignore changed.
+ */
+bool Repomix::runIncremental(const std::vector<fs::path>& changedFiles, 
+                             const std::vector<fs::path>& removedFiles) {
+    auto touchesGitignore = [](const std::vector<fs::path>& paths) {
+        return std::any_of(paths.begin(), paths.end(), [](const fs::path& path) {
+            return path.filename() == ".gitignore";
+        });
+    };
+    
+    if (!hasPreviousRun_ || 
+        options_.selectionStrategy == RepomixOptions::FileSelectionStrategy::Scoring ||
+        touchesGitignore(changedFiles) || touchesGitignore(removedFiles)) {
+        return run();
+    }
+    
+    try {
+        startTime_ = std::chrono::steady_clock::now();
+        metricsAtStart_ = Metrics::instance().snapshot();
+        TraceRecorder::ThreadScope traceScope(beginTrace());
+        auto processStart = startTime_;
         
-        // Write to file if specified
-        if (!options_.outputFile.empty()) {
-            std::ofstream outFile(options_.outputFile);
-            if (outFile) {
-                outFile << outputContent_;
-                if (options_.verbose) {
-                    std::cout << "Output written to " << options_.outputFile << std::endl;
-                }
-            } else {
-                std::cerr << "Error: Could not open output file: " << options_.outputFile << std::endl;
+        // Drop every stale entry, then process what still exists
+        std::unordered_set<std::string> stale;
+        for (const auto* paths : {&changedFiles, &removedFiles}) {
+            for (const auto& path : *paths) {
+                stale.insert(path.lexically_normal().generic_string());
             }
         }
+        processedFiles_.erase(
+            std::remove_if(processedFiles_.begin(), processedFiles_.end(),
+                [&stale](const FileProcessor::ProcessedFile& file) {
+                    return stale.count(file.path.lexically_normal().generic_string()) > 0;
+                }),
+            processedFiles_.end());
         
-        // End output timer
-        auto outputEnd = std::chrono::steady_clock::now();
-        outputDuration_ = std::chrono::duration_cast<std::chrono::milliseconds>(outputEnd - outputStart);
+        std::vector<fs::path> toProcess;
+        for (const auto& path : changedFiles) {
+            std::error_code ec;
+            if (fs::is_regular_file(path, ec) && patternMatcher_->shouldProcess(path)) {
+                toProcess.push_back(path);
+            }
+        }
         
-        // Count tokens if requested
-        if (options_.countTokens) {
-            auto tokenStart = std::chrono::steady_clock::now();
-            countOutputTokens();
-            auto tokenEnd = std::chrono::steady_clock::now();
-            tokenizationDuration_ = std::chrono::duration_cast<std::chrono::milliseconds>(tokenEnd - tokenStart);
+        for (auto& file : fileProcessor_->processFiles(toProcess)) {
+            if (file.processed) {
+                processedFiles_.push_back(std::move(file));
+            }
         }
         
-        // End overall timer
-        endTime_ = std::chrono::steady_clock::now();
-        duration_ = std::chrono::duration_cast<std::chrono::milliseconds>(endTime_ - startTime_);
+        // Same order as a full directory run
+        std::sort(processedFiles_.begin(), processedFiles_.end(),
+            [](const FileProcessor::ProcessedFile& a, const FileProcessor::ProcessedFile& b) {
+                return a.path < b.path;
+            });
+        resolveDuplicates(processedFiles_);
+        
+        processingDuration_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - processStart);
         
+        if (options_.verbose) {
+            std::cout << "Incremental run: " << toProcess.size() << " changed, " 
+                      << removedFiles.size() << " removed" << std::endl;
+        }
+        
+        emitOutput(processedFiles_);
         return true;
     }
     catch (const std::exception& e) {
@@ -227,12 +433,128 @@ bool Repomix::run() {
     }
 }
 
+/**
+ * @brief Formats the processed files, writes the output and counts tokens
+ * 
+ * @param files Processed files in output order
+ */
+void Repomix::emitOutput(const std::vector<FileProcessor::ProcessedFile>& files) {
+    // Update statistics
+    totalFiles_ = files.size();
+    totalLines_ = 0;
+    totalBytes_ = 0;
+    duplicateFiles_ = 0;
+    for (const auto& file : files) {
+        totalLines_ += file.lineCount;
+        totalBytes_ += file.byteSize;
+        duplicateFiles_ += file.duplicateOf.empty() ? 0 : 1;
+    }
+    
+    // Start output timer
+    auto outputStart = std::chrono::steady_clock::now();
+    
+    // Pick the destination: nowhere if only the token count is wanted, an
+    // explicit sink, the output file, or memory
+    const bool tokenCountOnly = options_.onlyShowTokenCount && options_.countTokens && !outputSink_;
+    MemorySink memory;
+    NullSink discard;
+    std::unique_ptr<FileSink> fileSink;
+    OutputSink* target = &memory;
+    if (tokenCountOnly) {
+        target = &discard;
+    } else if (outputSink_) {
+        target = outputSink_.get();
+    } else if (!options_.outputFile.empty()) {
+        try {
+            fileSink = std::make_unique<FileSink>(options_.outputFile);
+            target = fileSink.get();
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+    
+    // Count the framing on the way through; bodies were counted per file
+    std::unique_ptr<TokenCountingSink> tokenCounter;
+    if (tokenizer_) {
+        tokenCounter = std::make_unique<TokenCountingSink>(*target, *tokenizer_);
+    }
+    
+    // Format the output (without reading any file if only the count is wanted)
+    {
+        Metrics::ScopedTimer timer(Metrics::Stage::Format);
+        formatOutput(files, tokenCounter ? static_cast<OutputSink&>(*tokenCounter) : *target,
+                     tokenCounter.get(), !tokenCountOnly);
+        target->flush();
+    }
+    outputContent_ = memory.release();
+    
+    if (fileSink && options_.verbose) {
+        std::cout << "Output written to " << options_.outputFile << std::endl;
+    }
+    
+    std::chrono::milliseconds framingTokenization{0};
+    if (tokenCounter) {
+        tokenCount_ = tokenCounter->finish();
+        framingTokenization = tokenCounter->elapsed();
+        Metrics::instance().record(Metrics::Stage::Tokenize, framingTokenization);
+        tokenizationDuration_ = framingTokenization + std::chrono::duration_cast<std::chrono::milliseconds>(
+            fileProcessor_->getTokenizationTime());
+    }
+    
+    // End output timer (framing is tokenized while formatting but reported separately)
+    auto outputEnd = std::chrono::steady_clock::now();
+    outputDuration_ = std::chrono::duration_cast<std::chrono::milliseconds>(outputEnd - outputStart) - 
+                      framingTokenization;
+    
+    // End overall timer
+    endTime_ = std::chrono::steady_clock::now();
+    duration_ = std::chrono::duration_cast<std::chrono::milliseconds>(endTime_ - startTime_);
+    runMetrics_ = Metrics::instance().snapshot().since(metricsAtStart_);
+    writeTrace();
+    
+    hasPreviousRun_ = true;
+}
+
+/**
+ * @brief Starts a new trace for the run if a trace file is configured
+ * 
+ * @return TraceRecorder* Recorder to bind to the running thread, or nullptr
+ */
+TraceRecorder* Repomix::beginTrace() {
+    trace_ = options_.traceFile.empty() ? nullptr : std::make_unique<TraceRecorder>();
+    return trace_.get();
+}
+
+/**
+ * @brief Writes the trace of the run that just finished, if one was recorded
+ * 
+ * A trace that cannot be written only produces a warning; the run's output
+ * is already complete.
+ */
+void Repomix::writeTrace() {
+    if (!trace_) {
+        return;
+    }
+    try {
+        trace_->writeFile(options_.traceFile);
+        if (options_.verbose) {
+            std::cout << "Trace written to " << options_.traceFile << " (" << trace_->eventCount() 
+                      << " events)" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: " << e.what() << std::endl;
+    }
+}
+
 std::string Repomix::getSummary() const {
     std::stringstream ss;
     ss << "Repository processing summary:" << std::endl;
     ss << "  Total files: " << totalFiles_ << std::endl;
     ss << "  Total lines: " << totalLines_ << std::endl;
     ss << "  Total bytes: " << totalBytes_ << " bytes" << std::endl;
+    if (duplicateFiles_ > 0) {
+        ss << "  Duplicates: " << duplicateFiles_ << " files emitted as references" << std::endl;
+    }
     
     if (options_.showTiming) {
         ss << "  Processing time: " << processingDuration_.count() << " ms" << std::endl;
@@ -244,12 +566,23 @@ std::string Repomix::getSummary() const {
             ss << "  Tokenization time: " << tokenizationDuration_.count() << " ms" << std::endl;
         }
         ss << "  Total time: " << duration_.count() << " ms" << std::endl;
+        ss << Metrics::breakdown(runMetrics_);
     }
     
     if (options_.countTokens) {
         ss << "  Token count (" << getTokenizerName() << "): " << tokenCount_ << std::endl;
     }
     
+    if (options_.tokenBudget > 0) {
+        ss << "  Token budget: " << budgetUsedTokens_ << " of " << options_.tokenBudget << " tokens ("
+           << budgetFullFiles_ << " full, " << budgetSummarizedFiles_ << " summarized, "
+           << budgetOmittedFiles_ << " left out)" << std::endl;
+    }
+    
+    if (resultCache_) {
+        ss << "  Cache hits: " << resultCache_->hits() << ", misses: " << resultCache_->misses() << std::endl;
+    }
+    
     return ss.str();
 }
 
@@ -287,85 +620,91 @@ std::string Repomix::getTimingInfo() const {
         ss << "  * " << std::fixed << std::setprecision(2) << kbPerSecond << " KB/second" << std::endl;
     }
     
+    ss << Metrics::breakdown(runMetrics_);
+    
     return ss.str();
 }
 
-void Repomix::writeOutput() {
-    // Create a stringstream for the content
-    std::stringstream ss;
-    
-    // Write directory tree
-    ss << "Repository: " << options_.inputDir.filename().string() << "\n";
-    
-    // Format the current time
-    auto now = std::chrono::system_clock::now();
-    auto time_t_now = std::chrono::system_clock::to_time_t(now);
-    ss << "Processed at: " << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S") << "\n";
-    
-    ss << "Files: " << totalFiles_ << "\n";
-    ss << "Lines: " << totalLines_ << "\n";
-    ss << "Size: " << totalBytes_ << " bytes\n\n";
-    
-    // Directory structure
-    ss << "Directory structure:\n";
-    ss << generateDirectoryTree(options_.inputDir) << "\n\n";
-    
-    // Process and format the files with parallel collection
-    auto processedFiles = fileProcessor_->processDirectory(options_.inputDir, true);
-    ss << formatOutput(processedFiles);
-    
-    // Store the content
-    outputContent_ = ss.str();
-    
-    // Write to file if specified
-    if (!options_.outputFile.empty()) {
-        std::ofstream outFile(options_.outputFile);
-        if (outFile) {
-            outFile << outputContent_;
-            if (options_.verbose) {
-                std::cout << "Output written to " << options_.outputFile << std::endl;
-            }
-        } else {
-            std::cerr << "Error: Could not open output file: " << options_.outputFile << std::endl;
+/**
+ * @brief Builds the directory tree of the files being emitted
+ * 
+ * @param files Processed files; their paths are below options_.inputDir
+ * @return DirectoryTree Tree of exactly these files
+ * 
+ * Works from the paths the processor collected, so nothing is read from
+ * disk and ignored or unselected files do not show up.
+ */
+DirectoryTree Repomix::buildDirectoryTree(const std::vector<FileProcessor::ProcessedFile>& files) const {
+    DirectoryTree tree;
+    for (const auto& file : files) {
+        fs::path relPath = file.path.lexically_relative(options_.inputDir);
+        if (relPath.empty()) {
+            // Mixed relative/absolute inputs need the filesystem to line up
+            relPath = fs::relative(file.path, options_.inputDir);
         }
+        tree.add(relPath);
     }
+    return tree;
 }
 
-std::string Repomix::generateDirectoryTree(const fs::path& dir, int level) const {
-    // Preallocate a reasonably sized buffer
-    std::string result;
-    result.reserve(4096); // Start with 4KB, will grow if needed
-    
-    // Create indentation strings once
-    static const std::string indentChars = "  ";
-    std::string indent;
-    for (int i = 0; i < level; ++i) {
-        indent += indentChars;
-    }
+/**
+ * @brief Writes the formatted output for the processed files into a sink
+ * 
+ * @param files Processed files in output order
+ * @param sink Destination of the output
+ * @param counter Token counter inside sink, or nullptr; it is paused around
+ *        file bodies, which add their precomputed ProcessedFile::tokenCount
+ * @param writeBodies False to leave file bodies out (and not read them)
+ * @throws std::runtime_error if the sink fails
+ * 
+ * Each file's content is loaded only while it is being written and released
+ * right after, so the output is never held in memory as a whole.
+ */
+void Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile>& files, OutputSink& sink,
+                           TokenCountingSink* counter, bool writeBodies) const {
+    SinkStreamBuf buffer(sink);
+    std::ostream output(&buffer);
+    output.exceptions(std::ios::badbit);
     
-    for (const auto& entry : fs::directory_iterator(dir)) {
-        // Skip ignored entries
-        if (patternMatcher_->isIgnored(entry.path())) {
-            continue;
+    // Full content of a file, re-read from disk if the processor dropped it
+    auto fileContent = [this](const FileProcessor::ProcessedFile& file) -> FileContent {
+        try {
+            return fileProcessor_->readContent(file);
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: " << e.what() << std::endl;
+            return FileContent();
         }
-        
-        // Add indentation and entry
-        result += indent;
-        result += entry.is_directory() ? "📁 " : "📄 ";
-        result += entry.path().filename().string();
-        result += "\n";
-        
-        // Recursively process subdirectories
-        if (entry.is_directory()) {
-            result += generateDirectoryTree(entry.path(), level + 1);
+    };
+    
+    // Summary (computed during processing or packing) or full content of a file
+    auto fileBody = [this, &fileContent](const FileProcessor::ProcessedFile& file) -> FileContent {
+        if (file.isSummarized) {
+            return FileContent(fileProcessor_->summarizeFile(file));
         }
-    }
+        return fileContent(file);
+    };
     
-    return result;
-}
-
-std::string Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile>& files) const {
-    std::stringstream output;
+    // Path of a file as it appears in the output
+    auto relativePath = [this](const fs::path& path) {
+        return fs::relative(path, options_.inputDir).string();
+    };
+    
+    // Writes a file body; its tokens come from the worker that processed it
+    auto writeBody = [&](const FileProcessor::ProcessedFile& file, bool allowSummary) {
+        TraceRecorder::Span span("write_file", "output", &file.path);
+        if (counter) {
+            buffer.drain();
+            counter->pause();
+            counter->addTokens(file.tokenCount);
+        }
+        if (writeBodies) {
+            output << (allowSummary ? fileBody(file) : fileContent(file)).view();
+        }
+        if (counter) {
+            buffer.drain();
+            counter->resume();
+        }
+    };
     
     switch (options_.format) {
         case OutputFormat::Markdown: {
@@ -377,7 +716,7 @@ std::string Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile
             
             output << "## Directory Structure\n\n";
             output << "```\n";
-            output << generateDirectoryTree(options_.inputDir);
+            buildDirectoryTree(files).render(output);
             output << "```\n\n";
             
             output << "## File Contents\n\n";
@@ -391,11 +730,17 @@ std::string Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile
                 // Output file statistics
                 output << "*" << file.lineCount << " lines, " << (file.byteSize / 1024) << " KB*\n\n";
                 
+                if (!file.duplicateOf.empty()) {
+                    output << "*Identical to " << relativePath(file.duplicateOf) << "*\n\n";
+                    continue;
+                }
+                
                 // Special handling for README files when in Markdown format
                 if (options_.summarization.includeReadme && 
                     options_.summarization.enabled && 
                     fileProcessor_->isReadmeFile(file.path)) {
-                    output << file.content << "\n\n";
+                    writeBody(file, false);
+                    output << "\n\n";
                     continue;
                 }
                 
@@ -424,12 +769,8 @@ std::string Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile
                 }
                 output << "\n";
                 
-                // Apply summarization if enabled and file is large
-                if (options_.summarization.enabled && file.byteSize > options_.summarization.fileSizeThreshold) {
-                    output << fileProcessor_->summarizeFile(file);
-                } else {
-                    output << file.content;
-                }
+                // Summarized if enabled and the file is large
+                writeBody(file, true);
                 
                 output << "```\n\n";
             }
@@ -447,7 +788,7 @@ std::string Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile
             
             // Directory structure representation
             output << "  <directory_structure><![CDATA[\n";
-            output << generateDirectoryTree(options_.inputDir);
+            buildDirectoryTree(files).render(output);
             output << "]]></directory_structure>\n";
             
             output << "  <files>\n";
@@ -459,14 +800,15 @@ std::string Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile
                 output << "      <path>" << relPath << "</path>\n";
                 output << "      <lines>" << file.lineCount << "</lines>\n";
                 output << "      <size>" << file.byteSize << "</size>\n";
+                if (!file.duplicateOf.empty()) {
+                    output << "      <duplicate_of>" << relativePath(file.duplicateOf) << "</duplicate_of>\n";
+                    output << "    </file>\n";
+                    continue;
+                }
                 output << "      <content><![CDATA[";
                 
-                // Apply summarization if enabled and file is large
-                if (options_.summarization.enabled && file.byteSize > options_.summarization.fileSizeThreshold) {
-                    output << fileProcessor_->summarizeFile(file);
-                } else {
-                    output << file.content;
-                }
+                // Summarized if enabled and the file is large
+                writeBody(file, true);
                 
                 output << "]]></content>\n";
                 output << "    </file>\n";
@@ -489,14 +831,15 @@ std::string Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile
                 
                 output << "  <document index=\"" << documentIndex++ << "\">\n";
                 output << "    <source>" << relPath << "</source>\n";
+                if (!file.duplicateOf.empty()) {
+                    output << "    <duplicate_of>" << relativePath(file.duplicateOf) << "</duplicate_of>\n";
+                    output << "  </document>\n";
+                    continue;
+                }
                 output << "    <document_content>\n";
                 
-                // Apply summarization if enabled and file is large
-                if (options_.summarization.enabled && file.byteSize > options_.summarization.fileSizeThreshold) {
-                    output << fileProcessor_->summarizeFile(file);
-                } else {
-                    output << file.content;
-                }
+                // Summarized if enabled and the file is large
+                writeBody(file, true);
                 
                 output << "    </document_content>\n";
                 output << "  </document>\n";
@@ -524,7 +867,8 @@ std::string Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile
             
             output << "Directory Structure\n";
             output << "------------------\n";
-            output << generateDirectoryTree(options_.inputDir) << "\n\n";
+            buildDirectoryTree(files).render(output);
+            output << "\n\n";
             
             output << "File Contents\n";
             output << "-------------\n";
@@ -535,33 +879,30 @@ std::string Repomix::formatOutput(const std::vector<FileProcessor::ProcessedFile
                 output << "=== " << relPath << " ===\n";
                 output << "Lines: " << file.lineCount << ", Size: " << (file.byteSize / 1024) << " KB\n";
                 
-                // Apply summarization if enabled and file is large
-                if (options_.summarization.enabled && file.byteSize > options_.summarization.fileSizeThreshold) {
-                    output << fileProcessor_->summarizeFile(file);
-                } else {
-                    output << file.content;
+                if (!file.duplicateOf.empty()) {
+                    output << "Identical to " << relativePath(file.duplicateOf) << "\n\n";
+                    continue;
                 }
                 
+                // Summarized if enabled and the file is large
+                writeBody(file, true);
+                
                 output << "\n\n";
             }
             break;
         }
     }
     
-    return output.str();
+    output.flush();
 }
 
 // Get the output content directly (useful for WASM)
-std::string Repomix::getOutput() const {
+const std::string& Repomix::getOutput() const {
     return outputContent_;
 }
 
-void Repomix::countOutputTokens() {
-    if (!tokenizer_) {
-        tokenizer_ = std::make_unique<Tokenizer>(options_.tokenEncoding);
-    }
-    
-    tokenCount_ = tokenizer_->countTokens(outputContent_);
+void Repomix::setOutputSink(std::shared_ptr<OutputSink> sink) {
+    outputSink_ = std::move(sink);
 }
 
 size_t Repomix::getTokenCount() const {
@@ -589,27 +930,185 @@ std::vector<fs::path> Repomix::selectFilesUsingScoring(const fs::path& repoPath)
     // Score all files in the repository
     scoredFiles_ = fileScorer_->scoreRepository(repoPath);
     
+    // With a token budget every file is a candidate; the budget does the selecting
+    if (options_.tokenBudget > 0) {
+        std::vector<fs::path> candidates;
+        candidates.reserve(scoredFiles_.size());
+        for (const auto& scored : scoredFiles_) {
+            candidates.push_back(scored.path);
+        }
+        return candidates;
+    }
+    
     // Get selected files based on scoring
     return fileScorer_->getSelectedFiles(scoredFiles_);
 }
 
 std::vector<FileProcessor::ProcessedFile> Repomix::processSelectedFiles(const std::vector<fs::path>& selectedFiles) {
-    std::vector<FileProcessor::ProcessedFile> processedFiles;
+    // Process the selected files on the worker pool, keeping the scorer's order;
+    // binary, oversized and unreadable files are left out as in a directory run
+    std::vector<FileProcessor::ProcessedFile> files = fileProcessor_->processFiles(selectedFiles);
+    files.erase(std::remove_if(files.begin(), files.end(),
+                               [](const FileProcessor::ProcessedFile& file) { return !file.processed; }),
+                files.end());
+    return files;
+}
+
+/**
+ * @brief Keeps the best-scoring files that fit options_.tokenBudget
+ * 
+ * @param files Processed candidates, each with the token count of its content
+ * @return std::vector<FileProcessor::ProcessedFile> Files to emit, in input
+ *         order; those that only fit as a summary carry one
+ * 
+ * The directory tree and a fixed preamble are reserved up front and every
+ * file is charged for its header as well as its body, so the whole output
+ * stays within the budget. Scoring report entries are marked included or
+ * not according to the packing.
+ */
+std::vector<FileProcessor::ProcessedFile> Repomix::packToTokenBudget(std::vector<FileProcessor::ProcessedFile> files) {
+    std::unordered_map<std::string, FileScorer::ScoredFile*> scoredByPath;
+    for (auto& scored : scoredFiles_) {
+        scoredByPath[scored.path.string()] = &scored;
+    }
     
-    // Process each selected file
-    for (const auto& filePath : selectedFiles) {
-        try {
-            auto processedFile = fileProcessor_->processFile(filePath);
-            processedFiles.push_back(std::move(processedFile));
+    // The tree of all candidates bounds the tree of whatever gets packed
+    const size_t reserved = tokenizer_->countTokens(buildDirectoryTree(files).render()) + 
+                            BUDGET_PREAMBLE_TOKENS;
+    if (reserved >= options_.tokenBudget) {
+        std::cerr << "Warning: token budget of " << options_.tokenBudget 
+                  << " does not cover the directory tree (" << reserved << " tokens)" << std::endl;
+    }
+    
+    std::vector<TokenBudgetPacker::Item> items;
+    items.reserve(files.size());
+    for (const auto& file : files) {
+        auto it = scoredByPath.find(file.path.string());
+        std::string relPath = fs::relative(file.path, options_.inputDir).string();
+        
+        TokenBudgetPacker::Item item;
+        item.score = it != scoredByPath.end() ? it->second->score : 0.0f;
+        item.tokens = file.duplicateOf.empty() ? file.tokenCount : 0;
+        item.overhead = tokenizer_->countTokens(relPath) + BUDGET_TOKENS_PER_FILE;
+        items.push_back(item);
+    }
+    
+    TokenBudgetPacker packer(options_.tokenBudget > reserved ? options_.tokenBudget - reserved : 0);
+    auto packed = packer.pack(items, [this, &files](size_t i) -> std::optional<size_t> {
+        if (!files[i].duplicateOf.empty()) {
+            return std::nullopt;
         }
-        catch (const std::exception& e) {
-            if (options_.verbose) {
-                std::cerr << "Error processing file " << filePath << ": " << e.what() << std::endl;
+        try {
+            if (fileProcessor_->summarizeToFit(files[i])) {
+                return files[i].tokenCount;
             }
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: " << e.what() << std::endl;
+        }
+        return std::nullopt;
+    });
+    
+    // A reference is only worth its tokens if the file it refers to is emitted
+    std::unordered_map<std::string, size_t> indexByPath;
+    for (size_t i = 0; i < files.size(); ++i) {
+        indexByPath[files[i].path.string()] = i;
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (files[i].duplicateOf.empty() || packed.choices[i] == TokenBudgetPacker::Choice::Omitted) {
+            continue;
+        }
+        auto primary = indexByPath.find(files[i].duplicateOf.string());
+        if (primary == indexByPath.end() || packed.choices[primary->second] == TokenBudgetPacker::Choice::Omitted) {
+            packed.choices[i] = TokenBudgetPacker::Choice::Omitted;
+            packed.usedTokens -= items[i].overhead;
+            packed.fullCount--;
+            packed.omittedCount++;
+        }
+    }
+    
+    budgetUsedTokens_ = packed.usedTokens + std::min(reserved, options_.tokenBudget);
+    budgetFullFiles_ = packed.fullCount;
+    budgetSummarizedFiles_ = packed.summaryCount;
+    budgetOmittedFiles_ = packed.omittedCount;
+    
+    std::vector<FileProcessor::ProcessedFile> kept;
+    kept.reserve(packed.fullCount + packed.summaryCount);
+    for (size_t i = 0; i < files.size(); ++i) {
+        const bool include = packed.choices[i] != TokenBudgetPacker::Choice::Omitted;
+        auto it = scoredByPath.find(files[i].path.string());
+        if (it != scoredByPath.end()) {
+            it->second->included = include;
         }
+        if (include) {
+            kept.push_back(std::move(files[i]));
+        }
+    }
+    
+    if (options_.verbose) {
+        std::cout << "Token budget: " << budgetFullFiles_ << " files in full, " << budgetSummarizedFiles_ 
+                  << " summarized, " << budgetOmittedFiles_ << " left out" << std::endl;
     }
     
-    return processedFiles;
+    return kept;
+}
+
+/**
+ * @brief Turns every copy of an emitted content into a reference
+ * 
+ * @param files Processed files; updated in place
+ * 
+ * Of the files with the same content hash and size, the one with the
+ * smallest path keeps its analysis and the others get duplicateOf pointing
+ * at it, so the output does not depend on which copies the processor
+ * happened to analyze. A copy only refers to the primary if their bytes
+ * are equal, so a crafted hash collision cannot hide a file's content. A
+ * file the processor skipped as a copy of a file that is not in the list
+ * (left out by selection, or removed since the last run), or of different
+ * bytes under the same hash, is processed in full; the former becomes the
+ * primary itself.
+ */
+void Repomix::resolveDuplicates(std::vector<FileProcessor::ProcessedFile>& files) {
+    if (!options_.deduplicate) {
+        return;
+    }
+    
+    std::unordered_map<uint64_t, size_t> primaries;
+    for (size_t i = 0; i < files.size(); ++i) {
+        const auto& file = files[i];
+        if (file.byteSize == 0 || !file.duplicateOf.empty()) {
+            continue;
+        }
+        auto [it, inserted] = primaries.try_emplace(file.contentHash, i);
+        if (!inserted && files[it->second].byteSize == file.byteSize && file.path < files[it->second].path) {
+            it->second = i;
+        }
+    }
+    
+    for (size_t i = 0; i < files.size(); ++i) {
+        auto& file = files[i];
+        if (file.byteSize == 0) {
+            continue;
+        }
+        auto it = primaries.find(file.contentHash);
+        const bool hasPrimary = it != primaries.end() && files[it->second].byteSize == file.byteSize;
+        if (hasPrimary && it->second == i) {
+            continue;
+        }
+        if (hasPrimary && fileProcessor_->hasSameContent(files[it->second], file)) {
+            file.duplicateOf = files[it->second].path;
+            continue;
+        }
+        if (!file.duplicateOf.empty()) {
+            FileProcessor::ProcessedFile analyzed = fileProcessor_->processFile(file.path);
+            if (analyzed.processed) {
+                file = std::move(analyzed);
+            }
+            file.duplicateOf.clear();
+            if (!hasPrimary) {
+                primaries[file.contentHash] = i;
+            }
+        }
+    }
 }
 
 /**
@@ -657,6 +1156,15 @@ void Repomix::setJobId(const std::string& jobId) {
     jobId_ = jobId;
 }
 
+/**
+ * @brief Set where the timeline of the following runs is written
+ * 
+ * @param path Chrome trace-event JSON file; empty disables tracing
+ */
+void Repomix::setTraceFile(const fs::path& path) {
+    options_.traceFile = path;
+}
+
 /**
  * @brief Get the job ID for this Repomix instance
  * 
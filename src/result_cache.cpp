@@ -0,0 +1,263 @@
+#include "result_cache.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Unaligned little-endian loads (the targets we build for are little-endian)
+inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl(acc, 31);
+    return acc * PRIME64_1;
+}
+
+inline uint64_t xxhMerge(uint64_t acc, uint64_t lane) {
+    acc ^= xxhRound(0, lane);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+}  // namespace
+
+/**
+ * @brief Creates a cache rooted at the given directory
+ *
+ * @param directory Cache location; created lazily on the first store
+ */
+ResultCache::ResultCache(const fs::path& directory)
+    : directory_(directory) {
+}
+
+/**
+ * @brief Returns the per-user default cache location
+ *
+ * @return fs::path $XDG_CACHE_HOME/repomix, ~/.cache/repomix, or a directory
+ *         below the system temp directory if neither variable is set
+ */
+fs::path ResultCache::defaultDirectory() {
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return fs::path(xdg) / "repomix";
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return fs::path(home) / ".cache" / "repomix";
+    }
+    return fs::temp_directory_path() / "repomix-cache";
+}
+
+/**
+ * @brief Hashes a byte range with 64-bit FNV-1a
+ *
+ * @param data Bytes to hash
+ * @param size Number of bytes
+ * @param seed Initial state, or the result of a previous call to continue hashing
+ * @return uint64_t Hash value
+ */
+uint64_t ResultCache::hash(const void* data, size_t size, uint64_t seed) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief Hashes file content with XXH64
+ *
+ * @param data Bytes to hash
+ * @param seed XXH64 seed; 0 for keys that persist across processes
+ * @return uint64_t Hash value, the same as the reference xxHash implementation
+ *
+ * Four independent 64-bit lanes consume 32-byte stripes, so the loop runs at
+ * memory speed on the sizes files come in; FNV-1a's byte-serial dependency
+ * chain is what made hashing show up next to reading.
+ */
+uint64_t ResultCache::contentHash(std::string_view data, uint64_t seed) {
+    const auto* p = reinterpret_cast<const unsigned char*>(data.data());
+    const auto* const end = p + data.size();
+    uint64_t h;
+
+    if (data.size() >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const auto* const limit = end - 32;
+        do {
+            v1 = xxhRound(v1, read64(p));
+            v2 = xxhRound(v2, read64(p + 8));
+            v3 = xxhRound(v3, read64(p + 16));
+            v4 = xxhRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = xxhMerge(h, v1);
+        h = xxhMerge(h, v2);
+        h = xxhMerge(h, v3);
+        h = xxhMerge(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+
+    h += static_cast<uint64_t>(data.size());
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxhRound(0, read64(p));
+        h = rotl(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * PRIME64_1;
+        h = rotl(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= static_cast<uint64_t>(*p) * PRIME64_5;
+        h = rotl(h, 11) * PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+/**
+ * @brief Derives the key of a cache entry
+ *
+ * @param path Path of the file as it was processed
+ * @param size File size in bytes
+ * @param modifiedTime Last modification time
+ * @param contentHash Hash of the file content
+ * @param fingerprint Hash of the producer and the options that shaped the result
+ * @return std::string 32 hex digits; two independent 64-bit hashes keep collisions out of reach
+ */
+std::string ResultCache::makeKey(const fs::path& path, uintmax_t size, std::time_t modifiedTime,
+                                 uint64_t contentHash, uint64_t fingerprint) {
+    const std::string pathStr = path.generic_string();
+    const int64_t mtime = static_cast<int64_t>(modifiedTime);
+
+    auto hashFields = [&](uint64_t seed) {
+        uint64_t h = hash(pathStr, seed);
+        h = hash(&size, sizeof(size), h);
+        h = hash(&mtime, sizeof(mtime), h);
+        h = hash(&contentHash, sizeof(contentHash), h);
+        return hash(&fingerprint, sizeof(fingerprint), h);
+    };
+
+    std::ostringstream key;
+    key << std::hex << std::setfill('0')
+        << std::setw(16) << hashFields(HASH_SEED)
+        << std::setw(16) << hashFields(~HASH_SEED);
+    return key.str();
+}
+
+/**
+ * @brief Maps a key to its entry file, fanning out on the first two digits
+ */
+fs::path ResultCache::entryPath(const std::string& key) const {
+    return directory_ / key.substr(0, 2) / key.substr(2);
+}
+
+/**
+ * @brief Reads an entry
+ *
+ * @param key Key produced by makeKey
+ * @param value Receives the stored value on a hit
+ * @return bool True on a hit
+ *
+ * Corrupt or truncated entries count as misses and are overwritten by the
+ * next store.
+ */
+bool ResultCache::load(const std::string& key, nlohmann::json& value) const {
+    std::ifstream file(entryPath(key), std::ios::binary);
+    if (!file) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    value = nlohmann::json::from_cbor(bytes, true, false);
+    if (value.is_discarded()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Writes an entry atomically
+ *
+ * @param key Key produced by makeKey
+ * @param value Value to store
+ *
+ * The entry is written to a uniquely named temporary file and renamed over
+ * the final path, so readers never observe a partial entry. Only the first
+ * failure is reported; caching is best effort.
+ */
+void ResultCache::store(const std::string& key, const nlohmann::json& value) const {
+    const fs::path path = entryPath(key);
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    std::ostringstream tempName;
+    tempName << path.filename().string() << ".tmp." << ::getpid() << "."
+             << std::hash<std::thread::id>{}(std::this_thread::get_id());
+    const fs::path tempPath = path.parent_path() / tempName.str();
+
+    const std::vector<uint8_t> bytes = nlohmann::json::to_cbor(value);
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file) {
+            ec = std::make_error_code(std::errc::io_error);
+        }
+    }
+
+    if (!ec) {
+        fs::rename(tempPath, path, ec);
+    }
+
+    if (ec) {
+        std::error_code ignored;
+        fs::remove(tempPath, ignored);
+        if (!storeErrorReported_.exchange(true)) {
+            std::cerr << "Warning: Could not write to result cache " << directory_ << std::endl;
+        }
+    }
+}
@@ -10,6 +10,7 @@
 #include <curl/curl.h>
 #include <regex>
 #include "repomix.hpp"
+#include "virtual_file_system.hpp"
 #include <drogon/utils/Utilities.h>
 #include <chrono>
 #include <cstdlib>
@@ -17,6 +18,14 @@
 #include <unordered_map>
 #include <mutex>
 #include "progress_tracker.hpp"
+#include "repo_mirror.hpp"
+#include "result_cache.hpp"
+#include "entity_cache.hpp"
+#include "metrics.hpp"
+#include "job_executor.hpp"
+#include "engine.hpp"
+#include <deque>
+#include <list>
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
@@ -35,12 +44,116 @@ struct ProcessingJob {
 std::unordered_map<std::string, ProcessingJob> activeJobs;
 std::mutex activeJobsMutex;
 
+// Runs the processing endpoints with bounded concurrency and a shared CPU budget
+std::unique_ptr<JobExecutor> jobExecutor;
+
+// Tokenizers, entity recognizers and compiled patterns shared by all jobs
+std::shared_ptr<Engine> engine;
+
+// Responses of jobs submitted with ?async=true, until MAX_ASYNC_RESULTS newer ones push them out
+const size_t MAX_ASYNC_RESULTS = 64;
+std::unordered_map<std::string, drogon::HttpResponsePtr> asyncJobResults;
+std::deque<std::string> asyncJobOrder;
+std::mutex asyncJobResultsMutex;
+
+void storeAsyncResult(const std::string& jobId, const drogon::HttpResponsePtr& resp) {
+    std::lock_guard<std::mutex> lock(asyncJobResultsMutex);
+    if (asyncJobResults.emplace(jobId, resp).second) {
+        asyncJobOrder.push_back(jobId);
+    }
+    while (asyncJobOrder.size() > MAX_ASYNC_RESULTS) {
+        asyncJobResults.erase(asyncJobOrder.front());
+        asyncJobOrder.pop_front();
+    }
+}
+
+// Mirrors and last results of repositories packed with "incremental": true
+std::string MIRROR_DIRECTORY = "/tmp/repomix_mirrors";
+
+// Repositories kept at once (REPOMIX_MAX_MIRRORS); adding another deletes the
+// mirror and results of the least recently used one no request is using
+size_t MAX_INCREMENTAL_REPOS = 16;
+
+struct IncrementalRepo {
+    std::mutex mutex;                    // Serializes requests for the same repository
+    std::unique_ptr<RepoMirror> mirror;
+    std::string packedCommit;            // Commit the retained results correspond to
+    std::string optionsKey;              // incrementalOptionsKey of the retained results
+    std::shared_ptr<Repomix> repomix;    // Holds the per-file results of the last run
+    std::list<std::string>::iterator order;  // Position in incrementalRepoOrder
+};
+
+std::unordered_map<std::string, std::shared_ptr<IncrementalRepo>> incrementalRepos;
+std::list<std::string> incrementalRepoOrder;     // URLs, most recently used first
+std::mutex incrementalReposMutex;
+
+// The options an incremental request sets that change the output; a retained
+// Repomix is only reused by requests with the same key
+std::string incrementalOptionsKey(const RepomixOptions& options) {
+    std::ostringstream key;
+    key << static_cast<int>(options.format) << '|' << options.tokenBudget << '|' << options.deduplicate
+        << '|' << options.countTokens << '|' << static_cast<int>(options.tokenEncoding)
+        << '|' << static_cast<int>(options.selectionStrategy)
+        << '|' << options.includePatterns << '|' << options.excludePatterns;
+    return key.str();
+}
+
+// Get (or create) the incremental state of a repository. A new repository
+// evicts the least recently used ones beyond MAX_INCREMENTAL_REPOS; states
+// held by a request (a reference besides the map's) are skipped, and no
+// request can take one while the map is locked.
+std::shared_ptr<IncrementalRepo> getIncrementalRepo(const std::string& repoUrl) {
+    std::lock_guard<std::mutex> lock(incrementalReposMutex);
+    auto found = incrementalRepos.find(repoUrl);
+    if (found != incrementalRepos.end()) {
+        incrementalRepoOrder.splice(incrementalRepoOrder.begin(), incrementalRepoOrder, found->second->order);
+        return found->second;
+    }
+
+    auto state = std::make_shared<IncrementalRepo>();
+    state->order = incrementalRepoOrder.insert(incrementalRepoOrder.begin(), repoUrl);
+    incrementalRepos.emplace(repoUrl, state);
+
+    auto pos = incrementalRepoOrder.end();
+    while (incrementalRepos.size() > MAX_INCREMENTAL_REPOS && --pos != incrementalRepoOrder.begin()) {
+        auto victim = incrementalRepos.find(*pos);
+        if (victim->second.use_count() > 1) {
+            continue;
+        }
+        std::cout << "Evicting mirror of " << *pos << std::endl;
+        if (victim->second->mirror) {
+            victim->second->mirror->remove();
+        }
+        incrementalRepos.erase(victim);
+        pos = incrementalRepoOrder.erase(pos);
+    }
+    return state;
+}
+
+// Delete the mirrors an earlier server process left behind; they are not
+// tracked and would never be evicted
+void removeStaleMirrors() {
+    std::error_code ec;
+    for (fs::directory_iterator it(MIRROR_DIRECTORY, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path extension = it->path().extension();
+        if (extension == ".git" || extension == ".worktree") {
+            std::error_code removeError;
+            fs::remove_all(it->path(), removeError);
+        }
+    }
+}
+
 // Generate a unique job ID
 std::string generateJobId() {
     auto timestamp = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
     return "job_" + timestamp;
 }
 
+// Name of a job's trace file in the shared directory, served by /api/content
+std::string traceFileName(const std::string& jobId) {
+    return "repomix_trace_" + jobId + ".json";
+}
+
 // Callback function for curl to write response data
 static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
     size_t realsize = size * nmemb;
@@ -63,7 +176,7 @@ std::string createTempDir() {
 
 // Utility function to check if a string is base64 encoded
 // If it is, optionally returns the decoded content via outDecoded
-bool isBase64Encoded(const std::string& str, std::string* outDecoded = nullptr) {
+bool isBase64Encoded(std::string_view str, std::string* outDecoded = nullptr) {
     // If empty or too short, it's not base64
     if (str.empty() || str.size() < 4) {
         return false;
@@ -100,7 +213,7 @@ bool isBase64Encoded(const std::string& str, std::string* outDecoded = nullptr)
     
     // Try decoding with Drogon
     try {
-        std::string decoded = drogon::utils::base64Decode(str);
+        std::string decoded = drogon::utils::base64Decode(std::string(str));
         
         if (decoded.empty()) {
             return false;
@@ -148,18 +261,175 @@ std::string decodeBase64(const std::string& input) {
 }
 
 void cleanupTempDir(const std::string& path) {
-    // Simple recursive directory removal using system command
-    // In production, you'd want a more robust solution
-    std::string cmd = "rm -rf " + path;
-    system(cmd.c_str());
+    std::error_code ec;
+    fs::remove_all(path, ec);
+    if (ec) {
+        std::cerr << "Failed to remove temp directory " << path << ": " << ec.message() << std::endl;
+    }
 }
 
+// Removes a temporary directory when the scope ends, also on an exception
+struct TempDirGuard {
+    std::string path;
+    ~TempDirGuard() {
+        if (!path.empty()) {
+            cleanupTempDir(path);
+        }
+    }
+};
+
+// Clone the objects of a repository (shallow, bare: nothing is checked out)
+// into dir; returns the exit status of git. Mount the result with
+// GitObjectFileSystem.
+int cloneRepository(const std::string& repoUrl, const std::string& dir) {
+    std::string cloneCmd = "git clone --bare --depth=1 -- " + RepoMirror::shellQuote(repoUrl) + " " + 
+                           RepoMirror::shellQuote(dir);
+    return system(cloneCmd.c_str());
+}
+
+// The files of a multipart upload as a tree below "upload", without writing
+// them to disk. Parts are shared with the request rather than copied, and
+// base64-encoded parts are decoded once. An upload of a single zip, tar or
+// .tar.gz file is read from the archive's members instead.
+std::shared_ptr<const VirtualFileSystem> mountUpload(const drogon::HttpRequestPtr& req,
+                                                     const drogon::MultiPartParser& upload) {
+    auto partContent = [&req](const drogon::HttpFile& file) {
+        std::string decoded;
+        if (isBase64Encoded(file.fileContent(), &decoded)) {
+            return FileContent(std::move(decoded));
+        }
+        return FileContent::share(req, file.fileContent());
+    };
+    
+    const auto& files = upload.getFiles();
+    if (files.size() == 1) {
+        FileContent content = partContent(files.front());
+        if (ArchiveFileSystem::isArchive(content.view())) {
+            std::cout << "Reading archive " << files.front().getFileName() << std::endl;
+            return std::make_shared<ArchiveFileSystem>(std::move(content), "upload");
+        }
+    }
+    
+    auto tree = std::make_shared<MemoryFileSystem>("upload");
+    for (const auto& file : files) {
+        if (!tree->add(file.getFileName(), partContent(file))) {
+            std::cerr << "Skipping file outside the upload: " << file.getFileName() << std::endl;
+        }
+    }
+    return tree;
+}
+
+// Map the "format" field of a request to an output format (plain by default)
+OutputFormat parseOutputFormat(const std::string& format) {
+    if (format == "markdown") {
+        return OutputFormat::Markdown;
+    } else if (format == "xml") {
+        return OutputFormat::XML;
+    } else if (format == "claude_xml") {
+        return OutputFormat::ClaudeXML;
+    }
+    return OutputFormat::Plain;
+}
+
+// One server-sent event stream, shared by the progress callback and the output sink
+class SseChannel {
+public:
+    explicit SseChannel(drogon::ResponseStreamPtr stream) : stream_(std::move(stream)) {}
+    
+    // Send one event; data must be a single line (JSON). Returns false once the client is gone.
+    bool send(const std::string& event, const std::string& data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stream_) {
+            return false;
+        }
+        if (!stream_->send("event: " + event + "\ndata: " + data + "\n\n")) {
+            stream_.reset();
+            return false;
+        }
+        return true;
+    }
+    
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stream_) {
+            stream_->close();
+            stream_.reset();
+        }
+    }
+    
+private:
+    std::mutex mutex_;
+    drogon::ResponseStreamPtr stream_;
+};
+
+// Output sink that forwards the formatted output as "content" events of at most
+// EVENT_SIZE bytes. Each event carries a JSON string ending at a line break, or,
+// in a stretch without one (minified code, one-line JSON), before a UTF-8 lead
+// byte, so framing never splits a UTF-8 sequence and newlines in the output survive.
+class SseOutputSink : public OutputSink {
+public:
+    explicit SseOutputSink(std::shared_ptr<SseChannel> channel) : channel_(std::move(channel)) {}
+    
+    void write(std::string_view data) override {
+        pending_.append(data.data(), data.size());
+        bytesWritten_ += data.size();
+        if (pending_.size() >= EVENT_SIZE) {
+            sendLines();
+        }
+    }
+    
+    void flush() override {
+        sendLines();
+        if (!pending_.empty()) {
+            sendText(pending_);
+            pending_.clear();
+        }
+    }
+    
+private:
+    static constexpr size_t EVENT_SIZE = 32 * 1024;
+    
+    std::shared_ptr<SseChannel> channel_;
+    std::string pending_;
+    
+    // Send full events while EVENT_SIZE bytes are pending
+    void sendLines() {
+        size_t start = 0;
+        while (pending_.size() - start >= EVENT_SIZE) {
+            size_t end = pending_.rfind('\n', start + EVENT_SIZE - 1);
+            if (end != std::string::npos && end >= start) {
+                ++end;
+            } else {
+                end = start + EVENT_SIZE;
+                while (end > start && (static_cast<unsigned char>(pending_[end]) & 0xC0) == 0x80) {
+                    --end;
+                }
+                if (end == start) {
+                    end = start + EVENT_SIZE;   // Not UTF-8; the JSON encoder replaces it
+                }
+            }
+            sendText(pending_.substr(start, end - start));
+            start = end;
+        }
+        pending_.erase(0, start);
+    }
+    
+    void sendText(const std::string& text) {
+        json chunk = text;
+        if (!channel_->send("content", chunk.dump(-1, ' ', false, json::error_handler_t::replace))) {
+            // Aborts Repomix::run, which reports the failure
+            throw std::runtime_error("Client disconnected");
+        }
+    }
+};
+
 // Controllers
 class ApiController : public drogon::HttpController<ApiController> {
 public:
     METHOD_LIST_BEGIN
     ADD_METHOD_TO(ApiController::processFiles, "/api/process_files", drogon::Post);
     ADD_METHOD_TO(ApiController::processRepo, "/api/process_repo", drogon::Post);
+    ADD_METHOD_TO(ApiController::streamRepo, "/api/stream_repo", drogon::Post);
     ADD_METHOD_TO(ApiController::processUploadedDir, "/api/process_uploaded_dir", drogon::Post);
     ADD_METHOD_TO(ApiController::processSharedDir, "/api/process_shared", drogon::Post);
     ADD_METHOD_TO(ApiController::getCapabilities, "/api/capabilities", drogon::Get);
@@ -167,10 +437,79 @@ public:
     ADD_METHOD_TO(ApiController::getScoringReport, "/api/scoring_report", drogon::Post);
     ADD_METHOD_TO(ApiController::getProgress, "/api/progress/{id}", drogon::Get);
     ADD_METHOD_TO(ApiController::listJobs, "/api/jobs", drogon::Get);
+    ADD_METHOD_TO(ApiController::getJobResult, "/api/jobs/{id}/result", drogon::Get);
+    ADD_METHOD_TO(ApiController::getMetrics, "/api/metrics", drogon::Get);
     METHOD_LIST_END
 
-    void processFiles(const drogon::HttpRequestPtr& req, 
-                      std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+    using Callback = std::function<void(const drogon::HttpResponsePtr&)>;
+    using JobHandler = void (ApiController::*)(const drogon::HttpRequestPtr&, Callback&&, 
+                                               const std::string&, unsigned int);
+
+    // The processing endpoints run on the job executor instead of the event loop
+    void processFiles(const drogon::HttpRequestPtr& req, Callback&& callback) {
+        dispatchJob(req, std::move(callback), &ApiController::processFilesJob);
+    }
+
+    void processRepo(const drogon::HttpRequestPtr& req, Callback&& callback) {
+        dispatchJob(req, std::move(callback), &ApiController::processRepoJob);
+    }
+
+    void processUploadedDir(const drogon::HttpRequestPtr& req, Callback&& callback) {
+        dispatchJob(req, std::move(callback), &ApiController::processUploadedDirJob);
+    }
+
+    void processSharedDir(const drogon::HttpRequestPtr& req, Callback&& callback) {
+        dispatchJob(req, std::move(callback), &ApiController::processSharedDirJob);
+    }
+
+    // Queue a handler on the job executor. By default the response is sent when
+    // the job finishes (without holding an event-loop thread meanwhile); with
+    // ?async=true the client gets 202 and the job ID right away and collects the
+    // response from /api/jobs/{id}/result. A full queue is answered with 503.
+    void dispatchJob(const drogon::HttpRequestPtr& req, Callback&& callback, JobHandler handler) {
+        std::string asyncParam = req->getParameter("async");
+        bool async = asyncParam == "true" || asyncParam == "1";
+        std::string jobId = ProgressTracker::getInstance().registerJob();
+        auto respond = std::make_shared<Callback>(std::move(callback));
+        
+        bool accepted = jobExecutor->submit(jobId, [this, req, respond, handler, jobId, async](unsigned int numThreads) {
+            Callback done = *respond;
+            if (async) {
+                done = [jobId](const drogon::HttpResponsePtr& resp) {
+                    storeAsyncResult(jobId, resp);
+                };
+            }
+            (this->*handler)(req, std::move(done), jobId, numThreads);
+        });
+        
+        if (!accepted) {
+            ProgressTracker::getInstance().removeJob(jobId);
+            Json::Value error;
+            error["success"] = false;
+            error["error"] = "Server is busy, try again later";
+            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+            resp->setStatusCode(drogon::k503ServiceUnavailable);
+            resp->addHeader("Retry-After", "5");
+            (*respond)(resp);
+            return;
+        }
+        
+        if (async) {
+            Json::Value accepted;
+            accepted["success"] = true;
+            accepted["jobId"] = jobId;
+            accepted["progressUrl"] = "/api/progress/" + jobId;
+            accepted["resultUrl"] = "/api/jobs/" + jobId + "/result";
+            auto resp = drogon::HttpResponse::newHttpJsonResponse(accepted);
+            resp->setStatusCode(drogon::k202Accepted);
+            resp->addHeader("Location", "/api/jobs/" + jobId + "/result");
+            (*respond)(resp);
+        }
+    }
+
+    void processFilesJob(const drogon::HttpRequestPtr& req, 
+                         std::function<void(const drogon::HttpResponsePtr&)>&& callback,
+                         const std::string& jobId, unsigned int numThreads) {
         // Use Json::Value for Drogon responses
         Json::Value drogonResult;
         json result; // nlohmann::json for internal processing
@@ -196,33 +535,9 @@ public:
                 return;
             }
 
-            // Create temp directory
-            std::string tempDir = createTempDir();
-            std::cout << "Created temp directory: " << tempDir << std::endl;
-            
-            // Process uploaded files
-            auto& files = fileUpload.getFiles();
-            std::cout << "Received " << files.size() << " files" << std::endl;
-            for (auto& file : files) {
-                // Get file content and save to temp dir
-                std::string filePath = tempDir + "/" + file.getFileName();
-                std::ofstream fileOut(filePath, std::ios::binary);
-                if (fileOut) {
-                    // Check if the content appears to be Base64-encoded
-                    std::string fileContent(file.fileContent().data(), file.fileContent().size());
-                    if (isBase64Encoded(fileContent)) {
-                        // Decode the Base64 content
-                        std::string decodedContent = decodeBase64(fileContent);
-                        fileOut.write(decodedContent.data(), decodedContent.size());
-                    } else {
-                        // Write as-is
-                        fileOut.write(file.fileContent().data(), file.fileContent().size());
-                    }
-                    fileOut.close();
-                } else {
-                    std::cerr << "Failed to create file: " << filePath << std::endl;
-                }
-            }
+            // Read the uploaded files (or archive) in place
+            std::cout << "Received " << fileUpload.getFiles().size() << " files" << std::endl;
+            auto upload = mountUpload(req, fileUpload);
 
             // Extract format option
             std::string formatStr = "plain";
@@ -241,6 +556,16 @@ public:
                 showTiming = (*req->getJsonObject())["timing"].asBool();
             }
             
+            bool trace = false;
+            if (req->getJsonObject() && req->getJsonObject()->isMember("trace")) {
+                trace = (*req->getJsonObject())["trace"].asBool();
+            }
+            
+            bool deduplicate = true;
+            if (req->getJsonObject() && req->getJsonObject()->isMember("deduplicate")) {
+                deduplicate = (*req->getJsonObject())["deduplicate"].asBool();
+            }
+            
             // Parse summarization options
             SummarizationOptions summarizationOptions;
             if (req->getJsonObject() && req->getJsonObject()->isMember("summarization")) {
@@ -362,6 +687,22 @@ public:
                     summarizationOptions.maxMLProcessingTimeMs = summaryJson["maxMLProcessingTimeMs"].asInt();
                 }
 
+                if (summaryJson.isMember("mlBatchSize")) {
+                    summarizationOptions.mlBatchSize = std::max(1, summaryJson["mlBatchSize"].asInt());
+                }
+
+                if (summaryJson.isMember("mlIntraOpThreads")) {
+                    summarizationOptions.mlIntraOpThreads = std::max(1, summaryJson["mlIntraOpThreads"].asInt());
+                }
+
+                if (summaryJson.isMember("chunkThreshold")) {
+                    summarizationOptions.chunkThreshold = summaryJson["chunkThreshold"].asUInt64();
+                }
+
+                if (summaryJson.isMember("chunkSize")) {
+                    summarizationOptions.chunkSize = std::max<Json::UInt64>(1, summaryJson["chunkSize"].asUInt64());
+                }
+
                 // Parse advanced visualization options
                 if (summaryJson.isMember("includeEntityRelationships")) {
                     summarizationOptions.includeEntityRelationships = summaryJson["includeEntityRelationships"].asBool();
@@ -374,7 +715,7 @@ public:
             
             // Set options for repomix
             RepomixOptions options;
-            options.inputDir = tempDir;
+            options.fileSystem = upload;
             options.format = formatStr == "markdown" ? OutputFormat::Markdown : 
                              formatStr == "xml" ? OutputFormat::XML :
                              formatStr == "claude_xml" ? OutputFormat::ClaudeXML :
@@ -382,12 +723,14 @@ public:
             options.verbose = verbose;
             options.showTiming = showTiming;
             options.summarization = summarizationOptions;  // Set summarization options
+            options.deduplicate = deduplicate;
+            if (trace) {
+                options.traceFile = SHARED_DIRECTORY + "/" + traceFileName(jobId);
+            }
             
-            // Process the uploaded files
-            Repomix repomix(options);
-            
-            // Register a job for progress tracking
-            std::string jobId = ProgressTracker::getInstance().registerJob();
+            // Process the uploaded files with this job's share of the CPU budget
+            options.numThreads = numThreads;
+            Repomix repomix(options, engine);
             repomix.setJobId(jobId);
             
             // Run Repomix
@@ -403,16 +746,16 @@ public:
                 result["error"] = "Failed to process files";
             }
             
-            // Clean up temp directory
-            cleanupTempDir(tempDir);
-            
             // Convert to Json::Value for the response
             drogonResult["success"] = success;
             drogonResult["summary"] = repomix.getSummary();
+            if (trace && fs::exists(options.traceFile)) {
+                drogonResult["traceFile"] = traceFileName(jobId);
+            }
             
             if (success) {
                 // Get the output content as a string
-                std::string outputContent = repomix.getOutput();
+                const std::string& outputContent = repomix.getOutput();
                 drogonResult["content"] = outputContent;
             } else {
                 // Get the error as a string
@@ -447,8 +790,9 @@ public:
         callback(resp);
     }
 
-    void processRepo(const drogon::HttpRequestPtr& req, 
-                    std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+    void processRepoJob(const drogon::HttpRequestPtr& req, 
+                        std::function<void(const drogon::HttpResponsePtr&)>&& callback,
+                        const std::string& jobId, unsigned int numThreads) {
         // Use Json::Value for Drogon responses
         Json::Value drogonResult;
         json result; // nlohmann::json for internal processing
@@ -509,36 +853,14 @@ public:
 
             std::cout << "Processing repository: " << repoUrl << std::endl;
             
-            // Create temp directory
-            std::string tempDir = createTempDir();
-
-            std::cout << "Temp directory: " << tempDir << std::endl;
-            
-            // Clone the repository
-            std::string cloneCmd = "git clone --depth=1 " + repoUrl + " " + tempDir;
-            int cloneResult = system(cloneCmd.c_str());
-
-            std::cout << "Clone result: " << cloneResult << std::endl;
-            
-            if (cloneResult != 0) {
-                result["success"] = false;
-                result["error"] = "Failed to clone repository: " + repoUrl;
-                cleanupTempDir(tempDir);
-                
-                // Convert nlohmann::json to Json::Value for the response
-                drogonResult["success"] = false;
-                drogonResult["error"] = "Failed to clone repository: " + repoUrl;
-                auto resp = drogon::HttpResponse::newHttpJsonResponse(drogonResult);
-                resp->setStatusCode(drogon::k500InternalServerError);
-                callback(resp);
-                return;
-            }
+            // Incremental requests keep a mirror and the previous results per URL
+            bool incremental = body.contains("incremental") && body["incremental"].is_boolean() && 
+                               body["incremental"].get<bool>();
             
             // Create repomix options
             RepomixOptions options;
-            options.inputDir = tempDir;
             options.verbose = false;
-            options.numThreads = std::thread::hardware_concurrency();
+            options.numThreads = numThreads;
             
             // Set output format
             std::string format = "plain";
@@ -546,36 +868,118 @@ public:
                 format = body["format"];
             }
             
-            if (format == "markdown") {
-                options.format = OutputFormat::Markdown;
-            } else if (format == "xml") {
-                options.format = OutputFormat::XML;
-            } else if (format == "claude_xml") {
-                options.format = OutputFormat::ClaudeXML;
-            } else {
-                options.format = OutputFormat::Plain;
-            }
+            options.format = parseOutputFormat(format);
 
             std::cout << "Format: " << format << std::endl;
             
+            // Fit the output into a model's context window
+            if (body.contains("tokenBudget") && body["tokenBudget"].is_number_unsigned()) {
+                options.tokenBudget = body["tokenBudget"].get<size_t>();
+            }
+            
+            // Timeline of the run, fetched afterwards from /api/content
+            const bool trace = body.contains("trace") && body["trace"].is_boolean() && body["trace"].get<bool>();
+            if (trace) {
+                options.traceFile = SHARED_DIRECTORY + "/" + traceFileName(jobId);
+            }
+            
+            // Copies of identical files are emitted as references unless turned off
+            if (body.contains("deduplicate") && body["deduplicate"].is_boolean()) {
+                options.deduplicate = body["deduplicate"].get<bool>();
+            }
+            
             // Don't write to a file in server mode
             options.outputFile = "";
             
-            // Process repository
-            Repomix repomix(options);
-            
-            // Register a job for progress tracking
-            std::string jobId = ProgressTracker::getInstance().registerJob();
-            repomix.setJobId(jobId);
+            TempDirGuard tempDir;
+            std::shared_ptr<Repomix> repomix;
+            std::shared_ptr<IncrementalRepo> repoState;
+            std::unique_lock<std::mutex> repoLock;
+            bool success = false;
             
-            // Run Repomix
-            bool success = repomix.run();
+            if (incremental) {
+                repoState = getIncrementalRepo(repoUrl);
+                repoLock = std::unique_lock<std::mutex>(repoState->mutex);
+                
+                if (!repoState->mirror) {
+                    repoState->mirror = std::make_unique<RepoMirror>(repoUrl, MIRROR_DIRECTORY);
+                }
+                RepoMirror::SyncResult sync = repoState->mirror->sync(repoState->packedCommit);
+                std::cout << "Mirror HEAD: " << sync.commit << std::endl;
+                
+                const std::string optionsKey = incrementalOptionsKey(options);
+                if (repoState->repomix && repoState->optionsKey == optionsKey) {
+                    repomix = repoState->repomix;
+                    repomix->setJobId(jobId);
+                    repomix->setTraceFile(options.traceFile);
+                    if (sync.commit == repoState->packedCommit) {
+                        std::cout << "Repository unchanged, reusing previous output" << std::endl;
+                        success = true;
+                    } else if (sync.diffAvailable) {
+                        std::cout << "Incremental update: " << sync.changed.size() << " changed, " 
+                                  << sync.removed.size() << " removed" << std::endl;
+                        success = repomix->runIncremental(sync.changed, sync.removed);
+                    } else {
+                        success = repomix->run();
+                    }
+                } else {
+                    // First request for this URL (or with other options): full run on the mirror checkout
+                    options.inputDir = repoState->mirror->worktree();
+                    options.cacheDir = ResultCache::defaultDirectory();
+                    repomix = std::make_shared<Repomix>(options, engine);
+                    repomix->setJobId(jobId);
+                    success = repomix->run();
+                    repoState->repomix = repomix;
+                    repoState->optionsKey = optionsKey;
+                }
+                
+                // A failed run leaves the base commit alone so the next request retries the same diff
+                if (success) {
+                    repoState->packedCommit = sync.commit;
+                } else {
+                    repoState->repomix.reset();
+                }
+                drogonResult["commit"] = sync.commit;
+            } else {
+                // Create temp directory, removed however this request ends
+                tempDir.path = createTempDir();
+
+                std::cout << "Temp directory: " << tempDir.path << std::endl;
+                
+                // Clone the repository
+                int cloneResult = cloneRepository(repoUrl, tempDir.path);
+
+                std::cout << "Clone result: " << cloneResult << std::endl;
+                
+                if (cloneResult != 0) {
+                    result["success"] = false;
+                    result["error"] = "Failed to clone repository: " + repoUrl;
+                    
+                    // Convert nlohmann::json to Json::Value for the response
+                    drogonResult["success"] = false;
+                    drogonResult["error"] = "Failed to clone repository: " + repoUrl;
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(drogonResult);
+                    resp->setStatusCode(drogon::k500InternalServerError);
+                    callback(resp);
+                    return;
+                }
+                
+                // Read the files straight from the cloned objects
+                options.fileSystem = std::make_shared<GitObjectFileSystem>(tempDir.path);
+                
+                // Process repository
+                repomix = std::make_shared<Repomix>(options, engine);
+                repomix->setJobId(jobId);
+                
+                // Run Repomix
+                success = repomix->run();
+            }
             
             std::cout << "Success: " << success << std::endl;
             
             // Get outputs before preparing response
-            std::string summary = repomix.getSummary();
-            std::string outputContent = repomix.getOutput();
+            std::string summary = repomix->getSummary();
+            const std::string& outputContent = repomix->getOutput();
 
             std::cout << "Repository processing " << (success ? "successful" : "failed") << std::endl;
             std::cout << "Summary length: " << summary.length() << " bytes" << std::endl;
@@ -625,6 +1029,9 @@ public:
             drogonResult["success"] = success;
             drogonResult["summary"] = summary;
             drogonResult["contentInFile"] = contentInFile;
+            if (trace && fs::exists(options.traceFile)) {
+                drogonResult["traceFile"] = traceFileName(jobId);
+            }
             if (contentInFile) {
                 drogonResult["contentFilePath"] = contentFilePath;
                 // Add a brief content snippet
@@ -661,9 +1068,6 @@ public:
             auto resp = drogon::HttpResponse::newHttpJsonResponse(drogonResult);
             resp->setStatusCode(drogon::k200OK);
             
-            // Clean up temp directory
-            cleanupTempDir(tempDir);
-            
         } catch (const json::exception& e) {
             result["success"] = false;
             result["error"] = "Invalid JSON: " + std::string(e.what());
@@ -688,6 +1092,124 @@ public:
         callback(resp);
     }
 
+    // Process a git repository and stream the result as server-sent events:
+    // "job" (id), "progress" while files are processed, "content" chunks of the
+    // formatted output, then "summary" (or "error") and finally "done"
+    void streamRepo(const drogon::HttpRequestPtr& req, 
+                    std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+        json body;
+        try {
+            body = json::parse(req->getBody());
+        } catch (const json::exception& e) {
+            Json::Value error;
+            error["success"] = false;
+            error["error"] = "Invalid JSON: " + std::string(e.what());
+            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+            resp->setStatusCode(drogon::k400BadRequest);
+            callback(resp);
+            return;
+        }
+        
+        if (!body.contains("repoUrl") || !body["repoUrl"].is_string()) {
+            Json::Value error;
+            error["success"] = false;
+            error["error"] = "Missing or invalid repoUrl in request body";
+            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+            resp->setStatusCode(drogon::k400BadRequest);
+            callback(resp);
+            return;
+        }
+        
+        std::string repoUrl = body["repoUrl"];
+        std::string format = "plain";
+        if (body.contains("format") && body["format"].is_string()) {
+            format = body["format"];
+        }
+        
+        std::cout << "Streaming repository: " << repoUrl << std::endl;
+        
+        // The job runs on the executor so the event loop only relays chunks
+        auto resp = drogon::HttpResponse::newAsyncStreamResponse(
+            [repoUrl, format](drogon::ResponseStreamPtr stream) {
+                auto channel = std::make_shared<SseChannel>(std::move(stream));
+                std::string jobId = ProgressTracker::getInstance().registerJob();
+                bool accepted = jobExecutor->submit(jobId, [channel, repoUrl, format, jobId](unsigned int numThreads) {
+                    runStreamingJob(channel, repoUrl, format, jobId, numThreads);
+                });
+                if (!accepted) {
+                    ProgressTracker::getInstance().removeJob(jobId);
+                    channel->send("error", json{{"error", "Server is busy, try again later"}}.dump());
+                    channel->send("done", json{{"success", false}}.dump());
+                    channel->close();
+                }
+            });
+        resp->setContentTypeString("text/event-stream");
+        resp->addHeader("Cache-Control", "no-cache");
+        resp->addHeader("Access-Control-Allow-Origin", "*");
+        callback(resp);
+    }
+    
+    // Clone, process and format a repository, sending everything through channel
+    static void runStreamingJob(const std::shared_ptr<SseChannel>& channel, 
+                                const std::string& repoUrl, const std::string& format,
+                                const std::string& jobId, unsigned int numThreads) {
+        channel->send("job", json{{"id", jobId}}.dump());
+        
+        std::string tempDir = createTempDir();
+        try {
+            if (cloneRepository(repoUrl, tempDir) != 0) {
+                throw std::runtime_error("Failed to clone repository: " + repoUrl);
+            }
+            
+            RepomixOptions options;
+            options.fileSystem = std::make_shared<GitObjectFileSystem>(tempDir);
+            options.verbose = false;
+            options.numThreads = numThreads;
+            options.format = parseOutputFormat(format);
+            options.outputFile = "";
+            
+            Repomix repomix(options, engine);
+            repomix.setJobId(jobId);
+            
+            // Progress reports are serialized by the processor; send at most ten per second
+            std::chrono::steady_clock::time_point lastSent;
+            repomix.setProgressCallback([&channel, &jobId, &lastSent](const FileProcessor::ProgressInfo& progress) {
+                auto now = std::chrono::steady_clock::now();
+                if (!progress.isComplete && now - lastSent < std::chrono::milliseconds(100)) {
+                    return;
+                }
+                lastSent = now;
+                
+                json progressJson = {
+                    {"id", jobId},
+                    {"totalFiles", progress.totalFiles},
+                    {"processedFiles", progress.processedFiles},
+                    {"skippedFiles", progress.skippedFiles},
+                    {"errorFiles", progress.errorFiles},
+                    {"isComplete", progress.isComplete},
+                    {"percentage", progress.getPercentage()}
+                };
+                channel->send("progress", progressJson.dump(-1, ' ', false, json::error_handler_t::replace));
+            });
+            
+            repomix.setOutputSink(std::make_shared<SseOutputSink>(channel));
+            
+            if (repomix.run()) {
+                channel->send("summary", json{{"summary", repomix.getSummary()}}.dump());
+                channel->send("done", json{{"success", true}}.dump());
+            } else {
+                channel->send("error", json{{"error", "Failed to process repository"}}.dump());
+                channel->send("done", json{{"success", false}}.dump());
+            }
+        } catch (const std::exception& e) {
+            channel->send("error", json{{"error", e.what()}}.dump(-1, ' ', false, json::error_handler_t::replace));
+            channel->send("done", json{{"success", false}}.dump());
+        }
+        
+        cleanupTempDir(tempDir);
+        channel->close();
+    }
+
     void getCapabilities(const drogon::HttpRequestPtr& req, 
                          std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
         Json::Value result;
@@ -704,6 +1226,8 @@ public:
         result["capabilities"].append("shared_directory");
         result["capabilities"].append("token_counting");
         result["capabilities"].append("file_scoring");
+        result["capabilities"].append("incremental_repo");
+        result["capabilities"].append("streaming");
         
         // Supported formats
         result["formats"] = Json::Value(Json::arrayValue);
@@ -756,13 +1280,24 @@ public:
         // Max content size
         result["max_content_size_bytes"] = 10 * 1024 * 1024; // 10MB
         
+        // Shared entity recognition cache
+        EntityCache::Stats entityStats = EntityCache::instance().stats();
+        Json::Value entityCache;
+        entityCache["hits"] = static_cast<Json::UInt64>(entityStats.hits);
+        entityCache["misses"] = static_cast<Json::UInt64>(entityStats.misses);
+        entityCache["evictions"] = static_cast<Json::UInt64>(entityStats.evictions);
+        entityCache["entries"] = static_cast<Json::UInt64>(entityStats.entries);
+        entityCache["capacity"] = static_cast<Json::UInt64>(entityStats.capacity);
+        result["entity_cache"] = entityCache;
+        
         auto resp = drogon::HttpResponse::newHttpJsonResponse(result);
         callback(resp);
     }
 
     // New method to process directories that are uploaded from the frontend
-    void processUploadedDir(const drogon::HttpRequestPtr& req, 
-                          std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+    void processUploadedDirJob(const drogon::HttpRequestPtr& req, 
+                             std::function<void(const drogon::HttpResponsePtr&)>&& callback,
+                             const std::string& jobId, unsigned int numThreads) {
         // Use Json::Value for Drogon responses
         Json::Value drogonResult;
         json result; // nlohmann::json for internal processing
@@ -782,46 +1317,14 @@ public:
                 return;
             }
 
-            // Create temp directory
-            std::string tempDir = createTempDir();
-            std::cout << "Created temp directory: " << tempDir << std::endl;
-            
-            // Process uploaded files - maintain directory structure if possible
-            auto& files = fileUpload.getFiles();
-            std::cout << "Received " << files.size() << " files" << std::endl;
-            
-            for (auto& file : files) {
-                // Get file path from form field name or content-disposition
-                std::string relPath = file.getFileName();
-                
-                // Create the directory structure if needed
-                fs::path filePath = fs::path(tempDir) / relPath;
-                fs::create_directories(filePath.parent_path());
-                
-                // Save file content
-                std::ofstream fileOut(filePath, std::ios::binary);
-                if (fileOut) {
-                    // Check if the content appears to be Base64-encoded
-                    std::string fileContent(file.fileContent().data(), file.fileContent().size());
-                    if (isBase64Encoded(fileContent)) {
-                        // Decode the Base64 content
-                        std::string decodedContent = decodeBase64(fileContent);
-                        fileOut.write(decodedContent.data(), decodedContent.size());
-                    } else {
-                        // Write as-is
-                        fileOut.write(file.fileContent().data(), file.fileContent().size());
-                    }
-                    fileOut.close();
-                } else {
-                    std::cerr << "Failed to create file: " << filePath << std::endl;
-                }
-                
-                std::cout << "Saved file: " << relPath << " (" << file.fileContent().size() << " bytes)" << std::endl;
-            }
+            // Read the uploaded files (or archive) in place, keeping their relative
+            // paths (from the form field name or content-disposition)
+            std::cout << "Received " << fileUpload.getFiles().size() << " files" << std::endl;
+            auto upload = mountUpload(req, fileUpload);
             
             // Process the directory with Repomix
             RepomixOptions options;
-            options.inputDir = tempDir;
+            options.fileSystem = upload;
             options.format = OutputFormat::Plain; // Default - can be overridden by form params
             
             // Check for format parameter
@@ -848,25 +1351,20 @@ public:
                 }
             }
             
-            // Process the directory
-            Repomix repomix(options);
-            
-            // Register a job for progress tracking
-            std::string jobId = ProgressTracker::getInstance().registerJob();
+            // Process the directory with this job's share of the CPU budget
+            options.numThreads = numThreads;
+            Repomix repomix(options, engine);
             repomix.setJobId(jobId);
             
             // Run Repomix
             bool success = repomix.run();
             
-            // Clean up temp directory
-            cleanupTempDir(tempDir);
-            
             // Prepare response
             drogonResult["success"] = success;
             drogonResult["summary"] = repomix.getSummary();
             
             if (success) {
-                std::string outputContent = repomix.getOutput();
+                const std::string& outputContent = repomix.getOutput();
                 drogonResult["content"] = outputContent;
                 
                 // Add scoring report if scoring was used
@@ -953,8 +1451,9 @@ public:
     }
 
     // Process files from a shared directory
-    void processSharedDir(const drogon::HttpRequestPtr& req, 
-                        std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+    void processSharedDirJob(const drogon::HttpRequestPtr& req, 
+                           std::function<void(const drogon::HttpResponsePtr&)>&& callback,
+                           const std::string& jobId, unsigned int numThreads) {
         // Use Json::Value for Drogon responses
         Json::Value drogonResult;
         json result; // nlohmann::json for internal processing
@@ -1238,11 +1737,9 @@ public:
             options.inputDir = tempDir;
             options.format = format;
             
-            // Process the directory
-            Repomix repomix(options);
-            
-            // Register a job for progress tracking
-            std::string jobId = ProgressTracker::getInstance().registerJob();
+            // Process the directory with this job's share of the CPU budget
+            options.numThreads = numThreads;
+            Repomix repomix(options, engine);
             repomix.setJobId(jobId);
             
             // Run Repomix
@@ -1250,7 +1747,7 @@ public:
             
             // Get outputs before preparing response
             std::string summary = repomix.getSummary();
-            std::string outputContent = repomix.getOutput();
+            const std::string& outputContent = repomix.getOutput();
 
             std::cout << "Repository processing " << (success ? "successful" : "failed") << std::endl;
             std::cout << "Summary length: " << summary.length() << " bytes" << std::endl;
@@ -1645,7 +2142,7 @@ public:
             }
             
             // Initialize Repomix with scoring
-            Repomix repomix(options);
+            Repomix repomix(options, engine);
             
             // Run scoring but don't generate output
             options.onlyShowTokenCount = true; // This makes Repomix not generate full output
@@ -1839,6 +2336,46 @@ public:
     }
 
     // Method to get progress of a specific job
+    // Response of a job submitted with ?async=true; 202 while it is queued or running
+    void getJobResult(const drogon::HttpRequestPtr& req, Callback&& callback, const std::string& id) {
+        drogon::HttpResponsePtr stored;
+        {
+            std::lock_guard<std::mutex> lock(asyncJobResultsMutex);
+            auto it = asyncJobResults.find(id);
+            if (it != asyncJobResults.end()) {
+                stored = it->second;
+            }
+        }
+        
+        if (stored) {
+            // Copy the stored response; a response object is sent only once
+            auto resp = drogon::HttpResponse::newHttpResponse();
+            resp->setStatusCode(stored->getStatusCode());
+            resp->setContentTypeCode(stored->getContentType());
+            resp->setBody(std::string(stored->getBody()));
+            callback(resp);
+            return;
+        }
+        
+        Json::Value status;
+        status["id"] = id;
+        JobExecutor::JobState state;
+        if (!jobExecutor->getState(id, state)) {
+            status["success"] = false;
+            status["error"] = "Job not found";
+            auto resp = drogon::HttpResponse::newHttpJsonResponse(status);
+            resp->setStatusCode(drogon::k404NotFound);
+            callback(resp);
+            return;
+        }
+        
+        status["success"] = true;
+        status["state"] = JobExecutor::stateName(state);
+        auto resp = drogon::HttpResponse::newHttpJsonResponse(status);
+        resp->setStatusCode(drogon::k202Accepted);
+        callback(resp);
+    }
+
     void getProgress(const drogon::HttpRequestPtr& req, 
                      std::function<void(const drogon::HttpResponsePtr&)>&& callback,
                      const std::string& id) {
@@ -1909,21 +2446,70 @@ public:
             auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
                 now - job.startTime).count();
             
-            jobsArray.push_back({
+            json jobJson = {
                 {"id", job.id},
                 {"percentage", job.lastProgress.getPercentage()},
                 {"isComplete", job.isComplete},
                 {"elapsedMs", elapsedMs}
-            });
+            };
+            JobExecutor::JobState state;
+            if (jobExecutor->getState(job.id, state)) {
+                jobJson["state"] = JobExecutor::stateName(state);
+            }
+            jobsArray.push_back(jobJson);
         }
         
         json jobsJson = {
-            {"jobs", jobsArray}
+            {"jobs", jobsArray},
+            {"runningJobs", jobExecutor->runningJobs()},
+            {"queuedJobs", jobExecutor->queuedJobs()}
         };
         
         resp = drogon::HttpResponse::newHttpJsonResponse(jobsJson);
         callback(resp);
     }
+    
+    // Stage histograms, I/O counters and pool gauges in the Prometheus text
+    // format, plus the job executor, the engine and the shared entity cache
+    void getMetrics(const drogon::HttpRequestPtr&,
+                    std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+        std::ostringstream body;
+        body << Metrics::instance().prometheus();
+        
+        body << "# HELP repomix_jobs_running Jobs currently running\n"
+             << "# TYPE repomix_jobs_running gauge\n"
+             << "repomix_jobs_running " << jobExecutor->runningJobs() << "\n"
+             << "# HELP repomix_jobs_queued Jobs waiting for a slot\n"
+             << "# TYPE repomix_jobs_queued gauge\n"
+             << "repomix_jobs_queued " << jobExecutor->queuedJobs() << "\n";
+        
+        const Engine::Stats engineStats = engine->stats();
+        body << "# HELP repomix_engine_hits_total Tokenizers, recognizers and patterns reused from the engine\n"
+             << "# TYPE repomix_engine_hits_total counter\n"
+             << "repomix_engine_hits_total " << engineStats.hits << "\n"
+             << "# HELP repomix_engine_misses_total Tokenizers, recognizers and patterns the engine built\n"
+             << "# TYPE repomix_engine_misses_total counter\n"
+             << "repomix_engine_misses_total " << engineStats.misses << "\n";
+        
+        const EntityCache::Stats entityStats = EntityCache::instance().stats();
+        body << "# HELP repomix_entity_cache_hits_total Entity cache hits\n"
+             << "# TYPE repomix_entity_cache_hits_total counter\n"
+             << "repomix_entity_cache_hits_total " << entityStats.hits << "\n"
+             << "# HELP repomix_entity_cache_misses_total Entity cache misses\n"
+             << "# TYPE repomix_entity_cache_misses_total counter\n"
+             << "repomix_entity_cache_misses_total " << entityStats.misses << "\n"
+             << "# HELP repomix_entity_cache_evictions_total Entity cache evictions\n"
+             << "# TYPE repomix_entity_cache_evictions_total counter\n"
+             << "repomix_entity_cache_evictions_total " << entityStats.evictions << "\n"
+             << "# HELP repomix_entity_cache_entries Entries held by the entity cache\n"
+             << "# TYPE repomix_entity_cache_entries gauge\n"
+             << "repomix_entity_cache_entries " << entityStats.entries << "\n";
+        
+        auto resp = drogon::HttpResponse::newHttpResponse();
+        resp->setContentTypeString("text/plain; version=0.0.4; charset=utf-8");
+        resp->setBody(body.str());
+        callback(resp);
+    }
 };
 
 int main(int argc, char* argv[]) {
@@ -1949,6 +2535,46 @@ int main(int argc, char* argv[]) {
             std::cout << "Using default shared directory: " << SHARED_DIRECTORY << std::endl;
         }
         
+        // Check for REPOMIX_MIRROR_DIR environment variable
+        const char* mirrorDirEnv = std::getenv("REPOMIX_MIRROR_DIR");
+        if (mirrorDirEnv) {
+            MIRROR_DIRECTORY = mirrorDirEnv;
+        }
+        if (const char* env = std::getenv("REPOMIX_MAX_MIRRORS")) {
+            MAX_INCREMENTAL_REPOS = static_cast<size_t>(std::max(1, std::atoi(env)));
+        }
+        removeStaleMirrors();
+        std::cout << "Using mirror directory: " << MIRROR_DIRECTORY << ", at most "
+                  << MAX_INCREMENTAL_REPOS << " mirrors" << std::endl;
+        
+        // Job executor: REPOMIX_MAX_JOBS slots share REPOMIX_CPU_BUDGET threads,
+        // with up to REPOMIX_MAX_QUEUED_JOBS requests waiting
+        JobExecutor::Config executorConfig;
+        executorConfig.cpuBudget = std::max(1u, std::thread::hardware_concurrency());
+        executorConfig.maxConcurrentJobs = std::max(1u, executorConfig.cpuBudget / 4);
+        if (const char* env = std::getenv("REPOMIX_CPU_BUDGET")) {
+            executorConfig.cpuBudget = static_cast<unsigned int>(std::max(1, std::atoi(env)));
+        }
+        if (const char* env = std::getenv("REPOMIX_MAX_JOBS")) {
+            executorConfig.maxConcurrentJobs = static_cast<unsigned int>(std::max(1, std::atoi(env)));
+        }
+        if (const char* env = std::getenv("REPOMIX_MAX_QUEUED_JOBS")) {
+            executorConfig.maxQueuedJobs = static_cast<size_t>(std::max(0, std::atoi(env)));
+        }
+        jobExecutor = std::make_unique<JobExecutor>(executorConfig);
+        
+        // Per-job progress lines are only printed on request
+        if (const char* env = std::getenv("REPOMIX_LOG_PROGRESS")) {
+            ProgressTracker::getInstance().setLogging(std::atoi(env) != 0);
+        }
+        std::cout << "Job executor: " << executorConfig.maxConcurrentJobs << " concurrent jobs, "
+                  << jobExecutor->threadsPerJob() << " threads each, queue limit " 
+                  << executorConfig.maxQueuedJobs << std::endl;
+        
+        // Build the default tokenizer and patterns now rather than on the first request
+        engine = std::make_shared<Engine>();
+        engine->warmUp(RepomixOptions());
+        
         // Create shared directory if it doesn't exist
         try {
             if (!fs::exists(SHARED_DIRECTORY)) {
@@ -2063,6 +2689,9 @@ int main(int argc, char* argv[]) {
         std::cout << "=== Ready to run server ===\n";
         app.run();
         
+        // Let running jobs finish before the process exits
+        jobExecutor.reset();
+        
         return 0;
     } catch (const std::exception& e) {
         std::cerr << "*** FATAL ERROR: Unhandled exception: " << e.what() << std::endl;
@@ -0,0 +1,89 @@
+#include "string_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+/**
+ * @brief Creates an empty pool
+ *
+ * @param shardCount Number of independently locked shards
+ */
+StringPool::StringPool(size_t shardCount) {
+    shardCount = std::max<size_t>(shardCount, 1);
+    shards_.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+std::string_view StringPool::copyInto(Shard& shard, std::string_view text) {
+    char* data = static_cast<char*>(shard.arena.allocate(text.size(), alignof(char)));
+    std::memcpy(data, text.data(), text.size());
+    shard.bytes += text.size();
+    return std::string_view(data, text.size());
+}
+
+/**
+ * @brief Returns the pooled copy of a string, adding it on first use
+ *
+ * @param text String to intern
+ * @return std::string_view View valid for the lifetime of the pool
+ *
+ * Equal strings always land in the same shard, so one lookup under that
+ * shard's lock decides whether the text is already held.
+ */
+std::string_view StringPool::intern(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    const size_t hash = std::hash<std::string_view>()(text);
+    Shard& shard = *shards_[(hash >> 16) % shards_.size()];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.interned.find(text);
+    if (it != shard.interned.end()) {
+        return *it;
+    }
+    std::string_view copy = copyInto(shard, text);
+    shard.interned.insert(copy);
+    return copy;
+}
+
+/**
+ * @brief Copies a string into the pool
+ *
+ * @param text String to copy
+ * @return std::string_view View valid for the lifetime of the pool
+ *
+ * The shard is picked by thread, so workers storing their own files' text
+ * do not wait on each other.
+ */
+std::string_view StringPool::store(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    const size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    Shard& shard = *shards_[hash % shards_.size()];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return copyInto(shard, text);
+}
+
+size_t StringPool::internedCount() const {
+    size_t count = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->interned.size();
+    }
+    return count;
+}
+
+size_t StringPool::bytesUsed() const {
+    size_t bytes = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        bytes += shard->bytes;
+    }
+    return bytes;
+}
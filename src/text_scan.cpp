@@ -0,0 +1,384 @@
+#include "text_scan.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define REPOMIX_SCAN_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define REPOMIX_SCAN_NEON 1
+#endif
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 64;
+constexpr size_t CHARS_PER_TOKEN = 4;   // Must match the fallback tokenizer
+
+// Punctuation that ends a word and counts as a token of its own
+constexpr char PUNCTUATION[] = ".,!?:;()[]{}\"'`";
+
+// Bit i of each mask describes byte i of a 64-byte block
+struct BlockMasks {
+    uint64_t newline = 0;
+    uint64_t nul = 0;
+    uint64_t text = 0;
+    uint64_t space = 0;     // What std::isspace accepts in the C locale
+    uint64_t punct = 0;
+};
+
+using ClassifyFn = void (*)(const char* block, BlockMasks& masks);
+
+inline unsigned popcount(uint64_t x) {
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+    unsigned count = 0;
+    for (; x; x &= x - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// Index of the lowest set bit; x must not be 0
+inline unsigned lowestBit(uint64_t x) {
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+    unsigned index = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+// ---- Scalar kernel: one table lookup per byte ----
+
+enum : uint8_t {
+    CLASS_NEWLINE = 1,
+    CLASS_NUL = 2,
+    CLASS_TEXT = 4,
+    CLASS_SPACE = 8,
+    CLASS_PUNCT = 16
+};
+
+struct ClassTable {
+    uint8_t classes[256] = {};
+
+    ClassTable() {
+        for (int c = 0; c < 256; ++c) {
+            uint8_t bits = 0;
+            if (c == '\n') bits |= CLASS_NEWLINE;
+            if (c == 0) bits |= CLASS_NUL;
+            if ((c >= 32 && c <= 126) || c == '\n' || c == '\r' || c == '\t') bits |= CLASS_TEXT;
+            if (c == ' ' || (c >= '\t' && c <= '\r')) bits |= CLASS_SPACE;
+            classes[c] = bits;
+        }
+        for (const char* p = PUNCTUATION; *p; ++p) {
+            classes[static_cast<unsigned char>(*p)] |= CLASS_PUNCT;
+        }
+    }
+};
+
+void classifyScalar(const char* block, BlockMasks& masks) {
+    static const ClassTable table;
+    masks = BlockMasks();
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        const uint8_t bits = table.classes[static_cast<unsigned char>(block[i])];
+        const uint64_t bit = uint64_t(1) << i;
+        if (bits & CLASS_NEWLINE) masks.newline |= bit;
+        if (bits & CLASS_NUL) masks.nul |= bit;
+        if (bits & CLASS_TEXT) masks.text |= bit;
+        if (bits & CLASS_SPACE) masks.space |= bit;
+        if (bits & CLASS_PUNCT) masks.punct |= bit;
+    }
+}
+
+// Punctuation lookup for the kernels with a byte shuffle (AVX2, NEON): a
+// byte is punctuation iff LOW[c & 0xF] & HIGH[c >> 4] is non-zero. Each
+// bit stands for a group of punctuation sharing a high nibble:
+// 1 = 0x2_ (!"'(),.), 2 = 0x3_ (:;?), 4 = 0x5_/0x7_ ([]{}), 8 = 0x6_ (`)
+#if defined(REPOMIX_SCAN_X86) || defined(REPOMIX_SCAN_NEON)
+constexpr uint8_t PUNCT_LOW_NIBBLE[16] = {8, 1, 1, 0, 0, 0, 0, 1, 1, 1, 2, 6, 1, 4, 1, 2};
+constexpr uint8_t PUNCT_HIGH_NIBBLE[16] = {0, 0, 1, 2, 0, 4, 8, 4, 0, 0, 0, 0, 0, 0, 0, 0};
+#endif
+
+// ---- SSE2 kernel: byte compares, 16 bytes at a time ----
+
+#if defined(REPOMIX_SCAN_X86)
+inline uint64_t bits16(__m128i m) {
+    return static_cast<uint16_t>(_mm_movemask_epi8(m));
+}
+
+void classifySse2(const char* block, BlockMasks& masks) {
+    masks = BlockMasks();
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        const __m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+        // Signed compares: bytes >= 0x80 are negative and fail both ranges
+        const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x1F)),
+                                                 _mm_cmplt_epi8(v, _mm_set1_epi8(0x7F)));
+        const __m128i text = _mm_or_si128(_mm_or_si128(printable, newline),
+                                          _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')),
+                                                       _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        const __m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                           _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)),
+                                                         _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1))));
+        __m128i punct = _mm_setzero_si128();
+        for (const char* p = PUNCTUATION; *p; ++p) {
+            punct = _mm_or_si128(punct, _mm_cmpeq_epi8(v, _mm_set1_epi8(*p)));
+        }
+
+        masks.newline |= bits16(newline) << i;
+        masks.nul |= bits16(_mm_cmpeq_epi8(v, _mm_setzero_si128())) << i;
+        masks.text |= bits16(text) << i;
+        masks.space |= bits16(space) << i;
+        masks.punct |= bits16(punct) << i;
+    }
+}
+
+// ---- AVX2 kernel: 32 bytes at a time, punctuation by nibble lookup ----
+
+__attribute__((target("avx2")))
+inline uint64_t bits32(__m256i m) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+}
+
+__attribute__((target("avx2")))
+void classifyAvx2(const char* block, BlockMasks& masks) {
+    const __m256i lowLut = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(PUNCT_LOW_NIBBLE)));
+    const __m256i highLut = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(PUNCT_HIGH_NIBBLE)));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+
+    masks = BlockMasks();
+    for (size_t i = 0; i < BLOCK_SIZE; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        const __m256i newline = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+        const __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(0x1F)),
+                                                   _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7F), v));
+        const __m256i text = _mm256_or_si256(_mm256_or_si256(printable, newline),
+                                             _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')),
+                                                             _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        const __m256i space = _mm256_or_si256(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+            _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1)),
+                             _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v)));
+        const __m256i low = _mm256_and_si256(v, nibble);
+        const __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+        const __m256i groups = _mm256_and_si256(_mm256_shuffle_epi8(lowLut, low),
+                                                _mm256_shuffle_epi8(highLut, high));
+
+        masks.newline |= bits32(newline) << i;
+        masks.nul |= bits32(_mm256_cmpeq_epi8(v, zero)) << i;
+        masks.text |= bits32(text) << i;
+        masks.space |= bits32(space) << i;
+        masks.punct |= (~bits32(_mm256_cmpeq_epi8(groups, zero)) & 0xFFFFFFFFu) << i;
+    }
+}
+#endif
+
+// ---- NEON kernel: 16 bytes at a time, punctuation by table lookup ----
+
+#if defined(REPOMIX_SCAN_NEON)
+inline uint64_t bits16(uint8x16_t m) {
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vandq_u8(m, vld1q_u8(weights));
+    return uint64_t(vaddv_u8(vget_low_u8(bits))) | (uint64_t(vaddv_u8(vget_high_u8(bits))) << 8);
+}
+
+void classifyNeon(const char* block, BlockMasks& masks) {
+    const uint8x16_t lowLut = vld1q_u8(PUNCT_LOW_NIBBLE);
+    const uint8x16_t highLut = vld1q_u8(PUNCT_HIGH_NIBBLE);
+
+    masks = BlockMasks();
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(block + i));
+        const uint8x16_t newline = vceqq_u8(v, vdupq_n_u8('\n'));
+        const uint8x16_t printable = vandq_u8(vcgeq_u8(v, vdupq_n_u8(0x20)), vcleq_u8(v, vdupq_n_u8(0x7E)));
+        const uint8x16_t text = vorrq_u8(vorrq_u8(printable, newline),
+                                         vorrq_u8(vceqq_u8(v, vdupq_n_u8('\t')), vceqq_u8(v, vdupq_n_u8('\r'))));
+        const uint8x16_t space = vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')),
+                                          vandq_u8(vcgeq_u8(v, vdupq_n_u8('\t')), vcleq_u8(v, vdupq_n_u8('\r'))));
+        const uint8x16_t groups = vandq_u8(vqtbl1q_u8(lowLut, vandq_u8(v, vdupq_n_u8(0x0F))),
+                                           vqtbl1q_u8(highLut, vshrq_n_u8(v, 4)));
+
+        masks.newline |= bits16(newline) << i;
+        masks.nul |= bits16(vceqq_u8(v, vdupq_n_u8(0))) << i;
+        masks.text |= bits16(text) << i;
+        masks.space |= bits16(space) << i;
+        masks.punct |= bits16(vtstq_u8(groups, groups)) << i;
+    }
+}
+#endif
+
+ClassifyFn classifierFor(TextScanner::Kernel kernel) {
+    switch (kernel) {
+#if defined(REPOMIX_SCAN_X86)
+        case TextScanner::Kernel::SSE2:
+            return classifySse2;
+        case TextScanner::Kernel::AVX2:
+            return classifyAvx2;
+#endif
+#if defined(REPOMIX_SCAN_NEON)
+        case TextScanner::Kernel::NEON:
+            return classifyNeon;
+#endif
+        default:
+            return classifyScalar;
+    }
+}
+
+// Adds the words of one block to the token estimate. word has a bit for
+// every byte that is neither whitespace nor punctuation; wordLength carries
+// a word that runs across block boundaries.
+inline void measureWords(uint64_t word, size_t blockLength, size_t& wordLength, size_t& tokens) {
+    size_t pos = 0;
+    while (pos < blockLength) {
+        const uint64_t rest = word >> pos;
+        if (rest & 1) {
+            // Run of word bytes starting at pos
+            const uint64_t delimiters = ~rest;
+            const size_t run = delimiters == 0 ? BLOCK_SIZE : lowestBit(delimiters);
+            wordLength += run;
+            pos += run;
+        } else {
+            if (wordLength > 0) {
+                tokens += (wordLength + CHARS_PER_TOKEN - 1) / CHARS_PER_TOKEN;
+                wordLength = 0;
+            }
+            if (rest == 0) {
+                break;
+            }
+            pos += lowestBit(rest);
+        }
+    }
+}
+
+template <bool FullStats>
+TextStats scanBlocks(std::string_view data, ClassifyFn classify) {
+    TextStats stats;
+    size_t wordLength = 0;
+    char tail[BLOCK_SIZE];
+    BlockMasks masks;
+
+    for (size_t offset = 0; offset < data.size(); offset += BLOCK_SIZE) {
+        const size_t length = std::min(BLOCK_SIZE, data.size() - offset);
+        uint64_t valid = ~uint64_t(0);
+        if (length == BLOCK_SIZE) {
+            classify(data.data() + offset, masks);
+        } else {
+            // Pad the last block; the padding is masked out below
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, data.data() + offset, length);
+            classify(tail, masks);
+            valid = (uint64_t(1) << length) - 1;
+        }
+
+        stats.newlines += popcount(masks.newline & valid);
+        if (FullStats) {
+            stats.nulBytes += popcount(masks.nul & valid);
+            stats.textBytes += popcount(masks.text & valid);
+            stats.estimatedTokens += popcount(masks.punct & valid);
+            measureWords(~(masks.space | masks.punct) & valid, length, wordLength, stats.estimatedTokens);
+        }
+    }
+
+    if (FullStats && wordLength > 0) {
+        stats.estimatedTokens += (wordLength + CHARS_PER_TOKEN - 1) / CHARS_PER_TOKEN;
+    }
+    return stats;
+}
+
+}  // namespace
+
+/**
+ * @brief Computes all byte statistics of a buffer in one pass
+ *
+ * @param data Bytes to scan
+ * @return TextStats Newlines, NUL bytes, text bytes and the token estimate
+ */
+TextStats TextScanner::scan(std::string_view data) {
+    static const ClassifyFn classify = classifierFor(activeKernel());
+    return scanBlocks<true>(data, classify);
+}
+
+/**
+ * @brief Computes all byte statistics with a specific kernel
+ *
+ * @param data Bytes to scan
+ * @param kernel Kernel to use; falls back to Scalar if it is not supported
+ * @return TextStats Same result as scan(data)
+ */
+TextStats TextScanner::scan(std::string_view data, Kernel kernel) {
+    return scanBlocks<true>(data, classifierFor(isSupported(kernel) ? kernel : Kernel::Scalar));
+}
+
+/**
+ * @brief Counts newline characters
+ *
+ * @param data Bytes to scan
+ * @return size_t Number of '\n' bytes
+ */
+size_t TextScanner::countNewlines(std::string_view data) {
+    static const ClassifyFn classify = classifierFor(activeKernel());
+    return scanBlocks<false>(data, classify).newlines;
+}
+
+/**
+ * @brief Returns the fastest kernel the CPU supports
+ *
+ * @return Kernel Chosen on first use and kept for the process lifetime
+ */
+TextScanner::Kernel TextScanner::activeKernel() {
+    static const Kernel kernel = [] {
+        for (Kernel candidate : {Kernel::AVX2, Kernel::NEON, Kernel::SSE2}) {
+            if (isSupported(candidate)) {
+                return candidate;
+            }
+        }
+        return Kernel::Scalar;
+    }();
+    return kernel;
+}
+
+/**
+ * @brief Checks whether this build and CPU can run a kernel
+ *
+ * @param kernel Kernel to check
+ * @return bool True if scan(data, kernel) uses that kernel
+ */
+bool TextScanner::isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return true;
+#if defined(REPOMIX_SCAN_X86)
+        case Kernel::SSE2:
+            return true;    // Part of the x86-64 baseline
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(REPOMIX_SCAN_NEON)
+        case Kernel::NEON:
+            return true;    // Part of the AArch64 baseline
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* TextScanner::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar: return "scalar";
+        case Kernel::SSE2: return "sse2";
+        case Kernel::AVX2: return "avx2";
+        case Kernel::NEON: return "neon";
+    }
+    return "unknown";
+}
@@ -0,0 +1,76 @@
+#include "token_budget.hpp"
+#include <algorithm>
+#include <numeric>
+
+/**
+ * @brief Creates a packer for a fixed budget
+ *
+ * @param budget Tokens available for file bodies and their framing
+ */
+TokenBudgetPacker::TokenBudgetPacker(size_t budget) : budget_(budget) {}
+
+/**
+ * @brief Picks full content, a summary or nothing for each item
+ *
+ * @param items Files with their score and token cost
+ * @param summarize Computes a summary on demand; may be empty
+ * @return Result The choice for each item and the tokens they use
+ *
+ * Items are visited by decreasing score per token (ties go to the higher
+ * score, then to input order, so the result is deterministic). Each one is
+ * taken in full if it fits in what is left, else as a summary if that fits,
+ * else omitted. Greedy by density is within one item of the fractional
+ * optimum, which for a repository's worth of small files is close enough.
+ */
+TokenBudgetPacker::Result TokenBudgetPacker::pack(const std::vector<Item>& items,
+                                                  const Summarizer& summarize) const {
+    Result result;
+    result.choices.assign(items.size(), Choice::Omitted);
+
+    auto density = [&items](size_t i) {
+        return static_cast<double>(items[i].score) / static_cast<double>(items[i].tokens + items[i].overhead + 1);
+    };
+
+    std::vector<size_t> order(items.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        double da = density(a);
+        double db = density(b);
+        if (da != db) {
+            return da > db;
+        }
+        return items[a].score > items[b].score;
+    });
+
+    size_t remaining = budget_;
+    for (size_t i : order) {
+        const Item& item = items[i];
+        if (item.overhead >= remaining) {
+            continue;
+        }
+
+        if (item.tokens + item.overhead <= remaining) {
+            result.choices[i] = Choice::Full;
+            remaining -= item.tokens + item.overhead;
+            continue;
+        }
+
+        if (summarize) {
+            std::optional<size_t> summaryTokens = summarize(i);
+            if (summaryTokens && *summaryTokens + item.overhead <= remaining) {
+                result.choices[i] = Choice::Summary;
+                remaining -= *summaryTokens + item.overhead;
+            }
+        }
+    }
+
+    result.usedTokens = budget_ - remaining;
+    for (Choice choice : result.choices) {
+        switch (choice) {
+            case Choice::Full:    result.fullCount++; break;
+            case Choice::Summary: result.summaryCount++; break;
+            case Choice::Omitted: result.omittedCount++; break;
+        }
+    }
+    return result;
+}
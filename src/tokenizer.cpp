@@ -1,4 +1,6 @@
 #include "tokenizer.hpp"
+#include "text_scan.hpp"
+#include <algorithm>
 #include <stdexcept>
 
 // In cpp-tiktoken, the header is in a subdirectory
@@ -68,24 +70,33 @@ void Tokenizer::initializeEncoding() {
 #endif
 }
 
-size_t Tokenizer::countTokens(const std::string& text) const {
+size_t Tokenizer::countTokens(std::string_view text) const {
 #ifdef USE_TIKTOKEN
     if (!encoding_) {
         throw std::runtime_error("Tokenizer not initialized");
     }
     
-    // Encode the text into tokens using cpp-tiktoken
-    auto tokens = encoding_->encode(text);
-    
-    // Return the number of tokens
-    return tokens.size();
+    // Only the count is needed, so encode in pieces cut after a newline:
+    // the token vector stays small however large the text is
+    constexpr size_t CHUNK_SIZE = 64 * 1024;
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = std::min(text.size(), pos + CHUNK_SIZE);
+        if (end < text.size()) {
+            size_t newline = text.rfind('\n', end - 1);
+            if (newline != std::string_view::npos && newline >= pos) {
+                end = newline + 1;
+            }
+        }
+        count += encoding_->encode(std::string(text.substr(pos, end - pos))).size();
+        pos = end;
+    }
+    return count;
 #else
     // Fallback implementation if tiktoken is not available
     // Use a more efficient approximation method
     
-    // Cache these values to avoid repeated calls
-    static const size_t AVG_CHARS_PER_TOKEN = 4; // Average characters per token
-    
     // Quick estimate for empty or very short texts
     if (text.empty()) {
         return 0;
@@ -95,39 +106,9 @@ size_t Tokenizer::countTokens(const std::string& text) const {
         return 1;
     }
     
-    // Count tokens based on word boundaries and special characters
-    size_t tokenCount = 0;
-    bool inWord = false;
-    size_t currentWordLength = 0;
-    
-    for (const char c : text) {
-        if (std::isspace(c) || c == '.' || c == ',' || c == '!' || c == '?' || 
-            c == ':' || c == ';' || c == '(' || c == ')' || c == '[' || c == ']' || 
-            c == '{' || c == '}' || c == '"' || c == '\'' || c == '`') {
-            
-            if (inWord) {
-                // End of a word - add tokens based on word length
-                tokenCount += (currentWordLength + AVG_CHARS_PER_TOKEN - 1) / AVG_CHARS_PER_TOKEN;
-                inWord = false;
-                currentWordLength = 0;
-            }
-            
-            // Count separators and punctuation as potential tokens
-            if (!std::isspace(c)) {
-                tokenCount += 1;
-            }
-        } else {
-            if (!inWord) {
-                inWord = true;
-            }
-            currentWordLength++;
-        }
-    }
-    
-    // Handle the last word if the text doesn't end with a delimiter
-    if (inWord) {
-        tokenCount += (currentWordLength + AVG_CHARS_PER_TOKEN - 1) / AVG_CHARS_PER_TOKEN;
-    }
+    // Words and punctuation are classified by the vectorized TextScanner
+    // kernel: ceil(length / 4) tokens per word, one per punctuation mark
+    size_t tokenCount = TextScanner::scan(text).estimatedTokens;
     
     // Add a small overhead for special cases
     return std::max(tokenCount, static_cast<size_t>(1));
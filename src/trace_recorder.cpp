@@ -0,0 +1,187 @@
+#include "trace_recorder.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+std::atomic<uint64_t> nextRecorderId{1};
+
+// Recorder bound to this thread, and this thread's buffer in the last recorder used
+thread_local TraceRecorder* boundRecorder = nullptr;
+thread_local uint64_t cachedRecorderId = 0;
+thread_local void* cachedBuffer = nullptr;
+thread_local std::string threadName;
+
+void writeMicros(std::ostream& out, int64_t nanos) {
+    out << nanos / 1000 << '.' << std::setw(3) << std::setfill('0') << nanos % 1000 << std::setfill(' ');
+}
+
+// JSON string literal; paths that are not valid UTF-8 get replacement characters
+std::string quoted(const std::string& text) {
+    return nlohmann::json(text).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+}  // namespace
+
+TraceRecorder::TraceRecorder()
+    : id_(nextRecorderId.fetch_add(1, std::memory_order_relaxed)),
+      origin_(Clock::now()),
+      owner_(std::this_thread::get_id()) {}
+
+TraceRecorder::ThreadScope::ThreadScope(TraceRecorder* recorder) : previous_(boundRecorder) {
+    boundRecorder = recorder;
+}
+
+TraceRecorder::ThreadScope::~ThreadScope() {
+    boundRecorder = previous_;
+}
+
+TraceRecorder::Span::Span(const char* name, const char* category, const fs::path* detail)
+    : recorder_(boundRecorder), name_(name), category_(category), detail_(detail) {
+    if (recorder_) {
+        start_ = Clock::now();
+    }
+}
+
+TraceRecorder::Span::~Span() {
+    if (recorder_) {
+        recorder_->complete(name_, category_, start_, Clock::now(), detail_ ? detail_->string() : std::string());
+    }
+}
+
+TraceRecorder* TraceRecorder::current() {
+    return boundRecorder;
+}
+
+void TraceRecorder::setThreadName(std::string name) {
+    threadName = std::move(name);
+}
+
+/**
+ * @brief Returns the calling thread's buffer, creating it on first use
+ *
+ * @return ThreadBuffer& Buffer only this thread appends to
+ */
+TraceRecorder::ThreadBuffer& TraceRecorder::buffer() {
+    if (cachedRecorderId == id_) {
+        return *static_cast<ThreadBuffer*>(cachedBuffer);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::thread::id self = std::this_thread::get_id();
+    auto& slot = buffers_[self];
+    if (!slot) {
+        slot = std::make_unique<ThreadBuffer>();
+        slot->tid = static_cast<uint32_t>(buffers_.size());
+        if (!threadName.empty()) {
+            slot->name = threadName;
+        } else if (self == owner_) {
+            slot->name = "main";
+        } else {
+            slot->name = "thread " + std::to_string(slot->tid);
+        }
+    }
+    cachedRecorderId = id_;
+    cachedBuffer = slot.get();
+    return *slot;
+}
+
+/**
+ * @brief Adds one complete event on the calling thread's track
+ *
+ * @param name Event name shown on the slice
+ * @param category Comma-separated categories, for filtering in the viewer
+ * @param start Start of the event
+ * @param end End of the event
+ * @param detail Shown as the "detail" argument when not empty (usually a path)
+ */
+void TraceRecorder::complete(const char* name, const char* category, Clock::time_point start, Clock::time_point end,
+                             std::string detail) {
+    ThreadBuffer& own = buffer();
+    Event event{name, category,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin_).count(),
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+                std::move(detail)};
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.events.push_back(std::move(event));
+}
+
+size_t TraceRecorder::eventCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& entry : buffers_) {
+        std::lock_guard<std::mutex> bufferLock(entry.second->mutex);
+        count += entry.second->events.size();
+    }
+    return count;
+}
+
+/**
+ * @brief Writes the trace as a JSON object in the trace-event format
+ *
+ * @param out Destination stream
+ *
+ * Threads become tracks named by "thread_name" metadata events, ordered by
+ * their first event. Timestamps are microseconds since the recorder was created.
+ */
+void TraceRecorder::write(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<const ThreadBuffer*> threads;
+    threads.reserve(buffers_.size());
+    for (const auto& entry : buffers_) {
+        threads.push_back(entry.second.get());
+    }
+    std::sort(threads.begin(), threads.end(),
+              [](const ThreadBuffer* a, const ThreadBuffer* b) { return a->tid < b->tid; });
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&out, &first]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    for (const ThreadBuffer* thread : threads) {
+        std::lock_guard<std::mutex> bufferLock(thread->mutex);
+        separator();
+        out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread->tid
+            << ",\"args\":{\"name\":" << quoted(thread->name) << "}}";
+        separator();
+        out << "{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":1,\"tid\":" << thread->tid
+            << ",\"args\":{\"sort_index\":" << thread->tid << "}}";
+
+        for (const Event& event : thread->events) {
+            separator();
+            out << "{\"ph\":\"X\",\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+                << "\",\"pid\":1,\"tid\":" << thread->tid << ",\"ts\":";
+            writeMicros(out, event.startNanos);
+            out << ",\"dur\":";
+            writeMicros(out, event.durationNanos);
+            if (!event.detail.empty()) {
+                out << ",\"args\":{\"detail\":" << quoted(event.detail) << '}';
+            }
+            out << '}';
+        }
+    }
+    out << "\n]}\n";
+}
+
+/**
+ * @brief Writes the trace to a file
+ *
+ * @param path Destination, replaced if it exists
+ * @throws std::runtime_error if the file cannot be written
+ */
+void TraceRecorder::writeFile(const fs::path& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (file) {
+        write(file);
+    }
+    if (!file) {
+        throw std::runtime_error("Cannot write trace file " + path.string());
+    }
+}
@@ -0,0 +1,792 @@
+#include "virtual_file_system.hpp"
+#include "repo_mirror.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+extern char** environ;
+
+namespace {
+
+constexpr size_t TAR_BLOCK = 512;
+
+// Output allocated up front from a size the archive declares; more is
+// allocated as inflation actually produces it
+constexpr size_t MAX_SIZE_HINT = 1 << 20;
+
+// A gzip-compressed tar may always inflate to this much, whatever its ratio
+constexpr size_t MIN_INFLATED_LIMIT = 1 << 20;
+
+uint16_t read16(std::string_view data, size_t pos) {
+    return static_cast<uint16_t>(static_cast<unsigned char>(data[pos]) |
+                                 static_cast<unsigned char>(data[pos + 1]) << 8);
+}
+
+uint32_t read32(std::string_view data, size_t pos) {
+    return static_cast<uint32_t>(read16(data, pos)) | static_cast<uint32_t>(read16(data, pos + 2)) << 16;
+}
+
+// A NUL-terminated field of a tar header
+std::string_view tarField(std::string_view header, size_t offset, size_t length) {
+    std::string_view field = header.substr(offset, length);
+    return field.substr(0, field.find('\0'));
+}
+
+// Octal number of a tar header, or base-256 if the top bit of the first byte is set
+uint64_t tarNumber(std::string_view field) {
+    uint64_t value = 0;
+    if (!field.empty() && (static_cast<unsigned char>(field[0]) & 0x80)) {
+        value = static_cast<unsigned char>(field[0]) & 0x7f;
+        for (size_t i = 1; i < field.size(); ++i) {
+            value = value << 8 | static_cast<unsigned char>(field[i]);
+        }
+        return value;
+    }
+    size_t i = 0;
+    while (i < field.size() && field[i] == ' ') {
+        ++i;
+    }
+    for (; i < field.size() && field[i] >= '0' && field[i] <= '7'; ++i) {
+        value = value * 8 + static_cast<uint64_t>(field[i] - '0');
+    }
+    return value;
+}
+
+// Whether a block is a tar header: its checksum counts the checksum field as spaces
+bool isTarHeader(std::string_view block) {
+    if (block.size() < TAR_BLOCK) {
+        return false;
+    }
+    uint64_t unsignedSum = 0;
+    int64_t signedSum = 0;
+    for (size_t i = 0; i < TAR_BLOCK; ++i) {
+        const bool inChecksum = i >= 148 && i < 156;
+        unsignedSum += inChecksum ? ' ' : static_cast<unsigned char>(block[i]);
+        signedSum += inChecksum ? ' ' : static_cast<signed char>(block[i]);
+    }
+    const uint64_t stored = tarNumber(block.substr(148, 8));
+    return stored == unsignedSum || static_cast<int64_t>(stored) == signedSum;
+}
+
+// Modification time of a zip member, stored as MS-DOS local date and time
+std::time_t dosTime(uint16_t date, uint16_t time) {
+    std::tm tm{};
+    tm.tm_sec = (time & 0x1f) * 2;
+    tm.tm_min = (time >> 5) & 0x3f;
+    tm.tm_hour = time >> 11;
+    tm.tm_mday = date & 0x1f;
+    tm.tm_mon = ((date >> 5) & 0x0f) - 1;
+    tm.tm_year = (date >> 9) + 80;
+    return tm.tm_mday == 0 ? 0 : timegm(&tm);
+}
+
+#ifdef USE_ZLIB
+// Inflates a raw deflate stream (zip members) or a gzip file. sizeHint comes
+// from the archive and is only trusted up to MAX_SIZE_HINT; inflation stops
+// with an error as soon as the output exceeds maxSize.
+std::string inflateBytes(std::string_view input, size_t sizeHint, size_t maxSize, bool gzip) {
+    z_stream stream{};
+    if (inflateInit2(&stream, gzip ? 16 + MAX_WBITS : -MAX_WBITS) != Z_OK) {
+        throw std::runtime_error("Failed to initialize zlib");
+    }
+    // One byte past maxSize, so a stream that is too long is noticed
+    const size_t capacity = maxSize < SIZE_MAX ? maxSize + 1 : maxSize;
+    std::string output;
+    output.resize(std::min(std::max<size_t>(std::min(sizeHint, MAX_SIZE_HINT), 4096), capacity));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    int status = Z_OK;
+    while (status != Z_STREAM_END) {
+        if (stream.total_out == output.size()) {
+            if (output.size() > maxSize) {
+                inflateEnd(&stream);
+                throw std::runtime_error("Compressed data inflates past its limit");
+            }
+            output.resize(std::min(output.size() * 2, capacity));
+        }
+        stream.next_out = reinterpret_cast<Bytef*>(&output[stream.total_out]);
+        stream.avail_out = static_cast<uInt>(std::min<size_t>(output.size() - stream.total_out, UINT_MAX));
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END) {
+            inflateEnd(&stream);
+            throw std::runtime_error("Corrupt compressed data");
+        }
+        if (status == Z_OK && stream.avail_in == 0 && stream.avail_out != 0) {
+            inflateEnd(&stream);
+            throw std::runtime_error("Truncated compressed data");
+        }
+    }
+    if (stream.total_out > maxSize) {
+        inflateEnd(&stream);
+        throw std::runtime_error("Compressed data inflates past its limit");
+    }
+    output.resize(stream.total_out);
+    inflateEnd(&stream);
+    return output;
+}
+#endif
+
+// Runs a shell command; returns false on a non-zero exit
+bool runCommand(const std::string& cmd, std::string& output) {
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) {
+        return false;
+    }
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        output.append(buffer, n);
+    }
+    int status = pclose(pipe);
+    return status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+}  // namespace
+
+/**
+ * @brief Lists the files of the tree
+ *
+ * @return const std::vector<Entry>& Every regular file, sorted by path
+ */
+const std::vector<VirtualFileSystem::Entry>& VirtualFileSystem::entries() const {
+    sortEntries();
+    return entries_;
+}
+
+/**
+ * @brief Looks up a file
+ *
+ * @param path Path below root()
+ * @return const Entry* The file's entry, or nullptr if there is none
+ */
+const VirtualFileSystem::Entry* VirtualFileSystem::find(const fs::path& path) const {
+    sortEntries();
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), path,
+        [](const Entry& entry, const fs::path& target) {
+            return entry.path < target;
+        });
+    return it != entries_.end() && it->path == path ? &*it : nullptr;
+}
+
+/**
+ * @brief Reads a whole file
+ *
+ * @param path Path below root()
+ * @return FileContent The file's bytes
+ * @throws std::runtime_error if there is no such file or it cannot be read
+ */
+FileContent VirtualFileSystem::read(const fs::path& path) const {
+    const Entry* entry = find(path);
+    if (!entry) {
+        throw std::runtime_error("No such file: " + path.string());
+    }
+    return readEntry(*entry);
+}
+
+/**
+ * @brief Adds a file to the index
+ *
+ * @param relPath Path inside the tree, '/'-separated
+ * @param size Size of the file's content
+ * @param modifiedTime Modification time, or 0
+ * @param slot Implementation-defined location of the bytes
+ * @return bool False, and nothing added, for directories, absolute paths and
+ *         paths that leave the tree ("../x")
+ */
+bool VirtualFileSystem::addEntry(const std::string& relPath, size_t size, std::time_t modifiedTime, size_t slot) {
+    const fs::path rel = fs::path(relPath).lexically_normal();
+    if (rel.empty() || rel.has_root_path() || !rel.has_filename() || rel == ".") {
+        return false;
+    }
+    for (const auto& part : rel) {
+        if (part == "..") {
+            return false;
+        }
+    }
+
+    Entry entry{root_ / rel, size, modifiedTime, slot};
+    if (!entries_.empty() && !(entries_.back().path < entry.path)) {
+        sorted_ = false;
+    }
+    entries_.push_back(std::move(entry));
+    return true;
+}
+
+/**
+ * @brief Sorts the index by path once all files are added
+ *
+ * A path added more than once (an appended tar, a replaced upload) keeps its
+ * last version. Nothing happens if the files were added in order or the index
+ * is already sorted, so readers on several threads may all call it.
+ */
+void VirtualFileSystem::sortEntries() const {
+    if (sorted_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(sortMutex_);
+    if (sorted_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::stable_sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+        return a.path < b.path;
+    });
+
+    std::vector<Entry> unique;
+    unique.reserve(entries_.size());
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (i + 1 < entries_.size() && entries_[i + 1].path == entries_[i].path) {
+            continue;
+        }
+        unique.push_back(std::move(entries_[i]));
+    }
+    entries_ = std::move(unique);
+    sorted_.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Adds a file held in memory
+ *
+ * @param relPath Path below root()
+ * @param content The file's bytes, shared rather than copied
+ * @param modifiedTime Modification time, or 0 if unknown
+ * @return bool False if the path is not a file path inside the tree
+ */
+bool MemoryFileSystem::add(const std::string& relPath, FileContent content, std::time_t modifiedTime) {
+    if (!addEntry(relPath, content.size(), modifiedTime, contents_.size())) {
+        return false;
+    }
+    contents_.push_back(std::move(content));
+    return true;
+}
+
+FileContent MemoryFileSystem::readEntry(const Entry& entry) const {
+    return contents_[entry.slot];
+}
+
+/**
+ * @brief Indexes a zip, tar or .tar.gz archive
+ *
+ * @param archive The archive's bytes; members are slices of them
+ * @param root Directory the members appear under
+ * @param maxExpansion How many times its own size a gzip-compressed tar may
+ *        inflate to (at least 1 MB)
+ * @throws std::runtime_error if the archive is malformed, inflates past its
+ *         limit, is compressed without zlib support, or in another format
+ *
+ * A gzip-compressed tar is inflated once here, since tar has no index to
+ * seek by; zip members are only inflated when they are read, and never past
+ * the size their header declares.
+ */
+ArchiveFileSystem::ArchiveFileSystem(FileContent archive, fs::path root, size_t maxExpansion)
+    : VirtualFileSystem(std::move(root)), archive_(std::move(archive)) {
+    const std::string_view data = archive_.view();
+    if (data.substr(0, 4) == std::string_view("PK\x03\x04", 4) || data.substr(0, 4) == std::string_view("PK\x05\x06", 4)) {
+        indexZip();
+    } else if (data.substr(0, 2) == "\x1f\x8b") {
+#ifdef USE_ZLIB
+        const size_t sizeHint = data.size() >= 4 ? read32(data, data.size() - 4) : 0;
+        const size_t maxSize = data.size() > SIZE_MAX / maxExpansion
+            ? SIZE_MAX : std::max(data.size() * maxExpansion, MIN_INFLATED_LIMIT);
+        archive_ = FileContent(inflateBytes(data, sizeHint, maxSize, true));
+        indexTar();
+#else
+        throw std::runtime_error("Compressed archives need zlib support");
+#endif
+    } else if (isTarHeader(data.substr(0, TAR_BLOCK))) {
+        indexTar();
+    } else {
+        throw std::runtime_error("Unsupported archive format");
+    }
+    sortEntries();
+}
+
+/**
+ * @brief Recognizes archives by their first bytes
+ *
+ * @param data Start of a file (at least one 512-byte block for tar)
+ * @return bool True for zip, gzip and tar signatures
+ */
+bool ArchiveFileSystem::isArchive(std::string_view data) {
+    return data.substr(0, 4) == std::string_view("PK\x03\x04", 4) ||
+           data.substr(0, 4) == std::string_view("PK\x05\x06", 4) ||
+           data.substr(0, 2) == "\x1f\x8b" ||
+           isTarHeader(data.substr(0, TAR_BLOCK));
+}
+
+bool ArchiveFileSystem::supportsCompression() {
+#ifdef USE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Indexes the members of a zip archive from its central directory
+ *
+ * @throws std::runtime_error for truncated or ZIP64 archives
+ *
+ * Directories, encrypted members and compression methods other than stored
+ * and deflate are left out.
+ */
+void ArchiveFileSystem::indexZip() {
+    const std::string_view data = archive_.view();
+    constexpr size_t EOCD_SIZE = 22;
+    if (data.size() < EOCD_SIZE) {
+        throw std::runtime_error("Truncated zip archive");
+    }
+
+    // The end record is followed by a comment of at most 64 KiB
+    size_t eocd = std::string_view::npos;
+    const size_t lowest = data.size() > EOCD_SIZE + 0xffff ? data.size() - EOCD_SIZE - 0xffff : 0;
+    for (size_t pos = data.size() - EOCD_SIZE + 1; pos-- > lowest;) {
+        if (read32(data, pos) == 0x06054b50) {
+            eocd = pos;
+            break;
+        }
+    }
+    if (eocd == std::string_view::npos) {
+        throw std::runtime_error("Zip archive without end of central directory");
+    }
+
+    const size_t count = read16(data, eocd + 10);
+    const size_t directoryOffset = read32(data, eocd + 16);
+    if (count == 0xffff || directoryOffset == 0xffffffff) {
+        throw std::runtime_error("ZIP64 archives are not supported");
+    }
+
+    size_t pos = directoryOffset;
+    members_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (pos + 46 > data.size() || read32(data, pos) != 0x02014b50) {
+            throw std::runtime_error("Corrupt zip central directory");
+        }
+        const uint16_t flags = read16(data, pos + 8);
+        const uint16_t method = read16(data, pos + 10);
+        const std::time_t modifiedTime = dosTime(read16(data, pos + 14), read16(data, pos + 12));
+        const size_t storedSize = read32(data, pos + 20);
+        const size_t size = read32(data, pos + 24);
+        const size_t nameLength = read16(data, pos + 28);
+        const size_t headerLength = 46 + nameLength + read16(data, pos + 30) + read16(data, pos + 32);
+        const size_t localHeader = read32(data, pos + 42);
+        if (pos + headerLength > data.size()) {
+            throw std::runtime_error("Corrupt zip central directory");
+        }
+        const std::string name(data.substr(pos + 46, nameLength));
+        pos += headerLength;
+
+        const bool encrypted = flags & 1;
+        if (name.empty() || name.back() == '/' || encrypted || (method != 0 && method != 8)) {
+            continue;
+        }
+
+        // The data follows the local header, whose extra field may differ from the central one
+        if (localHeader + 30 > data.size() || read32(data, localHeader) != 0x04034b50) {
+            throw std::runtime_error("Corrupt zip member: " + name);
+        }
+        const size_t offset = localHeader + 30 + read16(data, localHeader + 26) + read16(data, localHeader + 28);
+        if (offset > data.size() || storedSize > data.size() - offset || (method == 0 && storedSize != size)) {
+            throw std::runtime_error("Corrupt zip member: " + name);
+        }
+
+        if (addEntry(name, size, modifiedTime, members_.size())) {
+            members_.push_back({offset, storedSize, method == 8});
+        }
+    }
+}
+
+/**
+ * @brief Indexes the members of a tar archive
+ *
+ * @throws std::runtime_error for corrupt headers and truncated members
+ *
+ * Understands ustar name prefixes, GNU long names and the path and size
+ * records of pax headers. Only regular files are indexed.
+ */
+void ArchiveFileSystem::indexTar() {
+    const std::string_view data = archive_.view();
+    std::string longName;                           // From a GNU 'L' or pax header
+    uint64_t paxSize = 0;
+    bool hasPaxSize = false;
+
+    size_t pos = 0;
+    while (pos + TAR_BLOCK <= data.size()) {
+        const std::string_view header = data.substr(pos, TAR_BLOCK);
+        if (header.find_first_not_of('\0') == std::string_view::npos) {
+            break;
+        }
+        if (!isTarHeader(header)) {
+            throw std::runtime_error("Corrupt tar header at offset " + std::to_string(pos));
+        }
+
+        const char type = header[156];
+        const bool meta = type == 'L' || type == 'x' || type == 'g';
+        const uint64_t size = !meta && hasPaxSize ? paxSize : tarNumber(header.substr(124, 12));
+        const size_t offset = pos + TAR_BLOCK;
+        if (size > data.size() - offset) {
+            throw std::runtime_error("Truncated tar archive");
+        }
+        const std::string_view body = data.substr(offset, static_cast<size_t>(size));
+        pos = offset + (static_cast<size_t>(size) + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+
+        if (type == 'L') {
+            longName.assign(body.substr(0, body.find('\0')));
+            continue;
+        }
+        if (type == 'x') {
+            // Records of the form "<length> <key>=<value>\n"
+            for (size_t record = 0; record < body.size();) {
+                const size_t space = body.find(' ', record);
+                const size_t length = space == std::string_view::npos ? 0 : std::strtoul(std::string(body.substr(record, space - record)).c_str(), nullptr, 10);
+                if (length == 0 || record + length > body.size()) {
+                    break;
+                }
+                const std::string_view field = body.substr(space + 1, record + length - space - 2);
+                const size_t equals = field.find('=');
+                if (equals != std::string_view::npos) {
+                    if (field.substr(0, equals) == "path") {
+                        longName.assign(field.substr(equals + 1));
+                    } else if (field.substr(0, equals) == "size") {
+                        paxSize = tarNumber(field.substr(equals + 1));
+                        hasPaxSize = true;
+                    }
+                }
+                record += length;
+            }
+            continue;
+        }
+        if (type == 'g') {
+            continue;
+        }
+
+        std::string name = std::move(longName);
+        longName.clear();
+        hasPaxSize = false;
+        if (name.empty()) {
+            name.assign(tarField(header, 0, 100));
+            const std::string_view prefix = tarField(header, 345, 155);
+            if (header.substr(257, 5) == "ustar" && !prefix.empty()) {
+                name = std::string(prefix) + "/" + name;
+            }
+        }
+
+        // Regular files only; directories, links and devices have no content of their own
+        if (type != '0' && type != '\0' && type != '7') {
+            continue;
+        }
+        const auto modifiedTime = static_cast<std::time_t>(tarNumber(header.substr(136, 12)));
+        if (addEntry(name, static_cast<size_t>(size), modifiedTime, members_.size())) {
+            members_.push_back({offset, static_cast<size_t>(size), false});
+        }
+    }
+}
+
+FileContent ArchiveFileSystem::readEntry(const Entry& entry) const {
+    const Member& member = members_[entry.slot];
+    if (!member.deflated) {
+        return archive_.slice(member.offset, member.storedSize);
+    }
+#ifdef USE_ZLIB
+    std::string inflated = inflateBytes(archive_.view().substr(member.offset, member.storedSize),
+                                        entry.size, entry.size, false);
+    if (inflated.size() != entry.size) {
+        throw std::runtime_error("Corrupt zip member: " + entry.path.string());
+    }
+    return FileContent(std::move(inflated));
+#else
+    throw std::runtime_error("Compressed zip members need zlib support: " + entry.path.string());
+#endif
+}
+
+/**
+ * @brief Lists the files of a commit
+ *
+ * @param repoDir Repository holding the objects, bare or not
+ * @param revision Commit (or tree-ish) to read
+ * @param root Directory the files appear under
+ * @throws std::runtime_error if git cannot list the tree
+ *
+ * Every file gets the commit time as its modification time. Symbolic links
+ * and submodules are left out.
+ */
+GitObjectFileSystem::GitObjectFileSystem(const fs::path& repoDir, const std::string& revision, fs::path root,
+                                         size_t maxProcesses)
+    : VirtualFileSystem(std::move(root)), repoDir_(repoDir), maxProcesses_(std::max<size_t>(maxProcesses, 1)) {
+    const std::string git = "git -C " + RepoMirror::shellQuote(repoDir.string()) + " ";
+    std::string tree;
+    if (!runCommand(git + "ls-tree -r -l -z " + RepoMirror::shellQuote(revision), tree)) {
+        throw std::runtime_error("Failed to list " + revision + " in " + repoDir.string());
+    }
+
+    std::string commitTime;
+    std::time_t modifiedTime = 0;
+    if (runCommand(git + "log -1 --format=%ct " + RepoMirror::shellQuote(revision) + " 2>/dev/null", commitTime)) {
+        modifiedTime = static_cast<std::time_t>(std::strtoll(commitTime.c_str(), nullptr, 10));
+    }
+
+    for (auto& blob : parseTree(tree)) {
+        if (addEntry(blob.path, blob.size, modifiedTime, objectIds_.size())) {
+            objectIds_.push_back(std::move(blob.objectId));
+        }
+    }
+    sortEntries();
+}
+
+GitObjectFileSystem::~GitObjectFileSystem() {
+    for (auto& batch : idleBatches_) {
+        stopBatch(*batch);
+    }
+}
+
+/**
+ * @brief Parses the output of `git ls-tree -r -l -z`
+ *
+ * @param output Records of the form "<mode> <type> <object> <size>\t<path>\0"
+ * @return std::vector<Blob> Regular files, in listing order
+ */
+std::vector<GitObjectFileSystem::Blob> GitObjectFileSystem::parseTree(std::string_view output) {
+    std::vector<Blob> blobs;
+    size_t pos = 0;
+    while (pos < output.size()) {
+        size_t end = output.find('\0', pos);
+        if (end == std::string_view::npos) {
+            end = output.size();
+        }
+        const std::string_view record = output.substr(pos, end - pos);
+        pos = end + 1;
+
+        const size_t tab = record.find('\t');
+        if (tab == std::string_view::npos) {
+            continue;
+        }
+        const std::string_view meta = record.substr(0, tab);
+        const size_t typeStart = meta.find(' ');
+        const size_t objectStart = typeStart == std::string_view::npos ? typeStart : meta.find(' ', typeStart + 1);
+        if (objectStart == std::string_view::npos) {
+            continue;
+        }
+        const std::string_view mode = meta.substr(0, typeStart);
+        const std::string_view type = meta.substr(typeStart + 1, objectStart - typeStart - 1);
+        if (type != "blob" || mode == "120000") {
+            continue;
+        }
+
+        // The size column is right-aligned
+        const size_t objectEnd = meta.find(' ', objectStart + 1);
+        Blob blob;
+        blob.objectId.assign(meta.substr(objectStart + 1, objectEnd - objectStart - 1));
+        blob.size = objectEnd == std::string_view::npos ? 0 :
+            static_cast<size_t>(std::strtoull(std::string(meta.substr(objectEnd)).c_str(), nullptr, 10));
+        blob.path.assign(record.substr(tab + 1));
+        blobs.push_back(std::move(blob));
+    }
+    return blobs;
+}
+
+/**
+ * @brief Starts `git cat-file --batch` on one end of a socket pair
+ *
+ * @return std::unique_ptr<BatchProcess> The running process
+ * @throws std::runtime_error if the process cannot be started
+ *
+ * posix_spawnp rather than fork and exec: the server has many threads, and
+ * nothing but the spawn's own file actions runs in the child.
+ */
+std::unique_ptr<GitObjectFileSystem::BatchProcess> GitObjectFileSystem::startBatch() const {
+    int sockets[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+        throw std::runtime_error(std::string("Failed to create socket pair: ") + std::strerror(errno));
+    }
+
+    std::string repo = repoDir_.string();
+    char gitArg[] = "git";
+    char dirArg[] = "-C";
+    char catFileArg[] = "cat-file";
+    char batchArg[] = "--batch";
+    char* argv[] = {gitArg, dirArg, &repo[0], catFileArg, batchArg, nullptr};
+
+    // dup2 clears close-on-exec on the child's stdin and stdout only
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, sockets[1], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, sockets[1], STDOUT_FILENO);
+    pid_t pid = -1;
+    const int status = ::posix_spawnp(&pid, "git", &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(sockets[1]);
+    if (status != 0) {
+        ::close(sockets[0]);
+        throw std::runtime_error(std::string("Failed to start git: ") + std::strerror(status));
+    }
+
+    auto batch = std::make_unique<BatchProcess>();
+    batch->pid = pid;
+    batch->fd = sockets[0];
+    return batch;
+}
+
+/**
+ * @brief Ends a cat-file process; it exits at end of input
+ *
+ * @param batch Process to end
+ */
+void GitObjectFileSystem::stopBatch(BatchProcess& batch) {
+    if (batch.fd >= 0) {
+        ::close(batch.fd);
+        batch.fd = -1;
+    }
+    if (batch.pid > 0) {
+        ::waitpid(batch.pid, nullptr, 0);
+        batch.pid = -1;
+    }
+    batch.buffer.clear();
+}
+
+/**
+ * @brief Takes an idle cat-file process, or starts one
+ *
+ * @return std::unique_ptr<BatchProcess> Process for one read; hand it back
+ *         with releaseBatch
+ * @throws std::runtime_error if a new process cannot be started
+ *
+ * Waits only when maxProcesses_ reads are already running.
+ */
+std::unique_ptr<GitObjectFileSystem::BatchProcess> GitObjectFileSystem::acquireBatch() const {
+    std::unique_lock<std::mutex> lock(batchMutex_);
+    batchAvailable_.wait(lock, [this]() { return !idleBatches_.empty() || runningBatches_ < maxProcesses_; });
+    if (!idleBatches_.empty()) {
+        auto batch = std::move(idleBatches_.back());
+        idleBatches_.pop_back();
+        return batch;
+    }
+    ++runningBatches_;
+    lock.unlock();
+
+    try {
+        return startBatch();
+    } catch (...) {
+        releaseBatch(nullptr);
+        throw;
+    }
+}
+
+/**
+ * @brief Returns a process after a read
+ *
+ * @param batch The process, or nullptr if it failed and was stopped
+ */
+void GitObjectFileSystem::releaseBatch(std::unique_ptr<BatchProcess> batch) const {
+    {
+        std::lock_guard<std::mutex> lock(batchMutex_);
+        if (batch) {
+            idleBatches_.push_back(std::move(batch));
+        } else {
+            --runningBatches_;
+        }
+    }
+    batchAvailable_.notify_one();
+}
+
+/**
+ * @brief Reads one blob through the cat-file process
+ *
+ * @param entry File to read
+ * @return FileContent The blob
+ * @throws std::runtime_error if the object is missing or git exits; the
+ *         process is stopped and a later read starts a fresh one
+ *
+ * Reads from several threads use different processes and run in parallel.
+ */
+FileContent GitObjectFileSystem::readEntry(const Entry& entry) const {
+    auto batch = acquireBatch();
+    try {
+        std::string content = readBlob(*batch, objectIds_[entry.slot]);
+        releaseBatch(std::move(batch));
+        return FileContent(std::move(content));
+    } catch (const std::exception& e) {
+        stopBatch(*batch);
+        releaseBatch(nullptr);
+        throw std::runtime_error("Failed to read " + entry.path.string() + " from git: " + e.what());
+    }
+}
+
+/**
+ * @brief Requests one object from a cat-file process and receives it
+ *
+ * @param batch Process to ask
+ * @param objectId Object to read
+ * @return std::string The blob's bytes
+ * @throws std::runtime_error if the object is missing or git exits
+ */
+std::string GitObjectFileSystem::readBlob(BatchProcess& batch, const std::string& objectId) {
+    // Appends at least one more chunk of output to the buffer
+    auto receive = [&batch]() {
+        char chunk[65536];
+        ssize_t n;
+        do {
+            n = ::recv(batch.fd, chunk, sizeof(chunk), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            throw std::runtime_error("git cat-file exited");
+        }
+        batch.buffer.append(chunk, static_cast<size_t>(n));
+    };
+
+    const std::string request = objectId + "\n";
+    for (size_t sent = 0; sent < request.size();) {
+        const ssize_t n = ::send(batch.fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("git cat-file exited");
+        }
+        sent += static_cast<size_t>(n);
+    }
+
+    // "<object> blob <size>\n" or "<object> missing\n"
+    size_t newline;
+    while ((newline = batch.buffer.find('\n')) == std::string::npos) {
+        receive();
+    }
+    const std::string header = batch.buffer.substr(0, newline);
+    batch.buffer.erase(0, newline + 1);
+    const size_t sizeStart = header.rfind(' ');
+    if (header.find(" blob ") == std::string::npos || sizeStart == std::string::npos) {
+        throw std::runtime_error(header);
+    }
+    const size_t size = static_cast<size_t>(std::strtoull(header.c_str() + sizeStart + 1, nullptr, 10));
+
+    // The blob and a newline; once the buffer is drained the rest is received in place
+    std::string content(size, '\0');
+    size_t filled = std::min(size, batch.buffer.size());
+    batch.buffer.copy(&content[0], filled);
+    batch.buffer.erase(0, filled);
+    while (filled < size) {
+        const ssize_t n = ::recv(batch.fd, &content[filled], size - filled, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("git cat-file exited");
+        }
+        filled += static_cast<size_t>(n);
+    }
+    while (batch.buffer.empty()) {
+        receive();
+    }
+    batch.buffer.erase(0, 1);
+    return content;
+}
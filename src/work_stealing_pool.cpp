@@ -0,0 +1,279 @@
+#include "work_stealing_pool.hpp"
+#include "metrics.hpp"
+#include "trace_recorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+namespace {
+
+// Identifies the pool and worker slot the current thread belongs to
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local unsigned int currentIndex = 0;
+
+}  // namespace
+
+/**
+ * @brief Constructs the pool and starts its worker threads
+ *
+ * @param numThreads Number of workers to start. If 0, defaults to 1 worker
+ *
+ * If the system refuses to create threads, the pool keeps the worker slots it
+ * asked for and wait() runs the queued tasks on the calling thread instead.
+ */
+WorkStealingPool::WorkStealingPool(unsigned int numThreads) {
+    const unsigned int count = numThreads == 0 ? 1 : numThreads;
+    queues_.reserve(count);
+    for (unsigned int i = 0; i < count; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    for (unsigned int i = 0; i < count; ++i) {
+        try {
+            threads_.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        } catch (const std::system_error& e) {
+            std::cerr << "Warning: Could not create worker thread: " << e.what() << std::endl;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Drains remaining tasks and joins all worker threads
+ */
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+/**
+ * @brief Queues a task for execution
+ *
+ * @param task Callable receiving the index of the worker that runs it
+ *
+ * Tasks submitted by a worker of this pool go onto that worker's own deque;
+ * tasks from other threads are spread round-robin across the deques. A trace
+ * recorder bound to the submitting thread stays bound while the task runs.
+ */
+void WorkStealingPool::submit(Task task) {
+    if (TraceRecorder* trace = TraceRecorder::current()) {
+        task = [trace, inner = std::move(task)](unsigned int workerIndex) {
+            TraceRecorder::ThreadScope scope(trace);
+            inner(workerIndex);
+        };
+    }
+
+    const unsigned int index = (currentPool == this)
+        ? currentIndex
+        : nextQueue_.fetch_add(1, std::memory_order_relaxed) % size();
+
+    // Count the task before publishing it so the counters never run negative
+    pendingTasks_.fetch_add(1);
+    queuedTasks_.fetch_add(1);
+    Metrics::instance().adjust(Metrics::Gauge::PoolQueuedTasks, 1);
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+
+    // Only pay for the wakeup when somebody is actually asleep
+    if (sleepingWorkers_.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        workAvailable_.notify_one();
+    }
+}
+
+/**
+ * @brief Waits until all submitted tasks have completed
+ *
+ * When no worker thread could be started, the calling thread executes the
+ * queued tasks itself.
+ */
+void WorkStealingPool::wait() {
+    if (threads_.empty()) {
+        const WorkStealingPool* previousPool = currentPool;
+        const unsigned int previousIndex = currentIndex;
+        currentPool = this;
+        currentIndex = 0;
+
+        Task task;
+        while (tryPop(0, task) || trySteal(0, task)) {
+            runTask(task, 0);
+        }
+
+        currentPool = previousPool;
+        currentIndex = previousIndex;
+        return;
+    }
+
+    TraceRecorder::Span span("pool_wait", "pool");
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    allDone_.wait(lock, [this] { return pendingTasks_.load() == 0; });
+}
+
+/**
+ * @brief Runs an indexed loop across the pool and the calling thread
+ *
+ * @param count Number of iterations
+ * @param body Callable run once per index
+ *
+ * Up to size() - 1 helper tasks are queued; each, like the caller, claims the
+ * next unclaimed index until none are left. Helpers that only start after the
+ * loop is finished find nothing to claim and return, so the shared state is
+ * reference counted rather than living on the caller's stack. The caller then
+ * waits only for iterations other threads have already started.
+ */
+void WorkStealingPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    struct Loop {
+        std::function<void(size_t)> body;
+        size_t count = 0;
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t done = 0;
+        std::exception_ptr error;
+
+        void run() {
+            for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                std::exception_ptr failure;
+                try {
+                    body(i);
+                } catch (...) {
+                    failure = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (failure && !error) {
+                    error = failure;
+                }
+                if (++done == count) {
+                    finished.notify_all();
+                }
+            }
+        }
+    };
+
+    auto loop = std::make_shared<Loop>();
+    loop->body = body;
+    loop->count = count;
+
+    const size_t helpers = std::min<size_t>(count, size()) - 1;
+    for (size_t i = 0; i < helpers; ++i) {
+        submit([loop](unsigned int) { loop->run(); });
+    }
+    loop->run();
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->finished.wait(lock, [&loop] { return loop->done == loop->count; });
+    if (loop->error) {
+        std::rethrow_exception(loop->error);
+    }
+}
+
+/**
+ * @brief Main loop of a worker thread
+ *
+ * @param index Worker slot owned by this thread
+ */
+void WorkStealingPool::workerLoop(unsigned int index) {
+    currentPool = this;
+    currentIndex = index;
+    TraceRecorder::setThreadName("worker " + std::to_string(index));
+
+    while (true) {
+        Task task;
+        if (tryPop(index, task) || trySteal(index, task)) {
+            runTask(task, index);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleepingWorkers_.fetch_add(1);
+        const auto sleepStart = std::chrono::steady_clock::now();
+        workAvailable_.wait(lock, [this] {
+            return stopping_.load() || queuedTasks_.load() > 0;
+        });
+        sleepingWorkers_.fetch_sub(1);
+        Metrics::instance().add(Metrics::Counter::WorkerIdleNanos, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sleepStart).count()));
+
+        if (stopping_.load() && queuedTasks_.load() == 0) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Pops the most recently pushed task from a worker's own deque
+ */
+bool WorkStealingPool::tryPop(unsigned int index, Task& task) {
+    auto& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    queuedTasks_.fetch_sub(1);
+    Metrics::instance().adjust(Metrics::Gauge::PoolQueuedTasks, -1);
+    return true;
+}
+
+/**
+ * @brief Steals the oldest task from another worker's deque
+ */
+bool WorkStealingPool::trySteal(unsigned int thief, Task& task) {
+    const unsigned int count = size();
+    for (unsigned int offset = 1; offset < count; ++offset) {
+        auto& queue = *queues_[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        queuedTasks_.fetch_sub(1);
+        Metrics::instance().adjust(Metrics::Gauge::PoolQueuedTasks, -1);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Runs a task and signals waiters when it was the last one outstanding
+ */
+void WorkStealingPool::runTask(Task& task, unsigned int index) {
+    Metrics& metrics = Metrics::instance();
+    metrics.adjust(Metrics::Gauge::PoolBusyWorkers, 1);
+    try {
+        task(index);
+    } catch (const std::exception& e) {
+        std::cerr << "Error in worker task: " << e.what() << std::endl;
+    }
+    task = nullptr;
+    metrics.adjust(Metrics::Gauge::PoolBusyWorkers, -1);
+    metrics.add(Metrics::Counter::PoolTasksRun);
+
+    if (pendingTasks_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        allDone_.notify_all();
+    }
+}
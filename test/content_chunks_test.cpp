@@ -0,0 +1,62 @@
+#include <catch2/catch_test_macros.hpp>
+#include "content_chunks.hpp"
+#include <algorithm>
+#include <string>
+
+TEST_CASE("splitIntoChunks covers the buffer with line-aligned chunks", "[ContentChunks]") {
+    std::string content;
+    for (int i = 0; i < 1000; ++i) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    
+    auto chunks = splitIntoChunks(content, 512, 64);
+    REQUIRE(chunks.size() > 1);
+    REQUIRE(chunks.front().begin == 0);
+    REQUIRE(chunks.back().end == content.size());
+    
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const ContentChunk& chunk = chunks[i];
+        if (i > 0) {
+            REQUIRE(chunk.begin == chunks[i - 1].end);
+            REQUIRE(chunk.windowBegin <= chunk.begin - std::min<size_t>(chunk.begin, 64));
+            REQUIRE(content[chunk.windowBegin - 1] == '\n');
+        } else {
+            REQUIRE(chunk.windowBegin == 0);
+        }
+        REQUIRE(content[chunk.end - 1] == '\n');
+        REQUIRE(content[chunk.windowEnd - 1] == '\n');
+        if (i + 1 < chunks.size()) {
+            REQUIRE(chunk.end - chunk.begin >= 512);
+            REQUIRE(chunk.windowEnd >= std::min(chunk.end + 64, content.size()));
+        }
+        REQUIRE(chunk.window(content).size() == chunk.windowEnd - chunk.windowBegin);
+        REQUIRE(chunk.window(content).substr(chunk.ownedBegin(), chunk.ownedEnd() - chunk.ownedBegin()) ==
+                content.substr(chunk.begin, chunk.end - chunk.begin));
+    }
+}
+
+TEST_CASE("splitIntoChunks edge cases", "[ContentChunks]") {
+    SECTION("Empty content has no chunks") {
+        REQUIRE(splitIntoChunks("", 16, 4).empty());
+    }
+    
+    SECTION("A line longer than the chunk size stays whole") {
+        std::string content = std::string(100, 'x') + "\nshort\n";
+        auto chunks = splitIntoChunks(content, 10, 0);
+        REQUIRE(chunks.size() == 2);
+        REQUIRE(chunks[0].end == 101);
+        REQUIRE(chunks[0].windowEnd == chunks[0].end);
+        REQUIRE(chunks[1].windowBegin == chunks[1].begin);
+        REQUIRE(chunks[1].end == content.size());
+    }
+    
+    SECTION("Content without a final newline ends the last chunk") {
+        auto chunks = splitIntoChunks("a\nb\nc", 2, 2);
+        REQUIRE(chunks.size() == 3);
+        REQUIRE(chunks[2].begin == 4);
+        REQUIRE(chunks[2].end == 5);
+        REQUIRE(chunks[1].windowEnd == 5);
+        REQUIRE(chunks[1].windowBegin == 0);
+        REQUIRE(chunks[2].windowBegin == 2);
+    }
+}
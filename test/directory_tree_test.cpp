@@ -0,0 +1,28 @@
+#include <catch2/catch_test_macros.hpp>
+#include "directory_tree.hpp"
+#include <string>
+
+TEST_CASE("DirectoryTree renders collected paths", "[DirectoryTree]") {
+    DirectoryTree tree;
+    tree.add("src/main.cpp");
+    tree.add("README.md");
+    tree.add("include/util/strings.hpp");
+    tree.add("src/app.cpp");
+    tree.add("./src/app.cpp");      // Same file again
+
+    REQUIRE(tree.fileCount() == 4);
+    REQUIRE(tree.render() ==
+            "📄 README.md\n"
+            "📁 include\n"
+            "  📁 util\n"
+            "    📄 strings.hpp\n"
+            "📁 src\n"
+            "  📄 app.cpp\n"
+            "  📄 main.cpp\n");
+
+    SECTION("Empty tree") {
+        DirectoryTree none;
+        REQUIRE(none.empty());
+        REQUIRE(none.render().empty());
+    }
+}
@@ -0,0 +1,99 @@
+#include <catch2/catch_test_macros.hpp>
+#include "engine.hpp"
+#include "code_ner.hpp"
+#include "repomix.hpp"
+#include "virtual_file_system.hpp"
+
+TEST_CASE("Engine builds each tokenizer and pattern set once", "[Engine]") {
+    Engine engine;
+
+    auto tokenizer = engine.tokenizer(TokenizerEncoding::CL100K_BASE);
+    REQUIRE(tokenizer != nullptr);
+    REQUIRE(engine.tokenizer(TokenizerEncoding::CL100K_BASE) == tokenizer);
+    REQUIRE(engine.tokenizer(TokenizerEncoding::P50K_BASE) != tokenizer);
+
+    FileScoringConfig config;
+    auto patterns = engine.scoringPatterns(config);
+    REQUIRE(engine.scoringPatterns(config) == patterns);
+    config.testFilePatterns.push_back("*_check.*");
+    REQUIRE(engine.scoringPatterns(config) != patterns);
+
+    auto stats = engine.stats();
+    REQUIRE(stats.misses == 4);
+    REQUIRE(stats.hits == 2);
+}
+
+TEST_CASE("Engine shares recognizers between runs with the same entity options", "[Engine]") {
+    Engine engine;
+
+    SummarizationOptions options;
+    REQUIRE(engine.codeNER(options) == nullptr);
+
+    options.includeEntityRecognition = true;
+    options.nerMethod = SummarizationOptions::NERMethod::Regex;
+    auto ner = engine.codeNER(options);
+    REQUIRE(ner != nullptr);
+
+    // Fields the recognizers do not read select the same recognizer
+    SummarizationOptions other = options;
+    other.firstNLinesCount = 3;
+    REQUIRE(engine.codeNER(other) == ner);
+
+    other.includeVariableNames = !options.includeVariableNames;
+    REQUIRE(engine.codeNER(other) != ner);
+
+    // A recognizer dropped from the engine stays usable by its holder
+    for (size_t i = 0; i < Engine::MAX_RECOGNIZERS; ++i) {
+        other = options;
+        other.maxEntities = options.maxEntities + static_cast<int>(i) + 1;
+        engine.codeNER(other);
+    }
+    auto entities = ner->extractEntities("class Widget {};\n", "widget.cpp");
+    REQUIRE(!entities.empty());
+    REQUIRE(engine.codeNER(options) != ner);
+}
+
+TEST_CASE("Copies of the default patterns are independent", "[Engine]") {
+    Engine engine;
+
+    PatternMatcher matcher = engine.defaultPatterns();
+    REQUIRE(matcher.isIgnored("node_modules/left-pad/index.js"));
+    REQUIRE_FALSE(matcher.isIgnored("src/notes.draft"));
+
+    matcher.addIgnorePattern("*.draft");
+    REQUIRE(matcher.isIgnored("src/notes.draft"));
+    REQUIRE_FALSE(engine.defaultPatterns().isIgnored("src/notes.draft"));
+}
+
+TEST_CASE("Runs sharing an engine match runs without one", "[Engine]") {
+    auto tree = std::make_shared<MemoryFileSystem>("upload");
+    tree->add("main.cpp", FileContent(std::string("#include \"util.h\"\nint main() { return helper(); }\n")));
+    tree->add("util.h", FileContent(std::string("#pragma once\nint helper();\n")));
+    tree->add("node_modules/dep/index.js", FileContent(std::string("module.exports = 1;\n")));
+
+    RepomixOptions options;
+    options.fileSystem = tree;
+    options.outputFile = "";
+    options.numThreads = 2;
+    options.countTokens = true;
+    options.summarization.includeEntityRecognition = true;
+
+    Repomix standalone(options);
+    REQUIRE(standalone.run());
+
+    auto engine = std::make_shared<Engine>();
+    engine->warmUp(options);
+    auto warm = engine->stats();
+
+    for (int run = 0; run < 2; ++run) {
+        Repomix repomix(options, engine);
+        REQUIRE(repomix.run());
+        REQUIRE(repomix.getOutput() == standalone.getOutput());
+        REQUIRE(repomix.getTokenCount() == standalone.getTokenCount());
+    }
+    REQUIRE(standalone.getOutput().find("node_modules") == std::string::npos);
+
+    auto stats = engine->stats();
+    REQUIRE(stats.misses == warm.misses);
+    REQUIRE(stats.hits > warm.hits);
+}
@@ -0,0 +1,61 @@
+#include <catch2/catch_test_macros.hpp>
+#include "entity_cache.hpp"
+#include "result_cache.hpp"
+#include <string>
+
+using NamedEntity = FileProcessor::NamedEntity;
+using EntityType = NamedEntity::EntityType;
+
+TEST_CASE("EntityCache returns stored results by content", "[EntityCache]") {
+    EntityCache cache(8);
+    const auto key = EntityCache::makeKey("class A {};", 1);
+
+    EntityCache::Entities entities;
+    REQUIRE_FALSE(cache.lookup(key, entities));
+
+    cache.store(key, {NamedEntity("A", EntityType::Class)});
+    REQUIRE(cache.lookup(key, entities));
+    REQUIRE(entities.size() == 1);
+    REQUIRE(entities[0].name == "A");
+
+    // Other content or another fingerprint misses
+    REQUIRE_FALSE(cache.lookup(EntityCache::makeKey("class B {};", 1), entities));
+    REQUIRE_FALSE(cache.lookup(EntityCache::makeKey("class A {};", 2), entities));
+
+    auto stats = cache.stats();
+    REQUIRE(stats.hits == 1);
+    REQUIRE(stats.misses == 3);
+    REQUIRE(stats.entries == 1);
+    REQUIRE(stats.capacity == 8);
+}
+
+TEST_CASE("EntityCache evicts the least recently used entry", "[EntityCache]") {
+    EntityCache cache(2, 1);
+    const auto a = EntityCache::makeKey("a", 0);
+    const auto b = EntityCache::makeKey("b", 0);
+    const auto c = EntityCache::makeKey("c", 0);
+    EntityCache::Entities entities;
+
+    cache.store(a, {NamedEntity("a", EntityType::Function)});
+    cache.store(b, {NamedEntity("b", EntityType::Function)});
+    REQUIRE(cache.lookup(a, entities));     // b is now the oldest
+    cache.store(c, {NamedEntity("c", EntityType::Function)});
+
+    REQUIRE(cache.lookup(a, entities));
+    REQUIRE(cache.lookup(c, entities));
+    REQUIRE_FALSE(cache.lookup(b, entities));
+    REQUIRE(cache.stats().evictions == 1);
+    REQUIRE(cache.stats().entries == 2);
+
+    cache.clear();
+    REQUIRE(cache.stats().entries == 0);
+    REQUIRE_FALSE(cache.lookup(a, entities));
+}
+
+TEST_CASE("EntityCache keys do not use the public content hash", "[EntityCache]") {
+    // Content crafted to collide under the unseeded XXH64 does not collide here
+    const std::string content = "class A {};";
+    const auto key = EntityCache::makeKey(content, 1);
+    REQUIRE(key.contentHash != ResultCache::contentHash(content));
+    REQUIRE(EntityCache::makeKey(content, 1) == key);
+}
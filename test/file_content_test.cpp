@@ -0,0 +1,140 @@
+#include <catch2/catch_test_macros.hpp>
+#include "file_content.hpp"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void writeFile(const fs::path& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+}
+
+}  // namespace
+
+TEST_CASE("FileContent owns a moved-in string", "[FileContent]") {
+    FileContent content(std::string("hello"));
+    REQUIRE(content.backing() == FileContent::Backing::Owned);
+    REQUIRE(content == "hello");
+    REQUIRE(content.size() == 5);
+
+    FileContent copy = content;
+    REQUIRE(copy.data() == content.data());   // Copies share the bytes
+
+    content.reset();
+    REQUIRE(content.empty());
+    REQUIRE(copy == "hello");
+
+    REQUIRE(FileContent().backing() == FileContent::Backing::Empty);
+}
+
+TEST_CASE("FileContent loads small files into pooled buffers and maps large ones", "[FileContent]") {
+    fs::path dir = fs::temp_directory_path() / "repomix_file_content_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    writeFile(dir / "small.txt", "line 1\nline 2\n");
+    writeFile(dir / "large.txt", std::string(4096, 'x'));
+    writeFile(dir / "empty.txt", "");
+
+    SECTION("Small file") {
+        FileContent content = FileContent::load(dir / "small.txt", 1024);
+        REQUIRE(content.backing() == FileContent::Backing::Pooled);
+        REQUIRE(content == "line 1\nline 2\n");
+        REQUIRE(content.find("line 2") == 7);
+    }
+
+    SECTION("Large file") {
+        FileContent content = FileContent::load(dir / "large.txt", 1024);
+        REQUIRE(content.backing() == FileContent::Backing::Mapped);
+        REQUIRE(content.size() == 4096);
+        REQUIRE(content.view() == std::string(4096, 'x'));
+
+        // The mapping outlives the handle it was loaded through
+        FileContent copy = content;
+        content.reset();
+        REQUIRE(copy.view().back() == 'x');
+    }
+
+    SECTION("Empty file") {
+        FileContent content = FileContent::load(dir / "empty.txt");
+        REQUIRE(content.empty());
+        REQUIRE(content.backing() == FileContent::Backing::Empty);
+    }
+
+    SECTION("Missing file") {
+        REQUIRE_THROWS_AS(FileContent::load(dir / "missing.txt"), std::runtime_error);
+    }
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("FileIngest probes the first block and then reads the rest", "[FileContent]") {
+    fs::path dir = fs::temp_directory_path() / "repomix_file_ingest_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    writeFile(dir / "text.txt", text);
+
+    SECTION("Small file is read into one buffer after the probe") {
+        FileIngest ingest(1024 * 1024);
+        REQUIRE(ingest.open(dir / "text.txt"));
+        REQUIRE(ingest.size() == text.size());
+
+        std::string_view probe = ingest.probe();
+        REQUIRE(probe.size() == FileIngest::PROBE_SIZE);
+        REQUIRE(probe == std::string_view(text).substr(0, FileIngest::PROBE_SIZE));
+
+        FileContent content = ingest.readAll();
+        REQUIRE(content.backing() == FileContent::Backing::Pooled);
+        REQUIRE(content.data() == probe.data());   // The probed block is reused
+        REQUIRE(content == text);
+    }
+
+    SECTION("Large file is mapped") {
+        FileIngest ingest(1024);
+        REQUIRE(ingest.open(dir / "text.txt"));
+        REQUIRE(ingest.probe().substr(0, 7) == "line 0\n");
+
+        FileContent content = ingest.readAll();
+        REQUIRE(content.backing() == FileContent::Backing::Mapped);
+        REQUIRE(content == text);
+    }
+
+    SECTION("Directories and missing files are rejected") {
+        FileIngest directory;
+        REQUIRE_FALSE(directory.open(dir));
+        FileIngest missing;
+        REQUIRE_FALSE(missing.open(dir / "missing.txt"));
+    }
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("FileContent slices and shares bytes without copying", "[FileContent]") {
+    FileContent content(std::string("header|body|footer"));
+    FileContent body = content.slice(7, 4);
+    REQUIRE(body == "body");
+    REQUIRE(body.data() == content.data() + 7);
+    REQUIRE(body.backing() == content.backing());
+    REQUIRE(content.slice(18, 0).empty());
+    REQUIRE_THROWS_AS(content.slice(10, 20), std::out_of_range);
+
+    content.reset();
+    REQUIRE(body == "body");   // The slice keeps the bytes alive
+
+    auto owner = std::make_shared<std::string>("owned elsewhere");
+    FileContent shared = FileContent::share(owner, std::string_view(*owner).substr(6));
+    REQUIRE(shared.backing() == FileContent::Backing::Shared);
+    REQUIRE(shared.data() == owner->data() + 6);
+    owner.reset();
+    REQUIRE(shared == "elsewhere");
+}
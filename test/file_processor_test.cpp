@@ -1,8 +1,15 @@
 #include <catch2/catch_test_macros.hpp>
 #include "file_processor.hpp"
 #include "pattern_matcher.hpp"
+#include "tokenizer.hpp"
+#include "result_cache.hpp"
 #include <filesystem>
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -48,6 +55,19 @@ TEST_CASE("FileProcessor processes files correctly", "[FileProcessor]") {
         REQUIRE(result.byteSize == result.content.size());
     }
     
+    SECTION("Content can be dropped after processing and read back") {
+        PatternMatcher matcher;
+        FileProcessor processor(matcher, 1);
+        processor.setKeepContent(false);
+        
+        auto result = processor.processFile(tempDir / "file1.txt");
+        
+        REQUIRE(result.processed);
+        REQUIRE(result.content.empty());
+        REQUIRE(result.lineCount == 3);
+        REQUIRE(processor.readContent(result) == "Line 1\nLine 2\nLine 3");
+    }
+    
     SECTION("ProcessDirectory finds all unignored files") {
         PatternMatcher matcher;
         matcher.addIgnorePattern("*.exe");
@@ -130,6 +150,80 @@ TEST_CASE("FileProcessor counts lines correctly", "[FileProcessor]") {
     fs::remove_all(tempDir);
 }
 
+TEST_CASE("FileProcessor counts tokens of the emitted body", "[FileProcessor]") {
+    PatternMatcher matcher;
+    FileProcessor processor(matcher, 1);
+    
+    fs::path tempDir = fs::temp_directory_path() / "repomix_token_test";
+    fs::create_directory(tempDir);
+    const fs::path filePath = tempDir / "main.cpp";
+    const std::string content = "int main() {\n    return 0;\n}\n";
+    createTestFile(filePath, content);
+    
+    SECTION("No tokenizer leaves the count at zero") {
+        auto result = processor.processFile(filePath);
+        REQUIRE(result.tokenCount == 0);
+    }
+    
+    SECTION("A tokenizer counts the content on the worker") {
+        auto tokenizer = std::make_shared<Tokenizer>();
+        processor.setTokenizer(tokenizer);
+        auto result = processor.processFile(filePath);
+        REQUIRE(result.tokenCount == tokenizer->countTokens(content));
+        REQUIRE(result.tokenCount > 0);
+    }
+    
+    fs::remove_all(tempDir);
+}
+
+TEST_CASE("FileProcessor detects binary content from the first block", "[FileProcessor]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_binary_test";
+    fs::remove_all(tempDir);
+    fs::create_directory(tempDir);
+    
+    std::string early(6000, 'a');
+    early[5000] = '\0';
+    createBinaryTestFile(tempDir / "early_null.txt", early, early.size());
+    
+    std::string late(20000, 'a');
+    late[15000] = '\0';
+    createBinaryTestFile(tempDir / "late_null.txt", late, late.size());
+    
+    createTestFile(tempDir / "text.txt", "plain text\n");
+    
+    PatternMatcher matcher;
+    FileProcessor processor(matcher, 1);
+    
+    SECTION("A null byte in the first block marks the file as binary") {
+        auto result = processor.processFile(tempDir / "early_null.txt");
+        REQUIRE(result.skipped);
+        REQUIRE_FALSE(result.processed);
+        REQUIRE(result.byteSize == early.size());
+        
+        // Its bytes are not read again for output
+        FileProcessor dropping(matcher, 1);
+        dropping.setKeepContent(false);
+        REQUIRE(dropping.readContent(dropping.processFile(tempDir / "early_null.txt")).empty());
+    }
+    
+    SECTION("Bytes past the first block are not examined") {
+        auto result = processor.processFile(tempDir / "late_null.txt");
+        REQUIRE(result.processed);
+        REQUIRE(result.content.size() == late.size());
+        REQUIRE(result.content.view() == late);
+    }
+    
+    SECTION("ProcessDirectory leaves binary files out") {
+        auto results = processor.processDirectory(tempDir, false);
+        REQUIRE(results.size() == 2);
+        for (const auto& file : results) {
+            REQUIRE(file.path != tempDir / "early_null.txt");
+        }
+    }
+    
+    fs::remove_all(tempDir);
+}
+
 TEST_CASE("FileProcessor handles non-existent or invalid files", "[FileProcessor]") {
     PatternMatcher matcher;
     FileProcessor processor(matcher, 1); // Use single thread for testing
@@ -141,4 +235,250 @@ TEST_CASE("FileProcessor handles non-existent or invalid files", "[FileProcessor
     SECTION("Invalid directory throws exception") {
         REQUIRE_THROWS_AS(processor.processDirectory("/non/existent/directory", false), std::runtime_error);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("FileProcessor skips directories excluded by .gitignore", "[FileProcessor]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_gitignore_prune_test";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "src");
+    fs::create_directories(tempDir / "build" / "obj");
+    fs::create_directories(tempDir / "lib" / "cache");
+    
+    createTestFile(tempDir / ".gitignore", "build/\n");
+    createTestFile(tempDir / "lib" / ".gitignore", "cache/\n");
+    createTestFile(tempDir / "src" / "main.cpp", "int main() {}\n");
+    createTestFile(tempDir / "lib" / "util.cpp", "void util() {}\n");
+    createTestFile(tempDir / "build" / "obj" / "generated.cpp", "void gen() {}\n");
+    createTestFile(tempDir / "lib" / "cache" / "entry.txt", "cached\n");
+    
+    auto collectPaths = [&](bool parallel) {
+        PatternMatcher matcher;
+        matcher.addIgnorePattern(".gitignore");
+        FileProcessor processor(matcher, 2);
+        
+        std::vector<fs::path> paths;
+        for (const auto& file : processor.processDirectory(tempDir, parallel)) {
+            paths.push_back(file.path);
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    };
+    
+    const std::vector<fs::path> expected = {tempDir / "lib" / "util.cpp", tempDir / "src" / "main.cpp"};
+    
+    SECTION("Sequential collection") {
+        REQUIRE(collectPaths(false) == expected);
+    }
+    
+    SECTION("Parallel collection") {
+        REQUIRE(collectPaths(true) == expected);
+    }
+    
+    fs::remove_all(tempDir);
+}
+
+TEST_CASE("FileProcessor processes an explicit file list in order", "[FileProcessor]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_file_list_test";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir);
+    
+    std::vector<fs::path> files;
+    for (int i = 0; i < 50; ++i) {
+        const fs::path filePath = tempDir / ("file" + std::to_string(i) + ".txt");
+        createTestFile(filePath, std::string(static_cast<size_t>(i + 1), 'x'));
+        files.push_back(filePath);
+    }
+    std::reverse(files.begin(), files.end());
+    
+    PatternMatcher matcher;
+    FileProcessor processor(matcher, 4);
+    
+    FileProcessor::ProgressInfo lastProgress;
+    processor.setProgressCallback([&lastProgress](const FileProcessor::ProgressInfo& progress) {
+        lastProgress = progress;
+    });
+    
+    auto results = processor.processFiles(files);
+    
+    REQUIRE(results.size() == files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        REQUIRE(results[i].path == files[i]);
+        REQUIRE(results[i].processed);
+    }
+    
+    REQUIRE(lastProgress.isComplete);
+    REQUIRE(lastProgress.totalFiles == files.size());
+    REQUIRE(lastProgress.processedFiles == files.size());
+    
+    fs::remove_all(tempDir);
+}
+
+TEST_CASE("FileProcessor coalesces progress reports", "[FileProcessor]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_progress_test";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir);
+    
+    std::vector<fs::path> files;
+    for (int i = 0; i < 200; ++i) {
+        const fs::path filePath = tempDir / ("file" + std::to_string(i) + ".txt");
+        createTestFile(filePath, "line\n");
+        files.push_back(filePath);
+    }
+    
+    PatternMatcher matcher;
+    FileProcessor processor(matcher, 4);
+    
+    std::atomic<size_t> reports{0};
+    FileProcessor::ProgressInfo lastProgress;
+    processor.setProgressCallback([&reports, &lastProgress](const FileProcessor::ProgressInfo& progress) {
+        ++reports;
+        lastProgress = progress;
+    });
+    
+    SECTION("time only: the first file and the final report") {
+        FileProcessor::ProgressOptions options;
+        options.interval = std::chrono::hours(1);
+        options.logToConsole = false;
+        processor.setProgressOptions(options);
+        
+        processor.processFiles(files);
+        REQUIRE(reports == 2);
+    }
+    
+    SECTION("every N files") {
+        FileProcessor::ProgressOptions options;
+        options.interval = std::chrono::hours(1);
+        options.everyFiles = 50;
+        options.logToConsole = false;
+        processor.setProgressOptions(options);
+        
+        processor.processFiles(files);
+        REQUIRE(reports >= 4);
+        REQUIRE(reports <= 200 / 50 + 2 + 4);    // Workers may cross the count together
+    }
+    
+    REQUIRE(lastProgress.isComplete);
+    REQUIRE(lastProgress.processedFiles == files.size());
+    REQUIRE(processor.getCurrentProgress().processedFiles == files.size());
+    
+    fs::remove_all(tempDir);
+}
+
+TEST_CASE("FileProcessor analyzes very large files in chunks", "[FileProcessor]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_chunk_test";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir);
+    
+    std::string content;
+    for (int i = 0; i < 400; ++i) {
+        const std::string n = std::to_string(i);
+        content += "// helper " + n + "\nint helper" + n + "(int x) {\n    return x + " + n + ";\n}\n\n";
+    }
+    const fs::path filePath = tempDir / "big.cpp";
+    createTestFile(filePath, content);
+    
+    SummarizationOptions options;
+    options.enabled = true;
+    options.useTreeSitter = false;
+    options.fileSizeThreshold = 1024;
+    options.maxEntities = 0;
+    options.chunkThreshold = 0;
+    
+    PatternMatcher matcher;
+    FileProcessor whole(matcher, 4);
+    whole.setSummarizationOptions(options);
+    
+    options.chunkThreshold = 1024;
+    options.chunkSize = 700;
+    options.chunkOverlap = 64;
+    FileProcessor chunked(matcher, 4);
+    chunked.setSummarizationOptions(options);
+    
+    auto expected = whole.processFiles({filePath});
+    auto actual = chunked.processFiles({filePath});
+    REQUIRE(actual.size() == 1);
+    REQUIRE(actual[0].processed);
+    REQUIRE(actual[0].isSummarized);
+    REQUIRE(actual[0].lineCount == expected[0].lineCount);
+    
+    // Same signatures and comments, each once, in file order
+    REQUIRE(actual[0].summary == expected[0].summary);
+    
+    // Same entities; chunks report them grouped by chunk rather than by type
+    auto names = [](const FileProcessor::ProcessedFile& file) {
+        std::vector<std::string> result;
+        for (const auto& entity : file.entities) {
+            result.emplace_back(entity.name);
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    };
+    REQUIRE(names(actual[0]) == names(expected[0]));
+    
+    fs::remove_all(tempDir);
+}
+
+TEST_CASE("FileProcessor analyzes identical files once", "[FileProcessor]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_dedup_test";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "a");
+    fs::create_directories(tempDir / "b");
+    
+    const std::string license = "Permission is hereby granted, free of charge,\nto any person obtaining a copy\n";
+    createTestFile(tempDir / "b" / "LICENSE", license);
+    createTestFile(tempDir / "a" / "LICENSE", license);
+    createTestFile(tempDir / "c.txt", license);
+    createTestFile(tempDir / "d.txt", license + "with changes\n");
+    createTestFile(tempDir / "empty1.txt", "");
+    createTestFile(tempDir / "empty2.txt", "");
+    
+    PatternMatcher matcher;
+    FileProcessor processor(matcher, 4);
+    processor.setDeduplicate(true);
+    
+    for (int run = 0; run < 2; ++run) {
+        std::map<std::string, FileProcessor::ProcessedFile> byName;
+        for (auto& file : processor.processDirectory(tempDir, true)) {
+            REQUIRE(file.processed);
+            byName[fs::relative(file.path, tempDir).generic_string()] = std::move(file);
+        }
+        REQUIRE(byName.size() == 6);
+        
+        // The smallest path owns the content whichever worker read it first
+        const auto& owner = byName["a/LICENSE"];
+        REQUIRE(owner.duplicateOf.empty());
+        REQUIRE(owner.contentHash == ResultCache::contentHash(license));
+        REQUIRE(byName["d.txt"].duplicateOf.empty());
+        REQUIRE(byName["empty1.txt"].duplicateOf.empty());
+        REQUIRE(byName["empty2.txt"].duplicateOf.empty());
+        
+        // Copies keep their line count; one read after a copy with a smaller
+        // path refers to it and is not analyzed
+        for (const char* copy : {"b/LICENSE", "c.txt"}) {
+            const auto& file = byName[copy];
+            REQUIRE(file.contentHash == owner.contentHash);
+            REQUIRE(file.lineCount == 2);
+            if (!file.duplicateOf.empty()) {
+                REQUIRE(file.duplicateOf < file.path);
+                REQUIRE(file.entities.empty());
+            }
+        }
+    }
+    
+    // Processing a single file never consults other files
+    REQUIRE(processor.processFile(tempDir / "c.txt").duplicateOf.empty());
+    
+    // Files are only the same if their bytes are, whatever their hashes say
+    createTestFile(tempDir / "e.txt", license);
+    createTestFile(tempDir / "f.txt", std::string(license.size(), 'x'));
+    processor.setKeepContent(false);
+    auto a = processor.processFile(tempDir / "a" / "LICENSE");
+    auto e = processor.processFile(tempDir / "e.txt");
+    auto f = processor.processFile(tempDir / "f.txt");
+    f.contentHash = a.contentHash;
+    REQUIRE(processor.hasSameContent(a, e));
+    REQUIRE_FALSE(processor.hasSameContent(a, f));
+    
+    fs::remove_all(tempDir);
+}
@@ -0,0 +1,74 @@
+#include <catch2/catch_test_macros.hpp>
+#include "job_executor.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+TEST_CASE("JobExecutor splits the CPU budget between slots", "[JobExecutor]") {
+    JobExecutor::Config config;
+    config.maxConcurrentJobs = 2;
+    config.cpuBudget = 8;
+    JobExecutor executor(config);
+    REQUIRE(executor.threadsPerJob() == 4);
+
+    std::atomic<unsigned int> granted{0};
+    std::atomic<bool> done{false};
+    REQUIRE(executor.submit("a", [&](unsigned int numThreads) {
+        granted = numThreads;
+        done = true;
+    }));
+    while (!done) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(granted == 4);
+}
+
+TEST_CASE("JobExecutor bounds concurrency and the queue", "[JobExecutor]") {
+    JobExecutor::Config config;
+    config.maxConcurrentJobs = 1;
+    config.maxQueuedJobs = 1;
+    config.cpuBudget = 1;
+    JobExecutor executor(config);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    std::atomic<int> started{0};
+    auto blocking = [&](unsigned int) {
+        ++started;
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return release; });
+    };
+
+    REQUIRE(executor.submit("running", blocking));
+    while (executor.runningJobs() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(executor.submit("queued", blocking));
+
+    // One running, one waiting: the next job is refused
+    REQUIRE_FALSE(executor.submit("rejected", blocking));
+    REQUIRE(started == 1);
+
+    JobExecutor::JobState state;
+    REQUIRE(executor.getState("running", state));
+    REQUIRE(state == JobExecutor::JobState::Running);
+    REQUIRE(executor.getState("queued", state));
+    REQUIRE(state == JobExecutor::JobState::Queued);
+    REQUIRE_FALSE(executor.getState("rejected", state));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cv.notify_all();
+
+    while (!(executor.getState("queued", state) && state == JobExecutor::JobState::Finished)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(started == 2);
+    REQUIRE(executor.getState("running", state));
+    REQUIRE(state == JobExecutor::JobState::Finished);
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+#include "metrics.hpp"
+#include "work_stealing_pool.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+using Stage = Metrics::Stage;
+using Counter = Metrics::Counter;
+
+TEST_CASE("Metrics sums events from every thread", "[Metrics]") {
+    Metrics& metrics = Metrics::instance();
+    const Metrics::Snapshot before = metrics.snapshot();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&metrics] {
+            for (int i = 0; i < 100; ++i) {
+                metrics.record(Stage::Read, std::chrono::microseconds(50));
+                metrics.add(Counter::BytesRead, 10);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const Metrics::Snapshot run = metrics.snapshot().since(before);
+    const auto& read = run.stage(Stage::Read);
+    REQUIRE(read.count == 400);
+    REQUIRE(read.nanos == 400 * 50000);
+    REQUIRE(read.buckets[2] == 400);    // 10us < 50us <= 100us
+    REQUIRE(run.counter(Counter::BytesRead) == 4000);
+    REQUIRE(run.stage(Stage::Format).count == 0);
+
+    const std::string breakdown = Metrics::breakdown(run);
+    REQUIRE(breakdown.find("read") != std::string::npos);
+    REQUIRE(breakdown.find("format") == std::string::npos);
+}
+
+TEST_CASE("Metrics renders the Prometheus text format", "[Metrics]") {
+    Metrics& metrics = Metrics::instance();
+    {
+        Metrics::ScopedTimer timer(Stage::Summarize);
+    }
+    metrics.record(Stage::Summarize, std::chrono::seconds(20));
+
+    const std::string text = metrics.prometheus();
+    REQUIRE(text.find("# TYPE repomix_stage_duration_seconds histogram") != std::string::npos);
+    REQUIRE(text.find("repomix_stage_duration_seconds_bucket{stage=\"summarize\",le=\"+Inf\"}") != std::string::npos);
+    REQUIRE(text.find("repomix_stage_duration_seconds_count{stage=\"summarize\"}") != std::string::npos);
+    REQUIRE(text.find("# TYPE repomix_read_bytes_total counter") != std::string::npos);
+    REQUIRE(text.find("# TYPE repomix_pool_queued_tasks gauge") != std::string::npos);
+
+    // Buckets are cumulative: the 20s event only shows up in +Inf
+    const Metrics::Snapshot totals = metrics.snapshot();
+    const auto& summarize = totals.stage(Stage::Summarize);
+    REQUIRE(summarize.buckets[Metrics::BUCKET_COUNT - 1] >= 1);
+}
+
+TEST_CASE("Worker pools report tasks and queue depth", "[Metrics][WorkStealingPool]") {
+    Metrics& metrics = Metrics::instance();
+    const Metrics::Snapshot before = metrics.snapshot();
+    {
+        WorkStealingPool pool(2);
+        for (int i = 0; i < 20; ++i) {
+            pool.submit([](unsigned int) {});
+        }
+        pool.wait();
+    }
+    const Metrics::Snapshot run = metrics.snapshot().since(before);
+    REQUIRE(run.counter(Counter::PoolTasksRun) == 20);
+    REQUIRE(run.gauge(Metrics::Gauge::PoolQueuedTasks) == 0);
+    REQUIRE(run.gauge(Metrics::Gauge::PoolBusyWorkers) == 0);
+}
@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+#include "output_sink.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("MemorySink collects and releases output", "[OutputSink]") {
+    MemorySink sink;
+    sink.write("Hello, ");
+    sink.write("world");
+    REQUIRE(sink.str() == "Hello, world");
+    REQUIRE(sink.bytesWritten() == 12);
+
+    REQUIRE(sink.release() == "Hello, world");
+    REQUIRE(sink.str().empty());
+}
+
+TEST_CASE("FileSink writes to a file", "[OutputSink]") {
+    fs::path path = fs::temp_directory_path() / "repomix_output_sink_test.txt";
+    {
+        FileSink sink(path);
+        sink.write("first\n");
+        sink.write(std::string(100000, 'x'));
+        sink.flush();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    REQUIRE(content.size() == 6 + 100000);
+    REQUIRE(content.compare(0, 6, "first\n") == 0);
+    fs::remove(path);
+
+    REQUIRE_THROWS(FileSink(fs::temp_directory_path() / "repomix_missing_dir" / "out.txt"));
+}
+
+TEST_CASE("FdSink writes to a pipe", "[OutputSink]") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    {
+        FdSink sink(fds[1], true);
+        sink.write("abc");
+        sink.write("def");
+    }
+
+    char buffer[16];
+    ssize_t n = read(fds[0], buffer, sizeof(buffer));
+    close(fds[0]);
+    REQUIRE(std::string(buffer, n > 0 ? static_cast<size_t>(n) : 0) == "abcdef");
+}
+
+TEST_CASE("SinkStreamBuf forwards stream output in order", "[OutputSink]") {
+    MemorySink sink;
+    {
+        SinkStreamBuf buffer(sink, 8);
+        std::ostream output(&buffer);
+        output << "Lines: " << 42 << "\n";
+        output << std::string(20, 'y');
+        output << '!';
+        output.flush();
+    }
+    REQUIRE(sink.str() == "Lines: 42\n" + std::string(20, 'y') + "!");
+}
@@ -1,6 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include "pattern_matcher.hpp"
 #include <filesystem>
+#include <fstream>
+#include <regex>
+#include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -77,4 +82,188 @@ TEST_CASE("PatternMatcher properly converts patterns to regex", "[PatternMatcher
         REQUIRE_FALSE(matcher.isIgnored("foo/test"));
         REQUIRE_FALSE(matcher.isIgnored("src/test/foo"));
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("PatternMatcher compiled set handles mixed pattern kinds", "[PatternMatcher]") {
+    PatternMatcher matcher;
+    
+    SECTION("Literal basenames match at any depth") {
+        matcher.addIgnorePattern("Thumbs.db");
+        REQUIRE(matcher.isIgnored("Thumbs.db"));
+        REQUIRE(matcher.isIgnored("assets/img/Thumbs.db"));
+        REQUIRE_FALSE(matcher.isIgnored("assets/Thumbs.db.bak"));
+    }
+    
+    SECTION("Multi-dot extensions") {
+        matcher.addIgnorePattern("*.tar.gz");
+        REQUIRE(matcher.isIgnored("dist/release.tar.gz"));
+        REQUIRE_FALSE(matcher.isIgnored("dist/release.gz"));
+    }
+    
+    SECTION("Wildcard extensions match the filename") {
+        matcher.addIgnorePattern("*.sublime-*");
+        REQUIRE(matcher.isIgnored("project.sublime-workspace"));
+        REQUIRE(matcher.isIgnored("editor/project.sublime-project"));
+        REQUIRE_FALSE(matcher.isIgnored("editor/project.sublime"));
+    }
+    
+    SECTION("Include patterns can be replaced") {
+        matcher.setIncludePatterns("*.cpp,src/**/*.h");
+        REQUIRE(matcher.isIncluded("main.cpp"));
+        REQUIRE(matcher.isIncluded("src/util/helper.h"));
+        REQUIRE_FALSE(matcher.isIncluded("include/helper.h"));
+        
+        matcher.setIncludePatterns("*.py");
+        REQUIRE(matcher.isIncluded("tool.py"));
+        REQUIRE_FALSE(matcher.isIncluded("main.cpp"));
+        REQUIRE_FALSE(matcher.isIncluded("src/util/helper.h"));
+    }
+}
+
+TEST_CASE("PatternMatcher applies nested .gitignore scopes", "[PatternMatcher]") {
+    fs::path root = fs::temp_directory_path() / "repomix_gitignore_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "src" / "generated");
+    fs::create_directories(root / "docs");
+    
+    auto writeFile = [](const fs::path& path, const std::string& content) {
+        std::ofstream file(path);
+        file << content;
+    };
+    writeFile(root / ".gitignore", "# comment\n*.log\n!keep.log\n/docs\nbuild/\n");
+    writeFile(root / "src" / ".gitignore", "generated/\n*.tmp\n!important.tmp\n");
+    
+    PatternMatcher matcher;
+    matcher.loadGitignore(root / ".gitignore");
+    matcher.loadNestedGitignore(root / "src");
+    
+    SECTION("Unanchored patterns match at any depth, negation re-includes") {
+        REQUIRE(matcher.isIgnored(root / "debug.log"));
+        REQUIRE(matcher.isIgnored(root / "src" / "trace.log"));
+        REQUIRE_FALSE(matcher.isIgnored(root / "keep.log"));
+        REQUIRE_FALSE(matcher.isIgnored(root / "src" / "keep.log"));
+    }
+    
+    SECTION("Anchored patterns only match relative to their .gitignore") {
+        REQUIRE(matcher.isDirectoryIgnored(root / "docs"));
+        REQUIRE(matcher.isIgnored(root / "docs" / "index.md"));
+        REQUIRE_FALSE(matcher.isDirectoryIgnored(root / "src" / "docs"));
+    }
+    
+    SECTION("Directory-only patterns exclude directories and their contents") {
+        REQUIRE(matcher.isDirectoryIgnored(root / "build"));
+        REQUIRE(matcher.isDirectoryIgnored(root / "src" / "build"));
+        REQUIRE(matcher.isIgnored(root / "build" / "main.cpp"));
+        REQUIRE_FALSE(matcher.isIgnored(root / "build"));
+    }
+    
+    SECTION("Nested scopes only apply below their directory") {
+        REQUIRE(matcher.isDirectoryIgnored(root / "src" / "generated"));
+        REQUIRE(matcher.isIgnored(root / "src" / "generated" / "api.cpp"));
+        REQUIRE_FALSE(matcher.isDirectoryIgnored(root / "generated"));
+        REQUIRE(matcher.isIgnored(root / "src" / "scratch.tmp"));
+        REQUIRE_FALSE(matcher.isIgnored(root / "src" / "important.tmp"));
+        REQUIRE_FALSE(matcher.isIgnored(root / "scratch.tmp"));
+    }
+    
+    SECTION("Files inside an ignored directory cannot be re-included") {
+        REQUIRE(matcher.isIgnored(root / "build" / "keep.log"));
+    }
+    
+    SECTION("Flat patterns are matched relative to the root directory") {
+        matcher.setRootDirectory(root);
+        matcher.addIgnorePattern("third_party/**");
+        REQUIRE(matcher.isDirectoryIgnored(root / "third_party"));
+        REQUIRE(matcher.isIgnored(root / "third_party" / "lib.c"));
+        REQUIRE_FALSE(matcher.isDirectoryIgnored(root / "src"));
+    }
+    
+    fs::remove_all(root);
+}
+
+namespace {
+
+// Builds a pattern list resembling defaults + .gitignore + --exclude on a large repo
+std::vector<std::string> makeBenchmarkPatterns() {
+    std::vector<std::string> patterns;
+    for (int i = 0; i < 100; ++i) {
+        patterns.push_back("*.ext" + std::to_string(i));
+        patterns.push_back("generated_" + std::to_string(i) + ".txt");
+        patterns.push_back("third_party/lib" + std::to_string(i) + "/**");
+    }
+    for (int i = 0; i < 20; ++i) {
+        patterns.push_back("src/**/fixture" + std::to_string(i) + "_*.json");
+    }
+    return patterns;
+}
+
+std::vector<std::string> makeBenchmarkPaths() {
+    std::vector<std::string> paths;
+    for (int i = 0; i < 1000; ++i) {
+        paths.push_back("src/module" + std::to_string(i % 37) + "/file" + std::to_string(i) +
+                        ".cpp");
+        if (i % 10 == 0) {
+            paths.push_back("third_party/lib" + std::to_string(i % 100) + "/src/vendored.c");
+            paths.push_back("src/data/fixture" + std::to_string(i % 20) + "_case.json");
+            paths.push_back("out/artifact.ext" + std::to_string(i % 100));
+        }
+    }
+    return paths;
+}
+
+}  // namespace
+
+TEST_CASE("PatternMatcher compiled matching benchmark", "[PatternMatcher][benchmark][.]") {
+    const auto patterns = makeBenchmarkPatterns();
+    const auto paths = makeBenchmarkPaths();
+    
+    PatternMatcher matcher(patterns);
+    
+    // The pre-compilation implementation: one std::regex per pattern, tried in order,
+    // with the extension suffix and filename special cases
+    std::vector<std::regex> regexes;
+    for (const auto& pattern : patterns) {
+        regexes.emplace_back(PatternMatcher::patternToRegex(pattern));
+    }
+    auto linearIsIgnored = [&](const std::string& pathStr) {
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            const auto& pattern = patterns[i];
+            const bool isExtension = pattern.size() >= 2 && pattern[0] == '*' && pattern[1] == '.';
+            if (isExtension) {
+                const std::string extension = pattern.substr(1);
+                if (pathStr.size() >= extension.size() &&
+                    pathStr.substr(pathStr.size() - extension.size()) == extension) {
+                    return true;
+                }
+            }
+            if (std::regex_match(pathStr, regexes[i])) {
+                return true;
+            }
+            if (isExtension && pattern.find('/') == std::string::npos &&
+                std::regex_match(fs::path(pathStr).filename().string(), regexes[i])) {
+                return true;
+            }
+        }
+        return false;
+    };
+    
+    for (const auto& path : paths) {
+        REQUIRE(matcher.isIgnored(path) == linearIsIgnored(path));
+    }
+    
+    BENCHMARK("linear regex loop") {
+        size_t ignored = 0;
+        for (const auto& path : paths) {
+            ignored += linearIsIgnored(path) ? 1 : 0;
+        }
+        return ignored;
+    };
+    
+    BENCHMARK("compiled pattern set") {
+        size_t ignored = 0;
+        for (const auto& path : paths) {
+            ignored += matcher.isIgnored(path) ? 1 : 0;
+        }
+        return ignored;
+    };
+}
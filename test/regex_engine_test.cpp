@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+#include "regex_engine.hpp"
+#include "language_registry.hpp"
+#include <string>
+#include <vector>
+
+TEST_CASE("Regex finds matches and their groups", "[Regex]") {
+    Regex regex(R"((class|struct)\s+(\w+))");
+    std::string_view text = "class A {}; struct B;";
+
+    Regex::Match match;
+    REQUIRE(regex.search(text, 0, match));
+    REQUIRE(match.start == 0);
+    REQUIRE(match.group(0) == "class A");
+    REQUIRE(match.group(2) == "A");
+    REQUIRE(match.group(3).empty());
+
+    std::vector<std::string> names;
+    regex.forEach(text, [&](const Regex::Match& m) { names.emplace_back(m.group(2)); });
+    REQUIRE(names == std::vector<std::string>{"A", "B"});
+
+    SECTION("Searching from an offset keeps the text before it") {
+        Regex wordStart(R"(\bB)");
+        REQUIRE_FALSE(wordStart.search("AB", 1, match));
+        REQUIRE(wordStart.search("A B", 1, match));
+        REQUIRE(match.start == 2);
+    }
+
+    SECTION("Unset and invalid patterns match nothing") {
+        REQUIRE_FALSE(Regex().search(text));
+        REQUIRE_FALSE(Regex("(unclosed").search("(unclosed"));
+    }
+}
+
+TEST_CASE("Language registry maps extensions to pattern tables", "[Regex]") {
+    REQUIRE(languageOf("a/b.cc") == Language::Cpp);
+    REQUIRE(languageOf("b.c") == Language::C);
+    REQUIRE(languageOf("b.tsx") == Language::JavaScript);
+    REQUIRE(languageOf("README") == Language::Unknown);
+    REQUIRE(isCFamily(Language::C));
+
+    const LanguageRules& python = rulesFor(Language::Python);
+    Regex::Match match;
+    REQUIRE(python.imports[0].search("from pkg.mod import x", 0, match));
+    REQUIRE(match.group(1) == "pkg.mod");
+
+    // PHP's include forms report the path as group 1 like every other pattern
+    const LanguageRules& php = rulesFor(Language::Php);
+    REQUIRE(php.imports[0].search("require_once 'lib/util.php';", 0, match));
+    REQUIRE(match.group(1) == "lib/util.php");
+
+    REQUIRE_FALSE(rulesFor(Language::Unknown).classNames.search("class A"));
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+#include "repo_mirror.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void writeFile(const fs::path& path, const std::string& content) {
+    std::ofstream file(path);
+    file << content;
+}
+
+int git(const fs::path& repo, const std::string& args) {
+    std::string cmd = "git -C " + RepoMirror::shellQuote(repo.string()) +
+                      " -c user.name=test -c user.email=test@example.com " + args + " >/dev/null 2>&1";
+    return std::system(cmd.c_str());
+}
+
+bool contains(const std::vector<fs::path>& paths, const fs::path& path) {
+    return std::find(paths.begin(), paths.end(), path) != paths.end();
+}
+
+}  // namespace
+
+TEST_CASE("RepoMirror parses name-status output", "[RepoMirror]") {
+    std::string output("M\0src/a.cpp\0D\0old.txt\0A\0dir/new file.h\0", 39);
+    RepoMirror::SyncResult result;
+    RepoMirror::parseNameStatus(output, "/wt", result);
+
+    REQUIRE(result.changed.size() == 2);
+    REQUIRE(result.changed[0] == fs::path("/wt/src/a.cpp"));
+    REQUIRE(result.changed[1] == fs::path("/wt/dir/new file.h"));
+    REQUIRE(result.removed.size() == 1);
+    REQUIRE(result.removed[0] == fs::path("/wt/old.txt"));
+}
+
+TEST_CASE("RepoMirror rejects URLs git would read as options", "[RepoMirror]") {
+    const fs::path mirrors = fs::temp_directory_path() / "repomix_repo_mirror_options_test";
+    REQUIRE_THROWS_AS(RepoMirror("--upload-pack=touch /tmp/pwned", mirrors), std::runtime_error);
+    REQUIRE_THROWS_AS(RepoMirror("-c", mirrors), std::runtime_error);
+    REQUIRE_NOTHROW(RepoMirror("https://example.com/a-b.git", mirrors));
+}
+
+TEST_CASE("RepoMirror fetches and diffs against the last commit", "[RepoMirror]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_repo_mirror_test";
+    fs::remove_all(tempDir);
+    fs::path source = tempDir / "source";
+    fs::create_directories(source);
+
+    REQUIRE(git(source, "init -q") == 0);
+    writeFile(source / "a.txt", "one\n");
+    writeFile(source / "b.txt", "two\n");
+    REQUIRE(git(source, "add -A") == 0);
+    REQUIRE(git(source, "commit -q -m first") == 0);
+
+    RepoMirror mirror(source.string(), tempDir / "mirrors");
+    auto first = mirror.sync("");
+    REQUIRE_FALSE(first.commit.empty());
+    REQUIRE_FALSE(first.diffAvailable);
+    REQUIRE(fs::exists(mirror.worktree() / "a.txt"));
+
+    writeFile(source / "a.txt", "one, changed\n");
+    fs::remove(source / "b.txt");
+    writeFile(source / "c.txt", "three\n");
+    REQUIRE(git(source, "add -A") == 0);
+    REQUIRE(git(source, "commit -q -m second") == 0);
+
+    auto second = mirror.sync(first.commit);
+    REQUIRE(second.commit != first.commit);
+    REQUIRE(second.diffAvailable);
+    REQUIRE(second.changed.size() == 2);
+    REQUIRE(contains(second.changed, mirror.worktree() / "a.txt"));
+    REQUIRE(contains(second.changed, mirror.worktree() / "c.txt"));
+    REQUIRE(second.removed.size() == 1);
+    REQUIRE(contains(second.removed, mirror.worktree() / "b.txt"));
+
+    // The checkout follows HEAD
+    REQUIRE(fs::exists(mirror.worktree() / "c.txt"));
+    REQUIRE_FALSE(fs::exists(mirror.worktree() / "b.txt"));
+
+    // Nothing new upstream: an empty diff
+    auto third = mirror.sync(second.commit);
+    REQUIRE(third.commit == second.commit);
+    REQUIRE(third.diffAvailable);
+    REQUIRE(third.changed.empty());
+    REQUIRE(third.removed.empty());
+
+    // Removed mirrors are cloned again on the next sync
+    mirror.remove();
+    REQUIRE_FALSE(fs::exists(mirror.worktree()));
+    auto fourth = mirror.sync(second.commit);
+    REQUIRE(fourth.commit == second.commit);
+    REQUIRE(fs::exists(mirror.worktree() / "c.txt"));
+
+    fs::remove_all(tempDir);
+}
@@ -0,0 +1,26 @@
+#include <catch2/catch_test_macros.hpp>
+#include "repomix.hpp"
+#include "virtual_file_system.hpp"
+
+TEST_CASE("Repomix leaves binary files out of scored runs", "[Repomix]") {
+    std::string binary = "GIF89a";
+    binary += '\0';
+    binary += "SECRET-PAYLOAD";
+
+    auto tree = std::make_shared<MemoryFileSystem>("upload");
+    tree->add("src/main.cpp", FileContent(std::string("int main() { return 0; }\n")));
+    tree->add("src/blob.txt", FileContent(std::string(binary)));
+
+    RepomixOptions options;
+    options.fileSystem = tree;
+    options.outputFile = "";
+    options.numThreads = 2;
+    options.tokenBudget = 100000;   // Scores every file
+
+    Repomix repomix(options);
+    REQUIRE(repomix.run());
+    const std::string& output = repomix.getOutput();
+    REQUIRE(output.find("int main()") != std::string::npos);
+    REQUIRE(output.find("SECRET-PAYLOAD") == std::string::npos);
+    REQUIRE(output.find("blob.txt") == std::string::npos);
+}
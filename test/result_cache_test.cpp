@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+#include "result_cache.hpp"
+#include "file_processor.hpp"
+#include "pattern_matcher.hpp"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("ResultCache stores and loads entries", "[ResultCache]") {
+    fs::path cacheDir = fs::temp_directory_path() / "repomix_result_cache_test";
+    fs::remove_all(cacheDir);
+    ResultCache cache(cacheDir);
+
+    SECTION("Keys depend on every field") {
+        std::string key = ResultCache::makeKey("a/b.cpp", 10, 1000, 42, 7);
+        REQUIRE(key.size() == 32);
+        REQUIRE(key == ResultCache::makeKey("a/b.cpp", 10, 1000, 42, 7));
+        REQUIRE(key != ResultCache::makeKey("a/c.cpp", 10, 1000, 42, 7));
+        REQUIRE(key != ResultCache::makeKey("a/b.cpp", 11, 1000, 42, 7));
+        REQUIRE(key != ResultCache::makeKey("a/b.cpp", 10, 1001, 42, 7));
+        REQUIRE(key != ResultCache::makeKey("a/b.cpp", 10, 1000, 43, 7));
+        REQUIRE(key != ResultCache::makeKey("a/b.cpp", 10, 1000, 42, 8));
+    }
+
+    SECTION("Content hashes match the reference XXH64") {
+        REQUIRE(ResultCache::contentHash("") == 0xEF46DB3751D8E999ULL);
+        REQUIRE(ResultCache::contentHash("abc") == 0x44BC2CF5AD770999ULL);
+        REQUIRE(ResultCache::contentHash("", 2654435761U) == 0xAC75FDA2929B17EFULL);
+
+        // Every tail length after the 32-byte stripes
+        std::string text(100, 'x');
+        for (size_t size = 30; size < 45; ++size) {
+            REQUIRE(ResultCache::contentHash(std::string_view(text).substr(0, size)) !=
+                    ResultCache::contentHash(std::string_view(text).substr(0, size + 1)));
+        }
+        REQUIRE(ResultCache::contentHash(text) == ResultCache::contentHash(std::string(100, 'x')));
+        REQUIRE(ResultCache::contentHash(text, 1) != ResultCache::contentHash(text));
+    }
+
+    SECTION("Round trip") {
+        std::string key = ResultCache::makeKey("file.txt", 3, 1, ResultCache::hash("abc"), 0);
+        nlohmann::json value;
+        REQUIRE_FALSE(cache.load(key, value));
+
+        cache.store(key, {{"lineCount", 3}, {"name", "file.txt"}});
+        REQUIRE(cache.load(key, value));
+        REQUIRE(value["lineCount"] == 3);
+        REQUIRE(value["name"] == "file.txt");
+        REQUIRE(cache.hits() == 1);
+        REQUIRE(cache.misses() == 1);
+    }
+
+    fs::remove_all(cacheDir);
+}
+
+TEST_CASE("FileProcessor reuses cached results", "[ResultCache][FileProcessor]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_result_cache_files";
+    fs::path cacheDir = tempDir / "cache";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir);
+
+    fs::path filePath = tempDir / "sample.cpp";
+    {
+        std::ofstream file(filePath);
+        file << "class Widget {};\nint main() {\n    return 0;\n}\n";
+    }
+
+    PatternMatcher matcher;
+    auto cache = std::make_shared<ResultCache>(cacheDir);
+
+    FileProcessor first(matcher, 1);
+    first.setResultCache(cache);
+    auto original = first.processFile(filePath);
+    REQUIRE(original.processed);
+    REQUIRE(cache->hits() == 0);
+    REQUIRE(cache->misses() == 1);
+
+    // A fresh processor sharing the cache directory gets the same result from disk
+    FileProcessor second(matcher, 1);
+    auto warmCache = std::make_shared<ResultCache>(cacheDir);
+    second.setResultCache(warmCache);
+    auto cached = second.processFile(filePath);
+    REQUIRE(cached.processed);
+    REQUIRE(warmCache->hits() == 1);
+    REQUIRE(cached.content == original.content);
+    REQUIRE(cached.lineCount == original.lineCount);
+    REQUIRE(cached.firstLines == original.firstLines);
+    REQUIRE(cached.formattedEntities == original.formattedEntities);
+    REQUIRE(cached.entities.size() == original.entities.size());
+
+    // Changing the content changes the key
+    {
+        std::ofstream file(filePath);
+        file << "int main() {\n    return 1;\n}\n";
+    }
+    auto cacheAfterEdit = std::make_shared<ResultCache>(cacheDir);
+    FileProcessor third(matcher, 1);
+    third.setResultCache(cacheAfterEdit);
+    auto edited = third.processFile(filePath);
+    REQUIRE(edited.processed);
+    REQUIRE(edited.content.find("return 1;") != std::string::npos);
+    REQUIRE(cacheAfterEdit->hits() == 0);
+    REQUIRE(cacheAfterEdit->misses() == 1);
+
+    fs::remove_all(tempDir);
+}
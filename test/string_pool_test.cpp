@@ -0,0 +1,99 @@
+#include <catch2/catch_test_macros.hpp>
+#include "string_pool.hpp"
+#include "file_processor.hpp"
+#include "pattern_matcher.hpp"
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("StringPool interns equal strings once", "[StringPool]") {
+    StringPool pool(4);
+
+    std::string first = "Widget";
+    std::string second = "Widget";
+    auto a = pool.intern(first);
+    auto b = pool.intern(second);
+    REQUIRE(a == "Widget");
+    REQUIRE(a.data() == b.data());
+    REQUIRE(a.data() != first.data());
+    REQUIRE(pool.intern("Gadget") != a);
+    REQUIRE(pool.internedCount() == 2);
+    REQUIRE(pool.bytesUsed() == 12);
+
+    // Stored strings are copied every time and not deduplicated
+    auto c = pool.store("Widget");
+    REQUIRE(c == "Widget");
+    REQUIRE(c.data() != a.data());
+    REQUIRE(pool.internedCount() == 2);
+    REQUIRE(pool.bytesUsed() == 18);
+
+    REQUIRE(pool.intern("").empty());
+    REQUIRE(pool.store("").empty());
+}
+
+TEST_CASE("StringPool is shared by concurrent workers", "[StringPool]") {
+    StringPool pool;
+    std::vector<std::vector<std::string_view>> seen(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < seen.size(); ++t) {
+        threads.emplace_back([&pool, &seen, t] {
+            for (int i = 0; i < 500; ++i) {
+                seen[t].push_back(pool.intern("name" + std::to_string(i % 50)));
+                pool.store("line" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(pool.internedCount() == 50);
+    for (size_t t = 1; t < seen.size(); ++t) {
+        for (size_t i = 0; i < seen[t].size(); ++i) {
+            REQUIRE(seen[t][i].data() == seen[0][i].data());
+        }
+    }
+}
+
+TEST_CASE("Processed files keep their run's strings alive", "[StringPool][FileProcessor]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_string_pool_files";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir);
+    {
+        std::ofstream(tempDir / "a.cpp") << "class Widget {};\nint helper() {\n    return 0;\n}\n";
+        std::ofstream(tempDir / "b.cpp") << "class Widget {};\n";
+    }
+
+    std::vector<FileProcessor::ProcessedFile> files;
+    {
+        PatternMatcher matcher;
+        FileProcessor processor(matcher, 2);
+        SummarizationOptions options;
+        options.includeEntityRecognition = true;
+        options.nerMethod = SummarizationOptions::NERMethod::Regex;
+        processor.setSummarizationOptions(options);
+        files = processor.processFiles({tempDir / "a.cpp", tempDir / "b.cpp"});
+    }
+
+    REQUIRE(files.size() == 2);
+    REQUIRE(files[0].strings);
+    REQUIRE(files[0].strings == files[1].strings);
+    REQUIRE(files[0].firstLines.substr(0, 16) == "class Widget {};");
+
+    // The processor is gone; names are still readable and shared between files
+    auto findWidget = [](const FileProcessor::ProcessedFile& file) -> std::string_view {
+        for (const auto& entity : file.entities) {
+            if (entity.name == "Widget") {
+                return entity.name;
+            }
+        }
+        return {};
+    };
+    auto inFirst = findWidget(files[0]);
+    auto inSecond = findWidget(files[1]);
+    REQUIRE(inFirst == "Widget");
+    REQUIRE(inFirst.data() == inSecond.data());
+
+    fs::remove_all(tempDir);
+}
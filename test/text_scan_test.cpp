@@ -0,0 +1,92 @@
+#include <catch2/catch_test_macros.hpp>
+#include "text_scan.hpp"
+#include <cctype>
+#include <random>
+#include <string>
+
+namespace {
+
+// Byte-at-a-time versions of the loops the kernels replace
+TextStats referenceScan(const std::string& data) {
+    TextStats stats;
+    bool inWord = false;
+    size_t wordLength = 0;
+    for (char c : data) {
+        const unsigned char u = static_cast<unsigned char>(c);
+        if (c == '\n') stats.newlines++;
+        if (c == 0) stats.nulBytes++;
+        if ((u >= 32 && u <= 126) || c == '\n' || c == '\r' || c == '\t') stats.textBytes++;
+
+        const bool space = std::isspace(u) != 0;
+        const bool punct = std::string(".,!?:;()[]{}\"'`").find(c) != std::string::npos && c != 0;
+        if (space || punct) {
+            if (inWord) {
+                stats.estimatedTokens += (wordLength + 3) / 4;
+                inWord = false;
+                wordLength = 0;
+            }
+            if (!space) {
+                stats.estimatedTokens++;
+            }
+        } else {
+            inWord = true;
+            wordLength++;
+        }
+    }
+    if (inWord) {
+        stats.estimatedTokens += (wordLength + 3) / 4;
+    }
+    return stats;
+}
+
+void requireSameStats(const TextStats& a, const TextStats& b) {
+    REQUIRE(a.newlines == b.newlines);
+    REQUIRE(a.nulBytes == b.nulBytes);
+    REQUIRE(a.textBytes == b.textBytes);
+    REQUIRE(a.estimatedTokens == b.estimatedTokens);
+}
+
+}  // namespace
+
+TEST_CASE("TextScanner counts simple text", "[TextScanner]") {
+    TextStats stats = TextScanner::scan("int main() {\n    return 0;\n}\n");
+    REQUIRE(stats.newlines == 3);
+    REQUIRE(stats.nulBytes == 0);
+    REQUIRE(stats.textBytes == 29);
+    REQUIRE(stats.estimatedTokens == 10);
+
+    REQUIRE(TextScanner::countNewlines("") == 0);
+    REQUIRE(TextScanner::countNewlines(std::string(1000, '\n')) == 1000);
+    REQUIRE(TextScanner::scan(std::string_view("a\0b", 3)).nulBytes == 1);
+}
+
+TEST_CASE("TextScanner kernels match the byte-at-a-time loops", "[TextScanner]") {
+    std::mt19937 rng(42);
+    const std::string alphabet = "abcXYZ019_ \t\n\r.,;:(){}[]\"'`!?-+=/<>@";
+
+    for (auto kernel : {TextScanner::Kernel::Scalar, TextScanner::Kernel::SSE2,
+                        TextScanner::Kernel::AVX2, TextScanner::Kernel::NEON}) {
+        if (!TextScanner::isSupported(kernel)) {
+            continue;
+        }
+        INFO("kernel " << TextScanner::kernelName(kernel));
+
+        for (size_t length : {0, 1, 5, 63, 64, 65, 127, 128, 129, 1000, 4099}) {
+            std::string text;
+            std::string bytes;
+            for (size_t i = 0; i < length; ++i) {
+                text += alphabet[rng() % alphabet.size()];
+                bytes += static_cast<char>(rng() % 256);
+            }
+            // Long words cross block boundaries
+            std::string longWords = std::string(length, 'w');
+            if (length > 10) {
+                longWords[length / 2] = ' ';
+            }
+
+            requireSameStats(TextScanner::scan(text, kernel), referenceScan(text));
+            requireSameStats(TextScanner::scan(bytes, kernel), referenceScan(bytes));
+            requireSameStats(TextScanner::scan(longWords, kernel), referenceScan(longWords));
+        }
+    }
+}
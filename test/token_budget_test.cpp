@@ -0,0 +1,57 @@
+#include <catch2/catch_test_macros.hpp>
+#include "token_budget.hpp"
+#include <vector>
+
+using Choice = TokenBudgetPacker::Choice;
+
+TEST_CASE("TokenBudgetPacker takes files by score per token", "[TokenBudgetPacker]") {
+    // Dense small files win over a high-scoring but expensive one
+    std::vector<TokenBudgetPacker::Item> items = {
+        {0.9f, 900, 10},
+        {0.5f, 100, 10},
+        {0.4f, 100, 10},
+    };
+
+    auto result = TokenBudgetPacker(300).pack(items);
+    REQUIRE(result.choices == std::vector<Choice>{Choice::Omitted, Choice::Full, Choice::Full});
+    REQUIRE(result.usedTokens == 220);
+    REQUIRE(result.fullCount == 2);
+    REQUIRE(result.omittedCount == 1);
+
+    SECTION("Everything fits") {
+        auto all = TokenBudgetPacker(10000).pack(items);
+        REQUIRE(all.fullCount == 3);
+        REQUIRE(all.usedTokens == 1130);
+    }
+
+    SECTION("Framing alone can exceed the budget") {
+        auto none = TokenBudgetPacker(10).pack(items);
+        REQUIRE(none.omittedCount == 3);
+        REQUIRE(none.usedTokens == 0);
+    }
+}
+
+TEST_CASE("TokenBudgetPacker falls back to summaries", "[TokenBudgetPacker]") {
+    std::vector<TokenBudgetPacker::Item> items = {
+        {0.9f, 900, 10},
+        {0.5f, 100, 10},
+        {0.1f, 5000, 10},
+    };
+
+    std::vector<size_t> summarized;
+    auto summarize = [&summarized](size_t index) -> std::optional<size_t> {
+        summarized.push_back(index);
+        if (index == 2) {
+            return std::nullopt;    // No shorter summary
+        }
+        return 150;
+    };
+
+    auto result = TokenBudgetPacker(400).pack(items, summarize);
+    REQUIRE(result.choices == std::vector<Choice>{Choice::Summary, Choice::Full, Choice::Omitted});
+    REQUIRE(result.usedTokens == 270);
+    REQUIRE(result.summaryCount == 1);
+
+    // Only files that did not fit in full were summarized
+    REQUIRE(summarized == std::vector<size_t>{0, 2});
+}
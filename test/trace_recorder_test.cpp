@@ -0,0 +1,122 @@
+#include <catch2/catch_test_macros.hpp>
+#include "trace_recorder.hpp"
+#include "file_processor.hpp"
+#include "metrics.hpp"
+#include "pattern_matcher.hpp"
+#include "work_stealing_pool.hpp"
+#include <nlohmann/json.hpp>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+
+namespace {
+
+nlohmann::json render(const TraceRecorder& trace) {
+    std::ostringstream out;
+    trace.write(out);
+    return nlohmann::json::parse(out.str());
+}
+
+}  // namespace
+
+TEST_CASE("Spans are only recorded while a recorder is bound", "[TraceRecorder]") {
+    TraceRecorder trace;
+    const fs::path file = "src/main.cpp";
+    {
+        TraceRecorder::Span ignored("outside", "test");
+    }
+    {
+        TraceRecorder::ThreadScope scope(&trace);
+        REQUIRE(TraceRecorder::current() == &trace);
+        TraceRecorder::Span span("inside", "test", &file);
+        Metrics::ScopedTimer timer(Metrics::Stage::Read);
+    }
+    REQUIRE(TraceRecorder::current() == nullptr);
+    REQUIRE(trace.eventCount() == 2);
+
+    const nlohmann::json json = render(trace);
+    std::set<std::string> names;
+    for (const auto& event : json.at("traceEvents")) {
+        if (event.at("ph") == "X") {
+            names.insert(event.at("name").get<std::string>());
+            REQUIRE(event.at("dur").get<double>() >= 0.0);
+            if (event.at("name") == "inside") {
+                REQUIRE(event.at("args").at("detail") == "src/main.cpp");
+            }
+        } else {
+            REQUIRE(event.at("ph") == "M");
+        }
+    }
+    REQUIRE(names == std::set<std::string>{"inside", "read"});
+}
+
+TEST_CASE("Pool tasks record into the submitter's trace", "[TraceRecorder][WorkStealingPool]") {
+    TraceRecorder trace;
+    WorkStealingPool pool(3);
+    {
+        TraceRecorder::ThreadScope scope(&trace);
+        for (int i = 0; i < 30; ++i) {
+            pool.submit([](unsigned int) {
+                TraceRecorder::Span span("task", "test");
+                REQUIRE(TraceRecorder::current() != nullptr);
+            });
+        }
+        pool.wait();
+    }
+
+    // Untraced submissions stay untraced
+    pool.submit([](unsigned int) { TraceRecorder::Span span("untraced", "test"); });
+    pool.wait();
+
+    size_t tasks = 0;
+    std::set<std::string> threadNames;
+    const nlohmann::json json = render(trace);
+    for (const auto& event : json.at("traceEvents")) {
+        if (event.at("ph") == "X") {
+            REQUIRE(event.at("name") != "untraced");
+            tasks += event.at("name") == "task" ? 1 : 0;
+        } else if (event.at("name") == "thread_name") {
+            threadNames.insert(event.at("args").at("name").get<std::string>());
+        }
+    }
+    REQUIRE(tasks == 30);
+    REQUIRE(threadNames.count("main") == 1);    // pool_wait on the submitting thread
+    for (const auto& name : threadNames) {
+        REQUIRE((name == "main" || name.rfind("worker ", 0) == 0));
+    }
+}
+
+TEST_CASE("Directory runs trace scans and per-file stages", "[TraceRecorder][FileProcessor]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_trace_recorder_test";
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir / "sub");
+    std::ofstream(tempDir / "a.cpp") << "int a() { return 1; }\n";
+    std::ofstream(tempDir / "sub" / "b.py") << "def b():\n    return 2\n";
+
+    TraceRecorder trace;
+    {
+        PatternMatcher matcher;
+        FileProcessor processor(matcher, 2);
+        TraceRecorder::ThreadScope scope(&trace);
+        REQUIRE(processor.processDirectory(tempDir, true).size() == 2);
+    }
+
+    std::multiset<std::string> names;
+    const nlohmann::json json = render(trace);
+    for (const auto& event : json.at("traceEvents")) {
+        if (event.at("ph") == "X") {
+            names.insert(event.at("name").get<std::string>());
+        }
+    }
+    REQUIRE(names.count("traversal") == 2);
+    REQUIRE(names.count("process_file") == 2);
+    REQUIRE(names.count("read") == 2);
+
+    const fs::path traceFile = tempDir / "trace.json";
+    trace.writeFile(traceFile);
+    std::ifstream in(traceFile);
+    REQUIRE(nlohmann::json::parse(in).at("traceEvents").size() > names.size());
+
+    fs::remove_all(tempDir);
+}
@@ -0,0 +1,382 @@
+#include <catch2/catch_test_macros.hpp>
+#include "virtual_file_system.hpp"
+#include "file_processor.hpp"
+#include "pattern_matcher.hpp"
+#include "repo_mirror.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// One ustar member: header block plus content padded to whole blocks
+std::string tarMember(const std::string& name, const std::string& content, char type = '0') {
+    std::string header(512, '\0');
+    auto put = [&header](size_t offset, const std::string& value) {
+        header.replace(offset, value.size(), value);
+    };
+    auto octal = [](uint64_t value, int width) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%0*llo", width - 1, static_cast<unsigned long long>(value));
+        return std::string(buffer);
+    };
+    put(0, name);
+    put(100, octal(0644, 8));
+    put(108, octal(0, 8));
+    put(116, octal(0, 8));
+    put(124, octal(content.size(), 12));
+    put(136, octal(1700000000, 12));
+    header[156] = type;
+    put(257, std::string("ustar\0" "00", 8));
+
+    unsigned int checksum = 0;
+    for (size_t i = 0; i < header.size(); ++i) {
+        checksum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(header[i]);
+    }
+    put(148, octal(checksum, 7));
+
+    std::string member = header + content;
+    member.resize((member.size() + 511) / 512 * 512, '\0');
+    return member;
+}
+
+std::string tarArchive(const std::vector<std::pair<std::string, std::string>>& files) {
+    std::string archive;
+    for (const auto& [name, content] : files) {
+        archive += tarMember(name, content);
+    }
+    return archive + std::string(1024, '\0');
+}
+
+void put16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xff));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void put32(std::string& out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value & 0xffff));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+#ifdef USE_ZLIB
+// Deflates data as a gzip file or, for zip members, a raw deflate stream
+std::string compress(const std::string& data, bool gzip) {
+    z_stream stream{};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzip ? 15 + 16 : -15, 8, Z_DEFAULT_STRATEGY);
+    std::string output(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+#endif
+
+// A zip archive whose members are stored uncompressed, or deflated if
+// deflated is set (CRCs are left zero)
+std::string zipArchive(const std::vector<std::pair<std::string, std::string>>& files, bool deflated = false) {
+    std::string archive;
+    std::string directory;
+    for (const auto& [name, content] : files) {
+#ifdef USE_ZLIB
+        const std::string stored = deflated ? compress(content, false) : content;
+#else
+        const std::string stored = content;
+#endif
+        const uint16_t method = deflated ? 8 : 0;
+        const uint32_t localOffset = static_cast<uint32_t>(archive.size());
+        put32(archive, 0x04034b50);
+        put16(archive, 10);                 // Version needed
+        put16(archive, 0);                  // Flags
+        put16(archive, method);
+        put16(archive, 0);                  // Time
+        put16(archive, (44 << 9) | (1 << 5) | 1);   // 2024-01-01
+        put32(archive, 0);                  // CRC
+        put32(archive, static_cast<uint32_t>(stored.size()));
+        put32(archive, static_cast<uint32_t>(content.size()));
+        put16(archive, static_cast<uint16_t>(name.size()));
+        put16(archive, 0);                  // Extra field
+        archive += name + stored;
+
+        put32(directory, 0x02014b50);
+        put16(directory, 20);               // Version made by
+        put16(directory, 10);
+        put16(directory, 0);
+        put16(directory, method);
+        put16(directory, 0);
+        put16(directory, (44 << 9) | (1 << 5) | 1);
+        put32(directory, 0);
+        put32(directory, static_cast<uint32_t>(stored.size()));
+        put32(directory, static_cast<uint32_t>(content.size()));
+        put16(directory, static_cast<uint16_t>(name.size()));
+        put16(directory, 0);                // Extra field
+        put16(directory, 0);                // Comment
+        put16(directory, 0);                // Disk
+        put16(directory, 0);                // Internal attributes
+        put32(directory, 0);                // External attributes
+        put32(directory, localOffset);
+        directory += name;
+    }
+
+    const uint32_t directoryOffset = static_cast<uint32_t>(archive.size());
+    archive += directory;
+    put32(archive, 0x06054b50);
+    put16(archive, 0);
+    put16(archive, 0);
+    put16(archive, static_cast<uint16_t>(files.size()));
+    put16(archive, static_cast<uint16_t>(files.size()));
+    put32(archive, static_cast<uint32_t>(directory.size()));
+    put32(archive, directoryOffset);
+    put16(archive, 0);
+    return archive;
+}
+
+std::vector<std::string> entryPaths(const VirtualFileSystem& tree) {
+    std::vector<std::string> paths;
+    for (const auto& entry : tree.entries()) {
+        paths.push_back(entry.path.generic_string());
+    }
+    return paths;
+}
+
+void writeFile(const fs::path& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+}
+
+int git(const fs::path& repo, const std::string& args) {
+    std::string cmd = "git -C " + RepoMirror::shellQuote(repo.string()) +
+                      " -c user.name=test -c user.email=test@example.com " + args + " >/dev/null 2>&1";
+    return std::system(cmd.c_str());
+}
+
+}  // namespace
+
+TEST_CASE("MemoryFileSystem sorts files and rejects paths outside the tree", "[VirtualFileSystem]") {
+    MemoryFileSystem tree("upload");
+    REQUIRE(tree.add("src/b.cpp", FileContent(std::string("int b;"))));
+    REQUIRE(tree.add("a.txt", FileContent(std::string("old"))));
+    REQUIRE(tree.add("./a.txt", FileContent(std::string("new"))));   // Replaces the first
+    REQUIRE_FALSE(tree.add("../escape.txt", FileContent(std::string("x"))));
+    REQUIRE_FALSE(tree.add("/etc/passwd", FileContent(std::string("x"))));
+    REQUIRE_FALSE(tree.add("dir/", FileContent(std::string("x"))));
+
+    REQUIRE(entryPaths(tree) == std::vector<std::string>{"upload/a.txt", "upload/src/b.cpp"});
+    REQUIRE(tree.read("upload/a.txt") == "new");
+    REQUIRE(tree.find("upload/src/b.cpp")->size == 6);
+    REQUIRE(tree.find("upload/missing.txt") == nullptr);
+    REQUIRE_THROWS_AS(tree.read("upload/missing.txt"), std::runtime_error);
+}
+
+TEST_CASE("MemoryFileSystem sorts files added in any order on first read", "[VirtualFileSystem]") {
+    MemoryFileSystem tree("upload");
+    std::vector<std::string> names;
+    for (int i = 0; i < 500; ++i) {
+        names.push_back("f" + std::to_string((i * 7919) % 500) + ".txt");
+    }
+    for (const auto& name : names) {
+        REQUIRE(tree.add(name, FileContent(name)));
+    }
+
+    // The first readers on several threads sort the index together
+    std::vector<std::thread> readers;
+    std::vector<int> found(4, 0);
+    for (size_t t = 0; t < found.size(); ++t) {
+        readers.emplace_back([&tree, &names, &found, t] {
+            for (const auto& name : names) {
+                const auto* entry = tree.find(fs::path("upload") / name);
+                found[t] += entry != nullptr && entry->size == name.size();
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    REQUIRE(found == std::vector<int>(4, 500));
+
+    std::sort(names.begin(), names.end());
+    std::vector<std::string> expected;
+    for (const auto& name : names) {
+        expected.push_back("upload/" + name);
+    }
+    REQUIRE(entryPaths(tree) == expected);
+}
+
+TEST_CASE("ArchiveFileSystem reads tar members in place", "[VirtualFileSystem]") {
+    std::string data = tarArchive({{"repo/README.md", "# Title\n"}, {"repo/src/main.cpp", "int main() {}\n"}});
+    data.insert(512 * 2 + 512 * 2, tarMember("repo/src", "", '5'));     // Directories are skipped
+    REQUIRE(ArchiveFileSystem::isArchive(data));
+    REQUIRE_FALSE(ArchiveFileSystem::isArchive("just some text"));
+
+    FileContent archive(data);
+    ArchiveFileSystem tree(archive);
+    REQUIRE(entryPaths(tree) == std::vector<std::string>{"archive/repo/README.md", "archive/repo/src/main.cpp"});
+    REQUIRE(tree.find("archive/repo/README.md")->modifiedTime == 1700000000);
+
+    FileContent main = tree.read("archive/repo/src/main.cpp");
+    REQUIRE(main == "int main() {}\n");
+    REQUIRE(main.data() > archive.data());      // A slice of the archive, not a copy
+    REQUIRE(main.data() < archive.data() + archive.size());
+
+    std::string corrupt = data;
+    corrupt[0] = 'X';
+    REQUIRE_THROWS_AS(ArchiveFileSystem(FileContent(corrupt)), std::runtime_error);
+}
+
+TEST_CASE("ArchiveFileSystem reads stored zip members", "[VirtualFileSystem]") {
+    std::string data = zipArchive({{"docs/", ""}, {"docs/guide.md", "Guide\n"}, {"lib.py", "def f():\n    pass\n"}});
+    REQUIRE(ArchiveFileSystem::isArchive(data));
+
+    ArchiveFileSystem tree(FileContent(data), "zip");
+    REQUIRE(entryPaths(tree) == std::vector<std::string>{"zip/docs/guide.md", "zip/lib.py"});
+    REQUIRE(tree.read("zip/lib.py") == "def f():\n    pass\n");
+    REQUIRE(tree.read("zip/docs/guide.md") == "Guide\n");
+
+    REQUIRE_THROWS_AS(ArchiveFileSystem(FileContent(data.substr(0, data.size() - 10))), std::runtime_error);
+}
+
+#ifdef USE_ZLIB
+TEST_CASE("ArchiveFileSystem inflates gzip-compressed tar archives", "[VirtualFileSystem]") {
+    const std::string tar = tarArchive({{"a.txt", std::string(10000, 'a')}, {"b.txt", "b\n"}});
+    const std::string gzip = compress(tar, true);
+
+    REQUIRE(ArchiveFileSystem::isArchive(gzip));
+    ArchiveFileSystem tree{FileContent(gzip)};
+    REQUIRE(tree.read("archive/a.txt") == std::string(10000, 'a'));
+    REQUIRE(tree.read("archive/b.txt") == "b\n");
+}
+
+TEST_CASE("ArchiveFileSystem bounds what compressed data inflates to", "[VirtualFileSystem]") {
+    // A forged uncompressed size in the gzip trailer is not allocated up front
+    std::string forged = compress(tarArchive({{"a.txt", "a\n"}}), true);
+    forged.resize(forged.size() - 4);
+    put32(forged, 0xFFFFFFF0);
+    REQUIRE_THROWS_AS(ArchiveFileSystem{FileContent(forged)}, std::runtime_error);
+
+    // Inflating far beyond the compressed size stops at the expansion limit
+    const std::string bomb = compress(tarArchive({{"zeros.bin", std::string(16 << 20, '\0')}}), true);
+    REQUIRE(bomb.size() * ArchiveFileSystem::MAX_EXPANSION < (16 << 20));
+    REQUIRE_THROWS_AS(ArchiveFileSystem{FileContent(bomb)}, std::runtime_error);
+    ArchiveFileSystem allowed(FileContent(bomb), "archive", 4096);
+    REQUIRE(allowed.find("archive/zeros.bin")->size == (16 << 20));
+
+    // A deflated zip member stops at the size its header declares
+    std::string zip = zipArchive({{"big.txt", std::string(100000, 'x')}}, true);
+    ArchiveFileSystem honest{FileContent(zip)};
+    REQUIRE(honest.read("archive/big.txt") == std::string(100000, 'x'));
+    size_t directory = 0;
+    for (int i = 3; i >= 0; --i) {
+        directory = directory << 8 | static_cast<unsigned char>(zip[zip.size() - 22 + 16 + i]);
+    }
+    std::string declared;
+    put32(declared, 100);
+    zip.replace(directory + 24, 4, declared);
+    ArchiveFileSystem understated{FileContent(zip)};
+    REQUIRE(understated.find("archive/big.txt")->size == 100);
+    REQUIRE_THROWS_AS(understated.read("archive/big.txt"), std::runtime_error);
+}
+#endif
+
+TEST_CASE("GitObjectFileSystem parses ls-tree output", "[VirtualFileSystem]") {
+    using namespace std::string_literals;
+    const std::string output =
+        "100644 blob 1111111111111111111111111111111111111111      12\tsrc/a.cpp\0"s +
+        "120000 blob 2222222222222222222222222222222222222222       5\tlink\0"s +
+        "160000 commit 3333333333333333333333333333333333333333       -\tmodule\0"s +
+        "100755 blob 4444444444444444444444444444444444444444 1048576\tdir/run me.sh\0"s;
+    auto blobs = GitObjectFileSystem::parseTree(output);
+
+    REQUIRE(blobs.size() == 2);
+    REQUIRE(blobs[0].path == "src/a.cpp");
+    REQUIRE(blobs[0].objectId == "1111111111111111111111111111111111111111");
+    REQUIRE(blobs[0].size == 12);
+    REQUIRE(blobs[1].path == "dir/run me.sh");
+    REQUIRE(blobs[1].size == 1048576);
+}
+
+TEST_CASE("GitObjectFileSystem reads a commit without a checkout", "[VirtualFileSystem]") {
+    fs::path tempDir = fs::temp_directory_path() / "repomix_git_object_fs_test";
+    fs::remove_all(tempDir);
+    fs::path source = tempDir / "source";
+    fs::create_directories(source / "src");
+
+    REQUIRE(git(source, "init -q") == 0);
+    writeFile(source / "README.md", "# Readme\n");
+    writeFile(source / "src" / "main.cpp", "int main() { return 0; }\n");
+    REQUIRE(git(source, "add -A") == 0);
+    REQUIRE(git(source, "commit -q -m first") == 0);
+    writeFile(source / "README.md", "uncommitted\n");
+
+    GitObjectFileSystem tree(source);
+    REQUIRE(entryPaths(tree) == std::vector<std::string>{"repo/README.md", "repo/src/main.cpp"});
+    REQUIRE(tree.find("repo/README.md")->modifiedTime > 0);
+    REQUIRE(tree.read("repo/README.md") == "# Readme\n");
+    REQUIRE(tree.read("repo/src/main.cpp") == "int main() { return 0; }\n");
+    REQUIRE(tree.read("repo/README.md") == "# Readme\n");   // Same batch process again
+
+    // Readers on several threads share a few processes
+    GitObjectFileSystem pooled(source, "HEAD", "repo", 2);
+    std::vector<std::thread> readers;
+    std::vector<int> matches(4, 0);
+    for (size_t t = 0; t < matches.size(); ++t) {
+        readers.emplace_back([&pooled, &matches, t]() {
+            for (int i = 0; i < 50; ++i) {
+                matches[t] += pooled.read("repo/src/main.cpp") == "int main() { return 0; }\n";
+                matches[t] += pooled.read("repo/README.md") == "# Readme\n";
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    REQUIRE(matches == std::vector<int>(4, 100));
+    REQUIRE_THROWS_AS(pooled.read("repo/missing.txt"), std::runtime_error);
+    REQUIRE(pooled.read("repo/README.md") == "# Readme\n");
+
+    REQUIRE_THROWS_AS(GitObjectFileSystem(source, "no-such-revision"), std::runtime_error);
+    fs::remove_all(tempDir);
+}
+
+TEST_CASE("FileProcessor processes a virtual tree and honors its .gitignore files", "[VirtualFileSystem]") {
+    auto tree = std::make_shared<MemoryFileSystem>("upload");
+    tree->add("main.cpp", FileContent(std::string("int main() {}\n")));
+    tree->add("notes.log", FileContent(std::string("log\n")));
+    tree->add("lib/.gitignore", FileContent(std::string("generated/\n*.tmp\n")));
+    tree->add("lib/util.h", FileContent(std::string("#pragma once\n")));
+    tree->add("lib/scratch.tmp", FileContent(std::string("tmp\n")));
+    tree->add("lib/generated/out.h", FileContent(std::string("// generated\n")));
+
+    PatternMatcher matcher;
+    matcher.setRootDirectory(tree->root());
+    matcher.addIgnorePattern("*.log");
+    FileProcessor processor(matcher, 2);
+    processor.setFileSystem(tree);
+
+    auto files = processor.processDirectory(tree->root());
+    std::vector<std::string> paths;
+    for (const auto& file : files) {
+        if (file.processed) {
+            paths.push_back(file.path.generic_string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    REQUIRE(paths == std::vector<std::string>{"upload/lib/.gitignore", "upload/lib/util.h", "upload/main.cpp"});
+
+    auto main = std::find_if(files.begin(), files.end(),
+                             [](const auto& file) { return file.path == "upload/main.cpp"; });
+    REQUIRE(processor.readContent(*main) == "int main() {}\n");
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch_test_macros.hpp>
+#include "work_stealing_pool.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("WorkStealingPool runs all submitted tasks", "[WorkStealingPool]") {
+    WorkStealingPool pool(4);
+    REQUIRE(pool.size() == 4);
+    
+    SECTION("Tasks submitted from outside the pool") {
+        std::atomic<int> counter{0};
+        for (int i = 0; i < 1000; ++i) {
+            pool.submit([&counter](unsigned int) { counter++; });
+        }
+        pool.wait();
+        REQUIRE(counter == 1000);
+    }
+    
+    SECTION("Tasks spawned by running tasks are waited for") {
+        std::atomic<int> leaves{0};
+        std::function<void(int)> spawn = [&](int depth) {
+            if (depth == 0) {
+                leaves++;
+                return;
+            }
+            for (int i = 0; i < 4; ++i) {
+                pool.submit([&spawn, depth](unsigned int) { spawn(depth - 1); });
+            }
+        };
+        pool.submit([&spawn](unsigned int) { spawn(5); });
+        pool.wait();
+        REQUIRE(leaves == 1024);
+    }
+    
+    SECTION("Worker indices allow lock-free per-worker state") {
+        std::vector<int> perWorker(pool.size(), 0);
+        for (int i = 0; i < 500; ++i) {
+            pool.submit([&perWorker](unsigned int worker) { perWorker[worker]++; });
+        }
+        pool.wait();
+        
+        int total = 0;
+        for (int count : perWorker) {
+            total += count;
+        }
+        REQUIRE(total == 500);
+    }
+    
+    SECTION("The pool can be reused after wait") {
+        std::atomic<int> counter{0};
+        pool.submit([&counter](unsigned int) { counter++; });
+        pool.wait();
+        pool.submit([&counter](unsigned int) { counter++; });
+        pool.wait();
+        REQUIRE(counter == 2);
+    }
+}
+
+TEST_CASE("WorkStealingPool::parallelFor runs every index once", "[WorkStealingPool]") {
+    WorkStealingPool pool(4);
+    
+    SECTION("From outside the pool") {
+        std::vector<std::atomic<int>> hits(100);
+        pool.parallelFor(hits.size(), [&hits](size_t i) { hits[i]++; });
+        for (const auto& hit : hits) {
+            REQUIRE(hit == 1);
+        }
+    }
+    
+    SECTION("From tasks that occupy every worker") {
+        std::atomic<int> total{0};
+        for (int task = 0; task < 8; ++task) {
+            pool.submit([&pool, &total](unsigned int) {
+                pool.parallelFor(16, [&total](size_t) { total++; });
+            });
+        }
+        pool.wait();
+        REQUIRE(total == 8 * 16);
+    }
+    
+    SECTION("Exceptions reach the caller after all indices ran") {
+        std::atomic<int> ran{0};
+        REQUIRE_THROWS_AS(pool.parallelFor(10, [&ran](size_t i) {
+            ran++;
+            if (i == 3) {
+                throw std::runtime_error("chunk failed");
+            }
+        }), std::runtime_error);
+        REQUIRE(ran == 10);
+    }
+}